@@ -0,0 +1,229 @@
+/**
+ * @file capture_shared.h
+ * @brief ESP-NOW 패킷 캡처 링 버퍼 및 덤프 파일 형식 (송신부/수신부/호스트 분석 도구 공용)
+ * @version 1.0.0
+ * @date 2024-06-13
+ *
+ * 덤프 파일 (모든 정수는 리틀 엔디언, Comm::Schema로 인코딩):
+ *   [FileHeader] [RecordHeader][capLen 바이트] [RecordHeader][capLen 바이트] ...
+ * 레코드는 오래된 것부터 기록됩니다. 타임스탬프는 기록한 장치의 esp_timer (us) 입니다.
+ * 시리얼 덤프는 같은 바이트를 "#CAPTURE BEGIN"과 "#CAPTURE END" 사이에
+ * 한 줄에 kHexBytesPerLine 바이트씩 16진수로 출력합니다 (로그 줄이 섞여도 분석 도구가 걸러냄).
+ */
+#pragma once
+#ifndef CAPTURE_SHARED_H
+#define CAPTURE_SHARED_H
+
+#include "espnow_comm_shared.h"
+#if defined(ARDUINO)
+#include <new>
+#include <esp_timer.h>
+#endif
+
+namespace Capture {
+
+static constexpr uint32_t kFileMagic = 0x50434C4DUL; // "MLCP"
+static constexpr uint16_t kFormatVersion = 1;
+static constexpr size_t   kHexBytesPerLine = 32;
+
+enum Role : uint8_t {
+    ROLE_TRANSMITTER = 1,
+    ROLE_RECEIVER    = 2
+};
+
+enum RecordKind : uint8_t {
+    REC_TX      = 0,   // esp_now_send 호출 (status: 0=성공, 1=호출 실패)
+    REC_RX      = 1,   // 수신 콜백 (검증 전 원본 프레임)
+    REC_TX_DONE = 2,   // 송신 완료 콜백 (status: 0=전달됨, 1=전달 실패), 데이터 없음
+    REC_FIRE    = 3    // 수신부 출력 시작 (데이터: FireEvent)
+};
+
+enum RecordStatus : uint8_t {
+    STATUS_OK     = 0,
+    STATUS_FAILED = 1
+};
+
+struct FileHeader {
+    uint32_t magic;
+    uint16_t formatVersion;
+    uint8_t  role;             // Role
+    uint8_t  deviceId;         // 수신부 ID (송신부는 0)
+    uint8_t  protocolVersion;  // 기록한 펌웨어의 Comm::kVersion
+    uint8_t  snapLen;          // 레코드당 최대 저장 바이트 (이보다 긴 프레임은 앞부분만 저장)
+    uint16_t recordCount;
+    uint32_t droppedCount;     // 덤프 전에 덮어써진 레코드 수
+    uint64_t dumpTimeUs;       // 덤프 시각 (esp_timer)
+};
+
+struct RecordHeader {
+    uint64_t timestampUs;
+    uint8_t  kind;             // RecordKind
+    uint8_t  status;           // RecordStatus
+    int8_t   rssi;             // REC_RX만 유효 (그 외 0)
+    uint8_t  peer[6];          // 상대 MAC (송신 대상 또는 수신 출처)
+    uint8_t  origLen;          // 원래 프레임 길이
+    uint8_t  capLen;           // 뒤따르는 저장된 바이트 수
+};
+
+// 수신부가 MOSFET을 켠 시점 (목표 시각과 실제 시각, 모두 수신부 esp_timer)
+struct FireEvent {
+    uint32_t commandId;        // 송신부 버튼 눌림 micros (수동 실행은 0)
+    int64_t  targetUs;
+    int64_t  actualUs;
+};
+
+using FileHeaderSchema = Comm::Schema<FileHeader,
+    Comm::Field<&FileHeader::magic>, Comm::Field<&FileHeader::formatVersion>, Comm::Field<&FileHeader::role>,
+    Comm::Field<&FileHeader::deviceId>, Comm::Field<&FileHeader::protocolVersion>, Comm::Field<&FileHeader::snapLen>,
+    Comm::Field<&FileHeader::recordCount>, Comm::Field<&FileHeader::droppedCount>, Comm::Field<&FileHeader::dumpTimeUs>>;
+
+using RecordHeaderSchema = Comm::Schema<RecordHeader,
+    Comm::Field<&RecordHeader::timestampUs>, Comm::Field<&RecordHeader::kind>, Comm::Field<&RecordHeader::status>,
+    Comm::Field<&RecordHeader::rssi>, Comm::Field<&RecordHeader::peer>, Comm::Field<&RecordHeader::origLen>,
+    Comm::Field<&RecordHeader::capLen>>;
+
+using FireEventSchema = Comm::Schema<FireEvent,
+    Comm::Field<&FireEvent::commandId>, Comm::Field<&FireEvent::targetUs>, Comm::Field<&FireEvent::actualUs>>;
+
+static_assert(FileHeaderSchema::kWireSize == 24, "Capture FileHeader wire size mismatch");
+static_assert(RecordHeaderSchema::kWireSize == 19, "Capture RecordHeader wire size mismatch");
+static_assert(FireEventSchema::kWireSize == 20, "Capture FireEvent wire size mismatch");
+
+#if defined(ARDUINO)
+//---------------------------------------------------------------------
+//  펌웨어용 캡처 링 (ESP-NOW 콜백, esp_timer 콜백, loop에서 동시에 기록 가능)
+//---------------------------------------------------------------------
+template<size_t Slots, size_t SnapLen>
+class Ring {
+    static_assert(SnapLen <= 255, "Capture SnapLen must fit in uint8_t");
+    static_assert(Slots > 0 && Slots <= UINT16_MAX && (Slots & (Slots - 1)) == 0, "Capture Slots must be a power of two");
+
+public:
+    Ring() : _total(0), _dropped(0), _mux(portMUX_INITIALIZER_UNLOCKED) {}
+
+    void record(RecordKind kind, uint8_t status, int8_t rssi, const uint8_t* peer, const uint8_t* data, size_t len) {
+        int64_t nowUs = esp_timer_get_time();
+        size_t capLen = (len < SnapLen) ? len : SnapLen;
+        portENTER_CRITICAL(&_mux);
+        Slot& slot = _slots[_total % Slots];
+        slot.header.timestampUs = (uint64_t)nowUs;
+        slot.header.kind = kind;
+        slot.header.status = status;
+        slot.header.rssi = rssi;
+        if (peer) memcpy(slot.header.peer, peer, 6); else memset(slot.header.peer, 0, 6);
+        slot.header.origLen = (uint8_t)((len > 255) ? 255 : len);
+        slot.header.capLen = (uint8_t)capLen;
+        if (capLen > 0) memcpy(slot.data, data, capLen);
+        if (_total >= Slots) _dropped++;
+        _total++;
+        portEXIT_CRITICAL(&_mux);
+    }
+
+    void recordFire(uint32_t commandId, int64_t targetUs, int64_t actualUs) {
+        FireEvent event = { commandId, targetUs, actualUs };
+        uint8_t bytes[FireEventSchema::kWireSize];
+        FireEventSchema::encode(event, bytes);
+        record(REC_FIRE, STATUS_OK, 0, nullptr, bytes, sizeof(bytes));
+    }
+
+    void clear() {
+        portENTER_CRITICAL(&_mux);
+        _total = 0;
+        _dropped = 0;
+        portEXIT_CRITICAL(&_mux);
+    }
+
+    // 덤프 파일을 sink(const uint8_t*, size_t)로 출력. 먼저 레코드를 하나씩 잠가 복사해 두므로
+    // 출력이 느려도(시리얼) 기록을 막지 않으며, 복사 도중 덮어써진 레코드는 droppedCount에 더함.
+    // 복사 버퍼를 할당하지 못하면 false
+    template<typename Sink>
+    bool dump(Role role, uint8_t deviceId, Sink&& sink) {
+        portENTER_CRITICAL(&_mux);
+        uint32_t endNo = _total;
+        uint32_t count = (_total < Slots) ? _total : (uint32_t)Slots;
+        uint32_t dropped = _dropped;
+        portEXIT_CRITICAL(&_mux);
+
+        Slot* snapshot = nullptr;
+        if (count > 0) {
+            snapshot = new (std::nothrow) Slot[count];
+            if (!snapshot) return false;
+        }
+        uint16_t copied = 0;
+        for (uint32_t no = endNo - count; no != endNo; ++no) {
+            portENTER_CRITICAL(&_mux);
+            bool alive = (_total - no) <= Slots;
+            if (alive) snapshot[copied++] = _slots[no % Slots];
+            portEXIT_CRITICAL(&_mux);
+            if (!alive) dropped++;
+        }
+
+        FileHeader fileHeader = { kFileMagic, kFormatVersion, role, deviceId, Comm::kVersion, (uint8_t)SnapLen,
+                                  copied, dropped, (uint64_t)esp_timer_get_time() };
+        uint8_t headerBytes[FileHeaderSchema::kWireSize];
+        FileHeaderSchema::encode(fileHeader, headerBytes);
+        sink(headerBytes, sizeof(headerBytes));
+
+        for (uint16_t i = 0; i < copied; ++i) {
+            uint8_t recordBytes[RecordHeaderSchema::kWireSize];
+            RecordHeaderSchema::encode(snapshot[i].header, recordBytes);
+            sink(recordBytes, sizeof(recordBytes));
+            if (snapshot[i].header.capLen > 0) sink(snapshot[i].data, snapshot[i].header.capLen);
+        }
+        delete[] snapshot;
+        return true;
+    }
+
+private:
+    struct Slot {
+        RecordHeader header;
+        uint8_t data[SnapLen];
+    };
+
+    Slot _slots[Slots];
+    uint32_t _total;     // 지금까지 기록한 레코드 수 (다음 레코드 번호, 슬롯 위치는 번호 % Slots)
+    uint32_t _dropped;
+    portMUX_TYPE _mux;
+};
+
+// [NEW] 덤프 바이트를 16진수 줄로 출력 (시리얼 덤프용)
+class HexLineWriter {
+public:
+    explicit HexLineWriter(Print& out) : _out(out), _lineLen(0) {}
+
+    void operator()(const uint8_t* data, size_t len) {
+        static const char kHex[] = "0123456789abcdef";
+        for (size_t i = 0; i < len; ++i) {
+            _line[_lineLen * 2] = kHex[data[i] >> 4];
+            _line[_lineLen * 2 + 1] = kHex[data[i] & 0x0F];
+            if (++_lineLen == kHexBytesPerLine) flush();
+        }
+    }
+
+    void flush() {
+        if (_lineLen == 0) return;
+        _line[_lineLen * 2] = '\0';
+        _out.println(_line);
+        _lineLen = 0;
+    }
+
+private:
+    Print& _out;
+    char _line[kHexBytesPerLine * 2 + 1];
+    size_t _lineLen;
+};
+
+template<size_t Slots, size_t SnapLen>
+inline bool dumpHex(Ring<Slots, SnapLen>& ring, Role role, uint8_t deviceId, Print& out) {
+    out.println("#CAPTURE BEGIN");
+    HexLineWriter writer(out);
+    bool ok = ring.dump(role, deviceId, writer);
+    writer.flush();
+    out.println(ok ? "#CAPTURE END" : "#CAPTURE FAILED");
+    return ok;
+}
+#endif // ARDUINO
+
+} // namespace Capture
+
+#endif // CAPTURE_SHARED_H
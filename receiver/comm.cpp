@@ -5,7 +5,7 @@
 /**
  * @file comm.cpp
  * @brief CommManager 클래스의 구현입니다.
- * @version 7.6.0 // [MODIFIED] 버전 업데이트
+ * @version 8.0.0 // [MODIFIED] 그룹 등록(GROUP_CONFIG), 그룹 주소 명령
  * @date 2024-06-13
  */
 #include "comm.h"
@@ -26,25 +26,53 @@ void onDataSent(const uint8_t* mac_addr, esp_now_send_status_t status) {
     commManager.handleEspNowSendStatus(mac_addr, status);
 }
 
-CommManager::CommManager() : _modeManager(nullptr), _myDeviceId(DEFAULT_DEVICE_ID) {
+CommManager::CommManager() : _modeManager(nullptr), _myDeviceId(DEFAULT_DEVICE_ID), _groupsDirty(false), _groupMux(portMUX_INITIALIZER_UNLOCKED), _ackSlotTimer(nullptr), _ackMux(portMUX_INITIALIZER_UNLOCKED), _serialLineLen(0),
+    _channel(ESP_NOW_CHANNEL), _pendingHopChannel(0), _pendingHopAtMs(0), _beaconChannel(0), _lastHeardMs(0), _scanning(false),
+    _scanDwellStartMs(0), _channelMux(portMUX_INITIALIZER_UNLOCKED), _replyRssiX16(0), _replyStep(0),
+    _replyStepCap(Comm::kRateLadderSize - 1), _replyAppliedStep(0xFF), _replySuccesses(0) {
     // 수신부에서는 runningDevices 배열이 필요 없습니다. (송신부에서 관리)
     // 따라서 memset 호출을 제거합니다.
+    memset(&_pendingAck, 0, sizeof(_pendingAck));
+    memset(_seqWindows, 0, sizeof(_seqWindows));
+    memset(_groupOwners, 0, sizeof(_groupOwners));
 }
 
 bool CommManager::begin(uint8_t deviceId, ModeManager* modeMgr) {
     _myDeviceId = deviceId;
     _modeManager = modeMgr;
-    Log::Info(PSTR("COMM: Device ID %d로 ESP-NOW 초기화 중 (수신부)"), _myDeviceId);
+
+    // [NEW] ACK 슬롯 타이머 (일괄 명령 수신 시 내 슬롯까지 ACK 전송을 미룸)
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = &CommManager::ackSlotTimerCallback;
+    timerArgs.arg = this;
+    timerArgs.name = "ack_slot";
+    if (esp_timer_create(&timerArgs, &_ackSlotTimer) != ESP_OK) {
+        Log::Warn(PSTR("COMM: ACK 슬롯 타이머 생성 실패. ACK는 즉시 전송됩니다."));
+        _ackSlotTimer = nullptr;
+    }
+
+    // [NEW] 마지막으로 옮긴 채널에서 시작 (송신기가 없으면 RX_CHANNEL_LOST_MS 뒤 탐색)
+    _channel = NVS::loadChannel();
+    if (_channel < Comm::kMinWifiChannel || _channel > Comm::kMaxWifiChannel) _channel = ESP_NOW_CHANNEL;
+    _lastHeardMs = millis();
+    // [NEW] 송신기별 그룹 등록 (표 크기가 바뀌었으면 비우고 송신기가 다시 등록하게 함)
+    if (!NVS::loadGroupOwners(_groupOwners, sizeof(_groupOwners))) memset(_groupOwners, 0, sizeof(_groupOwners));
+    uint8_t groupOwnerCount = 0;
+    for (const GroupOwner& owner : _groupOwners) {
+        if (owner.groups) ++groupOwnerCount;
+    }
+
+    Log::Info(PSTR("COMM: Device ID %d로 ESP-NOW 초기화 중 (수신부, 그룹 등록 송신기 %u개)"), _myDeviceId, groupOwnerCount);
     if (!initEspNowStack()) return false;
     registerCallbacks();
-    Log::Info(PSTR("COMM: ESP-NOW 초기화 성공 (채널: %d)."), ESP_NOW_CHANNEL);
+    Log::Info(PSTR("COMM: ESP-NOW 초기화 성공 (채널: %d)."), _channel);
     return true;
 }
 
 bool CommManager::initEspNowStack() {
     WiFi.mode(WIFI_STA); // Wi-Fi 스테이션 모드로 설정
-    if (esp_wifi_set_channel(ESP_NOW_CHANNEL, WIFI_SECOND_CHAN_NONE) != ESP_OK) {
-        Log::Error(PSTR("COMM: Wi-Fi 채널 %d 설정 실패."), ESP_NOW_CHANNEL);
+    if (esp_wifi_set_channel(_channel, WIFI_SECOND_CHAN_NONE) != ESP_OK) {
+        Log::Error(PSTR("COMM: Wi-Fi 채널 %d 설정 실패."), _channel);
         return false;
     }
     if (esp_now_init() != ESP_OK) {
@@ -56,12 +84,15 @@ bool CommManager::initEspNowStack() {
     // 송신부의 브로드캐스트 주소를 피어로 추가합니다.
     esp_now_peer_info_t peerInfo = {};
     memcpy(peerInfo.peer_addr, BROADCAST_ADDRESS, 6);
-    peerInfo.channel = ESP_NOW_CHANNEL;
+    peerInfo.channel = 0; // [MODIFIED] 0 = 현재 채널 (채널을 옮겨도 피어를 다시 등록하지 않음)
     peerInfo.encrypt = false; // 암호화 사용 안 함
     if (esp_now_add_peer(&peerInfo) != ESP_OK) {
         Log::Error(PSTR("COMM: 브로드캐스트 피어 추가 실패."));
         return false;
     }
+    // [NEW] 속도 설정이 없는 피어의 기본 속도. 피어를 다시 만들었으므로 응답 속도도 다시 적용
+    esp_wifi_config_espnow_rate(WIFI_IF_STA, Comm::kRateLadder[0].rate);
+    _replyAppliedStep = 0xFF;
     return true;
 }
 
@@ -75,7 +106,9 @@ void CommManager::reinitForEspNow() {
         return;
     }
     registerCallbacks(); // 콜백 다시 등록
-    Log::Info(PSTR("COMM: ESP-NOW 재초기화 성공 (수신부)."));
+    _scanning = false;
+    _lastHeardMs = millis();
+    Log::Info(PSTR("COMM: ESP-NOW 재초기화 성공 (수신부, 채널: %d)."), _channel);
 }
 
 void CommManager::registerCallbacks() {
@@ -90,50 +123,541 @@ void CommManager::updateMyDeviceId(uint8_t newId) {
     }
 }
 
-// [MODIFIED] CommPacket을 const 포인터로 받음
+// [MODIFIED] 패킷 타입을 먼저 확인한 뒤 타입별 검증 함수로 분기
 void CommManager::handleEspNowRecv(const esp_now_recv_info_t* recv_info, const uint8_t* incomingData, int len) {
-    const Comm::CommPacket* pkt = nullptr;
+    Comm::CommPacket pkt;
     bool forMe = false;
+    uint8_t packetType = 0;
 
     uint32_t rxTime = micros(); 
 
-    if (!Comm::verifyCommPacket(incomingData, len, pkt, _myDeviceId, forMe)) {
+    // [NEW] 비상 정지는 캡처와 로그보다 먼저 처리해 출력 차단까지의 지연을 줄임
+    if (Comm::peekPacketType(incomingData, len, packetType) && packetType == Comm::STOP_COMMAND) {
+        handleStopCommand(recv_info, incomingData, len, rxTime);
+        return;
+    }
+    // [NEW] 실행 패킷도 캡처와 로그보다 먼저 처리 (버튼 눌림부터 실행까지가 이 패킷 하나의 전송 시간이 되도록)
+    if (packetType == Comm::GO_COMMAND) {
+        handleGoCommand(recv_info, incomingData, len, rxTime);
+        return;
+    }
+
+    // [NEW] 검증 전 원본 프레임을 캡처 링에 기록
+    int8_t rssi = (recv_info && recv_info->rx_ctrl) ? (int8_t)recv_info->rx_ctrl->rssi : 0;
+    _capture.record(Capture::REC_RX, Capture::STATUS_OK, rssi, recv_info ? recv_info->src_addr : nullptr,
+                    incomingData, (len > 0) ? (size_t)len : 0);
+
+    if (!Comm::peekPacketType(incomingData, len, packetType)) {
+        Log::Warn(PSTR("COMM: 유효하지 않거나 손상된 ESP-NOW 패킷 수신."));
+        return;
+    }
+    _lastHeardMs = millis(); // [NEW] 송신기가 이 채널에 있음
+    updateReplyRate(rssi); // [NEW]
+
+    // [NEW] 채널 전환 예고와 채널 비콘
+    if (packetType == Comm::CHANNEL_HOP) {
+        handleChannelHop(recv_info, incomingData, len, rxTime);
+        return;
+    }
+    if (packetType == Comm::CHANNEL_BEACON) {
+        handleChannelBeacon(incomingData, len);
+        return;
+    }
+
+    // [NEW] 실행 정보 예약: 보관하고 바로 ACK (중복이면 ACK만)
+    if (packetType == Comm::ARM_CUE) {
+        Comm::ArmCuePacket cue;
+        if (!Comm::verifyArmCuePacket(incomingData, len, cue, _myDeviceId, forMe)) {
+            Log::Warn(PSTR("COMM: 유효하지 않거나 손상된 ARM_CUE 패킷 수신."));
+            return;
+        }
+        if (!forMe) return;
+        if (!isDuplicateSeq(recv_info->src_addr, cue.seq) && _modeManager) {
+            _modeManager->storeArmCue(recv_info->src_addr, &cue);
+        }
+        sendAck(recv_info->src_addr, cue.txMicros, rxTime);
+        return;
+    }
+
+    // [NEW] 그룹 등록/해제: 보낸 송신기의 비트맵만 바꾸고 바로 ACK (NVS 저장은 update()에서, 중복이면 ACK만).
+    // 등록할 빈 항목이 없으면 ACK하지 않음 (송신기는 그 장치를 그룹 주소 없이 일괄 명령으로 보냄)
+    if (packetType == Comm::GROUP_CONFIG) {
+        Comm::GroupConfigPacket cfg;
+        if (!Comm::verifyGroupConfigPacket(incomingData, len, cfg, _myDeviceId, forMe)) {
+            Log::Warn(PSTR("COMM: 유효하지 않거나 손상된 GROUP_CONFIG 패킷 수신."));
+            return;
+        }
+        if (!forMe) return;
+        const uint8_t* mac = recv_info->src_addr;
+        uint32_t groups = 0;
+        if (!isDuplicateSeq(mac, cfg.seq)) {
+            if (setGroupMember(mac, cfg.groupId, cfg.member, groups)) {
+                Log::Info(PSTR("COMM: %02X:%02X:%02X:%02X:%02X:%02X 그룹 %u %s (이 송신기의 그룹: 0x%08lX)."),
+                          mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], cfg.groupId, cfg.member ? "등록" : "해제", (unsigned long)groups);
+            } else {
+                Log::Warn(PSTR("COMM: 그룹 등록 표가 가득 참 (송신기 %u개). %02X:%02X:%02X:%02X:%02X:%02X의 그룹 %u 등록 거부."),
+                          MAX_GROUP_OWNERS, mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], cfg.groupId);
+            }
+        }
+        // 중복 패킷도 실제로 반영된 상태일 때만 ACK
+        groups = getGroups(mac);
+        if (((groups & Comm::groupBit(cfg.groupId)) != 0) != cfg.member) return;
+        sendAck(recv_info->src_addr, cfg.txMicros, rxTime);
+        return;
+    }
+
+    // [NEW] 일괄 명령 패킷: 비트맵에서 내 ID를 확인하고 내 항목만 꺼냄
+    if (packetType == Comm::BATCH_COMMAND) {
+        Comm::BatchCommandPacket batch;
+        Comm::BatchEntry entry;
+        if (!Comm::verifyBatchCommandPacket(incomingData, len, batch, _myDeviceId, entry, forMe)) {
+            Log::Warn(PSTR("COMM: 유효하지 않거나 손상된 BATCH_COMMAND 패킷 수신."));
+            return;
+        }
+        if (!forMe) {
+            Log::Debug(PSTR("COMM: 나를 위한 BATCH_COMMAND가 아님. 비트맵: 0x%08X, 내 ID: %u."), batch.targetBitmap, _myDeviceId);
+            return;
+        }
+        if (isDuplicateSeq(recv_info->src_addr, batch.seq)) {
+            // 이미 처리한 패킷: 로그/타이머 처리 없이 내 슬롯에서 ACK만 다시 보냄
+            sendAck(recv_info->src_addr, batch.txMicros, rxTime,
+                    (uint32_t)Comm::ackSlotIndex(batch.targetBitmap, _myDeviceId) * batch.ackSlotUs);
+            return;
+        }
+        if (_modeManager) {
+            _modeManager->handleEspNowBatchCommand(recv_info->src_addr, &batch, &entry);
+        }
+        return;
+    }
+
+    // [MODIFIED] 보낸 송신기가 나를 등록한 그룹으로 보낸 명령도 받음 (다른 송신기가 같은 번호를 써도 무시)
+    if (!Comm::verifyCommPacket(incomingData, len, pkt, _myDeviceId, forMe, getGroups(recv_info->src_addr))) {
         Log::Warn(PSTR("COMM: 유효하지 않거나 손상된 ESP-NOW 패킷 수신."));
         return;
     }
     if (!forMe) {
-        Log::Debug(PSTR("COMM: 나를 위한 패킷이 아님. 대상 ID: %u, 내 ID: %u."), pkt->targetId, _myDeviceId);
+        Log::Debug(PSTR("COMM: 나를 위한 패킷이 아님. 대상 ID: 0x%02X, 내 ID: %u."), pkt.targetId, _myDeviceId);
+        return;
+    }
+    // [NEW] 그룹 주소 명령은 그룹 전체가 ACK하므로 ID 순서 슬롯에서 ACK
+    uint32_t ackDelayUs = Comm::isGroupTarget(pkt.targetId) ? Comm::groupAckDelayUs(incomingData, len, _myDeviceId) : 0;
+    if (isDuplicateSeq(recv_info->src_addr, pkt.seq)) {
+        // [NEW] 재전송된 중복 패킷: 로그/타이머 처리 없이 ACK만 다시 보냄 (이전 ACK가 유실됐을 수 있음)
+        sendAck(recv_info->src_addr, pkt.txMicros, rxTime, ackDelayUs);
         return;
     }
 
     if (_modeManager) {
-        _modeManager->handleEspNowCommand(recv_info->src_addr, pkt); // [MODIFIED] 포인터 전달
+        _modeManager->handleEspNowCommand(recv_info->src_addr, &pkt, ackDelayUs); // [MODIFIED] 포인터 전달
+    }
+}
+
+// [NEW] 비상 정지: 검증 후 바로 출력을 끄고, 캡처/ACK/로그는 그 다음에 처리.
+// 같은 정지가 반복 전송되므로 중복 검사 없이 매번 출력을 끄고 ACK함 (ACK가 유실됐을 수 있음)
+void CommManager::handleStopCommand(const esp_now_recv_info_t* recv_info, const uint8_t* incomingData, int len, uint32_t rxTime) {
+    Comm::StopPacket stop;
+    bool forMe = false;
+    bool valid = Comm::verifyStopPacket(incomingData, len, stop, _myDeviceId, forMe);
+    const uint8_t* src = recv_info ? recv_info->src_addr : nullptr;
+    uint32_t stopLatencyUs = 0;
+    if (valid && forMe && _modeManager) {
+        _modeManager->emergencyStop(src, stop.txMicros);
+        stopLatencyUs = micros() - rxTime;
+    }
+
+    int8_t rssi = (recv_info && recv_info->rx_ctrl) ? (int8_t)recv_info->rx_ctrl->rssi : 0;
+    _capture.record(Capture::REC_RX, Capture::STATUS_OK, rssi, src, incomingData, (len > 0) ? (size_t)len : 0);
+
+    if (!valid) {
+        Log::Warn(PSTR("COMM: 유효하지 않거나 손상된 STOP_COMMAND 패킷 수신."));
+        return;
+    }
+    _lastHeardMs = millis();
+    if (!forMe) {
+        Log::Debug(PSTR("COMM: 나를 위한 STOP_COMMAND가 아님. 비트맵: 0x%08X, 내 ID: %u."), stop.targetBitmap, _myDeviceId);
+        return;
+    }
+    if (src) {
+        sendAck(src, stop.txMicros, rxTime, (uint32_t)Comm::ackSlotIndex(stop.targetBitmap, _myDeviceId) * stop.ackSlotUs);
+    }
+    Log::Warn(PSTR("COMM: STOP_COMMAND 수신. 출력 차단 (수신 후 %lu us)."), stopLatencyUs);
+}
+
+// [NEW] 실행 패킷: 보관한 실행 정보로 바로 타이머를 시작하고, 캡처/ACK는 그 다음에 처리.
+// 재전송을 받으면 applyFinalCommand가 같은 시퀀스로 보고 무시하므로 ACK만 다시 보냄.
+// 실행 정보가 없거나 무장 회차가 다르면 ACK하지 않음 (송신부가 이 장치만 개별 명령으로 대체)
+void CommManager::handleGoCommand(const esp_now_recv_info_t* recv_info, const uint8_t* incomingData, int len, uint32_t rxTime) {
+    Comm::GoPacket go;
+    bool forMe = false;
+    bool valid = Comm::verifyGoPacket(incomingData, len, go, _myDeviceId, forMe);
+    const uint8_t* src = recv_info ? recv_info->src_addr : nullptr;
+    bool armed = valid && forMe && _modeManager && _modeManager->handleGoCommand(src, &go, rxTime);
+
+    int8_t rssi = (recv_info && recv_info->rx_ctrl) ? (int8_t)recv_info->rx_ctrl->rssi : 0;
+    _capture.record(Capture::REC_RX, Capture::STATUS_OK, rssi, src, incomingData, (len > 0) ? (size_t)len : 0);
+
+    if (!valid) {
+        Log::Warn(PSTR("COMM: 유효하지 않거나 손상된 GO_COMMAND 패킷 수신."));
+        return;
+    }
+    _lastHeardMs = millis();
+    if (!forMe) {
+        Log::Debug(PSTR("COMM: 나를 위한 GO_COMMAND가 아님. 비트맵: 0x%08X, 내 ID: %u."), go.targetBitmap, _myDeviceId);
+        return;
+    }
+    if (armed && src) {
+        sendAck(src, go.txMicros, rxTime, (uint32_t)Comm::ackSlotIndex(go.targetBitmap, _myDeviceId) * go.ackSlotUs);
+    }
+}
+
+// [NEW] 채널 전환 예고: 내 슬롯에서 ACK하고 switchInMs 뒤로 전환 예약 (전환은 update()에서).
+// 재전송을 받을 때마다 남은 시간으로 예약을 고치고 다시 ACK함 (이전 ACK가 유실됐을 수 있음)
+void CommManager::handleChannelHop(const esp_now_recv_info_t* recv_info, const uint8_t* incomingData, int len, uint32_t rxTime) {
+    Comm::ChannelHopPacket hop;
+    bool forMe = false;
+    if (!Comm::verifyChannelHopPacket(incomingData, len, hop, _myDeviceId, forMe)) {
+        Log::Warn(PSTR("COMM: 유효하지 않거나 손상된 CHANNEL_HOP 패킷 수신."));
+        return;
+    }
+    if (!forMe || !recv_info) return;
+    if (_modeManager && _modeManager->getCurrentMode() == DeviceMode::MODE_WIFI) {
+        Log::Warn(PSTR("COMM: Wi-Fi 모드 중이라 채널 %d 전환 무시 (ESP-NOW 복귀 후 탐색)."), hop.newChannel);
+        return;
+    }
+
+    portENTER_CRITICAL(&_channelMux);
+    bool alreadyPending = (_pendingHopChannel == hop.newChannel);
+    _pendingHopChannel = hop.newChannel;
+    _pendingHopAtMs = millis() + hop.switchInMs;
+    portEXIT_CRITICAL(&_channelMux);
+
+    sendAck(recv_info->src_addr, hop.txMicros, rxTime, (uint32_t)Comm::ackSlotIndex(hop.targetBitmap, _myDeviceId) * hop.ackSlotUs);
+    if (!alreadyPending) {
+        Log::Info(PSTR("COMM: 채널 %d -> %d 전환 예고 수신 (%u ms 뒤)."), _channel, hop.newChannel, hop.switchInMs);
+    }
+}
+
+// [NEW] 채널 비콘: 송신기의 실제 채널을 기록 (옆 채널에서 들렸을 수 있으므로 update()가 그 채널로 맞춤)
+void CommManager::handleChannelBeacon(const uint8_t* incomingData, int len) {
+    Comm::ChannelBeacon beacon;
+    if (!Comm::verifyChannelBeacon(incomingData, len, beacon)) return;
+    _beaconChannel = beacon.channel;
+}
+
+bool CommManager::setChannel(uint8_t channel, bool persist) {
+    if (esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE) != ESP_OK) {
+        Log::Error(PSTR("COMM: Wi-Fi 채널 %d 설정 실패."), channel);
+        return false;
+    }
+    _channel = channel;
+    if (persist) NVS::saveChannel(channel);
+    return true;
+}
+
+// [NEW] 채널 관리 (loop 컨텍스트)
+//  - 예약된 전환 시각이 되면 새 채널로 옮기고 저장
+//  - 비콘이 다른 채널을 알려주면 그 채널로 옮김 (전환을 놓쳤지만 옆 채널에서 비콘이 들리는 경우)
+//  - RX_CHANNEL_LOST_MS 동안 송신기 프레임이 없으면 채널을 RX_CHANNEL_SCAN_DWELL_MS씩 돌며 탐색하고,
+//    비콘(또는 다른 송신기 프레임)이 들리면 그 채널에 고정
+void CommManager::update() {
+    if (_groupsDirty) { // [NEW] 수신 콜백에서 바뀐 그룹을 저장 (Wi-Fi 드라이버 태스크에서 NVS에 쓰지 않도록)
+        GroupOwner owners[MAX_GROUP_OWNERS];
+        portENTER_CRITICAL(&_groupMux);
+        memcpy(owners, _groupOwners, sizeof(owners));
+        _groupsDirty = false;
+        portEXIT_CRITICAL(&_groupMux);
+        NVS::saveGroupOwners(owners, sizeof(owners));
+    }
+    if (_modeManager && _modeManager->getCurrentMode() == DeviceMode::MODE_WIFI) return; // Wi-Fi 모드에서는 AP가 채널을 정함
+
+    uint32_t now = millis();
+    portENTER_CRITICAL(&_channelMux);
+    uint8_t hopChannel = _pendingHopChannel;
+    bool hopDue = (hopChannel != 0) && (int32_t)(now - _pendingHopAtMs) >= 0;
+    if (hopDue) _pendingHopChannel = 0;
+    uint8_t beaconChannel = _beaconChannel;
+    _beaconChannel = 0;
+    uint32_t lastHeardMs = _lastHeardMs;
+    portEXIT_CRITICAL(&_channelMux);
+
+    if (hopDue) {
+        Log::Info(PSTR("COMM: 채널 %d -> %d 전환."), _channel, hopChannel);
+        _scanning = false;
+        _lastHeardMs = now;
+        setChannel(hopChannel, true);
+        return;
+    }
+    if (beaconChannel != 0 && (beaconChannel != _channel || _scanning)) {
+        Log::Info(PSTR("COMM: 송신기 비콘 수신. 채널 %d로 고정 (현재 %d)."), beaconChannel, _channel);
+        _scanning = false;
+        _lastHeardMs = now;
+        setChannel(beaconChannel, true);
+        return;
+    }
+
+    if (_scanning) {
+        if ((int32_t)(lastHeardMs - _scanDwellStartMs) >= 0) {
+            Log::Info(PSTR("COMM: 채널 %d에서 송신기 프레임 수신. 탐색 종료."), _channel);
+            _scanning = false;
+            NVS::saveChannel(_channel);
+            return;
+        }
+        if (now - _scanDwellStartMs < RX_CHANNEL_SCAN_DWELL_MS) return;
+    } else {
+        if ((int32_t)(now - lastHeardMs) < RX_CHANNEL_LOST_MS) return; // 콜백이 방금 기록했으면 음수
+        Log::Warn(PSTR("COMM: %lu ms 동안 송신기 프레임 없음. 채널 탐색 시작 (채널 %d부터)."),
+                  (unsigned long)(now - lastHeardMs), _channel % Comm::kMaxWifiChannel + 1);
+        _scanning = true;
+    }
+    uint8_t next = (uint8_t)(_channel % Comm::kMaxWifiChannel + 1);
+    _scanDwellStartMs = now;
+    setChannel(next, false);
+    Log::Debug(PSTR("COMM: 채널 %d 탐색 중."), next);
+}
+
+// [NEW] 송신기별 그룹 등록 조회 (등록하지 않은 송신기는 0)
+uint32_t CommManager::getGroups(const uint8_t* senderMac) {
+    uint32_t groups = 0;
+    portENTER_CRITICAL(&_groupMux);
+    for (const GroupOwner& owner : _groupOwners) {
+        if (owner.groups && memcmp(owner.mac, senderMac, 6) == 0) { groups = owner.groups; break; }
+    }
+    portEXIT_CRITICAL(&_groupMux);
+    return groups;
+}
+
+// [NEW] 송신기의 그룹 등록/해제. 처음 등록하는 송신기는 빈 항목을 쓰고, 마지막 그룹이 해제되면 항목을 비움.
+// 빈 항목이 없으면 다른 송신기의 등록을 지우지 않고 false (해제는 항상 성공)
+bool CommManager::setGroupMember(const uint8_t* senderMac, uint8_t groupId, bool member, uint32_t& groups) {
+    uint32_t bit = Comm::groupBit(groupId);
+    GroupOwner* entry = nullptr;
+    GroupOwner* freeEntry = nullptr;
+    bool ok = true;
+    portENTER_CRITICAL(&_groupMux);
+    for (GroupOwner& owner : _groupOwners) {
+        if (owner.groups && memcmp(owner.mac, senderMac, 6) == 0) { entry = &owner; break; }
+        if (!owner.groups && !freeEntry) freeEntry = &owner;
+    }
+    if (!entry && member) {
+        if (freeEntry) {
+            entry = freeEntry;
+            memcpy(entry->mac, senderMac, 6);
+            entry->groups = 0;
+        } else {
+            ok = false;
+        }
+    }
+    groups = 0;
+    if (entry) {
+        uint32_t updated = member ? (entry->groups | bit) : (entry->groups & ~bit);
+        if (updated != entry->groups) {
+            entry->groups = updated;
+            if (!updated) memset(entry->mac, 0, sizeof(entry->mac));
+            _groupsDirty = true;
+        }
+        groups = updated;
+    }
+    portEXIT_CRITICAL(&_groupMux);
+    return ok;
+}
+
+// [NEW] 송신기별 슬라이딩 창으로 중복 여부를 O(1)에 판정하고, 새 시퀀스 번호는 수신 기록에 추가
+bool CommManager::isDuplicateSeq(const uint8_t* mac, uint32_t seq) {
+    SenderSeqWindow* window = nullptr;
+    SenderSeqWindow* oldest = &_seqWindows[0];
+    for (uint8_t i = 0; i < MAX_TRACKED_SENDERS; ++i) {
+        SenderSeqWindow& w = _seqWindows[i];
+        if (w.inUse && memcmp(w.mac, mac, 6) == 0) { window = &w; break; }
+        if (!w.inUse || (oldest->inUse && w.lastSeenMs < oldest->lastSeenMs)) oldest = &w;
+    }
+
+    uint32_t now = millis();
+    if (!window) {
+        // 처음 보는 송신기: 가장 오래된 항목을 교체
+        window = oldest;
+        memcpy(window->mac, mac, 6);
+        window->highestSeq = seq;
+        window->seenBitmap = 1;
+        window->lastSeenMs = now;
+        window->inUse = true;
+        return false;
+    }
+    window->lastSeenMs = now;
+
+    int32_t diff = (int32_t)(seq - window->highestSeq);
+    if (diff > 0) {
+        // 새 최고 시퀀스: 창을 앞으로 이동
+        window->seenBitmap = (diff >= SEQ_DEDUP_WINDOW) ? 1 : ((window->seenBitmap << diff) | 1);
+        window->highestSeq = seq;
+        return false;
+    }
+    if (diff <= -SEQ_DEDUP_WINDOW) {
+        // 창보다 훨씬 이전 번호: 송신기가 재부팅된 것으로 보고 창을 다시 시작
+        window->highestSeq = seq;
+        window->seenBitmap = 1;
+        return false;
     }
+    uint64_t bit = 1ULL << (-diff);
+    if (window->seenBitmap & bit) return true;
+    window->seenBitmap |= bit;
+    return false;
 }
 
 void CommManager::handleEspNowSendStatus(const uint8_t* mac_addr, esp_now_send_status_t status) {
+    _capture.record(Capture::REC_TX_DONE, (status == ESP_NOW_SEND_SUCCESS) ? Capture::STATUS_OK : Capture::STATUS_FAILED,
+                    0, mac_addr, nullptr, 0);
+    // [NEW] 응답은 유니캐스트이므로 실패는 송신기가 링크 계층 ACK를 못 받았다는 뜻: 속도 상한을 한 단계 낮춤
+    if (ENABLE_RX_RATE_CONTROL) {
+        if (status != ESP_NOW_SEND_SUCCESS) {
+            if (_replyAppliedStep != 0xFF && _replyAppliedStep > 0 && _replyStepCap >= _replyAppliedStep) {
+                _replyStepCap = _replyAppliedStep - 1;
+                Log::Debug(PSTR("COMM: 응답 전송 실패. 속도 상한 %s."), Comm::kRateLadder[_replyStepCap].name);
+            }
+            _replySuccesses = 0;
+        } else if (_replyStepCap < Comm::kRateLadderSize - 1 && ++_replySuccesses >= RX_RATE_RECOVER_ACKS) {
+            _replyStepCap++;
+            _replySuccesses = 0;
+        }
+    }
     Log::Debug(PSTR("COMM: MAC %02X:%02X:%02X:%02X:%02X:%02X로 ACK 전송 상태: %s"),
         mac_addr[0], mac_addr[1], mac_addr[2], mac_addr[3], mac_addr[4], mac_addr[5],
         status == ESP_NOW_SEND_SUCCESS ? "성공" : "실패");
 }
 
-void CommManager::sendAck(const uint8_t* targetMac, uint32_t original_packet_tx_timestamp, uint32_t rx_time) {
-    Comm::AckPacket ackPacket;
-    
-    uint32_t rxProcessingTime = micros() - rx_time;
-    
-    Comm::fillAckPacket(ackPacket, _myDeviceId, original_packet_tx_timestamp, rxProcessingTime);
+void CommManager::sendAck(const uint8_t* targetMac, uint32_t original_packet_tx_timestamp, uint32_t rx_time, uint32_t slotDelayUs) {
+    if (slotDelayUs == 0 || _ackSlotTimer == nullptr) {
+        transmitAck(targetMac, original_packet_tx_timestamp, rx_time, micros() - rx_time);
+        return;
+    }
+
+    // 이전 슬롯 ACK가 아직 대기 중이면 먼저 보내고 새 ACK를 예약
+    esp_timer_stop(_ackSlotTimer);
+    flushPendingAck();
+
+    portENTER_CRITICAL(&_ackMux);
+    memcpy(_pendingAck.mac, targetMac, 6);
+    _pendingAck.originalTxMicros = original_packet_tx_timestamp;
+    _pendingAck.rxTime = rx_time;
+    _pendingAck.slotDelayUs = slotDelayUs;
+    _pendingAck.valid = true;
+    portEXIT_CRITICAL(&_ackMux);
+
+    // 슬롯 시작 시각은 패킷 수신 시각 기준
+    uint32_t elapsedUs = micros() - rx_time;
+    uint32_t waitUs = (slotDelayUs > elapsedUs) ? slotDelayUs - elapsedUs : 0;
+    if (waitUs == 0 || esp_timer_start_once(_ackSlotTimer, waitUs) != ESP_OK) {
+        flushPendingAck();
+    }
+}
+
+void CommManager::ackSlotTimerCallback(void* arg) {
+    static_cast<CommManager*>(arg)->flushPendingAck();
+}
+
+void CommManager::flushPendingAck() {
+    PendingAck ack;
+    portENTER_CRITICAL(&_ackMux);
+    ack = _pendingAck;
+    _pendingAck.valid = false;
+    portEXIT_CRITICAL(&_ackMux);
+    if (!ack.valid) return;
+
+    // [NEW] 슬롯 대기 시간은 수신기 처리 시간에서 제외 (송신부도 RTT에서 같은 값을 뺌)
+    uint32_t heldUs = micros() - ack.rxTime;
+    uint32_t rxProcessingTime = (heldUs > ack.slotDelayUs) ? heldUs - ack.slotDelayUs : 0;
+    transmitAck(ack.mac, ack.originalTxMicros, ack.rxTime, rxProcessingTime);
+}
+
+void CommManager::transmitAck(const uint8_t* targetMac, uint32_t original_packet_tx_timestamp, uint32_t rx_time, uint32_t rxProcessingTime) {
+    Comm::Frame ackFrame;
+
+    // [NEW] 송신부 시계 동기화용 64비트 수신 시각 (micros()는 esp_timer 값의 하위 32비트)
+    int64_t nowUs = esp_timer_get_time();
+    uint64_t rxLocalUs = (uint64_t)(nowUs - (int64_t)(uint32_t)((uint32_t)nowUs - rx_time));
+
+    // [MODIFIED] ACK에 내 기능 비트맵(TLV)을 붙여 송신부가 사용할 패킷 형식을 고를 수 있게 함
+    size_t ackLen = Comm::buildAckFrame(ackFrame, _myDeviceId, original_packet_tx_timestamp, rxProcessingTime, rxLocalUs);
     
-    if (!esp_now_is_peer_exist(targetMac)) {
-        esp_now_peer_info_t peer = {};
-        memcpy(peer.peer_addr, targetMac, 6);
-        peer.channel = ESP_NOW_CHANNEL;
-        peer.encrypt = false;
-        esp_err_t addStatus = esp_now_add_peer(&peer);
-        if (addStatus != ESP_OK && addStatus != ESP_ERR_ESPNOW_EXIST) {
-            Log::Warn(PSTR("COMM: ACK 피어 추가 실패."));
-            return;
+    if (!ensurePeer(targetMac)) {
+        Log::Warn(PSTR("COMM: ACK 피어 추가 실패."));
+        return;
+    }
+    applyReplyRate(targetMac); // [NEW]
+    esp_err_t result = esp_now_send(targetMac, ackFrame.data, ackLen);
+    _capture.record(Capture::REC_TX, (result == ESP_OK) ? Capture::STATUS_OK : Capture::STATUS_FAILED,
+                    0, targetMac, ackFrame.data, ackLen);
+}
+
+bool CommManager::ensurePeer(const uint8_t* mac) {
+    if (esp_now_is_peer_exist(mac)) return true;
+    esp_now_peer_info_t peer = {};
+    memcpy(peer.peer_addr, mac, 6);
+    peer.channel = 0; // [MODIFIED] 현재 채널
+    peer.encrypt = false;
+    esp_err_t addStatus = esp_now_add_peer(&peer);
+    if (addStatus == ESP_OK) _replyAppliedStep = 0xFF; // [NEW] 새 피어에는 속도 설정이 없음
+    return addStatus == ESP_OK || addStatus == ESP_ERR_ESPNOW_EXIST;
+}
+
+// [NEW] 평활 세기(계수 1/8)가 단계의 수신 감도 + RX_RATE_RSSI_MARGIN_DB 이상인 가장 빠른 단계를 고름.
+// 송신기 ACK를 직접 볼 수 없으므로 세기만으로 고르고, 전송 실패는 handleEspNowSendStatus()의 상한으로 반영
+void CommManager::updateReplyRate(int8_t rssi) {
+    if (!ENABLE_RX_RATE_CONTROL || rssi == 0) return;
+    int16_t sampleX16 = (int16_t)(rssi * 16);
+    _replyRssiX16 = (_replyRssiX16 == 0) ? sampleX16 : (int16_t)(_replyRssiX16 + (sampleX16 - _replyRssiX16) / 8);
+
+    int16_t rssiDbm = _replyRssiX16 / 16;
+    uint8_t step = 0;
+    while (step + 1 < Comm::kRateLadderSize && rssiDbm >= Comm::kRateLadder[step + 1].minRssi + RX_RATE_RSSI_MARGIN_DB) step++;
+    if (step > _replyStepCap) step = _replyStepCap;
+    if (step != _replyStep) {
+        Log::Debug(PSTR("COMM: 응답 속도 %s -> %s (세기 %d dBm)"), Comm::kRateLadder[_replyStep].name, Comm::kRateLadder[step].name, rssiDbm);
+        _replyStep = step;
+    }
+}
+
+void CommManager::applyReplyRate(const uint8_t* mac) {
+    uint8_t step = _replyStep;
+    if (step == _replyAppliedStep) return;
+    if (Comm::applyPeerRate(mac, step)) _replyAppliedStep = step;
+}
+
+// [NEW] 실행 단계 보고. 같은 시퀀스의 명령을 보낸 송신기에게만 보냄
+void CommManager::sendPhaseReport(const uint8_t* targetMac, Comm::ExecPhase phase, uint32_t commandId, int64_t eventLocalUs,
+                                  int64_t fireTargetLocalUs, int32_t compensationUs, uint32_t playMs) {
+    Comm::Frame frame;
+    size_t len = Comm::buildPhaseReportFrame(frame, _myDeviceId, phase, commandId, (uint64_t)eventLocalUs, fireTargetLocalUs, compensationUs, playMs);
+    if (len == 0 || !ensurePeer(targetMac)) {
+        Log::Warn(PSTR("COMM: 실행 단계 보고 전송 준비 실패."));
+        return;
+    }
+    applyReplyRate(targetMac); // [NEW]
+    esp_err_t result = esp_now_send(targetMac, frame.data, len);
+    _capture.record(Capture::REC_TX, (result == ESP_OK) ? Capture::STATUS_OK : Capture::STATUS_FAILED,
+                    0, targetMac, frame.data, len);
+    Log::Debug(PSTR("COMM: 실행 단계 %u 보고 (시퀀스 %lu, 보정값 %ld us): %s"), phase, commandId, (long)compensationUs,
+               (result == ESP_OK) ? "성공" : esp_err_to_name(result));
+}
+
+// [NEW] 시리얼 줄 명령 처리 (캡처 덤프/초기화)
+void CommManager::handleSerialCommands() {
+    while (Serial.available() > 0) {
+        char c = (char)Serial.read();
+        if (c != '\n' && c != '\r') {
+            if (_serialLineLen < sizeof(_serialLine) - 1) _serialLine[_serialLineLen++] = c;
+            continue;
+        }
+        if (_serialLineLen == 0) continue;
+        _serialLine[_serialLineLen] = '\0';
+        _serialLineLen = 0;
+
+        if (strcmp(_serialLine, "capture") == 0) {
+            if (!Capture::dumpHex(_capture, Capture::ROLE_RECEIVER, _myDeviceId, Serial)) {
+                Log::Error(PSTR("CAPTURE: 덤프 버퍼 할당 실패"));
+            }
+        } else if (strcmp(_serialLine, "capture clear") == 0) {
+            _capture.clear();
+            Log::Info(PSTR("CAPTURE: 캡처 링 초기화"));
         }
     }
-    esp_now_send(targetMac, (uint8_t*)&ackPacket, sizeof(ackPacket));
 }
@@ -1,7 +1,7 @@
 /**
  * @file comm.h
  * @brief ESP-NOW 통신을 위한 CommManager 클래스의 헤더 파일입니다.
- * @version 4.1.0 // [MODIFIED] 버전 업데이트
+ * @version 4.5.0 // [MODIFIED] 그룹 등록(GROUP_CONFIG), 그룹 주소 명령
  * @date 2024-06-13
  */
 #pragma once
@@ -9,9 +9,13 @@
 #define COMM_H
 
 #include <esp_now.h>
+#include <esp_timer.h>
 #include <WiFi.h>
 #include "config.h"
 #include "espnow_comm_shared.h"
+#include "capture_shared.h"
+
+static_assert(SEQ_DEDUP_WINDOW <= 64, "SEQ_DEDUP_WINDOW must fit in a 64-bit bitmap");
 
 class ModeManager;
 
@@ -38,11 +42,95 @@ public:
     void handleEspNowSendStatus(const uint8_t* mac_addr, esp_now_send_status_t status);
     
     // [수정] sendAck 함수를 public으로 변경
-    void sendAck(const uint8_t* targetMac, uint32_t original_packet_tx_timestamp, uint32_t rx_time);
+    // [MODIFIED] slotDelayUs > 0이면 해당 시간만큼 기다렸다가 ACK 전송 (일괄 명령의 ACK 충돌 방지)
+    void sendAck(const uint8_t* targetMac, uint32_t original_packet_tx_timestamp, uint32_t rx_time, uint32_t slotDelayUs = 0);
+    // [NEW] 실행 단계 보고 전송 (ACK 없음, 유실되면 송신부는 로컬 타이머로 대체). 여러 태스크에서 호출 가능
+    void sendPhaseReport(const uint8_t* targetMac, Comm::ExecPhase phase, uint32_t commandId, int64_t eventLocalUs,
+                         int64_t fireTargetLocalUs, int32_t compensationUs, uint32_t playMs);
+
+    // [NEW] 패킷 캡처: 출력 시작 기록, 덤프(sink(const uint8_t*, size_t)로 출력), 초기화
+    void captureFire(uint32_t commandId, int64_t targetUs, int64_t actualUs) { _capture.recordFire(commandId, targetUs, actualUs); }
+    template<typename Sink>
+    bool dumpCapture(Sink&& sink) { return _capture.dump(Capture::ROLE_RECEIVER, _myDeviceId, sink); }
+    void clearCapture() { _capture.clear(); }
+    // [NEW] 시리얼 명령 확인 ("capture": 16진수 덤프, "capture clear": 초기화). loop에서 호출
+    void handleSerialCommands();
+    // [NEW] 예약된 채널 전환 실행, 송신기를 잃으면 채널을 돌며 비콘 탐색. loop에서 호출
+    void update();
+    uint8_t getChannel() const { return _channel; }
+    uint32_t getGroups(const uint8_t* senderMac); // [NEW] 이 송신기가 등록한 그룹 비트맵 (bit 그룹번호-1)
     
 private:
+    // [NEW] 슬롯 대기 중인 ACK
+    struct PendingAck {
+        uint8_t  mac[6];
+        uint32_t originalTxMicros;
+        uint32_t rxTime;
+        uint32_t slotDelayUs;
+        bool     valid;
+    };
+
+    // [NEW] 송신기(MAC)별 시퀀스 번호 슬라이딩 중복 검사 창
+    struct SenderSeqWindow {
+        uint8_t  mac[6];
+        uint32_t highestSeq;
+        uint64_t seenBitmap;    // bit n = (highestSeq - n) 수신 여부
+        uint32_t lastSeenMs;
+        bool     inUse;
+    };
+
+    // [NEW] 송신기(MAC)별 그룹 등록. 그룹 번호는 송신기마다 따로 매기므로 등록한 송신기의 그룹 명령에만 응함
+    struct GroupOwner {
+        uint8_t  mac[6];
+        uint32_t groups;        // bit 그룹번호-1, 0이면 빈 항목
+    };
+
     ModeManager* _modeManager;
     uint8_t _myDeviceId;
+    // [NEW] 그룹 등록 표. 수신 콜백이 바꾸고 NVS 저장은 update()가 처리
+    GroupOwner _groupOwners[MAX_GROUP_OWNERS];
+    volatile bool _groupsDirty;
+    portMUX_TYPE _groupMux;
+    SenderSeqWindow _seqWindows[MAX_TRACKED_SENDERS];
+    esp_timer_handle_t _ackSlotTimer;
+    PendingAck _pendingAck;
+    portMUX_TYPE _ackMux;
+    Capture::Ring<CAPTURE_RING_SLOTS, CAPTURE_SNAP_LEN> _capture; // [NEW] 송수신 패킷 캡처 링
+    char _serialLine[24];
+    uint8_t _serialLineLen;
+    // [NEW] 채널 상태. 수신 콜백은 예약/비콘/수신 시각만 기록하고 채널 변경은 update()가 처리
+    uint8_t _channel;
+    volatile uint8_t _pendingHopChannel;    // 0이면 예약 없음
+    volatile uint32_t _pendingHopAtMs;
+    volatile uint8_t _beaconChannel;        // 마지막 비콘이 알려준 송신기 채널 (update()가 읽으면 0)
+    volatile uint32_t _lastHeardMs;         // 송신기 프레임을 마지막으로 받은 시각
+    bool _scanning;
+    uint32_t _scanDwellStartMs;
+    portMUX_TYPE _channelMux;
+    // [NEW] 응답(ACK, 단계 보고) 전송 속도. 송신기 프레임 세기로 단계를 고르고, 링크 계층 전송 실패 시 상한을 낮춤
+    int16_t _replyRssiX16;                  // 평활 송신기 프레임 세기 (1/16 dBm, 0이면 아직 없음)
+    uint8_t _replyStep;                     // 현재 단계 (Comm::kRateLadder 인덱스)
+    uint8_t _replyStepCap;                  // 전송 실패로 낮춘 상한
+    uint8_t _replyAppliedStep;              // 송신기 피어에 적용된 단계 (0xFF면 다시 적용)
+    uint8_t _replySuccesses;                // 상한 아래에서 연속 전송 성공 수
+
+    bool isDuplicateSeq(const uint8_t* mac, uint32_t seq);
+    // [NEW] 송신기의 그룹 등록/해제. 새 송신기를 받을 빈 항목이 없으면 false
+    bool setGroupMember(const uint8_t* senderMac, uint8_t groupId, bool member, uint32_t& groups);
+    // [NEW] 비상 정지 패킷 처리 (출력 차단 -> 캡처 -> 슬롯 ACK 순서)
+    void handleStopCommand(const esp_now_recv_info_t* recv_info, const uint8_t* incomingData, int len, uint32_t rxTime);
+    // [NEW] 실행 패킷 처리 (저장된 실행 정보로 타이머 시작 -> 캡처 -> 슬롯 ACK 순서)
+    void handleGoCommand(const esp_now_recv_info_t* recv_info, const uint8_t* incomingData, int len, uint32_t rxTime);
+    // [NEW] 채널 전환 예고 (ACK 후 전환 시각 예약), 채널 비콘 처리
+    void handleChannelHop(const esp_now_recv_info_t* recv_info, const uint8_t* incomingData, int len, uint32_t rxTime);
+    void handleChannelBeacon(const uint8_t* incomingData, int len);
+    bool setChannel(uint8_t channel, bool persist);
+    static void ackSlotTimerCallback(void* arg);
+    void flushPendingAck();
+    void transmitAck(const uint8_t* targetMac, uint32_t original_packet_tx_timestamp, uint32_t rx_time, uint32_t rxProcessingTime);
+    bool ensurePeer(const uint8_t* mac); // [NEW] 응답을 보낼 송신기를 피어로 등록
+    void updateReplyRate(int8_t rssi);   // [NEW] 송신기 프레임 세기로 응답 속도 단계 갱신
+    void applyReplyRate(const uint8_t* mac); // [NEW] 응답 직전 피어에 속도 단계 적용
     // ESP-NOW 스택 초기화
     bool initEspNowStack();
     // 콜백 함수 등록
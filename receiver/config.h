@@ -49,7 +49,19 @@
 #define MAX_DEVICE_ID       10 
 
 // --- ESP-NOW 설정 ---
-#define ESP_NOW_CHANNEL     1
+#define ESP_NOW_CHANNEL     1   // [MODIFIED] 저장된 채널이 없을 때의 기본 채널 (송신기가 CHANNEL_HOP으로 옮길 수 있음)
+#define RX_CHANNEL_LOST_MS  3000 // [NEW] 송신기 비콘/프레임을 이 시간 동안 받지 못하면 채널을 돌며 송신기를 찾음
+#define RX_CHANNEL_SCAN_DWELL_MS 1200 // [NEW] 탐색 중 채널당 머무는 시간 (송신기 비콘 간격의 2배 이상)
+#define MAX_TRACKED_SENDERS 4   // 시퀀스 중복 검사를 위해 추적하는 송신기(MAC) 수
+#define MAX_GROUP_OWNERS    4   // [NEW] 그룹을 등록할 수 있는 송신기(MAC) 수 (그룹 번호는 송신기마다 따로 매김)
+#define SEQ_DEDUP_WINDOW    64  // 송신기별 중복 검사 창 크기 (최근 시퀀스 번호 개수)
+#define CLOCK_SYNC_SANITY_MS 500 // 절대 실행 시각이 RTT 보정 기반 예상 시각과 이보다 크게 다르면 보정값 방식으로 대체
+#define STOP_GUARD_MS       5000 // 비상 정지 후 이 시간 동안은 정지 전에 눌린 명령(늦게 도착한 패킷)을 무시
+#define ENABLE_RX_RATE_CONTROL true // [NEW] 송신기 프레임 세기로 ACK/단계 보고의 전송 속도를 고름 (false면 1 Mbps 고정)
+#define RX_RATE_RSSI_MARGIN_DB 8    // [NEW] 속도 단계의 수신 감도보다 이만큼 세야 그 단계를 사용 (dB)
+#define RX_RATE_RECOVER_ACKS   20   // [NEW] 전송 실패로 낮춘 속도 상한을 한 단계 올리기까지 필요한 연속 성공 수
+#define CAPTURE_RING_SLOTS  128 // 패킷 캡처 링 크기 (2의 거듭제곱, 가장 오래된 레코드부터 덮어씀)
+#define CAPTURE_SNAP_LEN    64  // 레코드당 저장하는 최대 프레임 바이트
 static const uint8_t BROADCAST_ADDRESS[6] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
 
 // --- WI-FI 및 WEB UI 설정 ---
@@ -1,7 +1,7 @@
 /**
  * @file espnow_comm_shared.h
  * @brief ESP-NOW 통신을 위한 공유 구조체 및 헬퍼 (지연시간 보정 기능 추가)
- * @version 6.0.0 // [MODIFIED] 버전 업데이트
+ * @version 8.7.0 // [MODIFIED] 그룹 주소 명령, 수신기 그룹 등록(GROUP_CONFIG)
  * @date 2024-06-13
  */
 #pragma once
@@ -10,7 +10,16 @@
 
 #include <stdint.h>
 #include <string.h>
+#include <stddef.h>
+#include <limits.h>
+#include <type_traits>
+#if defined(ARDUINO)
 #include <Arduino.h>
+#include <esp_now.h>
+#else
+// [NEW] 호스트 도구(tools/)에서 프로토콜 정의만 사용할 때는 도구가 micros()를 제공
+unsigned long micros();
+#endif
 
 namespace Comm {
 
@@ -18,131 +27,1146 @@ namespace Comm {
 //  서명 및 버전
 //---------------------------------------------------------------------
 static constexpr uint8_t kSig[4]   = { 'M','L','A','B' }; // "MLAB"
-static constexpr uint8_t kVersion  = 0x03; // [MODIFIED] 레이아웃 변경으로 버전 업데이트
+static constexpr uint8_t kVersion  = 0x08; // [MODIFIED] 패킷 타입별 무결성 검사로 버전 업데이트
+
+// [NEW] 이 버전부터는 고정 필드를 뒤에만 추가하고 새 정보는 TLV로 붙이므로,
+// 수신 측은 버전이 같지 않아도 kMinCompatibleVersion 이상이면 아는 부분만 읽고 나머지는 건너뜁니다.
+static constexpr uint8_t kMinCompatibleVersion = 0x07;
+
+// [NEW] 구 펌웨어(고정 32바이트 CommPacket)의 버전. 송신부는 기능 협상에 실패한 수신기와 이 형식으로 통신
+static constexpr uint8_t kLegacyVersion = 0x03;
+
+// [NEW] 이 버전 이상의 프레임은 패킷 타입별 무결성 검사를 사용 (그 전 버전은 모두 crc8)
+static constexpr uint8_t kTypedIntegrityVersion = 0x08;
+
+// [NEW] 시계 오프셋을 아직 모를 때 clockOffsetUs에 넣는 값 (수신부는 RTT 기반 보정으로 대체)
+static constexpr int64_t kNoClockOffset = INT64_MIN;
+
+// [NEW] ESP-NOW 최대 페이로드
+static constexpr size_t kMaxFrameSize = 250;
+
+// [NEW] 사용할 수 있는 Wi-Fi 채널 범위 (2.4 GHz)
+static constexpr uint8_t kMinWifiChannel = 1;
+static constexpr uint8_t kMaxWifiChannel = 13;
+
+//---------------------------------------------------------------------
+//  [NEW] 기능 비트맵 (수신기가 ACK의 TLV_CAPABILITIES로 알려줌)
+//---------------------------------------------------------------------
+enum Capability : uint32_t {
+    CAP_BATCH_COMMAND = 1UL << 0,  // BATCH_COMMAND 수신 및 슬롯 ACK
+    CAP_ABSOLUTE_TIME = 1UL << 1,  // 시계 오프셋을 이용한 절대 시각 실행
+    CAP_ELAPSED_COMP  = 1UL << 2,  // 버튼 눌림 후 경과 시간 보정
+    CAP_SEQ_DEDUP     = 1UL << 3,  // 시퀀스 번호 기반 중복 제거
+    CAP_STOP_COMMAND  = 1UL << 4,  // [NEW] STOP_COMMAND 수신 시 즉시 출력 차단
+    CAP_PHASE_REPORT  = 1UL << 5,  // [NEW] 실행 단계가 바뀔 때마다 PHASE_REPORT 전송
+    CAP_CHANNEL_HOP   = 1UL << 6,  // [NEW] CHANNEL_HOP으로 채널을 옮기고, 송신기를 잃으면 채널을 돌며 비콘을 찾음
+    CAP_ARM_GO        = 1UL << 7,  // [NEW] ARM_CUE로 받은 실행 정보를 저장했다가 GO_COMMAND로 실행
+    CAP_GROUP_ADDRESS = 1UL << 8   // [NEW] GROUP_CONFIG로 받은 그룹 번호를 저장하고 그룹 주소 명령을 받음
+};
+
+// 이 펌웨어가 지원하는 기능
+static constexpr uint32_t kLocalCapabilities = CAP_BATCH_COMMAND | CAP_ABSOLUTE_TIME | CAP_ELAPSED_COMP | CAP_SEQ_DEDUP | CAP_STOP_COMMAND | CAP_PHASE_REPORT | CAP_CHANNEL_HOP | CAP_ARM_GO | CAP_GROUP_ADDRESS;
+
+//---------------------------------------------------------------------
+//  [NEW] TLV 확장 타입 (고정 필드 뒤, 검사값 앞에 위치: type(1) + len(1) + value(len))
+//  모르는 타입은 길이만큼 건너뜁니다.
+//---------------------------------------------------------------------
+enum TlvType : uint8_t {
+    TLV_CAPABILITIES = 0x01,       // uint32_t 기능 비트맵
+    TLV_ACK_SLOT_US  = 0x02        // [NEW] uint16_t 그룹 주소 명령의 ACK 슬롯 폭 (수신기는 (내 ID - 1)번째 슬롯에서 ACK)
+};
+
+//---------------------------------------------------------------------
+//  [MODIFIED] 무결성 검사 (컴파일 타임에 생성한 256항목 테이블로 바이트당 한 번 조회)
+//  - Crc8 : Dallas/Maxim CRC-8 (다항식 0x31 반전, 초기값 0x00) - 기존과 같은 값
+//  - Crc16: CRC-16/CCITT-FALSE (다항식 0x1021, 초기값 0xFFFF) - 큰 패킷용
+//  250바이트 이하 프레임에서는 CRC-16으로 해밍 거리 4가 보장되므로 CRC-32는 두지 않음 (tools/crc_bench.cpp 참고)
+//  검사값은 프레임 끝에 리틀 엔디언으로 붙습니다.
+//---------------------------------------------------------------------
+template<typename T>
+struct CrcTable {
+    T entries[256];
+};
+
+// LSB 우선(반전) 방식 테이블
+template<typename T>
+constexpr CrcTable<T> makeReflectedCrcTable(T poly) {
+    CrcTable<T> table = {};
+    for (uint32_t i = 0; i < 256; ++i) {
+        T crc = (T)i;
+        for (uint8_t bit = 0; bit < 8; ++bit) crc = (crc & 1) ? (T)((crc >> 1) ^ poly) : (T)(crc >> 1);
+        table.entries[i] = crc;
+    }
+    return table;
+}
+
+// MSB 우선 방식 테이블
+template<typename T>
+constexpr CrcTable<T> makeNormalCrcTable(T poly) {
+    constexpr T kTopBit = (T)((T)1 << (8 * sizeof(T) - 1));
+    CrcTable<T> table = {};
+    for (uint32_t i = 0; i < 256; ++i) {
+        T crc = (T)((T)i << (8 * sizeof(T) - 8));
+        for (uint8_t bit = 0; bit < 8; ++bit) crc = (crc & kTopBit) ? (T)((crc << 1) ^ poly) : (T)(crc << 1);
+        table.entries[i] = crc;
+    }
+    return table;
+}
+
+struct Crc8 {
+    using Value = uint8_t;
+    static constexpr size_t kSize = 1;
+    static constexpr CrcTable<uint8_t> kTable = makeReflectedCrcTable<uint8_t>(0x8C); // 0x31 반전됨
+
+    Value value = 0x00;
+    void update(uint8_t inbyte) { value = kTable.entries[value ^ inbyte]; }
+    Value result() const { return value; }
+};
+
+struct Crc16 {
+    using Value = uint16_t;
+    static constexpr size_t kSize = 2;
+    static constexpr CrcTable<uint16_t> kTable = makeNormalCrcTable<uint16_t>(0x1021);
+
+    Value value = 0xFFFF;
+    void update(uint8_t inbyte) { value = (Value)((value << 8) ^ kTable.entries[(uint8_t)(value >> 8) ^ inbyte]); }
+    Value result() const { return value; }
+};
+
+// 프레임을 조립할 때 남겨두는 검사값 자리 (가장 긴 검사값)
+static constexpr size_t kMaxIntegritySize = Crc16::kSize;
+
+// 검사값이 필요 없는 인코딩/디코딩용 (TLV 값, 이미 검증된 프레임의 항목 등)
+struct NoIntegrity {
+    void update(uint8_t) {}
+};
+
+template<typename Crc>
+inline void crcUpdate(Crc &crc, const uint8_t *data, size_t len) {
+    while (len--) crc.update(*data++);
+}
+
+template<typename Crc>
+inline void storeCrc(const Crc &crc, uint8_t *out) {
+    typename Crc::Value value = crc.result();
+    for (size_t i = 0; i < Crc::kSize; ++i) out[i] = (uint8_t)(value >> (8 * i));
+}
+
+template<typename Crc>
+inline bool crcMatches(const Crc &crc, const uint8_t *stored) {
+    typename Crc::Value value = crc.result();
+    for (size_t i = 0; i < Crc::kSize; ++i) {
+        if (stored[i] != (uint8_t)(value >> (8 * i))) return false;
+    }
+    return true;
+}
+
+inline uint8_t crc8(const uint8_t *data, size_t len) {
+    Crc8 crc;
+    crcUpdate(crc, data, len);
+    return crc.result();
+}
 
 //---------------------------------------------------------------------
-//  패킷 레이아웃 (일관성을 위해 팩킹됨)
+//  [NEW] 컴파일 타임 스키마 코덱
+//  패킷 구조체는 정렬된 일반 구조체이고, 전송 형식(필드 순서, 리틀 엔디언, 패딩 없음)은
+//  아래 스키마가 정합니다. 인코딩/디코딩은 바이트 단위로 읽고 쓰므로 수신 버퍼의 정렬과
+//  CPU 엔디언에 관계없이 안전하며, 디코딩할 때는 같은 루프에서 검사값도 함께 계산합니다.
 //---------------------------------------------------------------------
-#pragma pack(push, 1)
+template<typename T>
+struct WireCodec {
+    static_assert(std::is_integral<T>::value, "WireCodec: 정수 타입만 지원");
+    using U = typename std::make_unsigned<T>::type;
+    static constexpr size_t kSize = sizeof(T);
 
+    template<typename Crc>
+    static void store(uint8_t* out, const T& value, Crc& crc) {
+        U v = (U)value;
+        for (size_t i = 0; i < kSize; ++i) {
+            out[i] = (uint8_t)(v >> (8 * i));
+            crc.update(out[i]);
+        }
+    }
+    template<typename Crc>
+    static void load(const uint8_t* in, T& value, Crc& crc) {
+        U v = 0;
+        for (size_t i = 0; i < kSize; ++i) {
+            v |= (U)in[i] << (8 * i);
+            crc.update(in[i]);
+        }
+        value = (T)v;
+    }
+};
+
+template<size_t N>
+struct WireCodec<uint8_t[N]> {
+    static constexpr size_t kSize = N;
+
+    template<typename Crc>
+    static void store(uint8_t* out, const uint8_t (&value)[N], Crc& crc) {
+        for (size_t i = 0; i < N; ++i) {
+            out[i] = value[i];
+            crc.update(out[i]);
+        }
+    }
+    template<typename Crc>
+    static void load(const uint8_t* in, uint8_t (&value)[N], Crc& crc) {
+        for (size_t i = 0; i < N; ++i) {
+            value[i] = in[i];
+            crc.update(in[i]);
+        }
+    }
+};
+
+template<typename M> struct MemberTraits;
+template<typename S, typename T> struct MemberTraits<T S::*> {
+    using Struct = S;
+    using Type = T;
+};
+
+// 구조체 멤버 하나 (전송 위치는 스키마에서 나열한 순서로 정해짐)
+template<auto Member>
+struct Field {
+    using Struct = typename MemberTraits<decltype(Member)>::Struct;
+    using Type = typename MemberTraits<decltype(Member)>::Type;
+    static constexpr size_t kSize = WireCodec<Type>::kSize;
+
+    template<typename S, typename Crc>
+    static void encode(const S& s, uint8_t* out, Crc& crc) { WireCodec<Type>::store(out, s.*Member, crc); }
+    template<typename S, typename Crc>
+    static void decode(const uint8_t* in, S& s, Crc& crc) { WireCodec<Type>::load(in, s.*Member, crc); }
+};
+
+template<typename S, typename... Fields>
+struct Schema {
+    static_assert(sizeof...(Fields) > 0, "Schema: 필드가 없음");
+    static_assert((std::is_base_of<typename Fields::Struct, S>::value && ...), "Schema: 다른 구조체의 필드가 섞임");
+
+    using Struct = S;
+    static constexpr size_t kWireSize = (Fields::kSize + ...);
+
+    // I번째 필드의 전송 위치
+    template<size_t I>
+    static constexpr size_t offsetOf() {
+        static_assert(I < sizeof...(Fields), "Schema: 필드 번호 범위 초과");
+        constexpr size_t sizes[] = { Fields::kSize... };
+        size_t offset = 0;
+        for (size_t i = 0; i < I; ++i) offset += sizes[i];
+        return offset;
+    }
+
+    template<typename Crc = NoIntegrity>
+    static void encode(const S& s, uint8_t* out, Crc&& crc = Crc()) {
+        size_t pos = 0;
+        ((Fields::encode(s, out + pos, crc), pos += Fields::kSize), ...);
+    }
+    template<typename Crc = NoIntegrity>
+    static void decode(const uint8_t* in, S& s, Crc&& crc = Crc()) {
+        size_t pos = 0;
+        ((Fields::decode(in + pos, s, crc), pos += Fields::kSize), ...);
+    }
+};
+
+//---------------------------------------------------------------------
+//  패킷 구조체 (정렬된 메모리 표현, 전송 형식은 스키마 참고)
+//  모든 패킷: [공통 헤더 | 타입별 고정 필드 (fixedLen까지)] [TLV ...] [검사값 (integrityFor)]
+//---------------------------------------------------------------------
 // [NEW] 패킷 타입 열거형
 enum PacketType : uint8_t {
     RTT_REQUEST = 0x01,  // RTT 측정을 위한 요청 패킷
-    FINAL_COMMAND = 0x02 // 최종 명령 실행을 위한 패킷 (보정값 포함)
+    FINAL_COMMAND = 0x02, // 최종 명령 실행을 위한 패킷 (보정값 포함)
+    BATCH_COMMAND = 0x03, // [NEW] 여러 장치의 최종 명령을 하나로 묶은 패킷
+    STOP_COMMAND = 0x04,  // [NEW] 비상 정지 (대상 장치는 즉시 출력을 끄고 진행 중인 시퀀스를 중단)
+    CHANNEL_HOP = 0x05,   // [NEW] 채널 전환 예고 (대상 장치는 ACK 후 정해진 시각에 새 채널로 이동)
+    CHANNEL_BEACON = 0x06, // [NEW] 송신기 채널 알림 (유휴 중에도 주기적으로 브로드캐스트, ACK 없음)
+    ARM_CUE = 0x07,       // [NEW] 유휴 중 미리 보내는 장치별 실행 정보 (딜레이, 플레이, 보정값, 시계 오프셋)
+    GO_COMMAND = 0x08,    // [NEW] 저장된 실행 정보로 실행 (버튼 눌림 시각만 싣는 짧은 브로드캐스트)
+    GROUP_CONFIG = 0x09,  // [NEW] 수신기 그룹 등록/해제 (수신기가 NVS에 저장)
+    ACK = 0x80,           // [NEW] 확인 응답 (공통 헤더 사용을 위해 타입 부여)
+    PHASE_REPORT = 0x81   // [NEW] 수신기 실행 단계 보고 (수신기 -> 송신기, ACK 없음)
 };
 
-// 명령 패킷 (송신기 -> 수신기)
-struct CommPacket {
+// [NEW] PHASE_REPORT의 실행 단계 (한 시퀀스에서 값이 커지는 순서로 진행)
+enum ExecPhase : uint8_t {
+    PHASE_ARMED        = 1,  // 명령을 적용하고 딜레이 시작 (목표 실행 시각과 적용한 보정값 포함)
+    PHASE_PLAY_STARTED = 2,  // MOSFET을 켬
+    PHASE_PLAY_ENDED   = 3,  // 플레이 시간을 채우고 MOSFET을 끔
+    PHASE_ABORTED      = 4   // 중간에 중단됨 (비상 정지, 버튼, 새 시퀀스) 또는 실행 시각이 지나 실행하지 않음
+};
+
+// [NEW] 프레임 끝의 무결성 검사 종류
+enum IntegrityKind : uint8_t {
+    INTEGRITY_CRC8,
+    INTEGRITY_CRC16
+};
+
+// [NEW] 프레임 버전과 패킷 타입으로 무결성 검사 종류 결정 (송신부와 수신부가 같은 표를 사용)
+// 여러 장치의 항목이 들어가는 BATCH_COMMAND는 길이가 커서 CRC-16을 사용합니다.
+inline constexpr IntegrityKind integrityFor(uint8_t version, uint8_t packetType) {
+    if (version < kTypedIntegrityVersion) return INTEGRITY_CRC8;
+    return (packetType == BATCH_COMMAND) ? INTEGRITY_CRC16 : INTEGRITY_CRC8;
+}
+
+inline constexpr size_t integritySize(IntegrityKind kind) {
+    return (kind == INTEGRITY_CRC16) ? Crc16::kSize : Crc8::kSize;
+}
+
+// [NEW] 모든 패킷의 공통 헤더
+struct PacketHeader {
     uint8_t  signature[4];
     uint8_t  version;
-    uint8_t  packetType;                // [NEW] 패킷 타입
+    uint8_t  packetType;
+    uint8_t  fixedLen;                  // 헤더를 포함한 고정 필드 길이 (이후부터 TLV 영역)
+};
+
+// 명령 패킷 (송신기 -> 수신기)
+struct CommPacket : PacketHeader {      // [MODIFIED] 공통 헤더 상속
     uint8_t  targetId;
+    uint32_t seq;                       // [NEW] 송신기별 메시지 시퀀스 번호 (재전송 시 동일 값 유지)
     uint32_t txButtonPressMicros;       // [NEW] 버튼이 눌린 시점의 송신부 micros() 타임스탬프
     uint32_t txMicros;                  // 패킷 전송 시점의 송신부 micros() 타임스탬프
+    uint32_t elapsedSincePressUs;       // [NEW] 버튼 눌림부터 이 패킷 전송까지 경과 시간 (재전송마다 새로 기록)
     uint32_t delayMs;
     uint32_t playMs;
     uint32_t lastKnownRttUs;            // [수정] RTT_REQUEST에서는 0, FINAL_COMMAND에서는 측정된 RTT
     uint32_t lastKnownRxProcessingTimeUs; // [수정] RTT_REQUEST에서는 0, FINAL_COMMAND에서는 측정된 수신기 처리 시간
-    uint8_t  crc8;
+    uint64_t fireAtTxUs;                // [NEW] 송신부 esp_timer 기준 절대 실행 시각 (딜레이 종료 시점)
+    int64_t  clockOffsetUs;             // [NEW] 실행 시각에서의 (수신부 시계 - 송신부 시계) 추정값
 };
 
 // 확인 응답 패킷 (수신기 -> 송신기)
-struct AckPacket {
-    uint8_t  signature[4];
-    uint8_t  version;
+struct AckPacket : PacketHeader {       // [MODIFIED] 공통 헤더 상속
     uint8_t  senderId;
     uint32_t originalTxMicros;          // 원본 CommPacket의 txMicros 값
     uint32_t rxProcessingTimeUs;        // [수정됨] 수신기가 CMD를 받고 ACK를 보내기까지 걸린 처리 시간
-    uint8_t  crc8;
+    uint64_t rxLocalUs;                 // [NEW] 수신부 esp_timer 기준 CMD 수신 시각 (시계 동기화용 T2)
 };
 
-#pragma pack(pop)
+// [NEW] 일괄 명령 패킷의 장치별 항목
+struct BatchEntry {
+    uint8_t  targetId;
+    uint32_t delayMs;
+    uint32_t playMs;
+    uint32_t compensationUs;            // 송신부가 계산한 총 보정값 (RTT/2 + 수신기 처리 시간)
+    int64_t  clockOffsetUs;             // [NEW] 이 수신기의 시계 오프셋 추정값 (kNoClockOffset이면 보정값 사용)
+};
+
+// [NEW] 일괄 명령 패킷 (송신기 -> 여러 수신기)
+// 항목은 entryCount개만 전송되고 entrySize 간격으로 놓이므로, 이후 버전에서 항목이 길어져도 앞부분은 읽을 수 있습니다.
+// 항목별 실행 시각은 pressAtTxUs + delayMs (송신부 시계 기준)입니다.
+static constexpr uint8_t kMaxBatchEntries = 9; // [MODIFIED] CRC-16 검사값(2바이트)까지 250바이트 안에 들어가도록 10에서 줄임
+
+struct BatchCommandPacket : PacketHeader { // [MODIFIED] 공통 헤더 상속
+    uint32_t seq;                       // [NEW] 송신기별 메시지 시퀀스 번호
+    uint32_t targetBitmap;              // bit (ID-1)이 1이면 해당 ID가 이 패킷에 포함됨
+    uint32_t txButtonPressMicros;
+    uint32_t txMicros;
+    uint32_t elapsedSincePressUs;       // [NEW] 버튼 눌림부터 이 패킷 전송까지 경과 시간 (모든 항목 공통)
+    uint64_t pressAtTxUs;               // [NEW] 송신부 esp_timer 기준 버튼 눌림 시각
+    uint16_t ackSlotUs;                 // [NEW] 수신기별 ACK 시간 슬롯 폭 (0이면 즉시 ACK)
+    uint8_t  entryCount;
+    uint8_t  entrySize;                 // [NEW] 전송되는 항목 하나의 크기 (BatchEntrySchema::kWireSize 이상)
+    BatchEntry entries[kMaxBatchEntries]; // 송신 시에만 사용 (수신 시에는 내 항목만 따로 디코딩)
+};
+
+// [NEW] 실행 단계 보고 (수신기 -> 송신기). 시각은 모두 수신부 esp_timer 기준이며 송신부가 시계 오프셋으로 환산
+struct PhaseReport : PacketHeader {
+    uint8_t  senderId;
+    uint8_t  phase;                     // ExecPhase
+    uint32_t commandId;                 // 송신부 버튼 눌림 micros (시퀀스 구분)
+    uint64_t eventLocalUs;              // 단계가 바뀐 시각
+    int64_t  fireTargetLocalUs;         // 목표 실행 시각 (딜레이 종료)
+    int32_t  compensationUs;            // 실제로 적용한 보정값 (원래 딜레이 - 수신 시각부터 목표 실행 시각까지)
+    uint32_t playMs;                    // 실제 플레이 시간 (늦게 받아 잘렸으면 설정값보다 짧음)
+};
 
-// 모든 플랫폼에서 구조체 크기가 예상대로인지 확인
-// CommPacket 크기는 packetType 추가로 인해 변경됨
-static_assert(sizeof(CommPacket) == 32, "CommPacket size mismatch"); // 31 + 1 (packetType) = 32 bytes
-static_assert(sizeof(AckPacket) == 15, "AckPacket size mismatch");
+// [NEW] 비상 정지 패킷 (송신기 -> 여러 수신기, 브로드캐스트로 확인될 때까지 반복 전송)
+// 같은 정지를 여러 번 받아도 결과가 같으므로 시퀀스 번호 없이 매번 처리하고 ACK합니다.
+static constexpr uint32_t kStopAllDevices = 0xFFFFFFFFUL; // 모든 ID (그룹에 없는 장치 포함)
+
+struct StopPacket : PacketHeader {
+    uint32_t targetBitmap;              // bit (ID-1)이 1이면 해당 ID가 정지 대상
+    uint32_t txMicros;                  // 패킷 전송 시점의 송신부 micros() (ACK의 originalTxMicros로 돌아옴)
+    uint16_t ackSlotUs;                 // 수신기별 ACK 시간 슬롯 폭 (비트맵 순서, 0이면 즉시 ACK)
+};
+
+// [NEW] 채널 전환 패킷 (송신기 -> 여러 수신기, 전환 시각까지 ACK를 모으며 반복 전송)
+// 수신기는 switchInMs 뒤에 newChannel로 옮김. 재전송마다 switchInMs가 줄어 모든 장치가 같은 시각에 옮김
+struct ChannelHopPacket : PacketHeader {
+    uint32_t targetBitmap;              // bit (ID-1)이 1이면 해당 ID가 전환 대상
+    uint32_t txMicros;                  // 패킷 전송 시점의 송신부 micros() (ACK의 originalTxMicros로 돌아옴)
+    uint16_t ackSlotUs;                 // 수신기별 ACK 시간 슬롯 폭 (비트맵 순서)
+    uint8_t  newChannel;
+    uint16_t switchInMs;                // 이 패킷 전송 후 전환까지 남은 시간
+};
+
+// [NEW] 채널 비콘. 채널이 겹쳐 옆 채널에서 들려도 수신기가 송신기의 실제 채널로 옮길 수 있도록 채널 번호를 실음
+struct ChannelBeacon : PacketHeader {
+    uint8_t  channel;                   // 송신기의 현재 채널
+    uint32_t txMicros;
+};
+
+// [NEW] 실행 정보 예약 패킷 (송신기 -> 수신기 하나, 유휴 중 전송하고 ACK로 확인)
+// 수신기는 마지막으로 받은 것 하나만 보관하고, armId가 같은 GO_COMMAND를 받으면 이 값으로 실행합니다.
+// 시계 오프셋은 offsetRefTxUs 시점의 값이며 실행 시각까지 driftPpb로 외삽합니다.
+struct ArmCuePacket : PacketHeader {
+    uint8_t  targetId;
+    uint32_t seq;                       // 송신기별 메시지 시퀀스 번호 (재전송 시 동일 값 유지)
+    uint32_t txMicros;                  // 패킷 전송 시점의 송신부 micros() (ACK의 originalTxMicros로 돌아옴)
+    uint32_t armId;                     // 무장 회차 (GO_COMMAND의 armId와 같아야 실행)
+    uint32_t delayMs;
+    uint32_t playMs;
+    uint32_t compensationUs;            // 송신부가 계산한 보정값 (RTT/2 + 수신기 처리 시간)
+    int64_t  clockOffsetUs;             // offsetRefTxUs에서의 (수신부 시계 - 송신부 시계), 모르면 kNoClockOffset
+    uint64_t offsetRefTxUs;             // 오프셋 기준 시각 (송신부 esp_timer)
+    int32_t  driftPpb;                  // 상대 드리프트 (수신부가 빠르면 양수)
+};
+
+// [NEW] 실행 패킷 (송신기 -> 여러 수신기, 모두 ACK하거나 GO_MAX_ATTEMPTS번 보낼 때까지 반복 전송)
+// 장치별 값은 ARM_CUE로 미리 보냈으므로 장치 수와 관계없이 크기가 같습니다.
+struct GoPacket : PacketHeader {
+    uint32_t targetBitmap;              // bit (ID-1)이 1이면 해당 ID가 실행 대상
+    uint32_t armId;                     // 대상 장치가 보관하고 있어야 하는 무장 회차
+    uint32_t txButtonPressMicros;       // 버튼 눌림 micros() (시퀀스 구분, 재전송마다 같음)
+    uint32_t txMicros;                  // 패킷 전송 시점의 송신부 micros() (ACK의 originalTxMicros로 돌아옴)
+    uint32_t elapsedSincePressUs;       // 버튼 눌림부터 이 패킷 전송까지 경과 시간
+    uint64_t pressAtTxUs;               // 송신부 esp_timer 기준 버튼 눌림 시각
+    uint16_t ackSlotUs;                 // 수신기별 ACK 시간 슬롯 폭 (비트맵 순서)
+};
+
+// [NEW] 그룹 주소. CommPacket.targetId의 최상위 비트가 1이면 나머지 비트는 그룹 번호(1~kMaxGroupId)이며,
+// 그 그룹에 등록된 모든 수신기가 받습니다. 장치 수와 관계없이 패킷 하나입니다.
+static constexpr uint8_t kGroupTargetFlag = 0x80;
+static constexpr uint8_t kMaxGroupId = 32;
+
+inline constexpr uint8_t groupTarget(uint8_t groupId) { return (uint8_t)(kGroupTargetFlag | groupId); }
+inline constexpr bool isGroupTarget(uint8_t targetId) { return (targetId & kGroupTargetFlag) != 0; }
+inline constexpr uint32_t groupBit(uint8_t groupId) {
+    return (groupId >= 1 && groupId <= kMaxGroupId) ? (1UL << (groupId - 1)) : 0;
+}
+
+// [NEW] 그룹 등록 패킷 (송신기 -> 수신기 하나, ACK로 확인). 수신기는 그룹 비트맵을 NVS에 저장
+struct GroupConfigPacket : PacketHeader {
+    uint8_t  targetId;
+    uint32_t seq;                       // 송신기별 메시지 시퀀스 번호 (재전송 시 동일 값 유지)
+    uint32_t txMicros;                  // 패킷 전송 시점의 송신부 micros() (ACK의 originalTxMicros로 돌아옴)
+    uint8_t  groupId;                   // 1~kMaxGroupId
+    uint8_t  member;                    // 1이면 등록, 0이면 해제
+};
+
+// [NEW] 구 펌웨어(v3) 명령/ACK 패킷. 전송 형식은 고정되어 있으므로 스키마를 절대 변경하지 마세요.
+// (crc8은 스키마 뒤에 붙음)
+struct LegacyCommPacketV3 {
+    uint8_t  signature[4];
+    uint8_t  version;                   // 항상 kLegacyVersion
+    uint8_t  packetType;
+    uint8_t  targetId;
+    uint32_t txButtonPressMicros;
+    uint32_t txMicros;
+    uint32_t delayMs;
+    uint32_t playMs;
+    uint32_t lastKnownRttUs;
+    uint32_t lastKnownRxProcessingTimeUs;
+};
+
+struct LegacyAckPacketV3 {
+    uint8_t  signature[4];
+    uint8_t  version;                   // 항상 kLegacyVersion
+    uint8_t  senderId;
+    uint32_t originalTxMicros;
+    uint32_t rxProcessingTimeUs;
+};
 
 //---------------------------------------------------------------------
-//  Dallas/Maxim CRC-8 (다항식 0x31, 초기값 0x00)
+//  [NEW] 전송 형식 스키마 (필드 순서 = 전송 순서). 고정 필드는 뒤에만 추가하세요.
 //---------------------------------------------------------------------
-inline uint8_t crc8(const uint8_t *data, size_t len) {
-    uint8_t crc = 0x00;
-    while (len--) {
-        uint8_t inbyte = *data++;
-        for (uint8_t i = 8; i; --i) {
-            uint8_t mix = (crc ^ inbyte) & 0x01;
-            crc >>= 1;
-            if (mix) crc ^= 0x8C; // 0x31 반전됨
-            inbyte >>= 1;
-        }
+template<typename S, typename... Fields>
+using FramedSchema = Schema<S, Field<&PacketHeader::signature>, Field<&PacketHeader::version>,
+                            Field<&PacketHeader::packetType>, Field<&PacketHeader::fixedLen>, Fields...>;
+
+using HeaderSchema = FramedSchema<PacketHeader>;
+
+using CommPacketSchema = FramedSchema<CommPacket,
+    Field<&CommPacket::targetId>, Field<&CommPacket::seq>, Field<&CommPacket::txButtonPressMicros>,
+    Field<&CommPacket::txMicros>, Field<&CommPacket::elapsedSincePressUs>, Field<&CommPacket::delayMs>,
+    Field<&CommPacket::playMs>, Field<&CommPacket::lastKnownRttUs>, Field<&CommPacket::lastKnownRxProcessingTimeUs>,
+    Field<&CommPacket::fireAtTxUs>, Field<&CommPacket::clockOffsetUs>>;
+
+using AckPacketSchema = FramedSchema<AckPacket,
+    Field<&AckPacket::senderId>, Field<&AckPacket::originalTxMicros>, Field<&AckPacket::rxProcessingTimeUs>,
+    Field<&AckPacket::rxLocalUs>>;
+
+using BatchEntrySchema = Schema<BatchEntry,
+    Field<&BatchEntry::targetId>, Field<&BatchEntry::delayMs>, Field<&BatchEntry::playMs>,
+    Field<&BatchEntry::compensationUs>, Field<&BatchEntry::clockOffsetUs>>;
+
+// 항목 앞까지의 일괄 명령 헤더 (항목은 BatchEntrySchema로 entrySize 간격에 놓임)
+using BatchHeaderSchema = FramedSchema<BatchCommandPacket,
+    Field<&BatchCommandPacket::seq>, Field<&BatchCommandPacket::targetBitmap>, Field<&BatchCommandPacket::txButtonPressMicros>,
+    Field<&BatchCommandPacket::txMicros>, Field<&BatchCommandPacket::elapsedSincePressUs>, Field<&BatchCommandPacket::pressAtTxUs>,
+    Field<&BatchCommandPacket::ackSlotUs>, Field<&BatchCommandPacket::entryCount>, Field<&BatchCommandPacket::entrySize>>;
+
+using StopPacketSchema = FramedSchema<StopPacket,
+    Field<&StopPacket::targetBitmap>, Field<&StopPacket::txMicros>, Field<&StopPacket::ackSlotUs>>;
+
+using ChannelHopPacketSchema = FramedSchema<ChannelHopPacket,
+    Field<&ChannelHopPacket::targetBitmap>, Field<&ChannelHopPacket::txMicros>, Field<&ChannelHopPacket::ackSlotUs>,
+    Field<&ChannelHopPacket::newChannel>, Field<&ChannelHopPacket::switchInMs>>;
+
+using ChannelBeaconSchema = FramedSchema<ChannelBeacon,
+    Field<&ChannelBeacon::channel>, Field<&ChannelBeacon::txMicros>>;
+
+using PhaseReportSchema = FramedSchema<PhaseReport,
+    Field<&PhaseReport::senderId>, Field<&PhaseReport::phase>, Field<&PhaseReport::commandId>,
+    Field<&PhaseReport::eventLocalUs>, Field<&PhaseReport::fireTargetLocalUs>, Field<&PhaseReport::compensationUs>,
+    Field<&PhaseReport::playMs>>;
+
+using ArmCuePacketSchema = FramedSchema<ArmCuePacket,
+    Field<&ArmCuePacket::targetId>, Field<&ArmCuePacket::seq>, Field<&ArmCuePacket::txMicros>, Field<&ArmCuePacket::armId>,
+    Field<&ArmCuePacket::delayMs>, Field<&ArmCuePacket::playMs>, Field<&ArmCuePacket::compensationUs>,
+    Field<&ArmCuePacket::clockOffsetUs>, Field<&ArmCuePacket::offsetRefTxUs>, Field<&ArmCuePacket::driftPpb>>;
+
+using GoPacketSchema = FramedSchema<GoPacket,
+    Field<&GoPacket::targetBitmap>, Field<&GoPacket::armId>, Field<&GoPacket::txButtonPressMicros>, Field<&GoPacket::txMicros>,
+    Field<&GoPacket::elapsedSincePressUs>, Field<&GoPacket::pressAtTxUs>, Field<&GoPacket::ackSlotUs>>;
+
+using GroupConfigPacketSchema = FramedSchema<GroupConfigPacket,
+    Field<&GroupConfigPacket::targetId>, Field<&GroupConfigPacket::seq>, Field<&GroupConfigPacket::txMicros>,
+    Field<&GroupConfigPacket::groupId>, Field<&GroupConfigPacket::member>>;
+
+using LegacyCommPacketSchemaV3 = Schema<LegacyCommPacketV3,
+    Field<&LegacyCommPacketV3::signature>, Field<&LegacyCommPacketV3::version>, Field<&LegacyCommPacketV3::packetType>,
+    Field<&LegacyCommPacketV3::targetId>, Field<&LegacyCommPacketV3::txButtonPressMicros>, Field<&LegacyCommPacketV3::txMicros>,
+    Field<&LegacyCommPacketV3::delayMs>, Field<&LegacyCommPacketV3::playMs>, Field<&LegacyCommPacketV3::lastKnownRttUs>,
+    Field<&LegacyCommPacketV3::lastKnownRxProcessingTimeUs>>;
+
+using LegacyAckPacketSchemaV3 = Schema<LegacyAckPacketV3,
+    Field<&LegacyAckPacketV3::signature>, Field<&LegacyAckPacketV3::version>, Field<&LegacyAckPacketV3::senderId>,
+    Field<&LegacyAckPacketV3::originalTxMicros>, Field<&LegacyAckPacketV3::rxProcessingTimeUs>>;
+
+static constexpr size_t kHeaderSize = HeaderSchema::kWireSize;
+static constexpr size_t kVersionOffset = HeaderSchema::offsetOf<1>();
+static constexpr size_t kPacketTypeOffset = HeaderSchema::offsetOf<2>();
+static constexpr size_t kFixedLenOffset = HeaderSchema::offsetOf<3>();
+static constexpr size_t kBatchHeaderSize = BatchHeaderSchema::kWireSize;
+
+// entryCount개의 항목을 가진 일괄 명령 패킷의 고정 필드 길이 (TLV, 검사값 제외)
+inline constexpr size_t batchFixedSize(uint8_t entryCount) {
+    return kBatchHeaderSize + entryCount * BatchEntrySchema::kWireSize;
+}
+
+// 전송 형식이 이전 packed 구조체와 바이트 단위로 같은지 확인 (구 펌웨어와의 호환성)
+static_assert(kHeaderSize == 7 && kFixedLenOffset == 6, "PacketHeader wire layout mismatch");
+static_assert(CommPacketSchema::kWireSize == 56, "CommPacket wire size mismatch");
+static_assert(AckPacketSchema::kWireSize == 24, "AckPacket wire size mismatch");
+static_assert(BatchEntrySchema::kWireSize == 21, "BatchEntry wire size mismatch");
+static_assert(kBatchHeaderSize == 39, "BatchCommandPacket header wire size mismatch");
+static_assert(StopPacketSchema::kWireSize == 17, "StopPacket wire size mismatch");
+static_assert(PhaseReportSchema::kWireSize == 37, "PhaseReport wire size mismatch");
+static_assert(ChannelHopPacketSchema::kWireSize == 20, "ChannelHopPacket wire size mismatch");
+static_assert(ChannelBeaconSchema::kWireSize == 12, "ChannelBeacon wire size mismatch");
+static_assert(ArmCuePacketSchema::kWireSize == 52, "ArmCuePacket wire size mismatch");
+static_assert(GoPacketSchema::kWireSize == 37, "GoPacket wire size mismatch");
+static_assert(GroupConfigPacketSchema::kWireSize == 18, "GroupConfigPacket wire size mismatch");
+static_assert(batchFixedSize(kMaxBatchEntries) + Crc16::kSize <= kMaxFrameSize, "BatchCommandPacket exceeds ESP-NOW payload limit");
+static_assert(LegacyCommPacketSchemaV3::kWireSize + 1 == 32, "LegacyCommPacketV3 wire size mismatch");
+static_assert(LegacyAckPacketSchemaV3::kWireSize + 1 == 15, "LegacyAckPacketV3 wire size mismatch");
+
+//---------------------------------------------------------------------
+//  [NEW] 프레임 조립 (고정 필드 + TLV + 검사값)
+//---------------------------------------------------------------------
+struct Frame {
+    uint8_t data[kMaxFrameSize];
+    size_t  len;
+};
+
+// [MODIFIED] 스키마로 필드를 프레임 끝에 직접 인코딩 (중간 구조체 복사 없음). 가장 긴 검사값 자리는 남겨둠
+template<typename SchemaT>
+inline bool appendFields(Frame &frame, const typename SchemaT::Struct &s) {
+    if (frame.len + SchemaT::kWireSize + kMaxIntegritySize > kMaxFrameSize) return false;
+    SchemaT::encode(s, frame.data + frame.len);
+    frame.len += SchemaT::kWireSize;
+    return true;
+}
+
+template<typename SchemaT>
+inline bool encodeFrame(Frame &frame, const typename SchemaT::Struct &s) {
+    frame.len = 0;
+    return appendFields<SchemaT>(frame, s);
+}
+
+// 검사값 자리를 남겨두고 공간이 있을 때만 TLV 추가
+inline bool appendTlv(Frame &frame, uint8_t type, const uint8_t* value, uint8_t valueLen) {
+    if (frame.len + 2 + valueLen + kMaxIntegritySize > kMaxFrameSize) return false;
+    frame.data[frame.len++] = type;
+    frame.data[frame.len++] = valueLen;
+    memcpy(frame.data + frame.len, value, valueLen);
+    frame.len += valueLen;
+    return true;
+}
+
+// [NEW] 정수 값을 리틀 엔디언 TLV로 추가
+template<typename T>
+inline bool appendTlvValue(Frame &frame, uint8_t type, T value) {
+    uint8_t bytes[WireCodec<T>::kSize];
+    NoIntegrity none;
+    WireCodec<T>::store(bytes, value, none);
+    return appendTlv(frame, type, bytes, sizeof(bytes));
+}
+
+template<typename Crc>
+inline size_t sealFrameWith(Frame &frame) {
+    Crc crc;
+    crcUpdate(crc, frame.data, frame.len);
+    storeCrc(crc, frame.data + frame.len);
+    frame.len += Crc::kSize;
+    return frame.len;
+}
+
+// [MODIFIED] 헤더의 버전/타입에 맞는 검사값을 붙이고 전송할 전체 길이를 반환
+// (v3 프레임은 버전이 kTypedIntegrityVersion보다 낮으므로 항상 crc8)
+inline size_t sealFrame(Frame &frame) {
+    switch (integrityFor(frame.data[kVersionOffset], frame.data[kPacketTypeOffset])) {
+        case INTEGRITY_CRC16: return sealFrameWith<Crc16>(frame);
+        default:              return sealFrameWith<Crc8>(frame);
     }
-    return crc;
 }
 
 //---------------------------------------------------------------------
 //  송신부 헬퍼 함수
 //---------------------------------------------------------------------
+inline void fillHeader(PacketHeader &header, PacketType type, size_t len) {
+    memcpy(header.signature, kSig, 4);
+    header.version    = kVersion;
+    header.packetType = type;
+    header.fixedLen   = (uint8_t)len;
+}
+
 // [수정됨] packetType 파라미터 추가
-inline void fillPacket(CommPacket &pkt, PacketType type, uint8_t tgtId, uint32_t txButtonPressMicros, uint32_t delayMs, uint32_t playMs, uint32_t rttUs, uint32_t rxProcessingTimeUs) {
-    memcpy(pkt.signature, kSig, 4);
-    pkt.version        = kVersion;
-    pkt.packetType     = type;          // [NEW]
+inline void fillPacket(CommPacket &pkt, PacketType type, uint8_t tgtId, uint32_t seq, uint32_t txButtonPressMicros, uint32_t delayMs, uint32_t playMs, uint32_t rttUs, uint32_t rxProcessingTimeUs,
+                       uint64_t fireAtTxUs = 0, int64_t clockOffsetUs = kNoClockOffset) {
+    fillHeader(pkt, type, CommPacketSchema::kWireSize);
     pkt.targetId       = tgtId;
+    pkt.seq            = seq;
     pkt.txButtonPressMicros = txButtonPressMicros;
     pkt.txMicros       = micros();      // 패킷 전송 시각
+    pkt.elapsedSincePressUs = pkt.txMicros - txButtonPressMicros; // [NEW]
     pkt.delayMs        = delayMs;
     pkt.playMs         = playMs;
     pkt.lastKnownRttUs = rttUs;         // [MODIFIED] RTT_REQUEST 시 0, FINAL_COMMAND 시 실제 RTT
     pkt.lastKnownRxProcessingTimeUs = rxProcessingTimeUs; // [MODIFIED] RTT_REQUEST 시 0, FINAL_COMMAND 시 실제 Rx 처리 시간
-    pkt.crc8           = crc8(reinterpret_cast<const uint8_t*>(&pkt), sizeof(CommPacket) - 1);
+    pkt.fireAtTxUs     = fireAtTxUs;    // [NEW]
+    pkt.clockOffsetUs  = clockOffsetUs; // [NEW]
+}
+
+// [NEW] 구 펌웨어(v3)용 명령 패킷 (고정 32바이트, crc8은 sealFrame에서 붙음)
+inline void fillLegacyPacketV3(LegacyCommPacketV3 &pkt, PacketType type, uint8_t tgtId, uint32_t txButtonPressMicros, uint32_t delayMs, uint32_t playMs, uint32_t rttUs, uint32_t rxProcessingTimeUs) {
+    memcpy(pkt.signature, kSig, 4);
+    pkt.version        = kLegacyVersion;
+    pkt.packetType     = type;
+    pkt.targetId       = tgtId;
+    pkt.txButtonPressMicros = txButtonPressMicros;
+    pkt.txMicros       = micros();
+    pkt.delayMs        = delayMs;
+    pkt.playMs         = playMs;
+    pkt.lastKnownRttUs = rttUs;
+    pkt.lastKnownRxProcessingTimeUs = rxProcessingTimeUs;
+}
+
+// [NEW] 일괄 명령 패킷 헤더 초기화 (항목은 addBatchEntry로 추가)
+inline void beginBatchPacket(BatchCommandPacket &pkt, uint32_t seq, uint32_t txButtonPressMicros, uint64_t pressAtTxUs, uint16_t ackSlotUs) {
+    fillHeader(pkt, BATCH_COMMAND, kBatchHeaderSize);
+    pkt.seq            = seq;
+    pkt.targetBitmap   = 0;
+    pkt.txButtonPressMicros = txButtonPressMicros;
+    pkt.txMicros       = 0;
+    pkt.elapsedSincePressUs = 0;
+    pkt.pressAtTxUs    = pressAtTxUs;
+    pkt.ackSlotUs      = ackSlotUs;
+    pkt.entryCount     = 0;
+    pkt.entrySize      = BatchEntrySchema::kWireSize;
+}
+
+inline bool addBatchEntry(BatchCommandPacket &pkt, uint8_t tgtId, uint32_t delayMs, uint32_t playMs, uint32_t compensationUs,
+                          int64_t clockOffsetUs = kNoClockOffset) {
+    if (pkt.entryCount >= kMaxBatchEntries || tgtId == 0 || tgtId > 32) return false;
+    BatchEntry &entry = pkt.entries[pkt.entryCount++];
+    entry.targetId       = tgtId;
+    entry.delayMs        = delayMs;
+    entry.playMs         = playMs;
+    entry.compensationUs = compensationUs;
+    entry.clockOffsetUs  = clockOffsetUs;
+    pkt.targetBitmap |= (1UL << (tgtId - 1));
+    return true;
+}
+
+// [MODIFIED] 전송 시각을 기록하고 프레임(헤더 + 항목 + 검사값)을 인코딩해 전송할 바이트 수를 반환
+// frameVersion: 받는 수신기 중 하나라도 kTypedIntegrityVersion 이전이면 kMinCompatibleVersion으로 보내 crc8 사용
+inline size_t finalizeBatchPacket(BatchCommandPacket &pkt, Frame &frame, uint8_t frameVersion = kVersion) {
+    pkt.version = frameVersion;
+    pkt.txMicros = micros();            // 패킷 전송 시각
+    pkt.elapsedSincePressUs = pkt.txMicros - pkt.txButtonPressMicros;
+    pkt.fixedLen = (uint8_t)batchFixedSize(pkt.entryCount);
+    if (!encodeFrame<BatchHeaderSchema>(frame, pkt)) return 0;
+    for (uint8_t i = 0; i < pkt.entryCount; ++i) {
+        if (!appendFields<BatchEntrySchema>(frame, pkt.entries[i])) return 0;
+    }
+    return sealFrame(frame);
+}
+
+// [NEW] 비상 정지 프레임을 만들어 전송할 바이트 수를 반환 (txMicros는 ACK 대조용으로 돌려줌)
+inline size_t buildStopFrame(Frame &frame, uint32_t targetBitmap, uint16_t ackSlotUs, uint32_t &txMicros) {
+    StopPacket pkt;
+    fillHeader(pkt, STOP_COMMAND, StopPacketSchema::kWireSize);
+    pkt.targetBitmap = targetBitmap;
+    pkt.txMicros     = micros();
+    pkt.ackSlotUs    = ackSlotUs;
+    txMicros = pkt.txMicros;
+    if (!encodeFrame<StopPacketSchema>(frame, pkt)) return 0;
+    return sealFrame(frame);
+}
+
+// [NEW] 채널 전환 프레임을 만들어 전송할 바이트 수를 반환 (txMicros는 ACK 대조용으로 돌려줌)
+inline size_t buildChannelHopFrame(Frame &frame, uint32_t targetBitmap, uint16_t ackSlotUs, uint8_t newChannel,
+                                   uint16_t switchInMs, uint32_t &txMicros) {
+    ChannelHopPacket pkt;
+    fillHeader(pkt, CHANNEL_HOP, ChannelHopPacketSchema::kWireSize);
+    pkt.targetBitmap = targetBitmap;
+    pkt.txMicros     = micros();
+    pkt.ackSlotUs    = ackSlotUs;
+    pkt.newChannel   = newChannel;
+    pkt.switchInMs   = switchInMs;
+    txMicros = pkt.txMicros;
+    if (!encodeFrame<ChannelHopPacketSchema>(frame, pkt)) return 0;
+    return sealFrame(frame);
+}
+
+// [NEW] 실행 정보 예약 프레임을 만들어 전송할 바이트 수를 반환 (txMicros는 ACK 대조용으로 돌려줌)
+inline size_t buildArmCueFrame(Frame &frame, uint8_t tgtId, uint32_t seq, uint32_t armId, uint32_t delayMs, uint32_t playMs,
+                               uint32_t compensationUs, int64_t clockOffsetUs, uint64_t offsetRefTxUs, int32_t driftPpb,
+                               uint32_t &txMicros) {
+    ArmCuePacket pkt;
+    fillHeader(pkt, ARM_CUE, ArmCuePacketSchema::kWireSize);
+    pkt.targetId       = tgtId;
+    pkt.seq            = seq;
+    pkt.txMicros       = micros();
+    pkt.armId          = armId;
+    pkt.delayMs        = delayMs;
+    pkt.playMs         = playMs;
+    pkt.compensationUs = compensationUs;
+    pkt.clockOffsetUs  = clockOffsetUs;
+    pkt.offsetRefTxUs  = offsetRefTxUs;
+    pkt.driftPpb       = driftPpb;
+    txMicros = pkt.txMicros;
+    if (!encodeFrame<ArmCuePacketSchema>(frame, pkt)) return 0;
+    return sealFrame(frame);
+}
+
+// [NEW] 실행 프레임을 만들어 전송할 바이트 수를 반환 (txMicros는 ACK 대조용으로 돌려줌)
+inline size_t buildGoFrame(Frame &frame, uint32_t targetBitmap, uint32_t armId, uint32_t txButtonPressMicros, uint64_t pressAtTxUs,
+                           uint16_t ackSlotUs, uint32_t &txMicros) {
+    GoPacket pkt;
+    fillHeader(pkt, GO_COMMAND, GoPacketSchema::kWireSize);
+    pkt.targetBitmap   = targetBitmap;
+    pkt.armId          = armId;
+    pkt.txButtonPressMicros = txButtonPressMicros;
+    pkt.txMicros       = micros();
+    pkt.elapsedSincePressUs = pkt.txMicros - txButtonPressMicros;
+    pkt.pressAtTxUs    = pressAtTxUs;
+    pkt.ackSlotUs      = ackSlotUs;
+    txMicros = pkt.txMicros;
+    if (!encodeFrame<GoPacketSchema>(frame, pkt)) return 0;
+    return sealFrame(frame);
+}
+
+// [NEW] 그룹 주소 최종 명령 프레임을 만들어 전송할 바이트 수를 반환. 보정값은 그룹 공통이며,
+// 그룹 전체가 같은 seq로 ACK하므로 슬롯 폭을 TLV로 붙임.
+// 장치별 시계 오프셋을 실을 수 없으므로 시계가 동기화된 구성원에게는 BATCH_COMMAND를 씀 (송신부 groupAddressFor)
+inline size_t buildGroupCommandFrame(Frame &frame, uint8_t groupId, uint32_t seq, uint32_t txButtonPressMicros, uint32_t delayMs,
+                                     uint32_t playMs, uint32_t rttUs, uint32_t rxProcessingTimeUs, uint64_t fireAtTxUs,
+                                     uint16_t ackSlotUs, uint32_t &txMicros) {
+    CommPacket pkt;
+    fillPacket(pkt, FINAL_COMMAND, groupTarget(groupId), seq, txButtonPressMicros, delayMs, playMs, rttUs, rxProcessingTimeUs,
+               fireAtTxUs, kNoClockOffset);
+    txMicros = pkt.txMicros;
+    if (!encodeFrame<CommPacketSchema>(frame, pkt)) return 0;
+    if (!appendTlvValue<uint16_t>(frame, TLV_ACK_SLOT_US, ackSlotUs)) return 0;
+    return sealFrame(frame);
+}
+
+// [NEW] 그룹 등록 프레임을 만들어 전송할 바이트 수를 반환 (txMicros는 ACK 대조용으로 돌려줌)
+inline size_t buildGroupConfigFrame(Frame &frame, uint8_t tgtId, uint32_t seq, uint8_t groupId, bool member, uint32_t &txMicros) {
+    GroupConfigPacket pkt;
+    fillHeader(pkt, GROUP_CONFIG, GroupConfigPacketSchema::kWireSize);
+    pkt.targetId = tgtId;
+    pkt.seq      = seq;
+    pkt.txMicros = micros();
+    pkt.groupId  = groupId;
+    pkt.member   = member ? 1 : 0;
+    txMicros = pkt.txMicros;
+    if (!encodeFrame<GroupConfigPacketSchema>(frame, pkt)) return 0;
+    return sealFrame(frame);
+}
+
+// [NEW] 채널 비콘 프레임을 만들어 전송할 바이트 수를 반환
+inline size_t buildChannelBeaconFrame(Frame &frame, uint8_t channel) {
+    ChannelBeacon beacon;
+    fillHeader(beacon, CHANNEL_BEACON, ChannelBeaconSchema::kWireSize);
+    beacon.channel  = channel;
+    beacon.txMicros = micros();
+    if (!encodeFrame<ChannelBeaconSchema>(frame, beacon)) return 0;
+    return sealFrame(frame);
+}
+
+// [NEW] ACK 슬롯 번호: 비트맵에서 내 ID보다 낮은 ID의 개수 (송신부와 수신부가 같은 값을 계산)
+inline uint8_t ackSlotIndex(uint32_t targetBitmap, uint8_t id) {
+    if (id == 0 || id > 32) return 0;
+    uint32_t lowerMask = (id == 32) ? 0x7FFFFFFFUL : ((1UL << (id - 1)) - 1);
+    return (uint8_t)__builtin_popcount(targetBitmap & lowerMask);
 }
 
 //---------------------------------------------------------------------
 //  수신부 헬퍼 함수
 //---------------------------------------------------------------------
-inline bool verifyCommPacket(const uint8_t* data, size_t len, const CommPacket*& pkt, uint8_t myId, bool &forMe) {
-    if (len < sizeof(CommPacket)) return false;
-    pkt = reinterpret_cast<const CommPacket*>(data);
+// [NEW] 프레임 공통 검증: 서명, 호환 버전
+inline bool checkFrameHeader(const uint8_t* data, size_t len) {
+    if (len < kHeaderSize + 1 || len > kMaxFrameSize) return false;
+    if (memcmp(data, kSig, 4) != 0) return false;
+    return data[kVersionOffset] >= kMinCompatibleVersion;
+}
+
+// [NEW] 검사값을 뺀 프레임 길이 (checkFrameHeader를 통과한 프레임에만 사용)
+inline size_t frameBodyLen(const uint8_t* data, size_t len) {
+    size_t trailer = integritySize(integrityFor(data[kVersionOffset], data[kPacketTypeOffset]));
+    return (len > trailer) ? len - trailer : 0;
+}
+
+// [NEW] TLV 영역이 정확히 검사값 앞에서 끝나는지 확인
+inline bool checkTlvArea(const uint8_t* data, size_t bodyLen) {
+    size_t pos = data[kFixedLenOffset];
+    while (pos < bodyLen) {
+        if (pos + 2 > bodyLen) return false;
+        pos += 2 + data[pos + 1];
+    }
+    return pos == bodyLen;
+}
 
-    if (memcmp(pkt->signature, kSig, 4) != 0) return false;
-    if (pkt->version != kVersion) return false;
-    
-    uint8_t calc_crc = crc8(data, sizeof(CommPacket) - 1);
-    if (calc_crc != pkt->crc8) return false;
+// [NEW] 고정 필드를 수신 버퍼에서 바로 디코딩하면서 검사값을 계산하고, 나머지 바이트(항목, TLV)까지 이어서 확인.
+// 검사값이 맞지 않으면 디코딩된 값은 사용하지 않고 TLV 등 이후 해석 없이 false 반환
+template<typename SchemaT, typename Crc>
+inline bool decodeFrameWith(const uint8_t* data, size_t len, typename SchemaT::Struct &out) {
+    if (len < SchemaT::kWireSize + Crc::kSize) return false;
+    size_t bodyLen = len - Crc::kSize;
+    size_t fixedLen = data[kFixedLenOffset];
+    if (fixedLen < SchemaT::kWireSize || fixedLen > bodyLen) return false;
 
-    // targetId가 0(브로드캐스트)이거나 내 ID와 일치할 때 forMe = true
-    forMe = (pkt->targetId == 0) || (pkt->targetId == myId);
+    Crc crc;
+    SchemaT::decode(data, out, crc);
+    crcUpdate(crc, data + SchemaT::kWireSize, bodyLen - SchemaT::kWireSize);
+    if (!crcMatches(crc, data + bodyLen)) return false;
+    return checkTlvArea(data, bodyLen);
+}
+
+// [MODIFIED] 프레임 버전/타입에 맞는 검사값으로 디코딩
+template<typename SchemaT>
+inline bool decodeFrame(const uint8_t* data, size_t len, typename SchemaT::Struct &out) {
+    if (!checkFrameHeader(data, len)) return false;
+    switch (integrityFor(data[kVersionOffset], data[kPacketTypeOffset])) {
+        case INTEGRITY_CRC16: return decodeFrameWith<SchemaT, Crc16>(data, len, out);
+        default:              return decodeFrameWith<SchemaT, Crc8>(data, len, out);
+    }
+}
+
+// [NEW] TLV 영역에서 type을 찾음 (디코딩에 성공한 프레임에만 사용)
+inline bool findTlv(const uint8_t* data, size_t len, uint8_t type, const uint8_t*& value, uint8_t &valueLen) {
+    size_t bodyLen = frameBodyLen(data, len);
+    size_t pos = data[kFixedLenOffset];
+    while (pos + 2 <= bodyLen) {
+        uint8_t tlvLen = data[pos + 1];
+        if (data[pos] == type) {
+            value = data + pos + 2;
+            valueLen = tlvLen;
+            return true;
+        }
+        pos += 2 + tlvLen;
+    }
+    return false;
+}
+
+// [NEW] 리틀 엔디언 정수 TLV 읽기 (값이 기대보다 짧으면 false)
+template<typename T>
+inline bool findTlvValue(const uint8_t* data, size_t len, uint8_t type, T &out) {
+    const uint8_t* value = nullptr;
+    uint8_t valueLen = 0;
+    if (!findTlv(data, len, type, value, valueLen) || valueLen < WireCodec<T>::kSize) return false;
+    NoIntegrity none;
+    WireCodec<T>::load(value, out, none);
     return true;
 }
 
-inline bool verifyAckPacket(const uint8_t* data, size_t len, const AckPacket*& pkt) {
-    if (len < sizeof(AckPacket)) return false;
-    pkt = reinterpret_cast<const AckPacket*>(data);
+// [NEW] 서명/버전만 확인하고 패킷 타입을 반환 (타입별 검증 함수 선택용)
+inline bool peekPacketType(const uint8_t* data, size_t len, uint8_t &type) {
+    if (len < kHeaderSize) return false;
+    if (memcmp(data, kSig, 4) != 0) return false;
+    if (data[kVersionOffset] < kMinCompatibleVersion) return false;
+    type = data[kPacketTypeOffset];
+    return true;
+}
 
-    if (memcmp(pkt->signature, kSig, 4) != 0) return false;
-    if (pkt->version != kVersion) return false;
+// [MODIFIED] 수신 버퍼를 직접 캐스팅하지 않고 정렬된 구조체로 디코딩
+// [MODIFIED] myGroups는 이 패킷을 보낸 송신기가 나를 등록한 그룹 비트맵 (bit 그룹번호-1)
+inline bool verifyCommPacket(const uint8_t* data, size_t len, CommPacket &pkt, uint8_t myId, bool &forMe, uint32_t myGroups = 0) {
+    if (!decodeFrame<CommPacketSchema>(data, len, pkt)) return false;
+    if (pkt.packetType != RTT_REQUEST && pkt.packetType != FINAL_COMMAND) return false;
 
-    uint8_t calc_crc = crc8(data, sizeof(AckPacket) - 1);
-    if (calc_crc != pkt->crc8) return false;
+    // targetId가 0(브로드캐스트)이거나 내 ID와 일치하거나 내가 등록된 그룹일 때 forMe = true
+    if (isGroupTarget(pkt.targetId)) {
+        forMe = (myGroups & groupBit(pkt.targetId & ~kGroupTargetFlag)) != 0;
+    } else {
+        forMe = (pkt.targetId == 0) || (pkt.targetId == myId);
+    }
+    return true;
+}
+
+// [NEW] 그룹 주소 명령에 대한 내 ACK 대기 시간 (ID 순서 슬롯, 슬롯 폭 TLV가 없으면 0)
+inline uint32_t groupAckDelayUs(const uint8_t* data, size_t len, uint8_t myId) {
+    uint16_t ackSlotUs = 0;
+    if (myId == 0 || !findTlvValue(data, len, TLV_ACK_SLOT_US, ackSlotUs)) return 0;
+    return (uint32_t)(myId - 1) * ackSlotUs;
+}
+
+// [NEW] 그룹 등록 패킷 검증. 대상 ID가 내 ID이면 forMe = true
+inline bool verifyGroupConfigPacket(const uint8_t* data, size_t len, GroupConfigPacket &pkt, uint8_t myId, bool &forMe) {
+    if (!decodeFrame<GroupConfigPacketSchema>(data, len, pkt)) return false;
+    if (pkt.packetType != GROUP_CONFIG || groupBit(pkt.groupId) == 0) return false;
+    forMe = (pkt.targetId == myId);
+    return true;
+}
+
+// [NEW] 일괄 명령 패킷 검증. 내 ID가 비트맵에 있으면 forMe = true, entry에 내 항목을 디코딩
+// (pkt.entries는 채우지 않음)
+inline bool verifyBatchCommandPacket(const uint8_t* data, size_t len, BatchCommandPacket &pkt, uint8_t myId,
+                                     BatchEntry &entry, bool &forMe) {
+    if (!decodeFrame<BatchHeaderSchema>(data, len, pkt)) return false;
+    if (pkt.packetType != BATCH_COMMAND) return false;
+    if (pkt.entrySize < BatchEntrySchema::kWireSize) return false;
+    if (pkt.fixedLen < kBatchHeaderSize + (size_t)pkt.entryCount * pkt.entrySize) return false;
+
+    forMe = false;
+    if (myId == 0 || myId > 32 || !(pkt.targetBitmap & (1UL << (myId - 1)))) return true;
+
+    for (uint8_t i = 0; i < pkt.entryCount; ++i) {
+        const uint8_t* candidate = data + kBatchHeaderSize + (size_t)i * pkt.entrySize;
+        if (candidate[0] == myId) { // targetId는 항목의 첫 바이트
+            BatchEntrySchema::decode(candidate, entry);
+            forMe = true;
+            break;
+        }
+    }
+    return true;
+}
+
+// [NEW] 비상 정지 패킷 검증. 내 ID가 비트맵에 있으면 forMe = true
+inline bool verifyStopPacket(const uint8_t* data, size_t len, StopPacket &pkt, uint8_t myId, bool &forMe) {
+    if (!decodeFrame<StopPacketSchema>(data, len, pkt)) return false;
+    if (pkt.packetType != STOP_COMMAND) return false;
+    forMe = (myId >= 1 && myId <= 32) && (pkt.targetBitmap & (1UL << (myId - 1)));
+    return true;
+}
+
+// [NEW] 채널 전환 패킷 검증. 내 ID가 비트맵에 있으면 forMe = true
+inline bool verifyChannelHopPacket(const uint8_t* data, size_t len, ChannelHopPacket &pkt, uint8_t myId, bool &forMe) {
+    if (!decodeFrame<ChannelHopPacketSchema>(data, len, pkt)) return false;
+    if (pkt.packetType != CHANNEL_HOP) return false;
+    if (pkt.newChannel < kMinWifiChannel || pkt.newChannel > kMaxWifiChannel) return false;
+    forMe = (myId >= 1 && myId <= 32) && (pkt.targetBitmap & (1UL << (myId - 1)));
+    return true;
+}
+
+// [NEW] 실행 정보 예약 패킷 검증. 대상 ID가 내 ID이면 forMe = true
+inline bool verifyArmCuePacket(const uint8_t* data, size_t len, ArmCuePacket &pkt, uint8_t myId, bool &forMe) {
+    if (!decodeFrame<ArmCuePacketSchema>(data, len, pkt)) return false;
+    if (pkt.packetType != ARM_CUE) return false;
+    forMe = (pkt.targetId == myId);
+    return true;
+}
 
+// [NEW] 실행 패킷 검증. 내 ID가 비트맵에 있으면 forMe = true
+inline bool verifyGoPacket(const uint8_t* data, size_t len, GoPacket &pkt, uint8_t myId, bool &forMe) {
+    if (!decodeFrame<GoPacketSchema>(data, len, pkt)) return false;
+    if (pkt.packetType != GO_COMMAND) return false;
+    forMe = (myId >= 1 && myId <= 32) && (pkt.targetBitmap & (1UL << (myId - 1)));
     return true;
 }
 
+// [NEW] 채널 비콘 검증
+inline bool verifyChannelBeacon(const uint8_t* data, size_t len, ChannelBeacon &beacon) {
+    if (!decodeFrame<ChannelBeaconSchema>(data, len, beacon)) return false;
+    return beacon.packetType == CHANNEL_BEACON && beacon.channel >= kMinWifiChannel && beacon.channel <= kMaxWifiChannel;
+}
+
+inline bool verifyAckPacket(const uint8_t* data, size_t len, AckPacket &pkt) {
+    if (!decodeFrame<AckPacketSchema>(data, len, pkt)) return false;
+    return pkt.packetType == ACK;
+}
+
+// [NEW] 실행 단계 보고 검증
+inline bool verifyPhaseReport(const uint8_t* data, size_t len, PhaseReport &report) {
+    if (!decodeFrame<PhaseReportSchema>(data, len, report)) return false;
+    return report.packetType == PHASE_REPORT && report.phase >= PHASE_ARMED && report.phase <= PHASE_ABORTED;
+}
+
+// [NEW] 구 펌웨어(v3) ACK 검증
+inline bool verifyLegacyAckPacketV3(const uint8_t* data, size_t len, LegacyAckPacketV3 &pkt) {
+    constexpr size_t kSize = LegacyAckPacketSchemaV3::kWireSize;
+    if (len < kSize + 1) return false;
+    if (memcmp(data, kSig, 4) != 0) return false;
+    if (data[kVersionOffset] != kLegacyVersion) return false;
+
+    Crc8 crc;
+    LegacyAckPacketSchemaV3::decode(data, pkt, crc);
+    return crcMatches(crc, data + kSize);
+}
+
 // [수정됨] rxProcessingTime 파라미터 추가
-inline void fillAckPacket(AckPacket& ack, uint8_t senderId, uint32_t originalTxMicros, uint32_t rxProcessingTime) {
-    memcpy(ack.signature, kSig, 4);
-    ack.version = kVersion;
+// [MODIFIED] 내 기능 비트맵을 TLV로 붙인 ACK 프레임을 만들어 전송할 바이트 수를 반환
+inline size_t buildAckFrame(Frame &frame, uint8_t senderId, uint32_t originalTxMicros, uint32_t rxProcessingTime, uint64_t rxLocalUs) {
+    AckPacket ack;
+    fillHeader(ack, ACK, AckPacketSchema::kWireSize);
     ack.senderId = senderId;
     ack.originalTxMicros = originalTxMicros;
     ack.rxProcessingTimeUs = rxProcessingTime; // [NEW] 수신기 처리 시간 추가
-    ack.crc8 = crc8(reinterpret_cast<const uint8_t*>(&ack), sizeof(AckPacket) - 1);
+    ack.rxLocalUs = rxLocalUs;                 // [NEW] 시계 동기화용 수신 시각
+
+    encodeFrame<AckPacketSchema>(frame, ack);
+    appendTlvValue<uint32_t>(frame, TLV_CAPABILITIES, kLocalCapabilities);
+    return sealFrame(frame);
+}
+
+// [NEW] 실행 단계 보고 프레임을 만들어 전송할 바이트 수를 반환
+inline size_t buildPhaseReportFrame(Frame &frame, uint8_t senderId, ExecPhase phase, uint32_t commandId, uint64_t eventLocalUs,
+                                    int64_t fireTargetLocalUs, int32_t compensationUs, uint32_t playMs) {
+    PhaseReport report;
+    fillHeader(report, PHASE_REPORT, PhaseReportSchema::kWireSize);
+    report.senderId          = senderId;
+    report.phase             = phase;
+    report.commandId         = commandId;
+    report.eventLocalUs      = eventLocalUs;
+    report.fireTargetLocalUs = fireTargetLocalUs;
+    report.compensationUs    = compensationUs;
+    report.playMs            = playMs;
+    if (!encodeFrame<PhaseReportSchema>(frame, report)) return 0;
+    return sealFrame(frame);
+}
+
+//---------------------------------------------------------------------
+//  [NEW] 송신 큐 헬퍼 (이미 만든 프레임을 전송 직전에 고침)
+//---------------------------------------------------------------------
+template<typename Crc>
+inline void resealWith(uint8_t* data, size_t bodyLen) {
+    Crc crc;
+    crcUpdate(crc, data, bodyLen);
+    storeCrc(crc, data + bodyLen);
+}
+
+// [NEW] 송신 큐에서 기다린 뒤 드라이버에 넘기는 순간 호출. 버튼 눌림 후 경과 시간을 지금 기준으로 다시 쓰고 검사값을 다시 붙임
+// (수신부 보정이 큐/드라이버 대기 시간까지 포함하도록). txMicros는 ACK 대조용 키이므로 바꾸지 않음.
+// 경과 시간 필드가 없는 프레임(v3, 다른 타입)은 그대로 두고 false 반환
+inline bool restampElapsedSincePress(uint8_t* data, size_t len, uint32_t nowMicros) {
+    if (!checkFrameHeader(data, len)) return false;
+    size_t pressOffset, elapsedOffset, fixedSize;
+    switch (data[kPacketTypeOffset]) {
+        case RTT_REQUEST:                   // 필드 6 = txButtonPressMicros, 필드 8 = elapsedSincePressUs (세 스키마 모두)
+        case FINAL_COMMAND:
+            pressOffset = CommPacketSchema::offsetOf<6>();
+            elapsedOffset = CommPacketSchema::offsetOf<8>();
+            fixedSize = CommPacketSchema::kWireSize;
+            break;
+        case BATCH_COMMAND:
+            pressOffset = BatchHeaderSchema::offsetOf<6>();
+            elapsedOffset = BatchHeaderSchema::offsetOf<8>();
+            fixedSize = BatchHeaderSchema::kWireSize;
+            break;
+        case GO_COMMAND:
+            pressOffset = GoPacketSchema::offsetOf<6>();
+            elapsedOffset = GoPacketSchema::offsetOf<8>();
+            fixedSize = GoPacketSchema::kWireSize;
+            break;
+        default:
+            return false;
+    }
+    size_t bodyLen = frameBodyLen(data, len);
+    if (bodyLen < fixedSize) return false;
+
+    NoIntegrity none;
+    uint32_t pressMicros = 0;
+    WireCodec<uint32_t>::load(data + pressOffset, pressMicros, none);
+    WireCodec<uint32_t>::store(data + elapsedOffset, nowMicros - pressMicros, none);
+    if (integrityFor(data[kVersionOffset], data[kPacketTypeOffset]) == INTEGRITY_CRC16) resealWith<Crc16>(data, bodyLen);
+    else resealWith<Crc8>(data, bodyLen);
+    return true;
 }
 
 inline uint32_t latencyUs(const CommPacket &pkt) {
     return micros() - pkt.txMicros;
 }
 
+#if defined(ARDUINO)
+//---------------------------------------------------------------------
+//  [NEW] ESP-NOW 전송 속도 단계 (견고한 것부터)
+//  - 드라이버 기본값은 1 Mbps DSSS로, 짧은 프레임도 프리앰블만 192 us를 차지함
+//  - OFDM 6 Mbps부터는 프리앰블이 20 us라 같은 프레임의 방송 시간이 크게 줄어듦
+//  - minRssi는 데이터시트 수신 감도에 가까운 값. 실제 선택에는 각 펌웨어의 여유값(dB)을 더해 사용
+//---------------------------------------------------------------------
+struct RateStep {
+    wifi_phy_rate_t rate;
+    wifi_phy_mode_t phyMode;
+    uint8_t         mbps;
+    int8_t          minRssi;
+    const char*     name;
+};
+
+static constexpr RateStep kRateLadder[] = {
+    { WIFI_PHY_RATE_1M_L, WIFI_PHY_MODE_11B, 1,  -98, "1M"  },
+    { WIFI_PHY_RATE_6M,   WIFI_PHY_MODE_11G, 6,  -93, "6M"  },
+    { WIFI_PHY_RATE_12M,  WIFI_PHY_MODE_11G, 12, -90, "12M" },
+    { WIFI_PHY_RATE_24M,  WIFI_PHY_MODE_11G, 24, -86, "24M" },
+    { WIFI_PHY_RATE_36M,  WIFI_PHY_MODE_11G, 36, -82, "36M" },
+};
+static constexpr uint8_t kRateLadderSize = sizeof(kRateLadder) / sizeof(kRateLadder[0]);
+
+// 피어(브로드캐스트 포함)에 속도 단계 적용. 피어가 등록되어 있어야 함
+inline bool applyPeerRate(const uint8_t* mac, uint8_t step) {
+    if (step >= kRateLadderSize) return false;
+    esp_now_rate_config_t config = {};
+    config.phymode = kRateLadder[step].phyMode;
+    config.rate = kRateLadder[step].rate;
+    config.ersu = false;
+    config.dcm = false;
+    return esp_now_set_peer_rate_config(mac, &config) == ESP_OK;
+}
+
+// [NEW] ESP-NOW 프레임(벤더 액션 프레임)에서 페이로드 외 바이트: MAC 헤더 24 + 카테고리/OUI/난수 8 + 벤더 요소 헤더 7 + FCS 4
+static constexpr uint16_t kEspNowFrameOverhead = 43;
+
+// [NEW] 프레임 하나의 방송 시간 추정 (us)
+//  - DSSS: 긴 프리앰블/PLCP 헤더 192 us + 비트 수 / 속도
+//  - OFDM: 프리앰블/SIGNAL 20 us + 4 us 심볼(SERVICE 16비트 + 꼬리 6비트 포함) + 2.4 GHz 신호 확장 6 us
+inline uint32_t frameAirtimeUs(uint8_t step, size_t payloadLen) {
+    const RateStep& r = kRateLadder[(step < kRateLadderSize) ? step : 0];
+    uint32_t bits = (uint32_t)(payloadLen + kEspNowFrameOverhead) * 8;
+    if (r.phyMode == WIFI_PHY_MODE_11B) return 192 + bits / r.mbps;
+    uint32_t bitsPerSymbol = 4U * r.mbps;
+    return 20 + 4 * ((16 + 6 + bits + bitsPerSymbol - 1) / bitsPerSymbol) + 6;
+}
+
+// [NEW] 유니캐스트의 송신 완료는 수신기의 링크 계층 ACK(14바이트, SIFS 10 us 뒤) 다음에 옴
+inline uint32_t linkAckExchangeUs(uint8_t step) {
+    bool dsss = kRateLadder[(step < kRateLadderSize) ? step : 0].phyMode == WIFI_PHY_MODE_11B;
+    return dsss ? 10 + 192 + 14 * 8 : 10 + 20 + 4 * ((16 + 6 + 14 * 8 + 23) / 24) + 6;
+}
+#endif
+
 } // namespace Comm
 
 #endif // ESPNOW_COMM_SHARED_H
@@ -188,6 +188,7 @@ void HardwareManager::updateLed() {
 bool HardwareManager::isLedPatternActive() const { return _currentLedPattern != LedPatternType::LED_OFF; }
 void HardwareManager::setLed(bool on) { if (_ledState != on) { _ledState = on; digitalWrite(LED_PIN, _ledState); } }
 void HardwareManager::setMosfets(bool on) { if (_mosfetState != on) { _mosfetState = on; digitalWrite(MOSFET_PIN_1, on); digitalWrite(MOSFET_PIN_2, on); Log::Info(PSTR("HW: MOSFETs turned %s."), on ? "ON" : "OFF"); } }
+void HardwareManager::forceMosfetsOff() { digitalWrite(MOSFET_PIN_1, LOW); digitalWrite(MOSFET_PIN_2, LOW); _mosfetState = false; }
 
 LedPatternType HardwareManager::getCurrentLedPattern() const {
     return _currentLedPattern;
@@ -20,6 +20,7 @@ public:
     void setLedPattern(LedPatternType pattern, int repeatCount = 0);
     bool isLedPatternActive() const;
     void setMosfets(bool on);
+    void forceMosfetsOff(); // [NEW] 비상 정지용 즉시 출력 차단 (수신 콜백에서 호출 가능, 로그 없음)
     LedPatternType getCurrentLedPattern() const;
 
 private:
@@ -24,17 +24,32 @@ ModeManager::ModeManager(HardwareManager* hwManager, CommManager* commManager, W
       _idSetState(IdSetState::IDLE), //
       _temporaryId(0),             //
       _idSetLastInputTime(0),      //
-      _isPlaySequenceActive(false), _isDelayPhase(false), _delayPhaseEndTime(0), _playPhaseEndTime(0),
+      _isPlaySequenceActive(false), _isDelayPhase(false), _preciseFireArmed(false), _fireTimer(nullptr),
+      _fireTargetUs(0), _appliedCompensationUs(0), _appliedPlayMs(0), _stopRequested(false), _stopGuardActive(false), _stopTxMicros(0), _stopReceivedMs(0), _lastGoCommandId(0),
+      _delayPhaseEndTime(0), _playPhaseEndTime(0),
       _lastWebApiActivityTime(0), _updateDownloaded(false),
       _idBlinkPatternStarted(false),
       _previousDeviceId(DEFAULT_DEVICE_ID) //
 {
     _modeSwitchMutex = xSemaphoreCreateMutex(); //
+    memset(_currentCommandSender, 0, sizeof(_currentCommandSender)); //
+    memset(_stopSender, 0, sizeof(_stopSender)); //
+    memset(&_armedCue, 0, sizeof(_armedCue)); //
 }
 
 void ModeManager::begin() {
     _deviceId = NVS::loadDeviceId(); //
     if(_commManager) _commManager->updateMyDeviceId(_deviceId); //
+
+    // [NEW] 절대 실행 시각용 타이머 (loop 주기와 무관하게 정확한 시각에 MOSFET 켜기)
+    esp_timer_create_args_t timerArgs = {}; //
+    timerArgs.callback = &ModeManager::fireTimerCallback; //
+    timerArgs.arg = this; //
+    timerArgs.name = "fire_at"; //
+    if (esp_timer_create(&timerArgs, &_fireTimer) != ESP_OK) { //
+        Log::Warn(PSTR("MODE: 실행 타이머 생성 실패. loop 기반 타이머를 사용합니다.")); //
+        _fireTimer = nullptr; //
+    }
     Log::Info(PSTR("MODE: ModeManager initialized. Device ID is %d."), _deviceId); //
     if (_hwManager) _hwManager->setLedPattern(LedPatternType::LED_BOOT_SUCCESS); //
 }
@@ -65,6 +80,12 @@ void ModeManager::switchToMode(DeviceMode newMode, bool forceSwitch) {
 }
 
 void ModeManager::update() {
+    // [NEW] 출력은 수신 콜백에서 이미 끊겼으므로 여기서는 시퀀스 상태와 LED만 정리
+    if (_stopRequested) { //
+        _stopRequested = false; //
+        Log::Warn(PSTR("MODE: 비상 정지 수신. 진행 중인 시퀀스 %lu 중단."), _currentCommandId); //
+        stopPlaySequence(); //
+    }
     if(_hwManager) handleButtonEvent(_hwManager->getButtonEvent()); //
     if (_isPlaySequenceActive) updatePlaySequence(); //
 
@@ -147,11 +168,11 @@ void ModeManager::handleButtonEvent(ButtonEventType event) {
 }
 
 // [MODIFIED] handleEspNowCommand 함수 변경
-void ModeManager::handleEspNowCommand(const uint8_t* senderMac, const Comm::CommPacket* pkt) {
+void ModeManager::handleEspNowCommand(const uint8_t* senderMac, const Comm::CommPacket* pkt, uint32_t ackSlotDelayUs) {
     if (_currentMode == DeviceMode::MODE_ID_SET) { //
         Log::Warn(PSTR("MODE: ID_SET mode. ESP-NOW command ignored for timer logic.")); //
         if (_commManager && senderMac) { //
-            _commManager->sendAck(senderMac, pkt->txMicros, micros()); // ACK 전송 (처리 시간 포함) //
+            _commManager->sendAck(senderMac, pkt->txMicros, micros(), ackSlotDelayUs); // ACK 전송 (처리 시간 포함) //
         }
         return; //
     }
@@ -166,53 +187,32 @@ void ModeManager::handleEspNowCommand(const uint8_t* senderMac, const Comm::Comm
         // RTT 요청 패킷 수신 시, ACK만 보내고 타이머 시작하지 않음
         Log::Info(PSTR("COMM: RTT_REQUEST 패킷 수신. ACK 전송 후 최종 명령 대기.")); //
         if (_commManager && senderMac) { //
-            _commManager->sendAck(senderMac, pkt->txMicros, rxTime); //
+            _commManager->sendAck(senderMac, pkt->txMicros, rxTime, ackSlotDelayUs); //
         }
     } else if (pkt->packetType == Comm::FINAL_COMMAND) { //
         // 최종 명령 패킷 수신 시, 보정값 계산 후 타이머 시작
-        bool isNewCommandSequence = (_currentCommandId != pkt->txButtonPressMicros); //
-        
-        uint32_t originalDelayMs = pkt->delayMs; //
-        uint32_t playMs = pkt->playMs; //
-
         // [MODIFIED] 보정값은 FINAL_COMMAND 패킷에 포함된 값을 사용
         long estimatedOneWayLatencyUs = pkt->lastKnownRttUs / 2; //
         long estimatedProcessingTimeUs = pkt->lastKnownRxProcessingTimeUs; //
 
-        long totalCompensationUs = estimatedOneWayLatencyUs + estimatedProcessingTimeUs; //
-        long totalCompensationMs = totalCompensationUs / 1000L; //
-
-        if (isNewCommandSequence) { //
-            if (_isPlaySequenceActive) { //
-                Log::Info(PSTR("COMM: New sequence %lu received. Stopping previous sequence %lu."), pkt->txButtonPressMicros, _currentCommandId); //
-                stopPlaySequence(); //
-            }
-            _currentCommandId = pkt->txButtonPressMicros; //
-            _sequenceRxStartTimeUs = rxTime; // 첫 (최종 명령) 패킷 수신 시각 기록 //
-
-            long finalAdjustedDelayMs = originalDelayMs - totalCompensationMs; //
-            finalAdjustedDelayMs = std::max(0L, finalAdjustedDelayMs); //
-
-            Log::Info(PSTR("COMM: FINAL_COMMAND 패킷 수신 - ID: %u, 버튼 눌림 시간: %lu ms, 딜레이: %lu ms, 플레이: %lu ms"),
-                      pkt->targetId, pkt->txButtonPressMicros / 1000UL, originalDelayMs, playMs); //
+        if (_currentCommandId != pkt->txButtonPressMicros || (senderMac && memcmp(_currentCommandSender, senderMac, 6) != 0)) { //
             Log::Info(PSTR("COMM: 보정값 관련 내용: 포함된 RTT: %lu us, 포함된 Rx 처리: %lu us"),
                       pkt->lastKnownRttUs, pkt->lastKnownRxProcessingTimeUs); //
             Log::Info(PSTR("COMM: 계산된 보정값 (예상 통신 지연): %ld ms"), estimatedOneWayLatencyUs / 1000L); //
             Log::Info(PSTR("COMM: 계산된 보정값 (예상 수신기 처리): %ld ms"), estimatedProcessingTimeUs / 1000L); //
-            Log::Info(PSTR("COMM: 최종 통신 지연값 (총 보정값): %ld ms"), totalCompensationMs); //
-            
-            Log::Info(PSTR("MODE: 딜레이 타이머 시작. (원본: %lu ms, 보정 후: %ld ms)"), originalDelayMs, finalAdjustedDelayMs); //
-            
-            startPlaySequence(finalAdjustedDelayMs, playMs); //
-            Log::TestLog(PSTR("Receiver %u: Wait %.1f s, Execute %.1f s"), _deviceId, (float)finalAdjustedDelayMs / 1000.0f, (float)playMs / 1000.0f); // [NEW] Simplified log
-        } else { // 재전송 패킷 //
-            Log::Debug(PSTR("COMM: 시퀀스 %lu FINAL_COMMAND 재전송 수신. 타이머는 이미 실행 중. 현재 총 예상 보정값: %ld ms"), 
-                       _currentCommandId, totalCompensationMs); //
+            Log::Info(PSTR("COMM: 버튼 눌림 후 경과 시간 (패킷 전송 시점): %lu ms"), pkt->elapsedSincePressUs / 1000UL); //
         }
 
+        // [NEW] 송신부가 시계 오프셋을 알고 있으면 절대 실행 시각을 내 시계로 변환
+        int64_t fireAtLocalUs = (pkt->clockOffsetUs != Comm::kNoClockOffset) ? (int64_t)pkt->fireAtTxUs + pkt->clockOffsetUs : 0; //
+
+        // [MODIFIED] 보정값에 버튼 눌림 후 이미 지난 시간(RTT 측정, 재전송, 앞선 장치 처리)도 포함
+        applyFinalCommand(senderMac, pkt->txButtonPressMicros, pkt->delayMs, pkt->playMs,
+                          (long)pkt->elapsedSincePressUs + estimatedOneWayLatencyUs + estimatedProcessingTimeUs, rxTime, fireAtLocalUs); //
+
         // ACK 패킷 전송 (송신부로의 확인 응답)
         if (_commManager && senderMac) { //
-            _commManager->sendAck(senderMac, pkt->txMicros, rxTime); //
+            _commManager->sendAck(senderMac, pkt->txMicros, rxTime, ackSlotDelayUs); //
         }
     } else { //
         Log::Warn(PSTR("COMM: 알 수 없는 패킷 타입 %u 수신. 무시됨."), pkt->packetType); //
@@ -221,6 +221,178 @@ void ModeManager::handleEspNowCommand(const uint8_t* senderMac, const Comm::Comm
 }
 
 
+// [NEW] 일괄 명령 패킷 처리. 보정값은 송신부가 항목별로 미리 계산해 보냄
+void ModeManager::handleEspNowBatchCommand(const uint8_t* senderMac, const Comm::BatchCommandPacket* pkt, const Comm::BatchEntry* entry) {
+    // [NEW] 여러 수신기의 ACK가 겹치지 않도록 비트맵 순서에 따른 내 슬롯에서 ACK 전송
+    uint32_t slotDelayUs = (uint32_t)Comm::ackSlotIndex(pkt->targetBitmap, _deviceId) * pkt->ackSlotUs; //
+
+    if (_currentMode == DeviceMode::MODE_ID_SET) { //
+        Log::Warn(PSTR("MODE: ID_SET mode. ESP-NOW command ignored for timer logic.")); //
+        if (_commManager && senderMac) { //
+            _commManager->sendAck(senderMac, pkt->txMicros, micros(), slotDelayUs); //
+        }
+        return; //
+    }
+
+    unsigned long rxTime = micros(); // 패킷 수신 시각 (수신부 기준)
+
+    Log::Info(PSTR("COMM: BATCH_COMMAND 수신 - 항목 %u개, TX Btn: %lu us, TX Pkt: %lu us, RX: %lu us, 경과: %lu us, 보정값: %lu us"),
+              pkt->entryCount, pkt->txButtonPressMicros, pkt->txMicros, rxTime, pkt->elapsedSincePressUs, entry->compensationUs); //
+
+    // [NEW] 항목별 실행 시각 = 버튼 눌림 시각 + 지연 (송신부 시계), 오프셋으로 내 시계에 맞춤
+    int64_t fireAtLocalUs = 0; //
+    if (entry->clockOffsetUs != Comm::kNoClockOffset) { //
+        fireAtLocalUs = (int64_t)pkt->pressAtTxUs + (int64_t)entry->delayMs * 1000 + entry->clockOffsetUs; //
+    }
+
+    applyFinalCommand(senderMac, pkt->txButtonPressMicros, entry->delayMs, entry->playMs,
+                      (long)pkt->elapsedSincePressUs + (long)entry->compensationUs, rxTime, fireAtLocalUs); //
+
+    if (_commManager && senderMac) { //
+        _commManager->sendAck(senderMac, pkt->txMicros, rxTime, slotDelayUs); //
+    }
+}
+
+// [NEW] 비상 정지 빠른 경로: 로그, 캡처, ACK보다 먼저 MOSFET을 끄고 예약된 실행 타이머를 멈춤.
+// 시퀀스 상태 정리는 loop의 update()에서 하며, 그 사이 loop/타이머가 출력을 다시 켜지 않도록 _stopRequested를 먼저 세움
+void ModeManager::emergencyStop(const uint8_t* senderMac, uint32_t stopTxMicros) {
+    _stopRequested = true; //
+    _preciseFireArmed = false; //
+    if (_hwManager) _hwManager->forceMosfetsOff(); //
+    if (_fireTimer) esp_timer_stop(_fireTimer); //
+
+    if (senderMac) memcpy(_stopSender, senderMac, 6); //
+    _stopTxMicros = stopTxMicros; //
+    _stopReceivedMs = millis(); //
+    _stopGuardActive = true; //
+}
+
+// [NEW] 실행 정보 보관. 송신부는 ACK를 받은 뒤에만 이 장치를 GO_COMMAND 대상에 넣음
+void ModeManager::storeArmCue(const uint8_t* senderMac, const Comm::ArmCuePacket* cue) {
+    _armedCue.valid = false; //
+    if (senderMac) memcpy(_armedCue.sender, senderMac, 6); //
+    _armedCue.armId = cue->armId; //
+    _armedCue.delayMs = cue->delayMs; //
+    _armedCue.playMs = cue->playMs; //
+    _armedCue.compensationUs = cue->compensationUs; //
+    _armedCue.clockOffsetUs = cue->clockOffsetUs; //
+    _armedCue.offsetRefTxUs = (int64_t)cue->offsetRefTxUs; //
+    _armedCue.driftPpb = cue->driftPpb; //
+    _armedCue.valid = true; //
+    Log::Debug(PSTR("MODE: 무장 회차 %lu 실행 정보 저장 (딜레이 %lu ms, 플레이 %lu ms, 보정값 %lu us, 오프셋 %s)."),
+               cue->armId, cue->delayMs, cue->playMs, cue->compensationUs,
+               (cue->clockOffsetUs == Comm::kNoClockOffset) ? "없음" : "있음"); //
+}
+
+// [NEW] GO_COMMAND 처리. 실행 시각 = 버튼 눌림 시각 + 딜레이 (송신부 시계), 오프셋은 예약 시점 값을 드리프트로 외삽
+bool ModeManager::handleGoCommand(const uint8_t* senderMac, const Comm::GoPacket* pkt, unsigned long rxTime) {
+    const ArmedCue& cue = _armedCue; //
+    if (!cue.valid || cue.armId != pkt->armId || (senderMac && memcmp(cue.sender, senderMac, 6) != 0)) { //
+        Log::Warn(PSTR("COMM: GO_COMMAND 수신. 무장 회차 %lu의 실행 정보 없음 (보관: %lu). 개별 명령을 기다림."),
+                  pkt->armId, cue.valid ? cue.armId : 0UL); //
+        return false; //
+    }
+    if (pkt->txButtonPressMicros == _lastGoCommandId) return true; // 재전송: ACK만 다시 (시퀀스가 끝난 뒤 도착해도 다시 실행하지 않음) //
+    _lastGoCommandId = pkt->txButtonPressMicros; //
+    if (_currentMode == DeviceMode::MODE_ID_SET) { //
+        Log::Warn(PSTR("MODE: ID_SET mode. ESP-NOW command ignored for timer logic.")); //
+        return true; //
+    }
+
+    int64_t fireAtLocalUs = 0; //
+    if (cue.clockOffsetUs != Comm::kNoClockOffset) { //
+        int64_t fireAtTxUs = (int64_t)pkt->pressAtTxUs + (int64_t)cue.delayMs * 1000; //
+        int64_t offsetUs = cue.clockOffsetUs + (fireAtTxUs - cue.offsetRefTxUs) * cue.driftPpb / 1000000000LL; //
+        fireAtLocalUs = fireAtTxUs + offsetUs; //
+    }
+
+    Log::Info(PSTR("COMM: GO_COMMAND 수신 - 무장 회차 %lu, TX Btn: %lu us, 경과: %lu us, 보정값: %lu us"),
+              pkt->armId, pkt->txButtonPressMicros, pkt->elapsedSincePressUs, cue.compensationUs); //
+    applyFinalCommand(senderMac, pkt->txButtonPressMicros, cue.delayMs, cue.playMs,
+                      (long)pkt->elapsedSincePressUs + (long)cue.compensationUs, rxTime, fireAtLocalUs); //
+    return true; //
+}
+
+// 최종 명령 공통 처리: 새 시퀀스이면 보정된 지연으로 타이머 시작, 재전송이면 무시
+// [MODIFIED] totalCompensationUs는 버튼 눌림부터 내가 받기까지의 추정 시간 (경과 시간 + 단방향 지연 + 처리 시간).
+//            모든 장치가 같은 버튼 눌림 시점을 기준으로 실행되며, 실행 시각이 이미 지났으면 플레이 시간을 그만큼 잘라냄
+// [MODIFIED] 시퀀스는 (송신기 MAC, 버튼 눌림 시각)으로 구분하여 여러 송신기의 명령이 섞이지 않도록 함
+void ModeManager::applyFinalCommand(const uint8_t* senderMac, uint32_t commandId, uint32_t originalDelayMs, uint32_t playMs, long totalCompensationUs, unsigned long rxTime,
+                                    int64_t fireAtLocalUs) {
+    bool isSameSender = (senderMac == nullptr) || (memcmp(_currentCommandSender, senderMac, 6) == 0); //
+    bool isNewCommandSequence = (_currentCommandId != commandId) || !isSameSender; //
+    long totalCompensationMs = totalCompensationUs / 1000L; //
+
+    // [NEW] 비상 정지 직후, 정지보다 먼저 눌린 명령이 늦게 도착하면 다시 실행하지 않음 (commandId = 송신부 버튼 눌림 micros)
+    if (_stopGuardActive && millis() - _stopReceivedMs > STOP_GUARD_MS) _stopGuardActive = false; //
+    if (_stopGuardActive && senderMac && memcmp(_stopSender, senderMac, 6) == 0 && (int32_t)(_stopTxMicros - commandId) >= 0) { //
+        Log::Warn(PSTR("COMM: 비상 정지 이전에 눌린 명령 %lu 수신. 무시됨."), commandId); //
+        return; //
+    }
+
+    if (!isNewCommandSequence) { // 재전송 패킷
+        Log::Debug(PSTR("COMM: 시퀀스 %lu FINAL_COMMAND 재전송 수신. 타이머는 이미 실행 중. 현재 총 예상 보정값: %ld ms"),
+                   _currentCommandId, totalCompensationMs); //
+        return; //
+    }
+
+    if (_isPlaySequenceActive) { //
+        Log::Info(PSTR("COMM: New sequence %lu received. Stopping previous sequence %lu."), commandId, _currentCommandId); //
+        stopPlaySequence(); //
+    }
+    _currentCommandId = commandId; //
+    if (senderMac) memcpy(_currentCommandSender, senderMac, 6); //
+    _sequenceRxStartTimeUs = rxTime; // 첫 (최종 명령) 패킷 수신 시각 기록
+
+    long finalAdjustedDelayMs = (long)originalDelayMs - totalCompensationMs; //
+    uint32_t clippedPlayMs = playMs; //
+    if (finalAdjustedDelayMs < 0) { //
+        // 실행 시각이 이미 지남: 즉시 플레이하되 늦은 만큼 플레이 시간을 줄임
+        uint32_t overrunMs = (uint32_t)(-finalAdjustedDelayMs); //
+        clippedPlayMs = (overrunMs < playMs) ? playMs - overrunMs : 0; //
+        finalAdjustedDelayMs = 0; //
+    }
+
+    Log::Info(PSTR("COMM: FINAL_COMMAND 적용 - 버튼 눌림 시간: %lu ms, 딜레이: %lu ms, 플레이: %lu ms"),
+              commandId / 1000UL, originalDelayMs, playMs); //
+    Log::Info(PSTR("COMM: 최종 통신 지연값 (총 보정값): %ld ms"), totalCompensationMs); //
+
+    if (fireAtLocalUs != 0) { //
+        // [NEW] 절대 실행 시각과 RTT 보정 기반 예상 시각이 크게 어긋나면 (잘못된 오프셋) 보정값 방식 사용
+        int64_t nowUs = esp_timer_get_time(); //
+        int64_t rttBasedFireUs = nowUs - (int64_t)(uint32_t)(micros() - rxTime) + (int64_t)originalDelayMs * 1000 - totalCompensationUs; //
+        int64_t disagreeUs = fireAtLocalUs - rttBasedFireUs; //
+        if (disagreeUs > (int64_t)CLOCK_SYNC_SANITY_MS * 1000 || disagreeUs < -(int64_t)CLOCK_SYNC_SANITY_MS * 1000) { //
+            Log::Warn(PSTR("COMM: 절대 실행 시각이 보정값 기반 예상과 %ld ms 차이남. 보정값 방식 사용."), (long)(disagreeUs / 1000)); //
+            fireAtLocalUs = 0; //
+        } else { //
+            finalAdjustedDelayMs = (long)std::max<int64_t>(0, (fireAtLocalUs - nowUs) / 1000); //
+            Log::Info(PSTR("MODE: 절대 시각 동기화 타이머 시작. (원본: %lu ms, 남은 시간: %ld ms, 보정값 방식과 차이: %ld us)"),
+                      originalDelayMs, finalAdjustedDelayMs, (long)disagreeUs); //
+            clippedPlayMs = startPlaySequenceAt(fireAtLocalUs, playMs); //
+        }
+    }
+    if (fireAtLocalUs == 0) { //
+        if (clippedPlayMs == 0) { //
+            Log::Warn(PSTR("MODE: 플레이 종료 시각까지 이미 지남 (보정값 %ld ms). 실행하지 않음."), totalCompensationMs); //
+        } else { //
+            if (clippedPlayMs < playMs) { //
+                Log::Warn(PSTR("MODE: 실행 시각이 %lu ms 지남. 즉시 플레이하고 플레이 시간을 %lu ms로 줄임."), playMs - clippedPlayMs, clippedPlayMs); //
+            }
+            Log::Info(PSTR("MODE: 딜레이 타이머 시작. (원본: %lu ms, 보정 후: %ld ms)"), originalDelayMs, finalAdjustedDelayMs); //
+            startPlaySequence(finalAdjustedDelayMs, clippedPlayMs); //
+        }
+    }
+    // [NEW] 송신부에 무장 보고. 적용한 보정값 = 원래 딜레이 - (수신 시각부터 목표 실행 시각까지). 실행하지 않으면 중단으로 보고
+    int64_t rxLocalUs = esp_timer_get_time() - (int64_t)(uint32_t)(micros() - rxTime); //
+    if (clippedPlayMs == 0) _fireTargetUs = (fireAtLocalUs != 0) ? fireAtLocalUs : rxLocalUs + (int64_t)originalDelayMs * 1000 - totalCompensationUs; //
+    _appliedCompensationUs = (int32_t)((int64_t)originalDelayMs * 1000 - (_fireTargetUs - rxLocalUs)); //
+    _appliedPlayMs = clippedPlayMs; //
+    reportPhase((clippedPlayMs > 0) ? Comm::PHASE_ARMED : Comm::PHASE_ABORTED, esp_timer_get_time()); //
+
+    Log::TestLog(PSTR("Receiver %u: Wait %.1f s, Execute %.1f s"), _deviceId, (float)finalAdjustedDelayMs / 1000.0f, (float)clippedPlayMs / 1000.0f); // [NEW] Simplified log
+}
+
 void ModeManager::triggerManualRun(uint32_t delayMs, uint32_t playMs) {
     if (_currentMode == DeviceMode::MODE_TEST || _currentMode == DeviceMode::MODE_WIFI) { //
         if (_isPlaySequenceActive) { //
@@ -347,24 +519,27 @@ void ModeManager::updateModeWifi() {
 }
 
 void ModeManager::updatePlaySequence() {
+    if (_stopRequested) return; // [NEW] 비상 정지 정리 전에는 출력을 다시 켜지 않음
     unsigned long currentTime = millis(); //
-    if (_isDelayPhase && currentTime >= _delayPhaseEndTime) { //
+    if (_isDelayPhase && !_preciseFireArmed && currentTime >= _delayPhaseEndTime) { //
         _isDelayPhase = false; //
         if (_hwManager) { //
             _hwManager->setMosfets(true); //
             _hwManager->setLedPattern(LedPatternType::LED_ON); //
         }
+        recordFire(); //
         Log::Info(PSTR("MODE: Delay phase completed. Playing.")); //
     }
     if (currentTime >= _playPhaseEndTime) { //
-        stopPlaySequence(); //
+        stopPlaySequence(Comm::PHASE_PLAY_ENDED); //
         Log::Info(PSTR("MODE: Play phase completed.")); //
     }
 }
 
-void ModeManager::startPlaySequence(uint32_t delayMs, uint32_t playMs) {
+void ModeManager::startPlaySequence(uint32_t delayMs, uint32_t playMs, int64_t fireTargetUs) {
     unsigned long currentTime = millis(); //
     _isPlaySequenceActive = true; //
+    _fireTargetUs = (fireTargetUs != 0) ? fireTargetUs : esp_timer_get_time() + (int64_t)delayMs * 1000; // [NEW] 캡처용 목표 실행 시각
     _delayPhaseEndTime = currentTime + delayMs; //
     _playPhaseEndTime = _delayPhaseEndTime + playMs; //
 
@@ -383,15 +558,80 @@ void ModeManager::startPlaySequence(uint32_t delayMs, uint32_t playMs) {
             _hwManager->setMosfets(true); //
             _hwManager->setLedPattern(LedPatternType::LED_ON); //
         }
+        recordFire(); //
         Log::Info(PSTR("MODE: No delay. Playing immediately.")); //
     }
 }
 
-void ModeManager::stopPlaySequence() {
+// [NEW] 딜레이 종료를 절대 시각에 맞춤. 종료 전환은 esp_timer 콜백이 하고 loop는 플레이 종료만 처리
+// [MODIFIED] 실행 시각이 이미 지났으면 즉시 플레이하고 늦은 만큼 잘라낸 플레이 시간을 반환 (0이면 실행하지 않음)
+uint32_t ModeManager::startPlaySequenceAt(int64_t fireAtLocalUs, uint32_t playMs) {
+    int64_t waitUs = fireAtLocalUs - esp_timer_get_time(); //
+    if (waitUs <= 0) { //
+        uint32_t overrunMs = (uint32_t)std::min<int64_t>(UINT32_MAX, -waitUs / 1000); //
+        if (overrunMs >= playMs) { //
+            Log::Warn(PSTR("MODE: 플레이 종료 시각까지 이미 지남 (%lu ms 늦음). 실행하지 않음."), overrunMs); //
+            return 0; //
+        }
+        if (overrunMs > 0) { //
+            Log::Warn(PSTR("MODE: 실행 시각이 %lu ms 지남. 즉시 플레이하고 플레이 시간을 %lu ms로 줄임."), overrunMs, playMs - overrunMs); //
+        }
+        startPlaySequence(0, playMs - overrunMs, fireAtLocalUs); //
+        return playMs - overrunMs; //
+    }
+    if (_fireTimer == nullptr) { //
+        startPlaySequence((uint32_t)((waitUs + 999) / 1000), playMs, fireAtLocalUs); //
+        return playMs; //
+    }
+
+    startPlaySequence((uint32_t)((waitUs + 999) / 1000), playMs, fireAtLocalUs); //
+    _playPhaseEndTime = (unsigned long)(fireAtLocalUs / 1000) + playMs; // millis()와 같은 시간축 (esp_timer / 1000)
+    _preciseFireArmed = true; //
+    if (esp_timer_start_once(_fireTimer, (uint64_t)waitUs) != ESP_OK) { //
+        _preciseFireArmed = false; //
+        Log::Warn(PSTR("MODE: 실행 타이머 시작 실패. loop 기반 타이머로 대체.")); //
+    }
+    return playMs; //
+}
+
+void ModeManager::fireTimerCallback(void* arg) {
+    static_cast<ModeManager*>(arg)->onFireTimer(); //
+}
+
+void ModeManager::onFireTimer() {
+    if (!_preciseFireArmed) return; //
+    _preciseFireArmed = false; //
+    if (!_isPlaySequenceActive || !_isDelayPhase) return; //
+
+    _isDelayPhase = false; //
+    if (_hwManager) { //
+        _hwManager->setMosfets(true); //
+        _hwManager->setLedPattern(LedPatternType::LED_ON); //
+        if (!_isPlaySequenceActive || _stopRequested) _hwManager->setMosfets(false); // 그 사이 stopPlaySequence() 또는 비상 정지가 호출된 경우
+    }
+    recordFire(); //
+}
+
+// [NEW] 출력을 켠 시각을 목표 시각과 함께 패킷 캡처에 기록 (실행 오차 분석용)
+void ModeManager::recordFire() {
+    int64_t actualUs = esp_timer_get_time(); //
+    if (_commManager) _commManager->captureFire(_currentCommandId, _fireTargetUs, actualUs); //
+    reportPhase(Comm::PHASE_PLAY_STARTED, actualUs); // [NEW]
+}
+
+void ModeManager::reportPhase(Comm::ExecPhase phase, int64_t eventLocalUs) {
+    if (_currentCommandId == 0 || !_commManager) return; //
+    _commManager->sendPhaseReport(_currentCommandSender, phase, _currentCommandId, eventLocalUs, _fireTargetUs, _appliedCompensationUs, _appliedPlayMs); //
+}
+
+void ModeManager::stopPlaySequence(Comm::ExecPhase endPhase) {
     if (_isPlaySequenceActive) { //
         _isPlaySequenceActive = false; //
+        _preciseFireArmed = false; //
+        if (_fireTimer) esp_timer_stop(_fireTimer); //
         if (_hwManager) _hwManager->setMosfets(false); //
         if (_hwManager) _hwManager->setLedPattern(LedPatternType::LED_OFF); //
+        reportPhase(endPhase, esp_timer_get_time()); // [NEW]
 
         if (_currentCommandId != 0) { //
              Log::Info(PSTR("COMM: Sequence %lu completed or stopped."), _currentCommandId); //
@@ -440,6 +680,7 @@ void ModeManager::updateDeviceId(uint8_t newId, bool fromWeb) {
         Log::Warn(PSTR("MODE: Attempted to set invalid Device ID: %d. Keeping current ID: %d."), newId, _deviceId); //
         return; //
     }
+    if (newId != _deviceId) _armedCue.valid = false; // [NEW] 다른 ID의 실행 정보로 실행하지 않도록 //
     _deviceId = newId; //
     NVS::saveDeviceId(_deviceId); //
     if (_commManager) _commManager->updateMyDeviceId(_deviceId); //
@@ -13,6 +13,7 @@
 #include "espnow_comm_shared.h" // CommPacket 구조체 정의를 위해 필요
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
+#include <esp_timer.h>
 
 class HardwareManager;
 class CommManager;
@@ -29,7 +30,15 @@ public:
 
     void handleButtonEvent(ButtonEventType event);
     // [MODIFIED] CommPacket을 const 참조 대신 const 포인터로 받음 (CommManager에서 이미 포인터 사용)
-    void handleEspNowCommand(const uint8_t* senderMac, const Comm::CommPacket* pkt); 
+    void handleEspNowCommand(const uint8_t* senderMac, const Comm::CommPacket* pkt, uint32_t ackSlotDelayUs = 0); // [MODIFIED] 그룹 주소 명령은 슬롯 ACK 
+    // [NEW] 일괄 명령 패킷에서 꺼낸 내 항목 처리
+    void handleEspNowBatchCommand(const uint8_t* senderMac, const Comm::BatchCommandPacket* pkt, const Comm::BatchEntry* entry);
+    // [NEW] 비상 정지 빠른 경로 (ESP-NOW 수신 콜백에서 호출). 출력만 즉시 끄고 나머지 정리는 update()에서
+    void emergencyStop(const uint8_t* senderMac, uint32_t stopTxMicros);
+    // [NEW] ARM_CUE로 받은 실행 정보 보관 (마지막 하나만)
+    void storeArmCue(const uint8_t* senderMac, const Comm::ArmCuePacket* cue);
+    // [NEW] GO_COMMAND 처리 (ESP-NOW 수신 콜백에서 호출). 보관한 실행 정보가 맞으면 실행하고 true (ACK 대상)
+    bool handleGoCommand(const uint8_t* senderMac, const Comm::GoPacket* pkt, unsigned long rxTime);
     void triggerManualRun(uint32_t delayMs, uint32_t playMs);
     void switchToMode(DeviceMode newMode, bool forceSwitch = false);
     
@@ -43,6 +52,19 @@ public:
     void applyUpdateAndReboot();
 
 private:
+    // [NEW] ARM_CUE로 미리 받은 실행 정보
+    struct ArmedCue {
+        bool     valid;
+        uint8_t  sender[6];
+        uint32_t armId;
+        uint32_t delayMs;
+        uint32_t playMs;
+        uint32_t compensationUs;
+        int64_t  clockOffsetUs;         // Comm::kNoClockOffset이면 보정값 방식
+        int64_t  offsetRefTxUs;
+        int32_t  driftPpb;
+    };
+
     HardwareManager* _hwManager;
     CommManager* _commManager;
     WebManager* _webManager;
@@ -52,6 +74,7 @@ private:
     
     SemaphoreHandle_t _modeSwitchMutex;
     uint32_t _currentCommandId;
+    uint8_t _currentCommandSender[6]; // [NEW] 현재 시퀀스를 보낸 송신기 MAC (여러 송신기 구분)
 
     // [MODIFIED] _sequenceRxStartTimeUs는 이제 최종 명령 패킷을 받은 시점의 타임스탬프를 의미
     unsigned long _sequenceRxStartTimeUs; 
@@ -60,8 +83,20 @@ private:
     uint8_t _temporaryId;
     unsigned long _idSetLastInputTime;
 
-    bool _isPlaySequenceActive;
-    bool _isDelayPhase;
+    volatile bool _isPlaySequenceActive;
+    volatile bool _isDelayPhase;
+    volatile bool _preciseFireArmed;  // [NEW] 딜레이 종료를 esp_timer가 처리 중이면 true (loop에서는 전환하지 않음)
+    esp_timer_handle_t _fireTimer;    // [NEW] 절대 실행 시각에 MOSFET을 켜는 one-shot 타이머
+    int64_t _fireTargetUs;            // [NEW] 현재 시퀀스의 목표 실행 시각 (esp_timer, 캡처 기록용)
+    int32_t _appliedCompensationUs;   // [NEW] 현재 시퀀스에 실제로 적용한 보정값 (단계 보고용)
+    uint32_t _appliedPlayMs;          // [NEW] 현재 시퀀스의 실제 플레이 시간 (잘림 반영)
+    volatile bool _stopRequested;     // [NEW] 수신 콜백이 비상 정지로 출력을 끊음 (loop에서 시퀀스 정리)
+    bool _stopGuardActive;            // [NEW] 정지 전에 눌린 명령을 무시하는 중
+    uint8_t _stopSender[6];           // [NEW] 마지막 비상 정지를 보낸 송신기 MAC
+    uint32_t _stopTxMicros;           // [NEW] 마지막 비상 정지 패킷의 송신부 micros() (버튼 눌림 시각과 같은 시간축)
+    unsigned long _stopReceivedMs;
+    ArmedCue _armedCue;               // [NEW] 수신 콜백에서만 기록 (ID가 바뀌면 무효화)
+    uint32_t _lastGoCommandId;        // [NEW] 마지막으로 처리한 GO_COMMAND의 버튼 눌림 micros (재전송 구분)
     unsigned long _delayPhaseEndTime;
     unsigned long _playPhaseEndTime;
 
@@ -79,8 +114,20 @@ private:
     void updateModeWifi();
     void updatePlaySequence();
 
-    void startPlaySequence(uint32_t delayMs, uint32_t playMs);
-    void stopPlaySequence();
+    // [MODIFIED] fireAtLocalUs: 수신부 esp_timer 기준 절대 실행 시각 (0이면 RTT 보정값 방식 사용)
+    void applyFinalCommand(const uint8_t* senderMac, uint32_t commandId, uint32_t originalDelayMs, uint32_t playMs, long totalCompensationUs, unsigned long rxTime,
+                           int64_t fireAtLocalUs = 0);
+    // [MODIFIED] fireTargetUs: 캡처에 기록할 목표 실행 시각 (0이면 지금 + delayMs)
+    void startPlaySequence(uint32_t delayMs, uint32_t playMs, int64_t fireTargetUs = 0);
+    // [NEW] 절대 시각(수신부 esp_timer)에 딜레이가 끝나도록 재생 시퀀스 시작. 실제 플레이 시간(이미 지난 만큼 잘림) 반환
+    uint32_t startPlaySequenceAt(int64_t fireAtLocalUs, uint32_t playMs);
+    static void fireTimerCallback(void* arg);
+    void onFireTimer();
+    void recordFire();
+    // [NEW] 송신기에 현재 시퀀스의 실행 단계 보고 (수동 실행은 보고하지 않음)
+    void reportPhase(Comm::ExecPhase phase, int64_t eventLocalUs);
+    // [MODIFIED] endPhase: 송신기에 보고할 종료 단계 (플레이 시간을 채웠으면 PHASE_PLAY_ENDED)
+    void stopPlaySequence(Comm::ExecPhase endPhase = Comm::PHASE_ABORTED);
     void incrementTemporaryId();
     void finalizeIdSelection();
     const char* getModeName(DeviceMode mode) const;
@@ -58,6 +58,8 @@ void setup() {
  */
 void loop() {
     modeManager.update();
+    commManager.handleSerialCommands(); // [NEW] 캡처 덤프 명령
+    commManager.update();               // [NEW] 채널 전환 예약 처리, 송신기를 잃으면 채널 탐색
     esp_task_wdt_reset();
     delay(5); 
 }
@@ -16,6 +16,8 @@ const char* NVS::KEY_WIFI_SSID = "wifi_ssid"; //
 const char* NVS::KEY_WIFI_PASS = "wifi_pass"; //
 const char* NVS::KEY_TEST_DELAY = "test_delay"; //
 const char* NVS::KEY_TEST_PLAY = "test_play"; //
+const char* NVS::KEY_CHANNEL = "espnow_ch"; //
+const char* NVS::KEY_GROUP_OWNERS = "grp_owners"; // [NEW] //
 Preferences NVS::preferences; //
 
 // --- Log 구현 ---
@@ -79,4 +81,11 @@ void NVS::saveWifiPassword(const String& password) { preferences.putString(KEY_W
 uint32_t NVS::loadTestDelay() { return preferences.getUInt(KEY_TEST_DELAY, DEFAULT_TEST_DELAY_MS); } //
 void NVS::saveTestDelay(uint32_t delayMs) { if(loadTestDelay() != delayMs) preferences.putUInt(KEY_TEST_DELAY, delayMs); } //
 uint32_t NVS::loadTestPlay() { return preferences.getUInt(KEY_TEST_PLAY, DEFAULT_TEST_PLAY_MS); } //
-void NVS::saveTestPlay(uint32_t playMs) { if(loadTestPlay() != playMs) preferences.putUInt(KEY_TEST_PLAY, playMs); } //
\ No newline at end of file
+void NVS::saveTestPlay(uint32_t playMs) { if(loadTestPlay() != playMs) preferences.putUInt(KEY_TEST_PLAY, playMs); } //
+uint8_t NVS::loadChannel() { return preferences.getUChar(KEY_CHANNEL, ESP_NOW_CHANNEL); } //
+void NVS::saveChannel(uint8_t channel) { if(loadChannel() != channel) preferences.putUChar(KEY_CHANNEL, channel); } //
+bool NVS::loadGroupOwners(void* owners, size_t len) {
+    if (preferences.getBytesLength(KEY_GROUP_OWNERS) != len) return false;
+    return preferences.getBytes(KEY_GROUP_OWNERS, owners, len) == len;
+}
+void NVS::saveGroupOwners(const void* owners, size_t len) { preferences.putBytes(KEY_GROUP_OWNERS, owners, len); } // 바뀐 경우에만 호출됨
\ No newline at end of file
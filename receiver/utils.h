@@ -77,6 +77,10 @@ public:
     static void saveTestDelay(uint32_t delayMs);
     static uint32_t loadTestPlay();
     static void saveTestPlay(uint32_t playMs);
+    static uint8_t loadChannel();             // [NEW] 마지막 ESP-NOW 채널
+    static void saveChannel(uint8_t channel); // [NEW]
+    static bool loadGroupOwners(void* owners, size_t len);        // [NEW] 송신기(MAC)별 그룹 등록 표. 저장된 크기가 다르면 false
+    static void saveGroupOwners(const void* owners, size_t len);  // [NEW]
     
 private:
     static Preferences preferences;
@@ -86,6 +90,8 @@ private:
     static const char* KEY_WIFI_PASS;
     static const char* KEY_TEST_DELAY;
     static const char* KEY_TEST_PLAY;
+    static const char* KEY_CHANNEL;
+    static const char* KEY_GROUP_OWNERS;
 };
 
 // --- JSON 문서 크기 ---
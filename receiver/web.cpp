@@ -11,6 +11,7 @@
  */
 #include "web.h" //
 #include "mode.h" //
+#include "comm.h" // [NEW] 패킷 캡처 덤프용
 #include <WiFi.h> //
 #include <WiFiClientSecure.h> //
 #include <HTTPClient.h> //
@@ -19,6 +20,8 @@
 #include <algorithm> //
 #include <esp_task_wdt.h> //
 
+extern CommManager commManager; // [NEW] 패킷 캡처 덤프용
+
 WebManager::WebManager() :
     _server(80), _ws("/ws"), _modeManager(nullptr), _isServerRunning(false),
     _otaUpdateDownloaded(false), _currentFirmwareVersion(FIRMWARE_VERSION), //
@@ -102,6 +105,7 @@ void WebManager::setupRoutes() {
     _server.on("/api/devicestatus", HTTP_GET, [this](AsyncWebServerRequest* r){ handleDeviceStatusApi(r); }); //
     _server.on("/api/setdeviceid", HTTP_POST, [this](AsyncWebServerRequest* r){ handleSetDeviceIdApi(r); }); //
     _server.on("/api/runtest", HTTP_POST, [this](AsyncWebServerRequest* r){ handleRunTestApi(r); }); //
+    _server.on("/api/capture", HTTP_GET, [this](AsyncWebServerRequest* r){ handleCaptureApi(r); }); // [NEW]
     _server.onNotFound([this](AsyncWebServerRequest* r){ handleNotFound(r); }); //
     _ws.onEvent([this](auto *s, auto *c, AwsEventType t, void *a, uint8_t *d, size_t l) { onWsEvent(s, c, t, a, d, l); }); //
     _server.addHandler(&_ws); //
@@ -542,6 +546,22 @@ void WebManager::handleSetDeviceIdApi(AsyncWebServerRequest* request) {
     request->send(200); //
 }
 
+// [NEW] 패킷 캡처 덤프 파일 다운로드 (?clear=1 이면 덤프 후 캡처 링 초기화)
+void WebManager::handleCaptureApi(AsyncWebServerRequest* request) {
+    AsyncResponseStream* response = request->beginResponseStream("application/octet-stream"); //
+    bool ok = commManager.dumpCapture([response](const uint8_t* data, size_t len) { response->write(data, len); }); //
+    if (!ok) { //
+        delete response; //
+        request->send(503, "text/plain", "Capture buffer allocation failed"); //
+        return; //
+    }
+    if (request->hasParam("clear") && request->getParam("clear")->value() == "1") commManager.clearCapture(); //
+    char disposition[48]; //
+    snprintf(disposition, sizeof(disposition), "attachment; filename=\"capture_rx%u.bin\"", (unsigned)NVS::loadDeviceId()); //
+    response->addHeader("Content-Disposition", disposition); //
+    request->send(response); //
+}
+
 void WebManager::handleRunTestApi(AsyncWebServerRequest* request) {
     uint32_t delayMs = NVS::loadTestDelay(); //
     uint32_t playMs = NVS::loadTestPlay(); //
@@ -68,6 +68,7 @@ private:
     void handleSetDeviceIdApi(AsyncWebServerRequest *request);
     void handleSetTestParamsApi(AsyncWebServerRequest *request);
     void handleRunTestApi(AsyncWebServerRequest *request);
+    void handleCaptureApi(AsyncWebServerRequest *request); // [NEW] 패킷 캡처 덤프
     
     void startSoftAP();
     bool fetchOtaVersionInfo();
@@ -0,0 +1,381 @@
+/**
+ * @file capture_analyzer.cpp
+ * @brief 송신부/수신부 패킷 캡처 덤프 분석 도구 (호스트 PC용)
+ * @version 1.0.0
+ * @date 2024-06-13
+ *
+ * 빌드:  g++ -std=c++17 -O2 -o capture_analyzer tools/capture_analyzer.cpp
+ * 사용:  capture_analyzer <덤프 파일>...
+ *   - 바이너리 덤프 (수신부 /api/capture 다운로드) 또는
+ *   - 시리얼 로그 ("capture" 명령 출력, #CAPTURE BEGIN/END 사이 16진수 줄만 사용. 한 로그에 여러 덤프 가능)
+ *
+ * 출력 (장치별 min / p50 / p90 / p99 / max / mean, 단위 us):
+ *   - RTT: ACK의 originalTxMicros와 같은 txMicros로 보낸 송신 레코드를 짝지어 계산.
+ *          raw = ACK 수신 - 명령 송신, net = raw - 수신기 처리 시간 - ACK 슬롯 대기
+ *   - 재전송: (대상, 메시지) 별 송신 횟수 분포, 호출/전달 실패 수
+ *   - 실행 오차: 수신부 덤프의 출력 시작 실제 시각 - 목표 시각 (수신부 자체 시계 기준)
+ *   - 수신 RSSI
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+// espnow_comm_shared.h는 펌웨어 외부에서 micros() 선언만 요구함 (분석 도구는 호출하지 않음)
+unsigned long micros() { return 0; }
+
+#include "../transmitter/capture_shared.h"
+
+namespace {
+
+struct Record {
+    Capture::RecordHeader header;
+    std::vector<uint8_t> data;
+};
+
+struct Dump {
+    std::string source;
+    Capture::FileHeader header;
+    std::vector<Record> records;
+};
+
+//---------------------------------------------------------------------
+//  입력 파싱
+//---------------------------------------------------------------------
+bool parseDump(const std::vector<uint8_t>& bytes, const std::string& source, Dump& out) {
+    using namespace Capture;
+    if (bytes.size() < FileHeaderSchema::kWireSize) return false;
+    FileHeaderSchema::decode(bytes.data(), out.header);
+    if (out.header.magic != kFileMagic || out.header.formatVersion != kFormatVersion) return false;
+
+    out.source = source;
+    size_t pos = FileHeaderSchema::kWireSize;
+    for (uint16_t i = 0; i < out.header.recordCount; ++i) {
+        Record rec;
+        if (pos + RecordHeaderSchema::kWireSize > bytes.size()) return false;
+        RecordHeaderSchema::decode(bytes.data() + pos, rec.header);
+        pos += RecordHeaderSchema::kWireSize;
+        if (pos + rec.header.capLen > bytes.size()) return false;
+        rec.data.assign(bytes.begin() + pos, bytes.begin() + pos + rec.header.capLen);
+        pos += rec.header.capLen;
+        out.records.push_back(std::move(rec));
+    }
+    return true;
+}
+
+bool hexLineToBytes(const std::string& line, std::vector<uint8_t>& out) {
+    std::string hex;
+    for (char c : line) {
+        if (std::isxdigit((unsigned char)c)) hex += c;
+        else if (!std::isspace((unsigned char)c)) return false; // 덤프 사이에 섞인 로그 줄
+    }
+    if (hex.empty() || hex.size() % 2 != 0) return false;
+    for (size_t i = 0; i < hex.size(); i += 2) out.push_back((uint8_t)std::strtoul(hex.substr(i, 2).c_str(), nullptr, 16));
+    return true;
+}
+
+bool loadFile(const std::string& path, std::vector<Dump>& dumps) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::fprintf(stderr, "%s: 파일을 열 수 없음\n", path.c_str());
+        return false;
+    }
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    Dump dump;
+    if (parseDump(bytes, path, dump)) {
+        dumps.push_back(std::move(dump));
+        return true;
+    }
+
+    // 시리얼 로그: #CAPTURE BEGIN ~ #CAPTURE END 블록마다 하나의 덤프
+    std::istringstream text(std::string(bytes.begin(), bytes.end()));
+    std::string line;
+    std::vector<uint8_t> block;
+    bool inBlock = false;
+    int blockNo = 0, loaded = 0;
+    while (std::getline(text, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.find("#CAPTURE BEGIN") != std::string::npos) {
+            inBlock = true;
+            block.clear();
+        } else if (inBlock && line.find("#CAPTURE") != std::string::npos) {
+            inBlock = false;
+            ++blockNo;
+            Dump blockDump;
+            std::string name = path + "#" + std::to_string(blockNo);
+            if (line.find("#CAPTURE END") != std::string::npos && parseDump(block, name, blockDump)) {
+                dumps.push_back(std::move(blockDump));
+                ++loaded;
+            } else {
+                std::fprintf(stderr, "%s: 손상되었거나 실패한 덤프 블록 건너뜀\n", name.c_str());
+            }
+        } else if (inBlock) {
+            hexLineToBytes(line, block);
+        }
+    }
+    if (loaded == 0) std::fprintf(stderr, "%s: 캡처 덤프를 찾지 못함\n", path.c_str());
+    return loaded > 0;
+}
+
+//---------------------------------------------------------------------
+//  통계
+//---------------------------------------------------------------------
+class Distribution {
+public:
+    void add(int64_t v) { _values.push_back(v); }
+    size_t size() const { return _values.size(); }
+
+    void print(const char* label) {
+        if (_values.empty()) {
+            std::printf("  %-22s n=0\n", label);
+            return;
+        }
+        std::sort(_values.begin(), _values.end());
+        double sum = 0;
+        for (int64_t v : _values) sum += (double)v;
+        std::printf("  %-22s n=%-6zu min=%-8lld p50=%-8lld p90=%-8lld p99=%-8lld max=%-8lld mean=%.1f\n",
+                    label, _values.size(), (long long)_values.front(), (long long)percentile(50),
+                    (long long)percentile(90), (long long)percentile(99), (long long)_values.back(),
+                    sum / (double)_values.size());
+    }
+
+private:
+    // nearest-rank 백분위 (정렬된 상태에서만 호출)
+    int64_t percentile(unsigned p) const {
+        size_t rank = (size_t)std::ceil(p / 100.0 * (double)_values.size());
+        return _values[rank > 0 ? rank - 1 : 0];
+    }
+
+    std::vector<int64_t> _values;
+};
+
+struct DeviceStats {
+    Distribution rttRaw;
+    Distribution rttNet;
+    Distribution attempts;
+    Distribution fireSkew;
+    Distribution rssi;
+    uint32_t unmatchedAcks = 0;
+};
+
+struct TxCounters {
+    uint32_t sends = 0;
+    uint32_t sendCallFailed = 0;
+    uint32_t deliveryFailed = 0;
+    uint32_t badFrames = 0;
+    uint32_t truncated = 0;
+};
+
+// 송신 레코드 타임스탬프(esp_timer)와 패킷의 32비트 micros()로 64비트 송신 시각 복원
+int64_t widenMicros(uint64_t nearUs, uint32_t lowUs) {
+    return (int64_t)nearUs - (int64_t)(uint32_t)((uint32_t)nearUs - lowUs);
+}
+
+// 잘린 프레임은 검사값 확인 없이 고정 필드만 디코딩 (완전한 프레임은 검사값까지 확인)
+template<typename SchemaT>
+bool decodeCaptured(const Record& rec, typename SchemaT::Struct& out, TxCounters& counters) {
+    const std::vector<uint8_t>& d = rec.data;
+    if (rec.header.capLen < rec.header.origLen) {
+        counters.truncated++;
+        if (d.size() < SchemaT::kWireSize) return false;
+        SchemaT::decode(d.data(), out);
+        return true;
+    }
+    if (Comm::decodeFrame<SchemaT>(d.data(), d.size(), out)) return true;
+    counters.badFrames++;
+    return false;
+}
+
+// 송신한 명령 하나 (ACK와 짝짓기용)
+struct SentCommand {
+    int64_t  txUs;
+    uint32_t txMicros;
+    uint8_t  targetId;          // 단일 명령 대상 (일괄 명령은 0)
+    uint32_t targetBitmap;      // 일괄 명령 대상 비트맵
+    uint16_t ackSlotUs;
+    bool     slotById = false;  // [NEW] 그룹 주소 명령: 장치 ID 순서 슬롯에서 ACK
+};
+
+void analyzeTransmitter(const Dump& dump, std::map<uint8_t, DeviceStats>& devices, TxCounters& counters) {
+    using namespace Comm;
+    std::vector<SentCommand> sent;
+    std::map<std::pair<uint8_t, uint64_t>, uint32_t> attemptsByMessage; // (대상, 메시지 키) -> 송신 횟수
+
+    for (const Record& rec : dump.records) {
+        const std::vector<uint8_t>& d = rec.data;
+        if (rec.header.kind == Capture::REC_TX_DONE) {
+            if (rec.header.status != Capture::STATUS_OK) counters.deliveryFailed++;
+            continue;
+        }
+        if (d.size() < kHeaderSize || memcmp(d.data(), kSig, 4) != 0) continue;
+        uint8_t version = d[kVersionOffset];
+
+        if (rec.header.kind == Capture::REC_TX) {
+            counters.sends++;
+            if (rec.header.status != Capture::STATUS_OK) {
+                counters.sendCallFailed++;
+                continue;
+            }
+            uint8_t type = d[kPacketTypeOffset];
+            if (version == kLegacyVersion) {
+                LegacyCommPacketV3 pkt;
+                if (d.size() < LegacyCommPacketSchemaV3::kWireSize) continue;
+                LegacyCommPacketSchemaV3::decode(d.data(), pkt);
+                sent.push_back({ widenMicros(rec.header.timestampUs, pkt.txMicros), pkt.txMicros, pkt.targetId, 0, 0 });
+                // v3에는 seq가 없으므로 버튼 눌림 시각과 타입으로 메시지 구분
+                attemptsByMessage[{ pkt.targetId, ((uint64_t)pkt.packetType << 32) | pkt.txButtonPressMicros }]++;
+            } else if (type == BATCH_COMMAND) {
+                BatchCommandPacket pkt;
+                if (!decodeCaptured<BatchHeaderSchema>(rec, pkt, counters)) continue;
+                sent.push_back({ widenMicros(rec.header.timestampUs, pkt.txMicros), pkt.txMicros, 0, pkt.targetBitmap, pkt.ackSlotUs });
+                for (uint8_t id = 1; id <= 32; ++id) {
+                    if (pkt.targetBitmap & (1UL << (id - 1))) attemptsByMessage[{ id, ((uint64_t)type << 32) | pkt.seq }]++;
+                }
+            } else if (type == STOP_COMMAND) {
+                // 비상 정지는 시퀀스 번호 없이 반복 전송되므로 재전송 통계에는 넣지 않고 ACK 대조만 함
+                StopPacket pkt;
+                if (!decodeCaptured<StopPacketSchema>(rec, pkt, counters)) continue;
+                sent.push_back({ widenMicros(rec.header.timestampUs, pkt.txMicros), pkt.txMicros, 0, pkt.targetBitmap, pkt.ackSlotUs });
+            } else if (type == CHANNEL_HOP) {
+                // 채널 전환도 전환 시각까지 반복 전송되므로 ACK 대조만 함
+                ChannelHopPacket pkt;
+                if (!decodeCaptured<ChannelHopPacketSchema>(rec, pkt, counters)) continue;
+                sent.push_back({ widenMicros(rec.header.timestampUs, pkt.txMicros), pkt.txMicros, 0, pkt.targetBitmap, pkt.ackSlotUs });
+            } else if (type == GO_COMMAND) {
+                // GO는 재전송마다 남은 장치만 비트맵에 넣으므로 버튼 눌림 시각으로 메시지 구분
+                GoPacket pkt;
+                if (!decodeCaptured<GoPacketSchema>(rec, pkt, counters)) continue;
+                sent.push_back({ widenMicros(rec.header.timestampUs, pkt.txMicros), pkt.txMicros, 0, pkt.targetBitmap, pkt.ackSlotUs });
+                for (uint8_t id = 1; id <= 32; ++id) {
+                    if (pkt.targetBitmap & (1UL << (id - 1))) attemptsByMessage[{ id, ((uint64_t)type << 32) | pkt.txButtonPressMicros }]++;
+                }
+            } else if (type == ARM_CUE) {
+                ArmCuePacket pkt;
+                if (!decodeCaptured<ArmCuePacketSchema>(rec, pkt, counters)) continue;
+                sent.push_back({ widenMicros(rec.header.timestampUs, pkt.txMicros), pkt.txMicros, pkt.targetId, 0, 0 });
+                attemptsByMessage[{ pkt.targetId, ((uint64_t)type << 32) | pkt.seq }]++;
+            } else if (type == GROUP_CONFIG) {
+                GroupConfigPacket pkt;
+                if (!decodeCaptured<GroupConfigPacketSchema>(rec, pkt, counters)) continue;
+                sent.push_back({ widenMicros(rec.header.timestampUs, pkt.txMicros), pkt.txMicros, pkt.targetId, 0, 0 });
+                attemptsByMessage[{ pkt.targetId, ((uint64_t)type << 32) | pkt.seq }]++;
+            } else if (type == RTT_REQUEST || type == FINAL_COMMAND) {
+                CommPacket pkt;
+                if (!decodeCaptured<CommPacketSchema>(rec, pkt, counters)) continue;
+                if (isGroupTarget(pkt.targetId)) {
+                    // [NEW] 그룹 주소 명령은 구성원을 알 수 없으므로 ACK 대조만 함 (슬롯 폭은 TLV, ID 2의 대기 시간 = 슬롯 하나)
+                    uint16_t ackSlotUs = (uint16_t)groupAckDelayUs(d.data(), d.size(), 2);
+                    sent.push_back({ widenMicros(rec.header.timestampUs, pkt.txMicros), pkt.txMicros, 0, 0, ackSlotUs, true });
+                    continue;
+                }
+                sent.push_back({ widenMicros(rec.header.timestampUs, pkt.txMicros), pkt.txMicros, pkt.targetId, 0, 0 });
+                attemptsByMessage[{ pkt.targetId, ((uint64_t)type << 32) | pkt.seq }]++;
+            }
+            continue;
+        }
+
+        if (rec.header.kind != Capture::REC_RX) continue;
+        uint8_t senderId;
+        uint32_t originalTxMicros, rxProcessingTimeUs;
+        if (version == kLegacyVersion) {
+            LegacyAckPacketV3 ack;
+            if (!verifyLegacyAckPacketV3(d.data(), d.size(), ack)) {
+                counters.badFrames++;
+                continue;
+            }
+            senderId = ack.senderId;
+            originalTxMicros = ack.originalTxMicros;
+            rxProcessingTimeUs = ack.rxProcessingTimeUs;
+        } else {
+            AckPacket ack;
+            if (!decodeCaptured<AckPacketSchema>(rec, ack, counters) || ack.packetType != ACK) continue;
+            senderId = ack.senderId;
+            originalTxMicros = ack.originalTxMicros;
+            rxProcessingTimeUs = ack.rxProcessingTimeUs;
+        }
+
+        DeviceStats& dev = devices[senderId];
+        dev.rssi.add(rec.header.rssi);
+
+        // 이 ACK보다 앞선 가장 최근 송신 중 같은 txMicros를 가진 명령
+        auto match = std::find_if(sent.rbegin(), sent.rend(), [&](const SentCommand& s) {
+            return s.txMicros == originalTxMicros && s.txUs <= (int64_t)rec.header.timestampUs;
+        });
+        if (match == sent.rend()) {
+            dev.unmatchedAcks++;
+            continue;
+        }
+        int64_t raw = (int64_t)rec.header.timestampUs - match->txUs;
+        int64_t slotWaitUs = (match->targetBitmap != 0) ? (int64_t)ackSlotIndex(match->targetBitmap, senderId) * match->ackSlotUs : 0;
+        if (match->slotById) slotWaitUs = (int64_t)(senderId - 1) * match->ackSlotUs;
+        dev.rttRaw.add(raw);
+        dev.rttNet.add(raw - (int64_t)rxProcessingTimeUs - slotWaitUs);
+    }
+
+    for (const auto& entry : attemptsByMessage) devices[entry.first.first].attempts.add(entry.second);
+}
+
+void analyzeReceiver(const Dump& dump, DeviceStats& dev) {
+    for (const Record& rec : dump.records) {
+        if (rec.header.kind == Capture::REC_RX) {
+            dev.rssi.add(rec.header.rssi);
+        } else if (rec.header.kind == Capture::REC_FIRE && rec.data.size() >= Capture::FireEventSchema::kWireSize) {
+            Capture::FireEvent event;
+            Capture::FireEventSchema::decode(rec.data.data(), event);
+            dev.fireSkew.add(event.actualUs - event.targetUs);
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <capture dump | serial log>...\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<Dump> dumps;
+    for (int i = 1; i < argc; ++i) loadFile(argv[i], dumps);
+    if (dumps.empty()) return 1;
+
+    std::map<uint8_t, DeviceStats> devices;  // 송신부 덤프: ACK를 보낸 수신부 ID별
+    std::map<uint8_t, DeviceStats> receivers; // 수신부 덤프: 덤프한 수신부 ID별
+    TxCounters counters;
+
+    for (const Dump& dump : dumps) {
+        std::printf("%s: %s id=%u proto=v%u records=%u dropped=%u snap=%u\n", dump.source.c_str(),
+                    dump.header.role == Capture::ROLE_TRANSMITTER ? "transmitter" : "receiver",
+                    dump.header.deviceId, dump.header.protocolVersion, dump.header.recordCount,
+                    dump.header.droppedCount, dump.header.snapLen);
+        if (dump.header.role == Capture::ROLE_TRANSMITTER) analyzeTransmitter(dump, devices, counters);
+        else analyzeReceiver(dump, receivers[dump.header.deviceId]);
+    }
+
+    if (counters.sends > 0) {
+        std::printf("\n[transmitter] sends=%u call_failed=%u delivery_failed=%u bad_frames=%u truncated=%u\n",
+                    counters.sends, counters.sendCallFailed, counters.deliveryFailed, counters.badFrames, counters.truncated);
+    }
+    for (auto& entry : devices) {
+        std::printf("\n[device %u] (seen by transmitter)\n", entry.first);
+        entry.second.rttRaw.print("rtt_raw_us");
+        entry.second.rttNet.print("rtt_net_us");
+        entry.second.attempts.print("sends_per_message");
+        entry.second.rssi.print("ack_rssi_dbm");
+        if (entry.second.unmatchedAcks > 0) std::printf("  unmatched_acks=%u\n", entry.second.unmatchedAcks);
+    }
+    for (auto& entry : receivers) {
+        std::printf("\n[device %u] (receiver dump)\n", entry.first);
+        entry.second.fireSkew.print("fire_skew_us");
+        entry.second.rssi.print("rx_rssi_dbm");
+    }
+    return 0;
+}
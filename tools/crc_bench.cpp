@@ -0,0 +1,128 @@
+/**
+ * @file crc_bench.cpp
+ * @brief 무결성 검사(CRC) 구현별 처리량 측정 (호스트 PC용)
+ * @version 1.0.0
+ * @date 2024-06-13
+ *
+ * 빌드:  g++ -std=c++17 -O2 -o crc_bench tools/crc_bench.cpp
+ * 사용:  crc_bench [프레임 크기별 반복 횟수 (기본 200000)]
+ *
+ * 먼저 각 CRC의 표준 검사값("123456789")을 확인하고 (틀리면 종료 코드 1),
+ * ESP-NOW 프레임 크기별로 바이트당 사이클(x86은 rdtsc, 그 외는 ns)과 처리량을 출력합니다.
+ *   - crc8 bitwise : 예전 비트 단위 crc8 (테이블 도입 전 기준값)
+ *   - Crc8 / Crc16 : 펌웨어가 쓰는 테이블 방식 (integrityFor 참고)
+ *   - crc32 (ref)  : 비교용 CRC-32/IEEE 테이블 방식. 펌웨어에서는 뺐음
+ *                    (250바이트 이하 프레임에서 CRC-16/CCITT가 이미 해밍 거리 4를 보장하고,
+ *                     802.11 FCS가 프레임마다 CRC-32로 검사하므로 검사값 2바이트를 더 쓸 이유가 없음)
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CRC_BENCH_HAS_TSC 1
+#endif
+
+// espnow_comm_shared.h는 펌웨어 외부에서 micros() 선언만 요구함 (이 도구는 호출하지 않음)
+unsigned long micros() { return 0; }
+
+#include "../transmitter/espnow_comm_shared.h"
+
+namespace {
+
+// 예전 crc8 (비트 단위)
+struct BitwiseCrc8 {
+    using Value = uint8_t;
+    Value value = 0x00;
+    void update(uint8_t inbyte) {
+        for (uint8_t i = 8; i; --i) {
+            uint8_t mix = (value ^ inbyte) & 0x01;
+            value >>= 1;
+            if (mix) value ^= 0x8C;
+            inbyte >>= 1;
+        }
+    }
+    Value result() const { return value; }
+};
+
+// 비교용 CRC-32/IEEE 802.3 (반전 다항식 0xEDB88320)
+struct RefCrc32 {
+    using Value = uint32_t;
+    static constexpr Comm::CrcTable<uint32_t> kTable = Comm::makeReflectedCrcTable<uint32_t>(0xEDB88320UL);
+    Value value = 0xFFFFFFFFUL;
+    void update(uint8_t inbyte) { value = (value >> 8) ^ kTable.entries[(uint8_t)value ^ inbyte]; }
+    Value result() const { return ~value; }
+};
+
+template<typename Crc>
+typename Crc::Value checksum(const uint8_t* data, size_t len) {
+    Crc crc;
+    Comm::crcUpdate(crc, data, len);
+    return crc.result();
+}
+
+template<typename Crc>
+bool checkValue(const char* name, uint32_t expected) {
+    const char* kCheckInput = "123456789";
+    uint32_t value = checksum<Crc>((const uint8_t*)kCheckInput, 9);
+    bool ok = value == expected;
+    std::printf("%-14s check 0x%08X %s\n", name, value, ok ? "ok" : "MISMATCH");
+    return ok;
+}
+
+inline uint64_t ticks() {
+#if defined(CRC_BENCH_HAS_TSC)
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+volatile uint32_t s_sink = 0;
+
+// 프레임 하나의 검사값 계산 (매번 첫 바이트를 바꿔 계산을 건너뛰지 못하게 함)
+template<typename Crc>
+double ticksPerByte(uint8_t* frame, size_t len, long iterations) {
+    uint64_t start = ticks();
+    for (long i = 0; i < iterations; ++i) {
+        frame[0] = (uint8_t)i;
+        s_sink = s_sink + (uint32_t)checksum<Crc>(frame, len);
+    }
+    return (double)(ticks() - start) / ((double)iterations * len);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    long iterations = (argc >= 2) ? std::strtol(argv[1], nullptr, 10) : 200000;
+    if (iterations <= 0) iterations = 1;
+
+    bool ok = true;
+    ok &= checkValue<BitwiseCrc8>("crc8 bitwise", 0xA1);
+    ok &= checkValue<Comm::Crc8>("Crc8", 0xA1);
+    ok &= checkValue<Comm::Crc16>("Crc16", 0x29B1);
+    ok &= checkValue<RefCrc32>("crc32 (ref)", 0xCBF43926UL);
+    if (!ok) return 1;
+
+    // 예: ACK 24+6, 명령 56, 그룹 명령 60, 일괄 명령 9항목 228, ESP-NOW 최대 250
+    static const size_t kSizes[] = { 16, 32, 56, 64, 128, 228, 250 };
+    uint8_t frame[Comm::kMaxFrameSize];
+    for (size_t i = 0; i < sizeof(frame); ++i) frame[i] = (uint8_t)(i * 37 + 11);
+
+#if defined(CRC_BENCH_HAS_TSC)
+    const char* unit = "cycles/byte";
+#else
+    const char* unit = "ns/byte";
+#endif
+    std::printf("\n%ld iterations per size, %s (lower is better)\n", iterations, unit);
+    std::printf("%6s %14s %10s %10s %12s\n", "bytes", "crc8 bitwise", "Crc8", "Crc16", "crc32 (ref)");
+    for (size_t len : kSizes) {
+        double bitwise = ticksPerByte<BitwiseCrc8>(frame, len, iterations);
+        double crc8 = ticksPerByte<Comm::Crc8>(frame, len, iterations);
+        double crc16 = ticksPerByte<Comm::Crc16>(frame, len, iterations);
+        double crc32 = ticksPerByte<RefCrc32>(frame, len, iterations);
+        std::printf("%6zu %14.2f %10.2f %10.2f %12.2f\n", len, bitwise, crc8, crc16, crc32);
+    }
+    return 0;
+}
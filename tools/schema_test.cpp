@@ -0,0 +1,504 @@
+/**
+ * @file schema_test.cpp
+ * @brief 패킷 스키마 코덱 왕복 테스트 및 벤치마크 (호스트 PC용)
+ * @version 1.0.0
+ * @date 2024-06-13
+ *
+ * 빌드:  g++ -std=c++17 -O2 -o schema_test tools/schema_test.cpp
+ * 사용:  schema_test [벤치마크 반복 횟수 (기본 2000000, 0이면 테스트만)]
+ *
+ * 테스트 (실패가 하나라도 있으면 종료 코드 1):
+ *   - 모든 스키마: 임의 바이트 -> decode -> encode가 원래 바이트와 같은지, 디코딩 중 누적한 검사값이
+ *     프레임 전체 검사값과 같은지
+ *   - v7 (CommPacket, AckPacket, BatchCommandPacket 헤더/항목)과 v3 (LegacyCommPacketV3, LegacyAckPacketV3):
+ *     예전 packed 구조체를 그대로 memcpy한 바이트와 스키마 인코딩이 같은지, 같은 바이트를 양쪽으로 읽은 값이 같은지
+ *   - 프레임 헬퍼: 만든 프레임을 verify 함수로 읽은 값이 보낸 값과 같은지, 한 바이트만 바꿔도 거부되는지
+ *   - 송신 큐 재기록: restampElapsedSincePress가 경과 시간만 바꾸고 검사값을 맞게 다시 붙이는지
+ *
+ * 벤치마크 (연산 하나당 ns): 스키마 인코딩/디코딩 vs 예전 packed 구조체 memcpy + 비트 단위 crc8
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <random>
+
+// espnow_comm_shared.h는 펌웨어 외부에서 micros() 선언만 요구함 (프레임 헬퍼가 송신 시각으로 기록)
+static unsigned long s_fakeMicros = 1000;
+unsigned long micros() { return s_fakeMicros += 7; }
+
+#include "../transmitter/espnow_comm_shared.h"
+#include "../transmitter/capture_shared.h"
+
+namespace {
+
+int s_failures = 0;
+
+#define EXPECT(cond) do { if (!(cond)) { std::printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); ++s_failures; } } while (0)
+
+std::mt19937 s_rng(0x4D4C4142); // "MLAB" (실행마다 같은 바이트)
+
+void fillRandom(uint8_t* out, size_t len) {
+    for (size_t i = 0; i < len; ++i) out[i] = (uint8_t)s_rng();
+}
+
+//---------------------------------------------------------------------
+//  예전 (v7 / v3) packed 구조체. 7.0.0 헤더에서 그대로 옮김 - 수정하지 마세요
+//---------------------------------------------------------------------
+#pragma pack(push, 1)
+struct OldCommPacketV7 {
+    uint8_t  signature[4];
+    uint8_t  version;
+    uint8_t  packetType;
+    uint8_t  fixedLen;
+    uint8_t  targetId;
+    uint32_t seq;
+    uint32_t txButtonPressMicros;
+    uint32_t txMicros;
+    uint32_t elapsedSincePressUs;
+    uint32_t delayMs;
+    uint32_t playMs;
+    uint32_t lastKnownRttUs;
+    uint32_t lastKnownRxProcessingTimeUs;
+    uint64_t fireAtTxUs;
+    int64_t  clockOffsetUs;
+};
+
+struct OldAckPacketV7 {
+    uint8_t  signature[4];
+    uint8_t  version;
+    uint8_t  packetType;
+    uint8_t  fixedLen;
+    uint8_t  senderId;
+    uint32_t originalTxMicros;
+    uint32_t rxProcessingTimeUs;
+    uint64_t rxLocalUs;
+};
+
+struct OldBatchEntryV7 {
+    uint8_t  targetId;
+    uint32_t delayMs;
+    uint32_t playMs;
+    uint32_t compensationUs;
+    int64_t  clockOffsetUs;
+};
+
+struct OldBatchHeaderV7 {            // BatchCommandPacket에서 entries 앞부분
+    uint8_t  signature[4];
+    uint8_t  version;
+    uint8_t  packetType;
+    uint8_t  fixedLen;
+    uint32_t seq;
+    uint32_t targetBitmap;
+    uint32_t txButtonPressMicros;
+    uint32_t txMicros;
+    uint32_t elapsedSincePressUs;
+    uint64_t pressAtTxUs;
+    uint16_t ackSlotUs;
+    uint8_t  entryCount;
+    uint8_t  entrySize;
+};
+
+struct OldLegacyCommPacketV3 {
+    uint8_t  signature[4];
+    uint8_t  version;
+    uint8_t  packetType;
+    uint8_t  targetId;
+    uint32_t txButtonPressMicros;
+    uint32_t txMicros;
+    uint32_t delayMs;
+    uint32_t playMs;
+    uint32_t lastKnownRttUs;
+    uint32_t lastKnownRxProcessingTimeUs;
+    uint8_t  crc8;
+};
+
+struct OldLegacyAckPacketV3 {
+    uint8_t  signature[4];
+    uint8_t  version;
+    uint8_t  senderId;
+    uint32_t originalTxMicros;
+    uint32_t rxProcessingTimeUs;
+    uint8_t  crc8;
+};
+#pragma pack(pop)
+
+// 예전 crc8 (비트 단위, 테이블 없음)
+uint8_t oldCrc8(const uint8_t* data, size_t len) {
+    uint8_t crc = 0x00;
+    while (len--) {
+        uint8_t inbyte = *data++;
+        for (uint8_t i = 8; i; --i) {
+            uint8_t mix = (crc ^ inbyte) & 0x01;
+            crc >>= 1;
+            if (mix) crc ^= 0x8C;
+            inbyte >>= 1;
+        }
+    }
+    return crc;
+}
+
+// 스키마 구조체 <-> 예전 packed 구조체 (필드 이름이 같음)
+#define SAME(f) EXPECT(s.f == p.f)
+#define COPY(f) p.f = s.f
+#define HEADER_FIELDS(X) X(version); X(packetType); X(fixedLen)
+
+void compare(const Comm::CommPacket& s, const OldCommPacketV7& p) {
+    EXPECT(memcmp(s.signature, p.signature, 4) == 0);
+    HEADER_FIELDS(SAME); SAME(targetId); SAME(seq); SAME(txButtonPressMicros); SAME(txMicros); SAME(elapsedSincePressUs);
+    SAME(delayMs); SAME(playMs); SAME(lastKnownRttUs); SAME(lastKnownRxProcessingTimeUs); SAME(fireAtTxUs); SAME(clockOffsetUs);
+}
+void pack(const Comm::CommPacket& s, OldCommPacketV7& p) {
+    memcpy(p.signature, s.signature, 4);
+    HEADER_FIELDS(COPY); COPY(targetId); COPY(seq); COPY(txButtonPressMicros); COPY(txMicros); COPY(elapsedSincePressUs);
+    COPY(delayMs); COPY(playMs); COPY(lastKnownRttUs); COPY(lastKnownRxProcessingTimeUs); COPY(fireAtTxUs); COPY(clockOffsetUs);
+}
+
+void compare(const Comm::AckPacket& s, const OldAckPacketV7& p) {
+    EXPECT(memcmp(s.signature, p.signature, 4) == 0);
+    HEADER_FIELDS(SAME); SAME(senderId); SAME(originalTxMicros); SAME(rxProcessingTimeUs); SAME(rxLocalUs);
+}
+void pack(const Comm::AckPacket& s, OldAckPacketV7& p) {
+    memcpy(p.signature, s.signature, 4);
+    HEADER_FIELDS(COPY); COPY(senderId); COPY(originalTxMicros); COPY(rxProcessingTimeUs); COPY(rxLocalUs);
+}
+
+void compare(const Comm::BatchEntry& s, const OldBatchEntryV7& p) {
+    SAME(targetId); SAME(delayMs); SAME(playMs); SAME(compensationUs); SAME(clockOffsetUs);
+}
+void pack(const Comm::BatchEntry& s, OldBatchEntryV7& p) {
+    COPY(targetId); COPY(delayMs); COPY(playMs); COPY(compensationUs); COPY(clockOffsetUs);
+}
+
+void compare(const Comm::BatchCommandPacket& s, const OldBatchHeaderV7& p) {
+    EXPECT(memcmp(s.signature, p.signature, 4) == 0);
+    HEADER_FIELDS(SAME); SAME(seq); SAME(targetBitmap); SAME(txButtonPressMicros); SAME(txMicros); SAME(elapsedSincePressUs);
+    SAME(pressAtTxUs); SAME(ackSlotUs); SAME(entryCount); SAME(entrySize);
+}
+void pack(const Comm::BatchCommandPacket& s, OldBatchHeaderV7& p) {
+    memcpy(p.signature, s.signature, 4);
+    HEADER_FIELDS(COPY); COPY(seq); COPY(targetBitmap); COPY(txButtonPressMicros); COPY(txMicros); COPY(elapsedSincePressUs);
+    COPY(pressAtTxUs); COPY(ackSlotUs); COPY(entryCount); COPY(entrySize);
+}
+
+void compare(const Comm::LegacyCommPacketV3& s, const OldLegacyCommPacketV3& p) {
+    EXPECT(memcmp(s.signature, p.signature, 4) == 0);
+    SAME(version); SAME(packetType); SAME(targetId); SAME(txButtonPressMicros); SAME(txMicros); SAME(delayMs); SAME(playMs);
+    SAME(lastKnownRttUs); SAME(lastKnownRxProcessingTimeUs);
+}
+void pack(const Comm::LegacyCommPacketV3& s, OldLegacyCommPacketV3& p) {
+    memcpy(p.signature, s.signature, 4);
+    COPY(version); COPY(packetType); COPY(targetId); COPY(txButtonPressMicros); COPY(txMicros); COPY(delayMs); COPY(playMs);
+    COPY(lastKnownRttUs); COPY(lastKnownRxProcessingTimeUs);
+}
+
+void compare(const Comm::LegacyAckPacketV3& s, const OldLegacyAckPacketV3& p) {
+    EXPECT(memcmp(s.signature, p.signature, 4) == 0);
+    SAME(version); SAME(senderId); SAME(originalTxMicros); SAME(rxProcessingTimeUs);
+}
+void pack(const Comm::LegacyAckPacketV3& s, OldLegacyAckPacketV3& p) {
+    memcpy(p.signature, s.signature, 4);
+    COPY(version); COPY(senderId); COPY(originalTxMicros); COPY(rxProcessingTimeUs);
+}
+
+#undef SAME
+#undef COPY
+#undef HEADER_FIELDS
+
+//---------------------------------------------------------------------
+//  테스트
+//---------------------------------------------------------------------
+// 임의 바이트 -> decode -> encode 왕복, 디코딩 중 누적한 crc8이 바이트 전체의 crc8과 같은지
+template<typename SchemaT>
+void testRoundTrip(const char* name) {
+    const int failuresBefore = s_failures;
+    for (int iter = 0; iter < 1000; ++iter) {
+        uint8_t wire[SchemaT::kWireSize];
+        uint8_t again[SchemaT::kWireSize];
+        fillRandom(wire, sizeof(wire));
+
+        typename SchemaT::Struct s = {};
+        Comm::Crc8 decodeCrc;
+        SchemaT::decode(wire, s, decodeCrc);
+        Comm::Crc8 encodeCrc;
+        SchemaT::encode(s, again, encodeCrc);
+
+        EXPECT(memcmp(wire, again, sizeof(wire)) == 0);
+        EXPECT(decodeCrc.result() == Comm::crc8(wire, sizeof(wire)));
+        EXPECT(encodeCrc.result() == decodeCrc.result());
+    }
+    std::printf("%-28s %3zu bytes  %s\n", name, SchemaT::kWireSize, s_failures == failuresBefore ? "ok" : "FAILED");
+}
+
+// 같은 바이트를 스키마와 예전 packed 구조체로 읽은 값이 같은지, 같은 값을 양쪽으로 쓴 바이트가 같은지
+template<typename SchemaT, typename Old>
+void testLegacyLayout(const char* name) {
+    static_assert(SchemaT::kWireSize <= sizeof(Old), "스키마가 예전 구조체보다 김");
+    const int failuresBefore = s_failures;
+    for (int iter = 0; iter < 1000; ++iter) {
+        uint8_t wire[sizeof(Old)];
+        fillRandom(wire, sizeof(wire));
+
+        typename SchemaT::Struct s = {};
+        SchemaT::decode(wire, s);
+        Old p;
+        memcpy(&p, wire, sizeof(p)); // 예전 수신 경로 (버퍼를 구조체로 캐스팅)
+        compare(s, p);
+
+        uint8_t encoded[SchemaT::kWireSize];
+        SchemaT::encode(s, encoded);
+        Old packed;
+        memcpy(&packed, wire, sizeof(packed)); // v3의 crc8처럼 스키마 밖에 있는 뒤쪽 바이트는 그대로
+        pack(s, packed);
+        EXPECT(memcmp(encoded, &packed, SchemaT::kWireSize) == 0);
+    }
+    std::printf("%-28s %3zu bytes  %s\n", name, sizeof(Old), s_failures == failuresBefore ? "same as old layout" : "FAILED");
+}
+
+// 한 바이트를 바꾼 프레임은 모두 거부되어야 함
+template<typename Verify>
+void expectRejectsCorruption(const Comm::Frame& frame, Verify verify) {
+    for (size_t i = 0; i < frame.len; ++i) {
+        uint8_t copy[Comm::kMaxFrameSize];
+        memcpy(copy, frame.data, frame.len);
+        copy[i] ^= 0x01;
+        EXPECT(!verify(copy, frame.len));
+    }
+}
+
+void testFrames() {
+    const int failuresBefore = s_failures;
+    Comm::Frame frame;
+
+    // 명령
+    Comm::CommPacket cmd;
+    Comm::fillPacket(cmd, Comm::FINAL_COMMAND, 3, 0x01020304, 123456, 2500, 800, 1900, 250, 0x1122334455667788ULL, -4242);
+    Comm::encodeFrame<Comm::CommPacketSchema>(frame, cmd);
+    size_t len = Comm::sealFrame(frame);
+    Comm::CommPacket cmdRx;
+    bool forMe = false;
+    EXPECT(Comm::verifyCommPacket(frame.data, len, cmdRx, 3, forMe) && forMe);
+    EXPECT(cmdRx.seq == cmd.seq && cmdRx.txMicros == cmd.txMicros && cmdRx.elapsedSincePressUs == cmd.elapsedSincePressUs);
+    EXPECT(cmdRx.fireAtTxUs == cmd.fireAtTxUs && cmdRx.clockOffsetUs == cmd.clockOffsetUs && cmdRx.playMs == cmd.playMs);
+    expectRejectsCorruption(frame, [](const uint8_t* d, size_t l) { Comm::CommPacket p; bool f; return Comm::verifyCommPacket(d, l, p, 3, f); });
+
+    // ACK (기능 TLV 포함)
+    len = Comm::buildAckFrame(frame, 5, 0xCAFEBABE, 321, 987654321ULL);
+    Comm::AckPacket ack;
+    uint32_t caps = 0;
+    EXPECT(Comm::verifyAckPacket(frame.data, len, ack));
+    EXPECT(ack.senderId == 5 && ack.originalTxMicros == 0xCAFEBABE && ack.rxProcessingTimeUs == 321 && ack.rxLocalUs == 987654321ULL);
+    EXPECT(Comm::findTlvValue(frame.data, len, Comm::TLV_CAPABILITIES, caps) && caps == Comm::kLocalCapabilities);
+    expectRejectsCorruption(frame, [](const uint8_t* d, size_t l) { Comm::AckPacket p; return Comm::verifyAckPacket(d, l, p); });
+
+    // 일괄 명령 (가장 큰 프레임, 항목은 entrySize 간격)
+    Comm::BatchCommandPacket batch;
+    Comm::beginBatchPacket(batch, 77, 5555, 999999, 600);
+    for (uint8_t id = 1; id <= Comm::kMaxBatchEntries; ++id) {
+        EXPECT(Comm::addBatchEntry(batch, (uint8_t)(id * 3), 1000u * id, 500u * id, 1700u + id, (id % 2) ? Comm::kNoClockOffset : -(int64_t)id * 1000));
+    }
+    len = Comm::finalizeBatchPacket(batch, frame);
+    EXPECT(len == Comm::batchFixedSize(Comm::kMaxBatchEntries) + Comm::integritySize(Comm::integrityFor(Comm::kVersion, Comm::BATCH_COMMAND)));
+    for (uint8_t i = 0; i < batch.entryCount; ++i) {
+        const Comm::BatchEntry& sent = batch.entries[i];
+        Comm::BatchCommandPacket header;
+        Comm::BatchEntry entry;
+        EXPECT(Comm::verifyBatchCommandPacket(frame.data, len, header, sent.targetId, entry, forMe) && forMe);
+        EXPECT(header.seq == 77 && header.pressAtTxUs == 999999 && header.ackSlotUs == 600 && header.entryCount == batch.entryCount);
+        EXPECT(entry.delayMs == sent.delayMs && entry.playMs == sent.playMs && entry.compensationUs == sent.compensationUs &&
+               entry.clockOffsetUs == sent.clockOffsetUs);
+    }
+    expectRejectsCorruption(frame, [](const uint8_t* d, size_t l) {
+        Comm::BatchCommandPacket p; Comm::BatchEntry e; bool f; return Comm::verifyBatchCommandPacket(d, l, p, 3, e, f); });
+
+    // 비상 정지, 채널 전환, 비콘, 실행 정보, 실행, 그룹 명령/등록, 실행 단계 보고
+    uint32_t txMicros = 0;
+    len = Comm::buildStopFrame(frame, 0x0000F00F, 400, txMicros);
+    Comm::StopPacket stop;
+    EXPECT(Comm::verifyStopPacket(frame.data, len, stop, 4, forMe) && forMe && stop.txMicros == txMicros && stop.ackSlotUs == 400);
+
+    len = Comm::buildChannelHopFrame(frame, 0x3, 500, 11, 250, txMicros);
+    Comm::ChannelHopPacket hop;
+    EXPECT(Comm::verifyChannelHopPacket(frame.data, len, hop, 2, forMe) && forMe && hop.newChannel == 11 && hop.switchInMs == 250);
+
+    len = Comm::buildChannelBeaconFrame(frame, 6);
+    Comm::ChannelBeacon beacon;
+    EXPECT(Comm::verifyChannelBeacon(frame.data, len, beacon) && beacon.channel == 6);
+
+    len = Comm::buildArmCueFrame(frame, 9, 42, 7, 3000, 1500, 2100, -123456789LL, 55555555ULL, -2500, txMicros);
+    Comm::ArmCuePacket cue;
+    EXPECT(Comm::verifyArmCuePacket(frame.data, len, cue, 9, forMe) && forMe);
+    EXPECT(cue.armId == 7 && cue.clockOffsetUs == -123456789LL && cue.offsetRefTxUs == 55555555ULL && cue.driftPpb == -2500);
+
+    len = Comm::buildGoFrame(frame, 0x100, 7, 8888, 777777ULL, 350, txMicros);
+    Comm::GoPacket go;
+    EXPECT(Comm::verifyGoPacket(frame.data, len, go, 9, forMe) && forMe && go.armId == 7 && go.pressAtTxUs == 777777ULL);
+
+    len = Comm::buildGroupConfigFrame(frame, 4, 43, 12, true, txMicros);
+    Comm::GroupConfigPacket groupCfg;
+    EXPECT(Comm::verifyGroupConfigPacket(frame.data, len, groupCfg, 4, forMe) && forMe && groupCfg.groupId == 12 && groupCfg.member == 1);
+
+    len = Comm::buildPhaseReportFrame(frame, 2, Comm::PHASE_PLAY_STARTED, 8888, 123ULL, -456LL, -789, 1000);
+    Comm::PhaseReport report;
+    EXPECT(Comm::verifyPhaseReport(frame.data, len, report) && report.phase == Comm::PHASE_PLAY_STARTED && report.compensationUs == -789);
+
+    // 구 펌웨어(v3) 명령: 예전 helper처럼 packed 구조체 + 비트 단위 crc8과 같은 바이트
+    Comm::LegacyCommPacketV3 legacy;
+    Comm::fillLegacyPacketV3(legacy, Comm::FINAL_COMMAND, 2, 4444, 100, 200, 300, 40);
+    Comm::encodeFrame<Comm::LegacyCommPacketSchemaV3>(frame, legacy);
+    len = Comm::sealFrame(frame);
+    OldLegacyCommPacketV3 old;
+    pack(legacy, old);
+    old.crc8 = oldCrc8((const uint8_t*)&old, sizeof(old) - 1);
+    EXPECT(len == sizeof(old) && memcmp(frame.data, &old, sizeof(old)) == 0);
+
+    std::printf("%-28s            %s\n", "frame helpers", s_failures == failuresBefore ? "ok" : "FAILED");
+}
+
+// 송신 큐가 드라이버에 넘길 때 경과 시간만 다시 쓰고, 다시 붙인 검사값으로 디코딩되는지
+void testRestamp() {
+    const int failuresBefore = s_failures;
+    Comm::Frame frame;
+    bool forMe = false;
+    const uint32_t pressMicros = 0xFFFFFF00UL; // micros() 넘침을 지나도 차이가 맞는지
+
+    Comm::CommPacket cmd;
+    Comm::fillPacket(cmd, Comm::FINAL_COMMAND, 3, 9, pressMicros, 2500, 800, 1900, 250);
+    Comm::encodeFrame<Comm::CommPacketSchema>(frame, cmd);
+    size_t len = Comm::sealFrame(frame);
+    EXPECT(Comm::restampElapsedSincePress(frame.data, len, pressMicros + 4321));
+    Comm::CommPacket cmdRx;
+    EXPECT(Comm::verifyCommPacket(frame.data, len, cmdRx, 3, forMe) && cmdRx.elapsedSincePressUs == 4321 && cmdRx.txMicros == cmd.txMicros);
+
+    Comm::BatchCommandPacket batch;
+    Comm::beginBatchPacket(batch, 10, pressMicros, 1000, 600);
+    Comm::addBatchEntry(batch, 2, 100, 200, 300);
+    Comm::addBatchEntry(batch, 5, 400, 500, 600);
+    len = Comm::finalizeBatchPacket(batch, frame);
+    EXPECT(Comm::restampElapsedSincePress(frame.data, len, pressMicros + 777));
+    Comm::BatchCommandPacket batchRx;
+    Comm::BatchEntry entry;
+    EXPECT(Comm::verifyBatchCommandPacket(frame.data, len, batchRx, 5, entry, forMe) && forMe);
+    EXPECT(batchRx.elapsedSincePressUs == 777 && batchRx.txMicros == batch.txMicros && entry.compensationUs == 600);
+
+    uint32_t txMicros = 0;
+    len = Comm::buildGoFrame(frame, 0x3, 4, pressMicros, 5000, 350, txMicros);
+    EXPECT(Comm::restampElapsedSincePress(frame.data, len, pressMicros + 99));
+    Comm::GoPacket go;
+    EXPECT(Comm::verifyGoPacket(frame.data, len, go, 1, forMe) && go.elapsedSincePressUs == 99 && go.txMicros == txMicros);
+
+    // 경과 시간이 없는 프레임과 v3 프레임은 그대로
+    len = Comm::buildStopFrame(frame, 0x3, 400, txMicros);
+    uint8_t before[Comm::kMaxFrameSize];
+    memcpy(before, frame.data, len);
+    EXPECT(!Comm::restampElapsedSincePress(frame.data, len, 12345) && memcmp(before, frame.data, len) == 0);
+    Comm::LegacyCommPacketV3 legacy;
+    Comm::fillLegacyPacketV3(legacy, Comm::FINAL_COMMAND, 2, pressMicros, 100, 200, 300, 40);
+    Comm::encodeFrame<Comm::LegacyCommPacketSchemaV3>(frame, legacy);
+    len = Comm::sealFrame(frame);
+    memcpy(before, frame.data, len);
+    EXPECT(!Comm::restampElapsedSincePress(frame.data, len, 12345) && memcmp(before, frame.data, len) == 0);
+
+    std::printf("%-28s            %s\n", "queue restamp", s_failures == failuresBefore ? "ok" : "FAILED");
+}
+
+//---------------------------------------------------------------------
+//  벤치마크
+//---------------------------------------------------------------------
+volatile uint32_t s_sink = 0;
+
+template<typename Fn>
+double nsPerOp(long iterations, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; ++i) fn(i);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+void benchmark(long iterations) {
+    Comm::CommPacket cmd;
+    Comm::fillPacket(cmd, Comm::FINAL_COMMAND, 3, 1, 123456, 2500, 800, 1900, 250, 42, -4242);
+    OldCommPacketV7 oldCmd;
+    pack(cmd, oldCmd);
+
+    Comm::Frame frame;
+    Comm::encodeFrame<Comm::CommPacketSchema>(frame, cmd);
+    const size_t len = Comm::sealFrame(frame);
+    uint8_t oldWire[sizeof(OldCommPacketV7) + 1];
+    memcpy(oldWire, &oldCmd, sizeof(oldCmd));
+    oldWire[sizeof(oldCmd)] = oldCrc8(oldWire, sizeof(oldCmd));
+
+    std::printf("\nbenchmark: CommPacket (%zu bytes + crc8), %ld iterations\n", Comm::CommPacketSchema::kWireSize, iterations);
+
+    double newEncode = nsPerOp(iterations, [&](long i) {
+        cmd.seq = (uint32_t)i;
+        Comm::encodeFrame<Comm::CommPacketSchema>(frame, cmd);
+        s_sink = s_sink + (uint32_t)Comm::sealFrame(frame) + frame.data[len - 1];
+    });
+    double oldEncode = nsPerOp(iterations, [&](long i) {
+        oldCmd.seq = (uint32_t)i;
+        uint8_t out[sizeof(oldWire)];
+        memcpy(out, &oldCmd, sizeof(oldCmd));
+        out[sizeof(oldCmd)] = oldCrc8(out, sizeof(oldCmd));
+        s_sink = s_sink + out[sizeof(oldCmd)];
+    });
+    double newDecode = nsPerOp(iterations, [&](long i) {
+        frame.data[Comm::CommPacketSchema::offsetOf<4>()] = (uint8_t)i; // 매번 다른 바이트 (검사값은 틀려도 끝까지 계산함)
+        Comm::CommPacket rx;
+        bool forMe = false;
+        bool ok = Comm::verifyCommPacket(frame.data, len, rx, 3, forMe);
+        s_sink = s_sink + ok + rx.seq;
+    });
+    double oldDecode = nsPerOp(iterations, [&](long i) {
+        oldWire[offsetof(OldCommPacketV7, seq)] = (uint8_t)i;
+        bool ok = oldCrc8(oldWire, sizeof(OldCommPacketV7)) == oldWire[sizeof(OldCommPacketV7)];
+        OldCommPacketV7 rx;
+        memcpy(&rx, oldWire, sizeof(rx));
+        s_sink = s_sink + ok + rx.seq;
+    });
+
+    std::printf("  encode+seal   schema %7.1f ns   old packed+bitwise crc8 %7.1f ns\n", newEncode, oldEncode);
+    std::printf("  verify+decode schema %7.1f ns   old bitwise crc8+memcpy %7.1f ns\n", newDecode, oldDecode);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    long iterations = (argc >= 2) ? std::strtol(argv[1], nullptr, 10) : 2000000;
+
+    testRoundTrip<Comm::HeaderSchema>("HeaderSchema");
+    testRoundTrip<Comm::CommPacketSchema>("CommPacketSchema");
+    testRoundTrip<Comm::AckPacketSchema>("AckPacketSchema");
+    testRoundTrip<Comm::BatchEntrySchema>("BatchEntrySchema");
+    testRoundTrip<Comm::BatchHeaderSchema>("BatchHeaderSchema");
+    testRoundTrip<Comm::StopPacketSchema>("StopPacketSchema");
+    testRoundTrip<Comm::ChannelHopPacketSchema>("ChannelHopPacketSchema");
+    testRoundTrip<Comm::ChannelBeaconSchema>("ChannelBeaconSchema");
+    testRoundTrip<Comm::PhaseReportSchema>("PhaseReportSchema");
+    testRoundTrip<Comm::ArmCuePacketSchema>("ArmCuePacketSchema");
+    testRoundTrip<Comm::GoPacketSchema>("GoPacketSchema");
+    testRoundTrip<Comm::GroupConfigPacketSchema>("GroupConfigPacketSchema");
+    testRoundTrip<Comm::LegacyCommPacketSchemaV3>("LegacyCommPacketSchemaV3");
+    testRoundTrip<Comm::LegacyAckPacketSchemaV3>("LegacyAckPacketSchemaV3");
+    testRoundTrip<Capture::FileHeaderSchema>("Capture::FileHeaderSchema");
+    testRoundTrip<Capture::RecordHeaderSchema>("Capture::RecordHeaderSchema");
+    testRoundTrip<Capture::FireEventSchema>("Capture::FireEventSchema");
+
+    testLegacyLayout<Comm::CommPacketSchema, OldCommPacketV7>("v7 CommPacket");
+    testLegacyLayout<Comm::AckPacketSchema, OldAckPacketV7>("v7 AckPacket");
+    testLegacyLayout<Comm::BatchEntrySchema, OldBatchEntryV7>("v7 BatchEntry");
+    testLegacyLayout<Comm::BatchHeaderSchema, OldBatchHeaderV7>("v7 BatchCommandPacket hdr");
+    testLegacyLayout<Comm::LegacyCommPacketSchemaV3, OldLegacyCommPacketV3>("v3 LegacyCommPacket");
+    testLegacyLayout<Comm::LegacyAckPacketSchemaV3, OldLegacyAckPacketV3>("v3 LegacyAckPacket");
+
+    testFrames();
+    testRestamp();
+
+    if (s_failures > 0) {
+        std::printf("\n%d check(s) failed\n", s_failures);
+        return 1;
+    }
+    std::printf("\nall checks passed\n");
+    if (iterations > 0) benchmark(iterations);
+    return 0;
+}
@@ -0,0 +1,42 @@
+#include "capture_t.h"
+#include "utils_t.h"
+
+static Capture::Ring<CAPTURE_RING_SLOTS, CAPTURE_SNAP_LEN> s_capture;
+
+void captureTx(const uint8_t* mac, const uint8_t* data, size_t len, esp_err_t result) {
+    s_capture.record(Capture::REC_TX, (result == ESP_OK) ? Capture::STATUS_OK : Capture::STATUS_FAILED, 0, mac, data, len);
+}
+
+void captureRx(const esp_now_recv_info_t* info, const uint8_t* data, int len) {
+    int8_t rssi = (info && info->rx_ctrl) ? (int8_t)info->rx_ctrl->rssi : 0;
+    s_capture.record(Capture::REC_RX, Capture::STATUS_OK, rssi, info ? info->src_addr : nullptr, data, (len > 0) ? (size_t)len : 0);
+}
+
+void captureTxDone(const uint8_t* mac, esp_now_send_status_t status) {
+    s_capture.record(Capture::REC_TX_DONE, (status == ESP_NOW_SEND_SUCCESS) ? Capture::STATUS_OK : Capture::STATUS_FAILED, 0, mac, nullptr, 0);
+}
+
+void captureHandleSerial() {
+    static char line[24];
+    static uint8_t lineLen = 0;
+
+    while (Serial.available() > 0) {
+        char c = (char)Serial.read();
+        if (c != '\n' && c != '\r') {
+            if (lineLen < sizeof(line) - 1) line[lineLen++] = c;
+            continue;
+        }
+        if (lineLen == 0) continue;
+        line[lineLen] = '\0';
+        lineLen = 0;
+
+        if (strcmp(line, "capture") == 0) {
+            if (!Capture::dumpHex(s_capture, Capture::ROLE_TRANSMITTER, 0, Serial)) {
+                logPrintf(LogLevel::LOG_ERROR, "CAPTURE: 덤프 버퍼 할당 실패");
+            }
+        } else if (strcmp(line, "capture clear") == 0) {
+            s_capture.clear();
+            logPrintf(LogLevel::LOG_INFO, "CAPTURE: 캡처 링 초기화");
+        }
+    }
+}
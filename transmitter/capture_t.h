@@ -0,0 +1,23 @@
+#pragma once
+#ifndef CAPTURE_T_H
+#define CAPTURE_T_H
+
+#include <Arduino.h>
+#include "config_t.h"
+#include "capture_shared.h"
+
+//────────────────────────────────────────────────────────────────────────────
+// [NEW] 송수신 패킷 캡처 (항상 켜져 있음)
+//  - 보낸 프레임, 받은 프레임, 송신 완료 상태를 us 타임스탬프와 함께 링 버퍼에 기록
+//  - 시리얼에 "capture" 입력 시 덤프 파일을 16진수 줄로 출력, "capture clear" 입력 시 비움
+//  - 덤프 형식과 분석 도구는 capture_shared.h, tools/capture_analyzer.cpp 참고
+//────────────────────────────────────────────────────────────────────────────
+
+void captureTx(const uint8_t* mac, const uint8_t* data, size_t len, esp_err_t result);
+void captureRx(const esp_now_recv_info_t* info, const uint8_t* data, int len);
+void captureTxDone(const uint8_t* mac, esp_now_send_status_t status);
+
+// 시리얼 명령 확인 (loop에서 호출)
+void captureHandleSerial();
+
+#endif // CAPTURE_T_H
@@ -0,0 +1,156 @@
+#include "channel_t.h"
+#include "utils_t.h"
+
+static_assert(CHANNEL_SURVEY_LAST_CHANNEL >= Comm::kMinWifiChannel && CHANNEL_SURVEY_LAST_CHANNEL <= Comm::kMaxWifiChannel,
+              "CHANNEL_SURVEY_LAST_CHANNEL out of range");
+
+static constexpr uint16_t kPhyOverheadBytes = 24; // 프리앰블/PLCP 헤더를 바이트로 환산한 대략적인 값
+
+static uint8_t s_channel = WIFI_CHANNEL;
+
+struct Survey {
+    bool     active;
+    bool     hasResult;       // 마지막 측정이 끝까지 진행됨
+    uint8_t  channel;         // 지금 듣고 있는 채널
+    int64_t  dwellStartUs;
+    uint64_t score[Comm::kMaxWifiChannel + 1];  // 채널별 점수 (CHANNEL_SURVEY_DWELL_MS 기준으로 환산)
+    uint32_t frames[Comm::kMaxWifiChannel + 1];
+};
+static Survey s_survey = {};
+
+// 무차별 수신 콜백이 현재 채널에 누적하는 값 (Wi-Fi 태스크에서 기록)
+static portMUX_TYPE s_dwellMux = portMUX_INITIALIZER_UNLOCKED;
+static uint64_t s_dwellScore = 0;
+static uint32_t s_dwellFrames = 0;
+
+static bool isValidChannel(uint8_t channel) {
+    return channel >= Comm::kMinWifiChannel && channel <= Comm::kMaxWifiChannel;
+}
+
+static void surveyRxCb(void* buf, wifi_promiscuous_pkt_type_t type) {
+    const wifi_promiscuous_pkt_t* pkt = (const wifi_promiscuous_pkt_t*)buf;
+    int weight = pkt->rx_ctrl.rssi - CHANNEL_SURVEY_RSSI_FLOOR;
+    if (weight < 1) weight = 1;
+    uint64_t cost = (uint64_t)(pkt->rx_ctrl.sig_len + kPhyOverheadBytes) * (uint32_t)weight;
+    portENTER_CRITICAL(&s_dwellMux);
+    s_dwellScore += cost;
+    s_dwellFrames++;
+    portEXIT_CRITICAL(&s_dwellMux);
+}
+
+bool channelInit() {
+    uint8_t saved = EEPROM.read(CHANNEL_ADDR);
+    s_channel = isValidChannel(saved) ? saved : WIFI_CHANNEL;
+    if (esp_wifi_set_channel(s_channel, WIFI_SECOND_CHAN_NONE) != ESP_OK) {
+        logPrintf(LogLevel::LOG_ERROR, "CHANNEL: Wi-Fi 채널 %d 설정 실패", s_channel);
+        return false;
+    }
+    logPrintf(LogLevel::LOG_INFO, "CHANNEL: 채널 %d에서 시작 (%s)", s_channel, isValidChannel(saved) ? "저장된 채널" : "기본값");
+    return true;
+}
+
+uint8_t channelCurrent() {
+    return s_channel;
+}
+
+bool channelSwitch(uint8_t channel) {
+    if (!isValidChannel(channel)) return false;
+    if (esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE) != ESP_OK) {
+        logPrintf(LogLevel::LOG_ERROR, "CHANNEL: Wi-Fi 채널 %d 설정 실패", channel);
+        return false;
+    }
+    s_channel = channel;
+    EEPROM.write(CHANNEL_ADDR, channel);
+    EEPROM.commit();
+    return true;
+}
+
+static void beginDwell(uint8_t channel) {
+    esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+    portENTER_CRITICAL(&s_dwellMux);
+    s_dwellScore = 0;
+    s_dwellFrames = 0;
+    portEXIT_CRITICAL(&s_dwellMux);
+    s_survey.channel = channel;
+    s_survey.dwellStartUs = esp_timer_get_time();
+}
+
+static void endSurvey() {
+    esp_wifi_set_promiscuous(false);
+    esp_wifi_set_channel(s_channel, WIFI_SECOND_CHAN_NONE);
+    s_survey.active = false;
+}
+
+static void logSurveyResult() {
+    char line[160];
+    size_t pos = 0;
+    for (uint8_t ch = Comm::kMinWifiChannel; ch <= CHANNEL_SURVEY_LAST_CHANNEL && pos < sizeof(line); ++ch) {
+        pos += snprintf(line + pos, sizeof(line) - pos, " %d:%lu/%lu", ch,
+                        (unsigned long)s_survey.score[ch], (unsigned long)s_survey.frames[ch]);
+    }
+    logPrintf(LogLevel::LOG_INFO, "CHANNEL: 측정 결과 (채널:점수/프레임)%s", line);
+}
+
+void channelSurveyStart() {
+    memset(&s_survey, 0, sizeof(s_survey));
+    s_survey.active = true;
+    esp_wifi_set_promiscuous_rx_cb(surveyRxCb);
+    if (esp_wifi_set_promiscuous(true) != ESP_OK) {
+        logPrintf(LogLevel::LOG_WARN, "CHANNEL: 무차별 수신 모드 시작 실패. 측정 생략.");
+        s_survey.active = false;
+        return;
+    }
+    logPrintf(LogLevel::LOG_DEBUG, "CHANNEL: 혼잡도 측정 시작 (채널 1-%d, 채널당 %d ms)", CHANNEL_SURVEY_LAST_CHANNEL, CHANNEL_SURVEY_DWELL_MS);
+    beginDwell(Comm::kMinWifiChannel);
+}
+
+bool channelSurveyActive() {
+    return s_survey.active;
+}
+
+bool channelSurveyStep() {
+    if (!s_survey.active) return false;
+    int64_t elapsedUs = esp_timer_get_time() - s_survey.dwellStartUs;
+    if (elapsedUs < (int64_t)CHANNEL_SURVEY_DWELL_MS * 1000) return false;
+
+    portENTER_CRITICAL(&s_dwellMux);
+    uint64_t score = s_dwellScore;
+    uint32_t frames = s_dwellFrames;
+    portEXIT_CRITICAL(&s_dwellMux);
+    // loop가 늦게 돌아와 더 오래 머문 채널이 불리하지 않도록 같은 시간 기준으로 환산
+    s_survey.score[s_survey.channel] = score * CHANNEL_SURVEY_DWELL_MS * 1000 / (uint64_t)elapsedUs;
+    s_survey.frames[s_survey.channel] = frames;
+
+    if (s_survey.channel < CHANNEL_SURVEY_LAST_CHANNEL) {
+        beginDwell(s_survey.channel + 1);
+        return false;
+    }
+    endSurvey();
+    s_survey.hasResult = true;
+    logSurveyResult();
+    return true;
+}
+
+void channelSurveyAbort() {
+    if (!s_survey.active) return;
+    endSurvey();
+    logPrintf(LogLevel::LOG_DEBUG, "CHANNEL: 혼잡도 측정 중단 (채널 %d로 복귀)", s_channel);
+}
+
+bool channelPickQuieter(uint8_t& channel) {
+    if (!s_survey.hasResult) return false;
+    uint8_t best = Comm::kMinWifiChannel;
+    for (uint8_t ch = Comm::kMinWifiChannel + 1; ch <= CHANNEL_SURVEY_LAST_CHANNEL; ++ch) {
+        if (s_survey.score[ch] < s_survey.score[best]) best = ch;
+    }
+    if (best == s_channel) return false;
+
+    // 현재 채널이 측정 범위 밖이면 비교할 수 없으므로 가장 조용한 채널로 옮김
+    if (s_channel <= CHANNEL_SURVEY_LAST_CHANNEL) {
+        uint64_t current = s_survey.score[s_channel];
+        if (current < CHANNEL_HOP_MIN_SCORE) return false;
+        if (s_survey.score[best] * 100 > current * (100 - CHANNEL_HOP_MIN_GAIN_PCT)) return false;
+    }
+    channel = best;
+    return true;
+}
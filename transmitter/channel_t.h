@@ -0,0 +1,40 @@
+#pragma once
+#ifndef CHANNEL_T_H
+#define CHANNEL_T_H
+
+#include <Arduino.h>
+#include "config_t.h"
+
+//────────────────────────────────────────────────────────────────────────────
+// [NEW] ESP-NOW 채널 관리 (현재 채널 저장과 채널별 혼잡도 측정)
+//  - 현재 채널은 EEPROM에 저장해 재부팅 후에도 수신기와 같은 채널에서 시작
+//  - 측정: 무차별 수신 모드로 1번부터 CHANNEL_SURVEY_LAST_CHANNEL번 채널에 CHANNEL_SURVEY_DWELL_MS씩 머물며
+//    들리는 모든 프레임의 (길이 + PHY 오버헤드) x 세기 가중치를 더함. 가까운 곳의 긴 프레임일수록
+//    ESP-NOW 프레임과 충돌하거나 채널 사용 대기를 일으키므로 점수가 큼 (낮을수록 조용한 채널)
+//  - 측정은 loop에서 한 채널씩 진행하므로 버튼과 화면은 계속 동작. 측정 중에는 현재 채널을 듣지 못함
+//────────────────────────────────────────────────────────────────────────────
+
+// EEPROM에 저장된 채널(없으면 WIFI_CHANNEL)로 라디오 설정 (esp_now_init 전에 호출)
+bool channelInit();
+
+// 현재 ESP-NOW 채널
+uint8_t channelCurrent();
+
+// 채널을 옮기고 EEPROM에 저장
+bool channelSwitch(uint8_t channel);
+
+// 혼잡도 측정 시작 (이전 결과는 지움)
+void channelSurveyStart();
+
+bool channelSurveyActive();
+
+// 측정 진행 (loop에서 호출). 마지막 채널까지 측정하고 현재 채널로 돌아왔으면 true
+bool channelSurveyStep();
+
+// 측정을 중단하고 현재 채널로 돌아옴 (실행이나 비상 정지 시작 시)
+void channelSurveyAbort();
+
+// 마지막 측정에서 현재 채널보다 CHANNEL_HOP_MIN_GAIN_PCT 이상 조용한 채널이 있으면 그 채널과 true
+bool channelPickQuieter(uint8_t& channel);
+
+#endif // CHANNEL_T_H
@@ -0,0 +1,75 @@
+#include "clocksync_t.h"
+#include "utils_t.h"
+#include <algorithm>
+
+// 장치 ID로 바로 접근 (1부터 시작, 0번은 사용하지 않음)
+static ClockSyncState s_clockSync[MAX_DEVICES + 1];
+
+void clockSyncInit() {
+    memset(s_clockSync, 0, sizeof(s_clockSync));
+}
+
+// 기준 시각의 오프셋에 드리프트를 적용해 atTxUs 시점의 오프셋을 외삽
+static int64_t predictOffset(const ClockSyncState& state, int64_t atTxUs) {
+    return state.offsetUs + (atTxUs - state.refTxUs) * (int64_t)state.driftPpb / 1000000000LL;
+}
+
+bool clockSyncAddSample(uint8_t deviceID, int64_t t1, int64_t t2, int64_t t3, int64_t t4) {
+    if (deviceID == 0 || deviceID > MAX_DEVICES) return false;
+    ClockSyncState& state = s_clockSync[deviceID];
+
+    int64_t delayUs = std::max<int64_t>(0, (t4 - t1) - (t3 - t2));
+    int64_t sampleOffsetUs = ((t2 - t1) + (t3 - t4)) / 2;
+    int64_t midTxUs = t1 + (t4 - t1) / 2;
+
+    // 큐잉/재전송으로 왕복 지연이 크게 늘어난 샘플은 비대칭 오차가 커서 버림.
+    // 링크가 계속 느려진 경우를 위해 기준값은 조금씩 완화
+    if (state.sampleCount > 0 && delayUs > (int64_t)state.minDelayUs * 2 + CLOCK_SYNC_DELAY_SLACK_US) {
+        state.minDelayUs += state.minDelayUs / 8 + 1;
+        logPrintf(LogLevel::LOG_DEBUG, "SYNC: ID %d 샘플 무시 (왕복 %lld us, 최소 %u us)",
+                  deviceID, (long long)delayUs, state.minDelayUs);
+        return false;
+    }
+    if (state.sampleCount == 0 || delayUs < state.minDelayUs) state.minDelayUs = (uint32_t)delayUs;
+
+    int64_t elapsedUs = midTxUs - state.refTxUs;
+    if (state.sampleCount == 0 || elapsedUs > (int64_t)CLOCK_SYNC_MAX_AGE_MS * 1000) {
+        // 첫 샘플이거나 마지막 추정이 너무 오래되어 외삽을 믿을 수 없으면 새로 시작 (드리프트는 유지)
+        state.offsetUs = sampleOffsetUs;
+        state.refTxUs = midTxUs;
+        state.sampleCount = 1;
+        logPrintf(LogLevel::LOG_INFO, "SYNC: ID %d 오프셋 초기화 %lld us (왕복 %lld us)",
+                  deviceID, (long long)sampleOffsetUs, (long long)delayUs);
+        return true;
+    }
+
+    int64_t predictedUs = predictOffset(state, midTxUs);
+    int64_t errorUs = sampleOffsetUs - predictedUs;
+
+    // 충분히 떨어진 샘플 사이의 예측 오차로 드리프트 보정 (같은 시퀀스 안의 샘플은 오프셋만 갱신)
+    if (elapsedUs >= (int64_t)CLOCK_SYNC_MIN_DRIFT_INTERVAL_MS * 1000) {
+        int64_t measuredPpb = errorUs * 1000000000LL / elapsedUs;
+        int64_t driftPpb = state.driftPpb + measuredPpb / 4;
+        state.driftPpb = (int32_t)std::max<int64_t>(-CLOCK_SYNC_MAX_DRIFT_PPB, std::min<int64_t>(CLOCK_SYNC_MAX_DRIFT_PPB, driftPpb));
+    }
+    state.offsetUs = predictedUs + errorUs / 2;
+    state.refTxUs = midTxUs;
+    if (state.sampleCount < UINT16_MAX) state.sampleCount++;
+
+    logPrintf(LogLevel::LOG_DEBUG, "SYNC: ID %d 오프셋 %lld us (오차 %lld us, 드리프트 %ld ppb, 왕복 %lld us)",
+              deviceID, (long long)state.offsetUs, (long long)errorUs, (long)state.driftPpb, (long long)delayUs);
+    return true;
+}
+
+int64_t clockSyncOffsetAt(uint8_t deviceID, int64_t atTxUs) {
+    if (deviceID == 0 || deviceID > MAX_DEVICES) return Comm::kNoClockOffset;
+    const ClockSyncState& state = s_clockSync[deviceID];
+    if (state.sampleCount == 0) return Comm::kNoClockOffset;
+    if (esp_timer_get_time() - state.refTxUs > (int64_t)CLOCK_SYNC_MAX_AGE_MS * 1000) return Comm::kNoClockOffset;
+    return predictOffset(state, atTxUs);
+}
+
+const ClockSyncState* clockSyncState(uint8_t deviceID) {
+    if (deviceID == 0 || deviceID > MAX_DEVICES) return nullptr;
+    return &s_clockSync[deviceID];
+}
@@ -0,0 +1,37 @@
+#pragma once
+#ifndef CLOCKSYNC_T_H
+#define CLOCKSYNC_T_H
+
+#include <Arduino.h>
+#include "config_t.h"
+
+//────────────────────────────────────────────────────────────────────────────
+// [NEW] 수신기별 시계 동기화 (NTP 방식 4-타임스탬프)
+//  - T1: 송신부가 CMD를 보낸 시각 (송신부 esp_timer)
+//  - T2: 수신부가 CMD를 받은 시각 (수신부 esp_timer, ACK의 rxLocalUs)
+//  - T3: 수신부가 ACK를 보낸 시각 (T2 + Rx 처리 시간 + ACK 슬롯 대기)
+//  - T4: 송신부가 ACK를 받은 시각 (송신부 esp_timer)
+//  오프셋 = ((T2 - T1) + (T3 - T4)) / 2, 왕복 지연 = (T4 - T1) - (T3 - T2)
+//  추정값은 장치 ID별로 시퀀스가 끝나도 유지되며, 연속된 샘플로 드리프트(ppb)도 추정합니다.
+//────────────────────────────────────────────────────────────────────────────
+
+struct ClockSyncState {
+    int64_t  refTxUs;       // 추정 기준 시각 (송신부 esp_timer)
+    int64_t  offsetUs;      // 기준 시각에서의 (수신부 시계 - 송신부 시계)
+    int32_t  driftPpb;      // 추정된 상대 드리프트 (ppb, 수신부가 빠르면 양수)
+    uint32_t minDelayUs;    // 지금까지 관측된 최소 왕복 지연 (이상치 필터 기준)
+    uint16_t sampleCount;   // 채택된 샘플 수 (0이면 추정값 없음)
+};
+
+// 모든 장치의 동기화 상태 초기화
+void clockSyncInit();
+
+// ACK 한 쌍으로 얻은 4개의 타임스탬프를 반영. 이상치로 버려지면 false 반환
+bool clockSyncAddSample(uint8_t deviceID, int64_t t1, int64_t t2, int64_t t3, int64_t t4);
+
+// 송신부 시각 atTxUs에서의 오프셋 예측값. 추정값이 없거나 오래되었으면 Comm::kNoClockOffset 반환
+int64_t clockSyncOffsetAt(uint8_t deviceID, int64_t atTxUs);
+
+const ClockSyncState* clockSyncState(uint8_t deviceID);
+
+#endif // CLOCKSYNC_T_H
@@ -34,8 +34,10 @@
 #define MAX_DELAY_SECONDS     59
 #define MIN_PLAY_SECONDS      1
 #define MAX_PLAY_SECONDS      60
+#define PEER_MAC_TABLE_ADDR   200 // [NEW] 장치별 수신기 MAC (ID당 7바이트: MAC 6 + 유효 표시 1)
 #define DEVICE_ID_ADDR        400
-#define GROUP_ID_ADDR         401
+#define GROUP_ID_ADDR         401 // [MODIFIED] 이 송신기의 그룹 번호 (수신기에 등록하는 그룹 주소, 1~32. 값이 없으면 1. 수신기는 송신기 MAC별로 등록하므로 송신기끼리 겹쳐도 됨)
+#define CHANNEL_ADDR          402 // [NEW] 마지막으로 옮긴 ESP-NOW 채널 (재부팅 후 같은 채널에서 시작)
 #define SETTINGS_START_ADDR   100
 #define MS_PER_SEC            1000UL
 #define MS_PER_MIN            (60 * MS_PER_SEC)
@@ -52,10 +54,88 @@
 //────────────────────────────────────────────────────────────────────────────
 // 3) ESP-NOW 관련 상수
 //────────────────────────────────────────────────────────────────────────────
-#define WIFI_CHANNEL            1
-#define ACK_TIMEOUT_MS          200
-#define RETRY_INTERVAL_MS       300
+#define WIFI_CHANNEL            1 // [MODIFIED] 저장된 채널이 없을 때의 기본 채널
+#define ACK_TIMEOUT_MS          200 // [MODIFIED] RTT를 아직 측정하지 못한 수신기의 초기 ACK 타임아웃 (이후 링크별 적응형 RTO 사용)
+#define ACK_RTO_MIN_US          3000   // 적응형 ACK 타임아웃 하한 (us, loop 지연과 수신기 처리 시간 변동 흡수)
+#define ACK_RTO_MAX_US          400000 // 적응형 ACK 타임아웃 상한 (us, 백오프 포함)
+#define ACK_RTO_GRANULARITY_US  1000   // RTO 계산 시 4 x RTTVAR의 최솟값 (타임아웃 확인 주기)
+#define ACK_RTO_MAX_BACKOFF     4      // 연속 타임아웃 시 RTO를 최대 2^4배까지 늘림
 #define MAX_SEND_ATTEMPTS       5
+#define MAX_PACKETS_IN_FLIGHT   4   // 동시에 ACK를 기다릴 수 있는 최대 패킷 수 (1로 설정하면 거의 순차 동작)
+#define SEND_PACING_MS          0   // [MODIFIED] 연속된 패킷 전송 사이의 최소 간격 (ms, 송신 큐가 드라이버 완료에 맞춰 보내므로 기본 0)
+#define SEND_RETRY_BACKOFF_US   1000 // [NEW] 드라이버가 전송을 거부했을 때 다시 시도하기까지 기다리는 시간 (us)
+#define TX_QUEUE_SLOTS          8    // [NEW] 송신 큐 크기 (가득 차면 전송 대기열에서 다음 loop까지 기다림)
+#define TX_DRIVER_DEPTH         2    // [NEW] 송신 완료를 기다리며 드라이버에 동시에 넘기는 프레임 수 (앞 프레임 방송 중 다음 프레임 준비)
+#define TX_DONE_HISTORY         16   // [NEW] ACK의 txMicros로 찾을 송신 완료 기록 수
+#define SCHED_MAX_IDLE_SLEEP_MS 10   // [NEW] 예약된 이벤트가 없어도 loop가 버튼/화면을 확인하러 깨어나는 최대 간격 (ms)
+#define SCHED_LATE_THRESHOLD_US 2000 // [NEW] 기한보다 이만큼 늦게 처리된 이벤트를 지연으로 집계 (us)
+#define ENABLE_BATCH_COMMAND    true // 최종 명령 대기 장치가 2개 이상이면 하나의 BATCH_COMMAND로 묶어 전송
+#define ACK_SLOT_MIN_US         500  // 일괄 명령 ACK 슬롯 폭 하한 (us)
+#define ACK_SLOT_MAX_US         4000 // 일괄 명령 ACK 슬롯 폭 상한 (us)
+#define ACK_SLOT_GUARD_US       300  // 측정된 ACK 전송 시간에 더하는 보호 구간 (us)
+#define CLOCK_SYNC_MAX_AGE_MS   600000 // 이 시간보다 오래된 시계 오프셋 추정값은 사용하지 않음 (ms)
+#define CLOCK_SYNC_MIN_DRIFT_INTERVAL_MS 1000 // 드리프트 추정에 쓰는 두 샘플 사이의 최소 간격 (ms)
+#define CLOCK_SYNC_DELAY_SLACK_US 2000 // 최소 왕복 지연 x 2에 더해 허용하는 여유 (이보다 느린 샘플은 버림)
+#define CLOCK_SYNC_MAX_DRIFT_PPB 200000 // 드리프트 추정 상한 (200 ppm)
+#define ENABLE_UNICAST_PEERS    true // MAC을 학습한 수신기에는 유니캐스트로 전송 (링크 계층 ACK/재전송 사용)
+#define PEER_UNICAST_LIMIT      19   // esp_now 피어 테이블에 등록할 최대 수신기 수 (드라이버 한도 20 - 브로드캐스트 1)
+#define PEER_UNICAST_MAX_MISSES 2    // 유니캐스트가 연속으로 이만큼 응답을 받지 못하면 브로드캐스트로 대체
+#define ACK_RX_QUEUE_SLOTS      16   // 수신 콜백 → loop ACK 전달 큐 크기 (2의 거듭제곱)
+#define ACK_RX_SLOT_BYTES       48   // 큐 슬롯당 프레임 크기 (ACK보다 긴 프레임은 큐에 넣지 않음)
+#define LINK_CACHE_MAX_AGE_MS   30000 // 이 시간 안에 측정된 RTT가 있으면 RTT_REQUEST 없이 바로 최종 명령 전송 (ms)
+#define LINK_CACHE_MIN_SAMPLES  2     // 캐시를 믿기 위한 최소 RTT 샘플 수
+#define LINK_CACHE_MAX_RTTVAR_US 3000 // RTT 편차가 이보다 크면 캐시를 쓰지 않고 다시 측정 (us)
+#define LINK_REFRESH_AGE_MS     20000 // 유휴 상태에서 이 시간보다 오래된 캐시는 백그라운드 RTT_REQUEST로 갱신 (ms)
+#define LINK_REFRESH_INTERVAL_MS 250  // 백그라운드 RTT_REQUEST 사이 최소 간격 (ms)
+#define LINK_REFRESH_MAX_FAILURES 3   // 연속으로 응답이 없으면 다음 실행까지 갱신 중단
+#define LINK_LOSS_WINDOW        16    // [NEW] 손실률 측정 창 (보낸 프레임 수)
+#define LINK_RTT_HISTORY        32    // [NEW] 진단 화면의 RTT 최소/중앙값/p95 계산에 쓰는 최근 샘플 수
+#define DIAG_PROBE_INTERVAL_MS  200   // [NEW] 진단 화면에서 보고 있는 수신기에 RTT_REQUEST를 보내는 간격 (ms)
+#define ENABLE_REDUNDANT_TX     true  // [NEW] ACK 타임아웃 후 재전송으로는 늦는 최종 명령을 ACK를 기다리지 않고 중복 전송
+#define REDUNDANT_MAX_COPIES    3     // [NEW] 패킷당 최대 중복 사본 수 (원본 제외)
+#define REDUNDANT_COPY_SPACING_US 3000 // [NEW] 중복 사본 사이 간격 (같은 잡음 구간에 함께 손실되지 않도록, us)
+#define REDUNDANT_TARGET_LOSS_PPM 2000 // [NEW] 사본을 포함해 남길 목표 손실률 (ppm, 0.2%)
+#define REDUNDANT_DEFAULT_LOSS_PERMILLE 50 // [NEW] 손실률을 아직 측정하지 못한 링크에 가정하는 값 (0.1% 단위)
+#define PHASE_REPORT_GRACE_MS   300   // [NEW] 수신기의 실제 플레이 종료 후 종료 보고를 기다리는 시간 (유실되면 이후 완료 처리, ms)
+#define STOP_RETRY_INTERVAL_MS  40    // [NEW] 비상 정지 패킷 재전송 간격 (ms, 모든 ACK 슬롯이 끝날 만큼)
+#define STOP_MAX_ATTEMPTS       25    // [NEW] 확인되지 않은 장치가 있을 때 비상 정지 패킷을 보내는 최대 횟수
+#define STOP_RESULT_HOLD_MS     5000  // [NEW] 비상 정지가 끝난 뒤 결과 화면을 보여주는 시간 (ms, SET 버튼으로 바로 닫기 가능)
+#define ENABLE_ARM_GO           true  // [NEW] 유휴 중 수신기에 실행 정보를 미리 보내 두고(ARM_CUE) PLAY 시 GO_COMMAND 하나로 실행
+#define ARM_REQUIRE_ALL         false // [NEW] true면 대상 장치가 모두 무장되어 있을 때만 실행 (아니면 무장 안 된 장치는 개별 명령으로)
+#define ARM_REFRESH_MS          30000 // [NEW] 무장된 장치에 최신 보정값/시계 오프셋으로 실행 정보를 다시 보내는 주기 (ms)
+#define ARM_MAX_AGE_MS          120000 // [NEW] 이 시간보다 오래 갱신되지 않은 실행 정보는 쓰지 않음 (ms)
+#define ARM_CUE_INTERVAL_MS     20    // [NEW] ARM_CUE 사이 최소 간격 (ms)
+#define ARM_MAX_FAILURES        3     // [NEW] 연속으로 응답이 없으면 ARM_REFRESH_MS 동안 그 장치에 보내지 않음
+#define GO_RETRY_INTERVAL_MS    15    // [NEW] GO_COMMAND 재전송 간격 (ms, 여기에 남은 장치 수 x ACK 슬롯 폭을 더함)
+#define GO_MAX_ATTEMPTS         4     // [NEW] GO_COMMAND 최대 전송 횟수. 끝내 ACK가 없는 장치는 개별 명령으로 대체
+#define ENABLE_GROUP_ADDRESS    true  // [NEW] 그룹 장치를 수신기에 그룹 번호로 등록하고, 실행 정보가 같으면 그룹 주소 명령 하나로 전송
+#define GROUP_MAX_COMPENSATION_SPREAD_US 200 // [NEW] 구성원 보정값(RTT/2 + 수신 처리)의 최대-최소가 이보다 크면 그룹 주소 명령(평균 보정값)을 쓰지 않음 (us)
+#define GROUP_CONFIG_INTERVAL_MS 50   // [NEW] GROUP_CONFIG 사이 최소 간격 (ms)
+#define GROUP_CONFIG_MAX_FAILURES 3   // [NEW] 연속으로 응답이 없으면 GROUP_CONFIG_RETRY_MS 동안 그 장치에 보내지 않음
+#define GROUP_CONFIG_RETRY_MS   30000 // [NEW] (ms)
+#define ENABLE_CHANNEL_SURVEY   true  // [NEW] 유휴 중 채널별 혼잡도를 측정해 더 조용한 채널로 수신기와 함께 이동
+#define CHANNEL_SURVEY_FIRST_DELAY_MS 15000  // [NEW] 부팅 후 첫 측정까지 대기 (ms)
+#define CHANNEL_SURVEY_INTERVAL_MS   600000  // [NEW] 측정 주기 (ms)
+#define CHANNEL_SURVEY_DWELL_MS      60      // [NEW] 채널당 수신 시간 (ms, 측정 중에는 현재 채널을 듣지 못함)
+#define CHANNEL_SURVEY_LAST_CHANNEL  11      // [NEW] 측정할 마지막 채널 (1부터, 지역 규정에 맞게 설정)
+#define CHANNEL_SURVEY_RSSI_FLOOR    -95     // [NEW] 프레임 세기 가중치의 기준 (이 값보다 1 dB 셀 때마다 가중치 1 증가)
+#define CHANNEL_HOP_MIN_GAIN_PCT     30      // [NEW] 현재 채널보다 이 비율 이상 조용해야 이동 (잦은 이동 방지)
+#define CHANNEL_HOP_MIN_SCORE        20000   // [NEW] 현재 채널 점수(바이트 x 세기 가중치)가 이 값 미만이면 충분히 조용하므로 이동하지 않음
+#define CHANNEL_HOP_LEAD_MS          400     // [NEW] 첫 채널 전환 패킷부터 실제 전환까지 시간 (ms)
+#define CHANNEL_HOP_RETRY_INTERVAL_MS 40     // [NEW] 채널 전환 패킷 재전송 간격 (ms)
+#define CHANNEL_HOP_ACK_MARGIN_MS    60      // [NEW] 전환 직전 이 시간 동안은 재전송하지 않음 (마지막 ACK 슬롯이 끝나도록, ms)
+#define CHANNEL_BEACON_INTERVAL_MS   500     // [NEW] 채널 비콘 간격 (ms, 수신기는 비콘이 끊기면 채널을 돌며 송신기를 찾음)
+#define ENABLE_RATE_CONTROL   true   // [NEW] 링크별 ESP-NOW 전송 속도와 송신 세기 조정 (false면 1 Mbps, 최대 세기 고정)
+#define RATE_RSSI_MARGIN_DB   8      // [NEW] 속도 단계의 수신 감도보다 이만큼 세야 그 단계를 사용 (dB)
+#define RATE_UP_SUCCESSES     10     // [NEW] 연속 ACK가 이만큼 쌓이면 한 단계 빠른 속도 시도
+#define RATE_UP_SUCCESSES_MAX 80     // [NEW] 빠른 속도 시도가 실패할 때마다 두 배로 늘리는 기준의 상한
+#define RATE_DOWN_FAILURES    2      // [NEW] 연속 ACK 타임아웃이 이만큼이면 한 단계 느린 속도로
+#define TX_POWER_MAX_QDBM     80     // [NEW] 최대 송신 세기 (0.25 dBm 단위, 80 = 20 dBm)
+#define TX_POWER_MIN_QDBM     40     // [NEW] 최소 송신 세기 (0.25 dBm 단위, 40 = 10 dBm)
+#define TX_POWER_STEP_QDBM    8      // [NEW] 송신 세기 조정 단위 (0.25 dBm 단위, 8 = 2 dB)
+#define TX_POWER_HEADROOM_DB  10     // [NEW] 가장 빠른 속도에서도 이만큼 여유가 있으면 송신 세기를 낮춤 (dB)
+#define CAPTURE_RING_SLOTS      128  // 패킷 캡처 링 크기 (2의 거듭제곱, 가장 오래된 레코드부터 덮어씀)
+#define CAPTURE_SNAP_LEN        64   // 레코드당 저장하는 최대 프레임 바이트 (일괄 명령은 헤더와 앞쪽 항목만 저장)
 
 static const uint8_t broadcastAddress[6] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
 
@@ -64,9 +144,17 @@ static const uint8_t broadcastAddress[6] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
 //────────────────────────────────────────────────────────────────────────────
 enum class LogLevel { LOG_DEBUG = 0, LOG_INFO, LOG_WARN, LOG_ERROR }; 
 enum ErrorCode { ERROR_NONE = 0, ERROR_INIT_FAILED, ERROR_INVALID_SETTINGS, ERROR_EXECUTION_FAILED };
-enum Mode { GENERAL_MODE = 0, GROUP_SETTING_MODE, TIMER_SETTING_MODE, DETAILED_SETTING_MODE, ADJUSTING_VALUE_MODE, EXECUTION_MODE, COMPLETION_MODE };
+enum Mode { GENERAL_MODE = 0, GROUP_SETTING_MODE, TIMER_SETTING_MODE, DETAILED_SETTING_MODE, ADJUSTING_VALUE_MODE, EXECUTION_MODE, COMPLETION_MODE, STOP_MODE, DIAGNOSTICS_MODE };
 enum TimerUnit { UNIT_MINUTES = 0, UNIT_SECONDS };
 
+// [NEW] 비상 정지 장치별 확인 상태
+enum StopStatus {
+    STOP_NOT_TARGETED,             // 확인 대상이 아님 (응답도 없음)
+    STOP_AWAITING_ACK,             // 정지 패킷 전송 중, ACK 대기
+    STOP_CONFIRMED,                // 정지 ACK 수신 (출력 차단 확인)
+    STOP_NO_ACK                    // 최대 전송 횟수까지 ACK 없음
+};
+
 // [MODIFIED] 통신 상태 열거형 업데이트
 enum CommStatus {
     COMM_IDLE,                     // 유휴 상태
@@ -75,7 +163,8 @@ enum CommStatus {
     COMM_PENDING_FINAL_COMMAND,    // 최종 명령 패킷 전송 대기 중
     COMM_AWAITING_FINAL_ACK,       // 최종 명령 ACK 대기 중
     COMM_ACK_RECEIVED_SUCCESS,     // 모든 ACK 성공적으로 수신
-    COMM_FAILED_NO_ACK             // 모든 재시도 후 ACK 수신 실패
+    COMM_FAILED_NO_ACK,            // 모든 재시도 후 ACK 수신 실패
+    COMM_AWAITING_GO_ACK           // [NEW] 무장된 장치. GO_COMMAND ACK 대기 중
 };
 
 //────────────────────────────────────────────────────────────────────────────
@@ -101,13 +190,26 @@ struct RunningDevice {
     uint8_t sendAttempts;
     uint8_t successfulAcks;
     unsigned long lastPacketSendTime; // 마지막 패킷 전송 시점 (millis())
-    unsigned long ackTimeoutDeadline; // ACK 타임아웃 기한 (millis())
     uint32_t lastTxTimestamp;         // 마지막 전송 패킷의 txMicros 값 (micros())
+    uint32_t ackSlotWaitUs;           // [NEW] 마지막 패킷에 대해 수신기가 ACK 슬롯까지 기다리는 시간 (RTT에서 제외)
+    uint32_t messageSeq;              // [NEW] 현재 단계 메시지의 시퀀스 번호 (0이면 미할당, 재전송 시 유지)
     uint32_t txButtonPressSequenceMicros; // 이 실행 시퀀스가 시작된 버튼 누름 시점 (micros())
+    int64_t  sequenceStartUs;         // [NEW] 같은 버튼 누름 시점의 64비트 esp_timer 값 (절대 실행 시각 계산용)
     
     // [NEW] 현재 시퀀스 내에서 측정된 RTT 및 Rx 처리 시간 (최종 명령 패킷에 포함될 값)
     uint32_t currentSequenceRttUs; 
     uint32_t currentSequenceRxProcessingTimeUs;
+
+    // [NEW] 버튼 누름부터 최종 ACK 수신까지 걸린 시간 (장치별 무장 시간, 0이면 미완료)
+    uint32_t armTimeUs;
+
+    // [NEW] 수신기 실행 단계 보고(PHASE_REPORT)로 받은 실제 실행 정보
+    uint8_t  reportedPhase;           // 지금까지 보고된 가장 나중 단계 (Comm::ExecPhase, 0이면 보고 없음)
+    int32_t  rxCompensationUs;        // 수신기가 실제로 적용한 보정값
+    uint32_t rxPlayMs;                // 수신기의 실제 플레이 시간
+    bool     rxFireReported;          // 출력 시작 보고를 받았는지
+    int32_t  rxFireErrorUs;           // 수신기 시계 기준 출력 시작 오차 (실제 - 목표)
+    int64_t  rxFireTxUs;              // 송신부 esp_timer로 환산한 실제 출력 시작 시각 (시계 오프셋을 모르면 0)
 };
 
 //────────────────────────────────────────────────────────────────────────────
@@ -1,62 +1,421 @@
 #include "espnow_t.h"
 #include "utils_t.h" 
+#include "clocksync_t.h"
+#include "link_t.h"
+#include "capture_t.h"
+#include "peer_t.h"
+#include "sched_t.h"
+#include "channel_t.h"
+#include "rate_t.h"
+#include "txqueue_t.h"
 #include <algorithm> 
+#include <atomic>
 
-// ESP-NOW 송신 콜백 (단순 로그 출력)
-void espNowSendCb(const uint8_t* mac_addr, esp_now_send_status_t status) {
-    if (status != ESP_NOW_SEND_SUCCESS) {
-        logPrintf(LogLevel::LOG_ERROR, "ESP-NOW: 송신 실패, 상태=%d", status);
-    } else {
-        logPrintf(LogLevel::LOG_DEBUG, "ESP-NOW: 송신 성공.");
+// [NEW] 관측된 ACK 단방향 전송 시간 추정치 (EWMA, us). 일괄 명령의 ACK 슬롯 폭 계산에 사용
+static uint32_t s_ackAirtimeEstUs = 0;
+
+// 슬롯 폭 = 추정 ACK 전송 시간 x 1.5 + 보호 구간, [ACK_SLOT_MIN_US, ACK_SLOT_MAX_US]로 제한
+static uint16_t currentAckSlotUs() {
+    uint32_t slotUs = s_ackAirtimeEstUs + s_ackAirtimeEstUs / 2 + ACK_SLOT_GUARD_US;
+    slotUs = std::max<uint32_t>(ACK_SLOT_MIN_US, std::min<uint32_t>(ACK_SLOT_MAX_US, slotUs));
+    return (uint16_t)slotUs;
+}
+
+// [NEW] 송신기 메시지 시퀀스 번호. 재부팅 후 수신기의 중복 검사 창과 겹치지 않도록 임의 값에서 시작
+static uint32_t s_nextSeq = 0;
+
+uint32_t nextMessageSeq() {
+    if (s_nextSeq == 0) s_nextSeq = esp_random();
+    uint32_t seq = s_nextSeq++;
+    if (seq == 0) seq = s_nextSeq++;
+    return seq;
+}
+
+// [NEW] 유휴 상태에서 링크 캐시를 갱신하는 백그라운드 RTT_REQUEST (한 번에 하나만 진행)
+struct LinkProbe {
+    bool     active;
+    uint8_t  deviceID;
+    uint32_t txMicros;
+    uint32_t deadlineUs;
+};
+static LinkProbe s_probe = {};
+static unsigned long s_lastProbeMs = 0;
+static uint8_t s_nextProbeId = 1;
+static uint8_t s_focusId = 0;          // [NEW] 진단 화면에서 보고 있는 장치 (0은 없음)
+
+// [NEW] 유휴 상태에서 실행 정보를 미리 보내는 ARM_CUE (백그라운드 갱신과 번갈아 한 번에 하나만 진행)
+struct ArmCueProbe {
+    bool     active;
+    uint8_t  deviceID;
+    uint32_t txMicros;
+    uint32_t deadlineUs;
+    uint32_t delayMs;    // 보낸 실행 정보 (ACK를 받으면 무장 상태로 기록)
+    uint32_t playMs;
+};
+static ArmCueProbe s_cue = {};
+
+// [NEW] 유휴 상태에서 수신기 그룹 등록을 맞추는 GROUP_CONFIG (마찬가지로 한 번에 하나만)
+struct GroupConfigProbe {
+    bool     active;
+    uint8_t  deviceID;
+    uint32_t txMicros;
+    uint32_t deadlineUs;
+    bool     member;     // 보낸 요청 (ACK를 받으면 확인된 상태로 기록)
+};
+static GroupConfigProbe s_groupCfg = {};
+
+static void updateAckAirtimeEstimate(uint32_t rttUs, uint32_t rxProcessingTimeUs) {
+    if (rttUs <= rxProcessingTimeUs) return;
+    uint32_t oneWayUs = (rttUs - rxProcessingTimeUs) / 2;
+    s_ackAirtimeEstUs = (s_ackAirtimeEstUs == 0) ? oneWayUs : (s_ackAirtimeEstUs * 7 + oneWayUs) / 8;
+}
+
+//────────────────────────────────────────────────────────────────────────────
+// [NEW] 수신 콜백 → loop 전달 큐 (단일 생산자/단일 소비자, 잠금 없음)
+//  - ESP-NOW 콜백은 Wi-Fi 드라이버 태스크에서 실행되므로 수신 시각만 기록하고 프레임을 큐에 넣음
+//  - ACK 검증, runningDevices 갱신, 로그 출력은 모두 loop()에서 processReceivedAcks()가 처리
+//────────────────────────────────────────────────────────────────────────────
+static_assert((ACK_RX_QUEUE_SLOTS & (ACK_RX_QUEUE_SLOTS - 1)) == 0, "ACK_RX_QUEUE_SLOTS must be a power of two");
+
+struct RxSlot {
+    int64_t rxTimeUs;                   // 콜백 진입 시각 (시계 동기화용 T4)
+    uint8_t srcMac[6];                  // [NEW] 보낸 수신기 MAC (유니캐스트 피어 학습용)
+    int8_t  rssi;                       // [NEW] 수신 세기 (링크 진단용, dBm)
+    uint8_t len;
+    uint8_t data[ACK_RX_SLOT_BYTES];
+};
+static RxSlot s_rxSlots[ACK_RX_QUEUE_SLOTS];
+static std::atomic<uint32_t> s_rxHead{0};      // 콜백만 증가
+static std::atomic<uint32_t> s_rxTail{0};      // loop만 증가
+static std::atomic<uint32_t> s_rxDropped{0};   // 큐가 가득 찼거나 ACK보다 긴 프레임
+static std::atomic<uint32_t> s_txDoneFailed{0};
+static uint32_t s_rxDroppedReported = 0;
+static uint32_t s_txDoneFailedReported = 0;
+
+// [NEW] 장치 ID → runningDevices 위치 (0xFF는 없음). 시퀀스 시작 후 첫 ACK 처리 때 만듦 (시작 시 정렬되므로)
+static uint8_t s_slotById[MAX_DEVICES + 1];
+static bool s_slotIndexValid = false;
+
+static RunningDevice* findRunningDevice(uint8_t deviceID) {
+    if (deviceID == 0 || deviceID > MAX_DEVICES) return nullptr;
+    if (!s_slotIndexValid) {
+        memset(s_slotById, 0xFF, sizeof(s_slotById));
+        for (uint8_t i = 0; i < groupDeviceCount; ++i) {
+            uint8_t id = runningDevices[i].deviceID;
+            if (id >= 1 && id <= MAX_DEVICES) s_slotById[id] = i;
+        }
+        s_slotIndexValid = true;
     }
+    uint8_t slot = s_slotById[deviceID];
+    return (slot < groupDeviceCount) ? &runningDevices[slot] : nullptr;
 }
 
-// ESP-NOW 수신 콜백 (ACK 패킷 처리 - 송신부가 ACK를 받기 위해 필요)
+// [NEW] 파이프라인 통신 엔진의 ACK/타임아웃 처리 함수 (아래 정의)
+static void settleAck(uint8_t slot, uint32_t txTimestamp);
+static void enqueuePending(uint8_t slot);
+static void markFinished(RunningDevice& device, uint8_t slot, bool success);
+static void handleAckTimeout(uint8_t slot, int64_t dueUs);
+static bool isAwaitingAck(const RunningDevice& device);
+static bool sentRedundantCopies(uint32_t txTimestamp);
+static void sendRedundantCopy(uint8_t slot, int64_t dueUs);
+static bool handleStopAck(uint8_t deviceID, uint32_t originalTxMicros);
+static void sendStopPacket(uint8_t slot, int64_t dueUs);
+static bool handleChannelHopAck(uint8_t deviceID, uint32_t originalTxMicros);
+static void sendChannelHop(uint8_t slot, int64_t dueUs);
+static bool channelHopActive();
+static void recordArmCueAck();
+static void recordGroupConfigAck();
+static uint8_t groupAddressFor(RunningDevice* const devices[], uint8_t count);
+static bool sendGroupCommand(RunningDevice* const devices[], uint8_t count, uint8_t groupId, uint32_t& out_tx_timestamp);
+static bool handleGoAck(uint8_t deviceID, uint32_t originalTxMicros, int64_t rxTimeUs);
+static void sendGoPacket(uint8_t slot, int64_t dueUs);
+static void startGoTrigger(uint32_t targetBitmap);
+static void cancelGoTrigger();
+
+// ESP-NOW 송신 콜백 (Wi-Fi 태스크에서 실행되므로 실패 횟수만 세고 로그는 loop에서 출력)
+void espNowSendCb(const uint8_t* mac_addr, esp_now_send_status_t status) {
+    captureTxDone(mac_addr, status); // [NEW]
+    txqOnSendDone(status); // [NEW] 전송 시작 시각 기록 (다음 프레임은 loop가 넘김)
+    if (status != ESP_NOW_SEND_SUCCESS) s_txDoneFailed.fetch_add(1, std::memory_order_relaxed);
+}
+
+// ESP-NOW 수신 콜백 (ACK 패킷을 큐에 넣기만 함 - 처리는 processReceivedAcks)
 void OnDataRecv(const esp_now_recv_info_t *info, const uint8_t *data, int len) {
-    const Comm::AckPacket* ackPkt = nullptr; 
+    int64_t rxTimeUs = esp_timer_get_time();
+    captureRx(info, data, len); // [NEW] 검증 전 원본 프레임 기록
+    if (len <= 0 || len > ACK_RX_SLOT_BYTES) {
+        s_rxDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    uint32_t head = s_rxHead.load(std::memory_order_relaxed);
+    if (head - s_rxTail.load(std::memory_order_acquire) >= ACK_RX_QUEUE_SLOTS) {
+        s_rxDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    RxSlot& slot = s_rxSlots[head % ACK_RX_QUEUE_SLOTS];
+    slot.rxTimeUs = rxTimeUs;
+    if (info) memcpy(slot.srcMac, info->src_addr, 6); else memset(slot.srcMac, 0, 6);
+    slot.rssi = (info && info->rx_ctrl) ? (int8_t)info->rx_ctrl->rssi : 0;
+    slot.len = (uint8_t)len;
+    memcpy(slot.data, data, len);
+    s_rxHead.store(head + 1, std::memory_order_release);
+    schedWake(); // [NEW] 다음 이벤트까지 잠든 loop를 바로 깨움
+}
+
+// ACK 한 개 처리 (loop 컨텍스트)
+// [MODIFIED] TLV 형식 ACK와 구 펌웨어(v3) ACK를 모두 받아 수신기의 버전/기능을 기록
+static void processAck(const uint8_t *data, int len, int64_t rxTimeUs, const uint8_t* srcMac, int8_t rssi) {
+    Comm::AckPacket ackPkt;
+    Comm::LegacyAckPacketV3 legacyAck;
+    uint8_t ackingDeviceID;
+    uint32_t originalTxMicros;
+    uint32_t rxProcessingTimeUs;
+    bool hasRxLocalTime = false;
+    uint64_t rxLocalUs = 0;
 
-    if (!Comm::verifyAckPacket(data, len, ackPkt)) {
+    if (Comm::verifyAckPacket(data, len, ackPkt)) {
+        ackingDeviceID = ackPkt.senderId;
+        originalTxMicros = ackPkt.originalTxMicros;
+        rxProcessingTimeUs = ackPkt.rxProcessingTimeUs;
+        rxLocalUs = ackPkt.rxLocalUs;
+        hasRxLocalTime = true;
+
+        uint32_t capabilities = 0;
+        Comm::findTlvValue(data, len, Comm::TLV_CAPABILITIES, capabilities);
+        linkRecordProtocol(ackingDeviceID, ackPkt.version, capabilities);
+    } else if (Comm::verifyLegacyAckPacketV3(data, len, legacyAck)) {
+        ackingDeviceID = legacyAck.senderId;
+        originalTxMicros = legacyAck.originalTxMicros;
+        rxProcessingTimeUs = legacyAck.rxProcessingTimeUs;
+        linkRecordProtocol(ackingDeviceID, Comm::kLegacyVersion, 0);
+    } else {
         logPrintf(LogLevel::LOG_WARN, "COMM: 유효하지 않은 ACK 패킷 수신. 무시됨."); 
         return; // 유효하지 않은 ACK 패킷은 무시
     }
 
-    uint8_t ackingDeviceID = ackPkt->senderId;
-    unsigned long rtt = micros() - ackPkt->originalTxMicros; // RTT 계산
+    peerLearn(ackingDeviceID, srcMac); // [NEW] 다음 전송부터 이 MAC으로 유니캐스트
+    linkRecordRssi(ackingDeviceID, rssi); // [NEW] 링크 진단
+    if (handleStopAck(ackingDeviceID, originalTxMicros)) return; // [NEW] 비상 정지 확인 (링크 통계와 실행 상태는 건드리지 않음)
+    if (handleChannelHopAck(ackingDeviceID, originalTxMicros)) return; // [NEW] 채널 전환 확인
+    linkRecordAckHeard(ackingDeviceID); // [NEW] 손실률 측정 (중복 사본에 대한 ACK도 포함)
+    rateRecordAck(ackingDeviceID, rssi); // [NEW] 전송 속도/세기 조정
+    if (handleGoAck(ackingDeviceID, originalTxMicros, rxTimeUs)) return; // [NEW] GO 확인 (ACK 슬롯 대기가 섞여 있어 RTT 샘플로 쓰지 않음)
+    unsigned long rawRtt = (uint32_t)rxTimeUs - originalTxMicros; // RTT 계산
+    // [NEW] 송신 큐와 드라이버에서 기다린 시간은 빼고 실제 전송 시작부터 잼
+    int64_t airStartUs = 0;
+    if (txqSentAt(originalTxMicros, airStartUs) && airStartUs <= rxTimeUs && (unsigned long)(rxTimeUs - airStartUs) <= rawRtt) {
+        rawRtt = (unsigned long)(rxTimeUs - airStartUs);
+    }
 
-    for (int i = 0; i < groupDeviceCount; ++i) {
-        RunningDevice& device = runningDevices[i];
-        if (device.deviceID == ackingDeviceID) {
-            // [MODIFIED] ACK 수신 시 상태별 처리
-            if (device.commStatus == COMM_AWAITING_RTT_ACK) {
-                // RTT 요청에 대한 ACK를 받은 경우
-                if (device.lastTxTimestamp == ackPkt->originalTxMicros) {
-                    device.currentSequenceRttUs = rtt; // 현재 시퀀스의 RTT 저장
-                    device.currentSequenceRxProcessingTimeUs = ackPkt->rxProcessingTimeUs; // 현재 시퀀스의 Rx 처리 시간 저장
-                    device.successfulAcks++;
-                    device.commStatus = COMM_PENDING_FINAL_COMMAND; // 최종 명령 전송 대기 상태로 변경
-                    logPrintf(LogLevel::LOG_INFO, "COMM: ID %d로부터 RTT ACK 성공. RTT: %lu us, RxProc: %lu us.", 
-                                ackingDeviceID, rtt, ackPkt->rxProcessingTimeUs);
-                } else {
-                    logPrintf(LogLevel::LOG_WARN, "COMM: ID %d로부터 RTT ACK 수신 (타임스탬프 불일치). 무시됨. (현재 TX: %u, 수신 ACK TX: %u)", 
-                                ackingDeviceID, device.lastTxTimestamp, ackPkt->originalTxMicros);
-                }
-            } else if (device.commStatus == COMM_AWAITING_FINAL_ACK) {
-                // 최종 명령에 대한 ACK를 받은 경우
-                if (device.lastTxTimestamp == ackPkt->originalTxMicros) {
-                    device.successfulAcks++;
-                    device.commStatus = COMM_ACK_RECEIVED_SUCCESS; // 최종 통신 성공 상태로 변경
-                    logPrintf(LogLevel::LOG_INFO, "COMM: ID %d로부터 최종 CMD ACK 성공. RTT: %lu us, RxProc: %lu us.", 
-                                ackingDeviceID, rtt, ackPkt->rxProcessingTimeUs);
-                } else {
-                    logPrintf(LogLevel::LOG_WARN, "COMM: ID %d로부터 최종 CMD ACK 수신 (타임스탬프 불일치). 무시됨. (현재 TX: %u, 수신 ACK TX: %u)", 
-                                ackingDeviceID, device.lastTxTimestamp, ackPkt->originalTxMicros);
-                }
-            } else {
-                logPrintf(LogLevel::LOG_WARN, "COMM: ID %d로부터 ACK 수신 (예상치 못한 상태: %d). 무시됨.", 
-                            ackingDeviceID, device.commStatus);
+    // [NEW] 백그라운드 갱신 응답: 링크 캐시와 시계 동기화만 갱신 (실행 중인 장치 상태는 건드리지 않음)
+    // [MODIFIED] ARM_CUE 응답도 같은 방식으로 샘플을 얻고 장치를 무장된 것으로 기록
+    // [MODIFIED] GROUP_CONFIG 응답도 마찬가지 (확인된 그룹 등록 상태를 기록)
+    bool cueAck = s_cue.active && s_cue.deviceID == ackingDeviceID && s_cue.txMicros == originalTxMicros;
+    bool groupAck = s_groupCfg.active && s_groupCfg.deviceID == ackingDeviceID && s_groupCfg.txMicros == originalTxMicros;
+    if (cueAck || groupAck || (s_probe.active && s_probe.deviceID == ackingDeviceID && s_probe.txMicros == originalTxMicros)) {
+        linkRecordRtt(ackingDeviceID, rawRtt, rxProcessingTimeUs);
+        if (hasRxLocalTime) {
+            int64_t t1 = rxTimeUs - (int64_t)rawRtt;
+            int64_t t2 = (int64_t)rxLocalUs;
+            clockSyncAddSample(ackingDeviceID, t1, t2, t2 + rxProcessingTimeUs, rxTimeUs);
+        }
+        if (cueAck) {
+            recordArmCueAck();
+            return;
+        }
+        if (groupAck) {
+            recordGroupConfigAck();
+            return;
+        }
+        s_probe.active = false;
+        logPrintf(LogLevel::LOG_DEBUG, "LINK: ID %d 백그라운드 갱신 RTT %lu us", ackingDeviceID, rawRtt);
+        return;
+    }
+
+    RunningDevice* found = findRunningDevice(ackingDeviceID);
+    if (!found) return;
+    RunningDevice& device = *found;
+    uint8_t slot = (uint8_t)(found - runningDevices);
+
+    // [NEW] 수신기가 ACK 슬롯에서 기다린 시간은 통신 지연이 아니므로 제외
+    unsigned long rtt = (rawRtt > device.ackSlotWaitUs) ? rawRtt - device.ackSlotWaitUs : 0;
+    // [MODIFIED] 중복 사본을 보낸 패킷은 어느 사본의 ACK인지 알 수 없으므로 RTT/시계 샘플로 쓰지 않음 (Karn 규칙)
+    if (device.lastTxTimestamp == originalTxMicros && isAwaitingAck(device) && !sentRedundantCopies(originalTxMicros)) {
+        updateAckAirtimeEstimate(rtt, rxProcessingTimeUs);
+        linkRecordRtt(ackingDeviceID, rtt, rxProcessingTimeUs); // [NEW] 적응형 ACK 타임아웃, 링크 캐시 갱신
+
+        // [NEW] 4-타임스탬프 시계 동기화. T3는 수신기가 실제로 ACK를 보낸 시각 (처리 시간 + 슬롯 대기 포함)
+        if (hasRxLocalTime) {
+            int64_t t1 = rxTimeUs - (int64_t)rawRtt;
+            int64_t t2 = (int64_t)rxLocalUs;
+            int64_t t3 = t2 + rxProcessingTimeUs + device.ackSlotWaitUs;
+            clockSyncAddSample(ackingDeviceID, t1, t2, t3, rxTimeUs);
+        }
+    }
+    // [MODIFIED] ACK 수신 시 상태별 처리
+    if (device.commStatus == COMM_AWAITING_RTT_ACK) {
+        // RTT 요청에 대한 ACK를 받은 경우
+        if (device.lastTxTimestamp == originalTxMicros) {
+            device.currentSequenceRttUs = rtt; // 현재 시퀀스의 RTT 저장
+            device.currentSequenceRxProcessingTimeUs = rxProcessingTimeUs; // 현재 시퀀스의 Rx 처리 시간 저장
+            device.successfulAcks++;
+            device.messageSeq = 0; // 최종 명령은 새 메시지이므로 새 시퀀스 번호 사용
+            device.commStatus = COMM_PENDING_FINAL_COMMAND; // 최종 명령 전송 대기 상태로 변경
+            settleAck(slot, originalTxMicros); // [NEW]
+            enqueuePending(slot);
+            logPrintf(LogLevel::LOG_INFO, "COMM: ID %d로부터 RTT ACK 성공. RTT: %lu us, RxProc: %lu us.", 
+                        ackingDeviceID, rtt, rxProcessingTimeUs);
+        } else {
+            logPrintf(LogLevel::LOG_WARN, "COMM: ID %d로부터 RTT ACK 수신 (타임스탬프 불일치). 무시됨. (현재 TX: %u, 수신 ACK TX: %u)", 
+                        ackingDeviceID, device.lastTxTimestamp, originalTxMicros);
+        }
+    } else if (device.commStatus == COMM_AWAITING_FINAL_ACK) {
+        // 최종 명령에 대한 ACK를 받은 경우
+        if (device.lastTxTimestamp == originalTxMicros) {
+            device.successfulAcks++;
+            device.armTimeUs = (uint32_t)rxTimeUs - device.txButtonPressSequenceMicros; // [NEW] 장치별 무장 시간 기록 (ACK 수신 시각 기준)
+            device.commStatus = COMM_ACK_RECEIVED_SUCCESS; // 최종 통신 성공 상태로 변경
+            settleAck(slot, originalTxMicros); // [NEW]
+            logPrintf(LogLevel::LOG_INFO, "COMM: ID %d로부터 최종 CMD ACK 성공. RTT: %lu us, RxProc: %lu us.", 
+                        ackingDeviceID, rtt, rxProcessingTimeUs);
+            markFinished(device, slot, true); // [NEW] 로컬 타이머 예약
+        } else {
+            logPrintf(LogLevel::LOG_WARN, "COMM: ID %d로부터 최종 CMD ACK 수신 (타임스탬프 불일치). 무시됨. (현재 TX: %u, 수신 ACK TX: %u)", 
+                        ackingDeviceID, device.lastTxTimestamp, originalTxMicros);
+        }
+    } else if (device.lastTxTimestamp == originalTxMicros) {
+        // [NEW] 이미 처리한 패킷의 중복 사본에 대한 ACK
+        logPrintf(LogLevel::LOG_DEBUG, "COMM: ID %d로부터 중복 사본 ACK 수신. 무시됨.", ackingDeviceID);
+    } else {
+        logPrintf(LogLevel::LOG_WARN, "COMM: ID %d로부터 ACK 수신 (예상치 못한 상태: %d). 무시됨.", 
+                    ackingDeviceID, device.commStatus);
+    }
+}
+
+// [NEW] 수신기 실행 단계 보고 처리 (loop 컨텍스트)
+//  - 화면용 딜레이/플레이 종료 시각을 수신기의 실제 일정으로 바꿈 (시계 오프셋으로 송신부 시각으로 환산)
+//  - 로컬 타이머 이벤트를 실제 일정에 맞춤: 출력 시작 보고가 오면 딜레이 종료를 지금 처리하고 플레이 종료는
+//    실제 종료 + PHASE_REPORT_GRACE_MS로, 종료/중단 보고가 오면 바로 완료 (보고가 유실되면 기존 예약대로 완료)
+//  - 보고는 순서가 바뀌어 올 수 있으므로 단계는 앞으로만 진행 (무장 보고의 보정값/플레이 시간은 항상 기록)
+static void processPhaseReport(const uint8_t *data, int len, int64_t rxTimeUs, int8_t rssi) {
+    Comm::PhaseReport report;
+    if (!Comm::verifyPhaseReport(data, len, report)) {
+        logPrintf(LogLevel::LOG_WARN, "COMM: 유효하지 않은 실행 단계 보고 수신. 무시됨.");
+        return;
+    }
+    linkRecordRssi(report.senderId, rssi); // [NEW] 링크 진단
+    RunningDevice* found = findRunningDevice(report.senderId);
+    if (!found || found->txButtonPressSequenceMicros != report.commandId) {
+        logPrintf(LogLevel::LOG_DEBUG, "COMM: ID %d의 이전 시퀀스 단계 보고 (%u). 무시됨.", report.senderId, report.phase);
+        return;
+    }
+    RunningDevice& device = *found;
+    uint8_t slot = (uint8_t)(found - runningDevices);
+
+    int64_t offsetUs = clockSyncOffsetAt(report.senderId, rxTimeUs);
+    bool synced = (offsetUs != Comm::kNoClockOffset);
+    if (report.phase == Comm::PHASE_ARMED) {
+        device.rxCompensationUs = report.compensationUs;
+        device.rxPlayMs = report.playMs;
+        logPrintf(LogLevel::LOG_INFO, "COMM: ID %d 무장 보고. 적용 보정값 %ld us, 플레이 %lu ms.",
+                  report.senderId, (long)report.compensationUs, (unsigned long)report.playMs);
+    }
+    if (report.phase <= device.reportedPhase) return;
+    device.reportedPhase = report.phase;
+    device.rxPlayMs = report.playMs;
+    // 최종 ACK를 아직 못 받은 장치는 통신 엔진이 완료를 판단하므로 로컬 타이머는 건드리지 않음
+    bool timersOwned = (device.commStatus == COMM_ACK_RECEIVED_SUCCESS) && !device.isCompleted;
+
+    switch (report.phase) {
+        case Comm::PHASE_ARMED:
+            if (synced && !device.isDelayCompleted) {
+                int64_t fireTxUs = report.fireTargetLocalUs - offsetUs;
+                device.delayEndTime = (unsigned long)(fireTxUs / 1000); // millis()와 같은 시간축 (esp_timer / 1000)
+                device.playEndTime = device.delayEndTime + report.playMs;
             }
-            return; // 해당 장치에 대한 ACK를 찾았으므로 함수 종료
+            break;
+
+        case Comm::PHASE_PLAY_STARTED: {
+            device.rxFireReported = true;
+            device.rxFireErrorUs = (int32_t)((int64_t)report.eventLocalUs - report.fireTargetLocalUs);
+            int64_t fireTxUs = synced ? (int64_t)report.eventLocalUs - offsetUs : rxTimeUs;
+            if (synced) device.rxFireTxUs = fireTxUs;
+            device.delayEndTime = (unsigned long)(fireTxUs / 1000);
+            device.playEndTime = device.delayEndTime + report.playMs;
+            if (!timersOwned) break;
+            if (schedIsArmed(SCHED_DELAY_END, slot)) schedArm(SCHED_DELAY_END, slot, rxTimeUs);
+            schedArm(SCHED_PLAY_END, slot, fireTxUs + ((int64_t)report.playMs + PHASE_REPORT_GRACE_MS) * 1000);
+            logPrintf(LogLevel::LOG_INFO, "COMM: ID %d 출력 시작 보고. 수신부 실행 오차 %ld us.", report.senderId, (long)device.rxFireErrorUs);
+            break;
+        }
+
+        default: // PHASE_PLAY_ENDED, PHASE_ABORTED
+            device.playEndTime = (unsigned long)(rxTimeUs / 1000);
+            if (!timersOwned) break;
+            schedCancel(SCHED_DELAY_END, slot);
+            device.isDelayCompleted = true;
+            schedArm(SCHED_PLAY_END, slot, rxTimeUs);
+            logPrintf(report.phase == Comm::PHASE_ABORTED ? LogLevel::LOG_WARN : LogLevel::LOG_INFO,
+                      "COMM: ID %d %s 보고.", report.senderId, report.phase == Comm::PHASE_ABORTED ? "실행 중단" : "플레이 종료");
+            break;
+    }
+}
+
+// [NEW] 실행 오차/장치 간 편차 보고. 출력 시작 보고를 받은 장치의 (실제 - 목표) 시각을 비교하며,
+// 시계 오프셋을 아는 장치는 송신부 시각 기준(보정값 오차 포함), 모르는 장치는 수신부 시계 기준 오차만 사용
+void logExecutionSkewReport() {
+    int64_t minErrUs = INT64_MAX, maxErrUs = INT64_MIN;
+    uint8_t measured = 0, localOnly = 0, missing = 0;
+    for (uint8_t k = 0; k < groupDeviceCount; ++k) {
+        const RunningDevice& rd = runningDevices[k];
+        if (rd.commStatus != COMM_ACK_RECEIVED_SUCCESS) continue;
+        if (!rd.rxFireReported) {
+            missing++;
+            continue;
         }
+        int64_t targetTxUs = rd.sequenceStartUs + (int64_t)rd.delayTime * 1000;
+        int64_t errUs = (rd.rxFireTxUs != 0) ? rd.rxFireTxUs - targetTxUs : rd.rxFireErrorUs;
+        if (rd.rxFireTxUs == 0) localOnly++;
+        measured++;
+        minErrUs = std::min(minErrUs, errUs);
+        maxErrUs = std::max(maxErrUs, errUs);
+        logPrintf(LogLevel::LOG_INFO, "SKEW: ID %d 실행 오차 %ld us%s (수신부 기준 %ld us, 적용 보정값 %ld us, 플레이 %lu ms)",
+                  rd.deviceID, (long)errUs, (rd.rxFireTxUs == 0) ? " [시계 오프셋 없음]" : "",
+                  (long)rd.rxFireErrorUs, (long)rd.rxCompensationUs, (unsigned long)rd.rxPlayMs);
+    }
+    if (measured == 0) {
+        logPrintf(LogLevel::LOG_INFO, "SKEW: 출력 시작 보고 없음 (누락 %u대).", missing);
+        return;
+    }
+    logPrintf(LogLevel::LOG_INFO, "SKEW: 장치 간 실행 편차 %ld us (최소 %ld / 최대 %ld us, 측정 %u대, 오프셋 없음 %u대, 보고 누락 %u대)",
+              (long)(maxErrUs - minErrUs), (long)minErrUs, (long)maxErrUs, measured, localOnly, missing);
+}
+
+// [NEW] 콜백이 큐에 넣은 ACK를 모두 처리하고, 콜백에서 센 실패/버림 횟수를 로그로 보고
+// [MODIFIED] 실행 단계 보고도 같은 큐로 들어오므로 패킷 타입으로 나눠 처리
+static void processReceivedAcks() {
+    uint32_t tail = s_rxTail.load(std::memory_order_relaxed);
+    while (tail != s_rxHead.load(std::memory_order_acquire)) {
+        const RxSlot& slot = s_rxSlots[tail % ACK_RX_QUEUE_SLOTS];
+        uint8_t packetType = 0;
+        if (Comm::peekPacketType(slot.data, slot.len, packetType) && packetType == Comm::PHASE_REPORT) {
+            processPhaseReport(slot.data, slot.len, slot.rxTimeUs, slot.rssi);
+        } else {
+            processAck(slot.data, slot.len, slot.rxTimeUs, slot.srcMac, slot.rssi);
+        }
+        s_rxTail.store(++tail, std::memory_order_release);
+    }
+    txqPump(); // [NEW]
+
+    uint32_t dropped = s_rxDropped.load(std::memory_order_relaxed);
+    if (dropped != s_rxDroppedReported) {
+        logPrintf(LogLevel::LOG_WARN, "COMM: 수신 프레임 %lu개 버림 (큐 가득 참 또는 ACK가 아님)", (unsigned long)(dropped - s_rxDroppedReported));
+        s_rxDroppedReported = dropped;
+    }
+    uint32_t txFailed = s_txDoneFailed.load(std::memory_order_relaxed);
+    if (txFailed != s_txDoneFailedReported) {
+        logPrintf(LogLevel::LOG_ERROR, "ESP-NOW: 송신 실패 %lu건", (unsigned long)(txFailed - s_txDoneFailedReported));
+        s_txDoneFailedReported = txFailed;
     }
 }
 
@@ -65,49 +424,85 @@ bool initEspNow() {
     WiFi.mode(WIFI_STA); // Wi-Fi 스테이션 모드 설정
     delay(50); // 잠시 대기
 
-    if (esp_wifi_set_channel(WIFI_CHANNEL, WIFI_SECOND_CHAN_NONE) != ESP_OK) {
-        logPrintf(LogLevel::LOG_ERROR, "ESP-NOW: Wi-Fi 채널 %d 설정 실패", WIFI_CHANNEL);
-        return false;
-    }
+    if (!channelInit()) return false; // [MODIFIED] 마지막으로 옮긴 채널에서 시작
     if (esp_now_init() != ESP_OK) {
         logPrintf(LogLevel::LOG_ERROR, "ESP-NOW: esp_now_init 실패");
         return false;
     }
 
+    schedSetHandler(SCHED_ACK_TIMEOUT, handleAckTimeout); // [NEW]
+    schedSetHandler(SCHED_REDUNDANT_COPY, sendRedundantCopy); // [NEW]
+    schedSetHandler(SCHED_STOP_RETRY, sendStopPacket);        // [NEW]
+    schedSetHandler(SCHED_CHANNEL_HOP, sendChannelHop);       // [NEW]
+    schedSetHandler(SCHED_GO_RETRY, sendGoPacket);            // [NEW]
+    clockSyncInit(); // [NEW] 장치별 시계 동기화 상태 초기화
+    linkInit();      // [NEW] 장치별 프로토콜 버전/기능 초기화
+    peerInit();      // [NEW] 저장된 수신기 MAC 로드
+
     esp_now_register_send_cb(espNowSendCb);
     esp_now_register_recv_cb(OnDataRecv);
 
     esp_now_peer_info_t peerInfo = {};
     memcpy(peerInfo.peer_addr, broadcastAddress, 6);
-    peerInfo.channel = WIFI_CHANNEL;
+    peerInfo.channel = 0; // [MODIFIED] 0 = 현재 채널 (채널을 옮겨도 피어를 다시 등록하지 않음)
     peerInfo.encrypt = false;
     if (esp_now_add_peer(&peerInfo) != ESP_OK) {
         logPrintf(LogLevel::LOG_ERROR, "ESP-NOW: 브로드캐스트 피어 추가 실패.");
         return false;
     }
+    rateInit();      // [NEW] 기본 속도
+    txqInit();       // [NEW] 송신 큐 (브로드캐스트 피어 등록 후)
 
-    logPrintf(LogLevel::LOG_INFO, "ESP-NOW: 초기화 완료 (채널=%d)", WIFI_CHANNEL);
+    logPrintf(LogLevel::LOG_INFO, "ESP-NOW: 초기화 완료 (채널=%d)", channelCurrent());
     espNowInitialized = true;
     return true;
 }
 
+// [NEW] 마지막으로 전송한 프레임 (중복 사본 예약 시 그대로 다시 보내기 위해 보관)
+static uint8_t s_lastFrame[Comm::kMaxFrameSize];
+static uint8_t s_lastFrameLen = 0;
+
+static void rememberFrame(const uint8_t* data, size_t len) {
+    s_lastFrameLen = (uint8_t)std::min(len, sizeof(s_lastFrame));
+    memcpy(s_lastFrame, data, s_lastFrameLen);
+}
+
+// [NEW] 장치 하나에게 보내는 프레임 전송. MAC을 알면 유니캐스트 (거부되면 송신 큐가 브로드캐스트로 한 번 더)
+// [MODIFIED] 송신 큐를 거쳐 전송. txMicros는 프레임에 넣은 송신 시각
+static esp_err_t sendToDevice(uint8_t targetId, const uint8_t* data, size_t len, uint32_t txMicros) {
+    const uint8_t* dest = peerDestination(targetId);
+    TxRate rate = (dest != broadcastAddress) ? rateForUnicast(targetId) : rateForBroadcast(1UL << (targetId - 1)); // [NEW] 링크별 속도와 송신 세기
+    esp_err_t result = txqSubmit(dest, data, len, rate, txMicros);
+    if (result == ESP_OK) {
+        rememberFrame(data, len);
+        linkRecordFrameSent(targetId); // [NEW] 손실률 측정
+    }
+    return result;
+}
+
 // [MODIFIED] 실행 명령 전송 함수에 packetType 파라미터 추가
-bool sendExecutionCommand(Comm::PacketType type, uint8_t targetId, uint32_t txButtonPressSequenceMicros_arg, uint32_t original_delay_ms, uint32_t play_ms, uint32_t rttUs, uint32_t rxProcessingTimeUs, uint32_t& out_tx_timestamp) {
+bool sendExecutionCommand(Comm::PacketType type, uint8_t targetId, uint32_t seq, uint32_t txButtonPressSequenceMicros_arg, uint32_t original_delay_ms, uint32_t play_ms, uint32_t rttUs, uint32_t rxProcessingTimeUs,
+                          uint64_t fireAtTxUs, int64_t clockOffsetUs, uint32_t& out_tx_timestamp) {
     Comm::CommPacket packet;
     
-    // [MODIFIED] Comm::fillPacket 함수에 packetType 추가
-    Comm::fillPacket(packet, type, targetId, txButtonPressSequenceMicros_arg, original_delay_ms, play_ms, rttUs, rxProcessingTimeUs);
+    // [MODIFIED] Comm::fillPacket 함수에 packetType, 절대 실행 시각 추가
+    Comm::fillPacket(packet, type, targetId, seq, txButtonPressSequenceMicros_arg, original_delay_ms, play_ms, rttUs, rxProcessingTimeUs,
+                     fireAtTxUs, clockOffsetUs);
     
     out_tx_timestamp = packet.txMicros; // 실제 패킷이 전송된 시각 기록
 
+    Comm::Frame frame;
+    Comm::encodeFrame<Comm::CommPacketSchema>(frame, packet);
+    size_t frameLen = Comm::sealFrame(frame);
+
     const char* packetTypeStr = (type == Comm::RTT_REQUEST) ? "RTT_REQUEST" : "FINAL_COMMAND";
 
-    logPrintf(LogLevel::LOG_DEBUG, "COMM: ID %d - %s 전송 시도 (버튼: %u us, 패킷: %u us, 지연: %u ms, 플레이: %u ms)", 
-                        targetId, packetTypeStr, txButtonPressSequenceMicros_arg, out_tx_timestamp, original_delay_ms, play_ms);
+    logPrintf(LogLevel::LOG_DEBUG, "COMM: ID %d - %s 전송 시도 (seq: %u, 버튼: %u us, 패킷: %u us, 경과: %u us, 지연: %u ms, 플레이: %u ms)", 
+                        targetId, packetTypeStr, seq, txButtonPressSequenceMicros_arg, out_tx_timestamp, packet.elapsedSincePressUs, original_delay_ms, play_ms);
     logPrintf(LogLevel::LOG_DEBUG, "COMM: ID %d - 포함된 RTT: %u us, 포함된 Rx 처리: %u us", 
                         targetId, rttUs, rxProcessingTimeUs);
 
-    esp_err_t result = esp_now_send(broadcastAddress, (uint8_t*)&packet, sizeof(packet));
+    esp_err_t result = sendToDevice(targetId, frame.data, frameLen, packet.txMicros); // [MODIFIED] 유니캐스트 우선
 
     if (result == ESP_OK) {
         return true;
@@ -117,99 +512,1209 @@ bool sendExecutionCommand(Comm::PacketType type, uint8_t targetId, uint32_t txBu
     }
 }
 
-// [MODIFIED] 그룹 통신 안정성을 위해 한 번의 호출에 하나의 패킷만 전송하도록 수정
-// 이 함수는 loop()에서 반복적으로 호출되어야 합니다.
-bool manageCommunication() {
-    unsigned long currentTime = millis();
-    bool all_comm_done = true; // 모든 장치 통신이 완료되었는지 여부
+// [NEW] 구 펌웨어(v3) 수신기용 실행 명령 전송 (고정 32바이트 형식)
+bool sendLegacyExecutionCommand(Comm::PacketType type, uint8_t targetId, uint32_t txButtonPressSequenceMicros_arg, uint32_t original_delay_ms, uint32_t play_ms, uint32_t rttUs, uint32_t rxProcessingTimeUs, uint32_t& out_tx_timestamp) {
+    Comm::LegacyCommPacketV3 packet;
+    Comm::fillLegacyPacketV3(packet, type, targetId, txButtonPressSequenceMicros_arg, original_delay_ms, play_ms, rttUs, rxProcessingTimeUs);
+    out_tx_timestamp = packet.txMicros;
+
+    Comm::Frame frame;
+    Comm::encodeFrame<Comm::LegacyCommPacketSchemaV3>(frame, packet);
+    size_t frameLen = Comm::sealFrame(frame);
 
-    // [NEW] 한 번의 manageCommunication 호출에서는 하나의 장치에 대해서만 통신 시도를 합니다.
-    // 이렇게 해야 여러 장치에 대한 브로드캐스트 전송이 한 번에 몰리지 않고 분산되어 안정성이 높아집니다.
-    RunningDevice* currentDeviceToProcess = nullptr;
+    const char* packetTypeStr = (type == Comm::RTT_REQUEST) ? "RTT_REQUEST" : "FINAL_COMMAND";
+    logPrintf(LogLevel::LOG_DEBUG, "COMM: ID %d - v3 %s 전송 시도 (패킷: %u us, 지연: %u ms, 플레이: %u ms)",
+              targetId, packetTypeStr, out_tx_timestamp, original_delay_ms, play_ms);
+
+    esp_err_t result = sendToDevice(targetId, frame.data, frameLen, packet.txMicros); // [MODIFIED] 유니캐스트 우선
+    if (result != ESP_OK) {
+        logPrintf(LogLevel::LOG_ERROR, "ESP-NOW: ID %d로 v3 %s 전송 실패 (에러=%d)", targetId, packetTypeStr, result);
+        return false;
+    }
+    return true;
+}
+
+// [NEW] 최종 명령 대기 중인 여러 장치를 하나의 BATCH_COMMAND 패킷으로 전송
+// 각 항목에는 장치별 지연/플레이 시간과 송신부에서 미리 계산한 보정값(RTT/2 + Rx 처리 시간)이 들어갑니다.
+bool sendBatchCommand(RunningDevice* const devices[], uint8_t count, uint32_t& out_tx_timestamp) {
+    if (count == 0) return false;
+
+    Comm::BatchCommandPacket packet;
+    uint16_t ackSlotUs = currentAckSlotUs();
+    int64_t pressAtTxUs = devices[0]->sequenceStartUs;
+    Comm::beginBatchPacket(packet, nextMessageSeq(), devices[0]->txButtonPressSequenceMicros, (uint64_t)pressAtTxUs, ackSlotUs);
+    for (uint8_t i = 0; i < count; ++i) {
+        const RunningDevice& device = *devices[i];
+        uint32_t compensationUs = device.currentSequenceRttUs / 2 + device.currentSequenceRxProcessingTimeUs;
+        // [NEW] 이 장치의 실행 시각(pressAtTxUs + 지연)에서 예측한 시계 오프셋 (절대 시각 실행을 지원하는 수신기만)
+        int64_t clockOffsetUs = linkSupports(device.deviceID, Comm::CAP_ABSOLUTE_TIME)
+                                    ? clockSyncOffsetAt(device.deviceID, pressAtTxUs + (int64_t)device.delayTime * 1000)
+                                    : Comm::kNoClockOffset;
+        if (!Comm::addBatchEntry(packet, device.deviceID, device.delayTime, device.playTime, compensationUs, clockOffsetUs)) {
+            logPrintf(LogLevel::LOG_ERROR, "COMM: ID %d를 BATCH_COMMAND에 추가할 수 없음.", device.deviceID);
+            return false;
+        }
+    }
+    // [NEW] 패킷 타입별 검사값(CRC-16)을 모르는 수신기가 하나라도 있으면 crc8 형식(v7)으로 전송
+    uint8_t frameVersion = Comm::kVersion;
+    for (uint8_t i = 0; i < count; ++i) {
+        const LinkState* link = linkState(devices[i]->deviceID);
+        if (!link || link->protocolVersion < Comm::kTypedIntegrityVersion) frameVersion = Comm::kMinCompatibleVersion;
+    }
+    Comm::Frame frame;
+    size_t size = Comm::finalizeBatchPacket(packet, frame, frameVersion);
+    if (size == 0) return false;
+    out_tx_timestamp = packet.txMicros;
+
+    // [NEW] 수신기는 비트맵 순서대로 슬롯을 나눠 ACK하므로, 장치별 슬롯 대기 시간을 기록해 RTT에서 제외
+    for (uint8_t i = 0; i < count; ++i) {
+        devices[i]->ackSlotWaitUs = (uint32_t)Comm::ackSlotIndex(packet.targetBitmap, devices[i]->deviceID) * ackSlotUs;
+    }
+
+    logPrintf(LogLevel::LOG_DEBUG, "COMM: BATCH_COMMAND 전송 시도 (장치 %d개, 비트맵: 0x%08X, %u 바이트, 슬롯: %u us, 패킷: %u us, 경과: %u us)",
+              count, packet.targetBitmap, (unsigned)size, ackSlotUs, out_tx_timestamp, packet.elapsedSincePressUs);
+
+    // [NEW] 묶인 장치 중 가장 느린 링크의 속도로
+    esp_err_t result = txqSubmit(broadcastAddress, frame.data, size, rateForBroadcast(packet.targetBitmap), packet.txMicros);
+    if (result != ESP_OK) {
+        logPrintf(LogLevel::LOG_ERROR, "ESP-NOW: BATCH_COMMAND 전송 실패 (에러=%d)", result);
+        return false;
+    }
+    rememberFrame(frame.data, size);
+    for (uint8_t i = 0; i < count; ++i) linkRecordFrameSent(devices[i]->deviceID); // [NEW] 손실률 측정
+    return true;
+}
+
+//────────────────────────────────────────────────────────────────────────────
+// 파이프라인 통신 엔진
+//  - 모든 장치의 핸드셰이크(RTT_REQUEST → ACK → FINAL_COMMAND → ACK)를 동시에 진행합니다.
+//  - ACK 대기 중인 패킷 수는 MAX_PACKETS_IN_FLIGHT로, 연속 전송 간격은 SEND_PACING_MS로 제한합니다.
+//  - 따라서 전체 그룹 무장 시간은 각 장치 시간의 합이 아니라 가장 느린 링크를 따라갑니다.
+//  - [MODIFIED] 매 호출마다 모든 장치를 훑지 않음. ACK 타임아웃과 전송 간격은 스케줄러 이벤트로,
+//    전송할 장치는 대기열로, 진행 상황은 카운터로 관리하므로 장치 수가 늘어도 호출당 비용이 거의 일정합니다.
+//  - [NEW] 대기열은 장치별 실행 시각에서 계산한 전송 기한 순(EDF)이므로 장치 배열 순서와 무관합니다.
+//────────────────────────────────────────────────────────────────────────────
+struct InFlightPacket {
+    uint32_t txTimestamp; // 패킷 txMicros (장치의 lastTxTimestamp와 같음)
+    uint8_t  refs;        // 아직 ACK나 타임아웃으로 정리되지 않은 대상 장치 수 (일괄 패킷은 여럿)
+};
+
+static bool           s_armReportLogged = false;
+static bool           s_sequenceReady = false;                // [NEW] 대기열과 카운터를 만들었는지 (장치 배치가 끝난 뒤 첫 호출 때 만듦)
+static uint8_t        s_pendingQueue[MAX_GROUP_DEVICES];      // [NEW] 전송 대기 장치 위치 ([MODIFIED] 전송 기한이 빠른 순서)
+static int64_t        s_pendingDeadlineUs[MAX_GROUP_DEVICES]; // [NEW] 대기열 항목별 전송 기한 (latestSafeSendUs)
+static uint8_t        s_pendingCount = 0;
+static InFlightPacket s_inFlight[MAX_PACKETS_IN_FLIGHT];      // [NEW] ACK를 기다리는 패킷
+static uint8_t        s_inFlightCount = 0;
+static uint8_t        s_finishedCount = 0;                    // [NEW] 통신이 끝난 장치 수 (성공 + 실패)
+static uint8_t        s_failedCount = 0;
+static uint16_t       s_redundantCopiesSent = 0;              // [NEW] 이번 시퀀스에서 보낸 중복 사본 수
+
+void beginCommSequence() {
+    s_armReportLogged = false;
+    s_sequenceReady = false;
+    s_slotIndexValid = false; // [NEW] 장치 배치가 바뀌므로 ID → 위치 색인을 다시 만듦
+    schedReset();             // [NEW] 이전 시퀀스의 이벤트와 통계 정리
+}
+
+void abortCommSequence() {
+    schedLogStats();
+    schedClear();
+    s_sequenceReady = false;
+    s_pendingCount = 0;
+    s_inFlightCount = 0;
+    s_slotIndexValid = false; // 늦게 도착한 ACK가 버려진 장치 상태를 바꾸지 않도록
+    cancelGoTrigger();        // [NEW]
+}
+
+uint8_t commFailedDeviceCount() {
+    return s_failedCount;
+}
+
+static bool isAwaitingAck(const RunningDevice& device) {
+    return device.commStatus == COMM_AWAITING_RTT_ACK || device.commStatus == COMM_AWAITING_FINAL_ACK;
+}
+
+// [NEW] 실행 시각에 맞추려면 늦어도 이때 전송해야 하는 시각 (esp_timer)
+// 실행 시각에서 남은 핸드셰이크 단계 수 x 현재 ACK 타임아웃을 뺌 (재전송 한 번의 여유를 두는 보수적 추정)
+static int64_t latestSafeSendUs(const RunningDevice& device) {
+    int64_t fireAtUs = device.sequenceStartUs + (int64_t)device.delayTime * 1000;
+    uint8_t phases = (device.commStatus == COMM_PENDING_RTT_REQUEST) ? 2 : 1;
+    return fireAtUs - (int64_t)phases * linkAckTimeoutUs(device.deviceID);
+}
+
+// [MODIFIED] 배열 순서가 아니라 전송 기한 순(EDF)으로 삽입. 딜레이가 짧은 장치가 먼저 무선 시간을 얻고,
+// 딜레이가 긴 장치는 남는 시간에 무장됨. 기한이 같으면 먼저 들어온 장치가 앞
+static void enqueuePending(uint8_t slot) {
+    if (s_pendingCount >= MAX_GROUP_DEVICES) return;
+    int64_t deadlineUs = latestSafeSendUs(runningDevices[slot]);
+    uint8_t index = s_pendingCount;
+    while (index > 0 && s_pendingDeadlineUs[index - 1] > deadlineUs) {
+        s_pendingQueue[index] = s_pendingQueue[index - 1];
+        s_pendingDeadlineUs[index] = s_pendingDeadlineUs[index - 1];
+        index--;
+    }
+    s_pendingQueue[index] = slot;
+    s_pendingDeadlineUs[index] = deadlineUs;
+    s_pendingCount++;
+}
+
+static void removePendingAt(uint8_t index) {
+    uint8_t tail = s_pendingCount - index - 1;
+    memmove(&s_pendingQueue[index], &s_pendingQueue[index + 1], tail);
+    memmove(&s_pendingDeadlineUs[index], &s_pendingDeadlineUs[index + 1], tail * sizeof(int64_t));
+    s_pendingCount--;
+}
+
+static void acquireInFlight(uint32_t txTimestamp, uint8_t refs) {
+    if (s_inFlightCount < MAX_PACKETS_IN_FLIGHT) s_inFlight[s_inFlightCount++] = { txTimestamp, refs };
+}
+
+static void releaseInFlight(uint32_t txTimestamp) {
+    for (uint8_t k = 0; k < s_inFlightCount; ++k) {
+        if (s_inFlight[k].txTimestamp != txTimestamp) continue;
+        if (--s_inFlight[k].refs == 0) s_inFlight[k] = s_inFlight[--s_inFlightCount];
+        return;
+    }
+}
+
+// 장치가 기다리던 ACK를 받았거나 타임아웃됨: 타임아웃 이벤트 취소, 전송 중 패킷 정리
+static void settleAck(uint8_t slot, uint32_t txTimestamp) {
+    schedCancel(SCHED_ACK_TIMEOUT, slot);
+    releaseInFlight(txTimestamp);
+}
+
+// [NEW] 통신이 끝난 장치 처리. 성공하면 송신부 로컬 타이머를 버튼 누름 시점 기준으로 예약 (수신부와 같은 기준)
+static void markFinished(RunningDevice& device, uint8_t slot, bool success) {
+    s_finishedCount++;
+    linkRecordSequenceEnd(device.deviceID); // [NEW] 시퀀스별 재전송 수 마감
+    if (!success) {
+        s_failedCount++;
+        device.isCompleted = true; // 로컬 타이머가 시작되지 않으므로 완료로 표시 (화면은 실패 상태를 먼저 확인)
+        return;
+    }
+    unsigned long elapsedMs = (micros() - device.txButtonPressSequenceMicros) / 1000UL;
+    if (device.reportedPhase == 0) { // [MODIFIED] ACK보다 먼저 온 수신기 단계 보고가 있으면 그 일정을 유지
+        device.delayEndTime = (millis() - elapsedMs) + device.delayTime; // 화면 표시용 (millis)
+        if (device.delayEndTime == 0) device.delayEndTime = 1; // 0은 타이머 미시작 표시이므로 피함
+        device.playEndTime = device.delayEndTime + device.playTime;
+    }
+    schedArm(SCHED_DELAY_END, slot, device.sequenceStartUs + (int64_t)device.delayTime * 1000); // 이미 지났으면 바로 처리됨
+    logPrintf(LogLevel::LOG_INFO, "ID %d: 송신부 로컬 타이머 시작. (설정된 지연: %lu ms, 버튼 후 경과: %lu ms)", device.deviceID, device.delayTime, elapsedMs);
+}
+
+// [NEW] 시퀀스 첫 호출: 시작 준비가 끝난 장치를 전송 기한 순으로 대기열에 넣음
+// [MODIFIED] 무장된 장치는 대기열 대신 GO_COMMAND 하나로 한꺼번에 실행
+static void startSequenceQueue() {
+    s_pendingCount = 0;
+    s_inFlightCount = 0;
+    s_finishedCount = 0;
+    s_failedCount = 0;
+    s_redundantCopiesSent = 0;
+    uint32_t goBitmap = 0;
+    for (uint8_t i = 0; i < groupDeviceCount; ++i) {
+        const RunningDevice& device = runningDevices[i];
+        if (device.commStatus == COMM_AWAITING_GO_ACK && device.deviceID >= 1 && device.deviceID <= 32) {
+            goBitmap |= 1UL << (device.deviceID - 1);
+        } else {
+            enqueuePending(i);
+        }
+    }
+    s_sequenceReady = true;
+    if (goBitmap != 0) startGoTrigger(goBitmap);
+}
+
+// 장치별 및 전체 무장 시간 보고 (순차 방식과 비교하기 위한 로그)
+static void logArmTimeReport() {
+    uint32_t slowestArmUs = 0;
+    uint8_t  successCount = 0;
     for (int i = 0; i < groupDeviceCount; ++i) {
-        if (runningDevices[i].commStatus != COMM_ACK_RECEIVED_SUCCESS &&
-            runningDevices[i].commStatus != COMM_FAILED_NO_ACK) {
-            currentDeviceToProcess = &runningDevices[i];
-            all_comm_done = false; // 아직 통신이 완료되지 않은 장치가 있음
-            break; 
-        }
-    }
-
-    if (!currentDeviceToProcess) {
-        return all_comm_done; // 모든 장치 통신이 완료됨
-    }
-
-    RunningDevice& device = *currentDeviceToProcess;
-
-    switch (device.commStatus) {
-        case COMM_PENDING_RTT_REQUEST:
-        case COMM_AWAITING_RTT_ACK: { // [FIXED] Typo 'COMM_AWAITing_RTT_ACK' corrected to 'COMM_AWAITING_RTT_ACK'
-            if (device.commStatus == COMM_PENDING_RTT_REQUEST || currentTime - device.lastPacketSendTime >= RETRY_INTERVAL_MS) {
-                // RTT 요청 패킷 전송 (이전 RTT, RxProc는 0으로 보냄)
-                logPrintf(LogLevel::LOG_INFO, "COMM: 장치 %d로 RTT_REQUEST 전송 시도 #%d", 
-                            device.deviceID, device.sendAttempts + 1);
-                
-                uint32_t tx_time;
-                if (sendExecutionCommand(Comm::RTT_REQUEST, device.deviceID, device.txButtonPressSequenceMicros, 
-                                        device.delayTime, device.playTime, 0, 0, tx_time)) { // RTT/RxProc는 0으로 초기 전송
-                    device.sendAttempts++;
-                    device.lastPacketSendTime = currentTime;
-                    device.ackTimeoutDeadline = currentTime + ACK_TIMEOUT_MS;
-                    device.lastTxTimestamp = tx_time;
-                    device.commStatus = COMM_AWAITING_RTT_ACK;
-                } else {
-                    logPrintf(LogLevel::LOG_ERROR, "COMM: 장치 %d RTT_REQUEST 전송 실패. 재시도 필요.", device.deviceID);
-                }
-            } else if (currentTime > device.ackTimeoutDeadline) {
-                // RTT 요청 ACK 타임아웃
-                logPrintf(LogLevel::LOG_WARN, "COMM: 장치 %d에 대한 RTT_ACK 타임아웃 (시도 #%d)", device.deviceID, device.sendAttempts);
-                if (device.sendAttempts >= MAX_SEND_ATTEMPTS) {
-                    device.commStatus = COMM_FAILED_NO_ACK;
-                    logPrintf(LogLevel::LOG_ERROR, "COMM: 장치 %d에 대한 RTT_ACK 모든 시도 실패. 실패로 표시.", device.deviceID);
-                } else {
-                    // 재시도를 위해 상태 유지 (manageCommunication이 다시 호출될 때 재시도 로직으로 들어감)
-                    device.commStatus = COMM_PENDING_RTT_REQUEST; // 다시 전송 대기 상태로
-                }
-            }
-            return false; // 하나의 장치에 대해서만 처리 후 즉시 반환
-        }
-
-        case COMM_PENDING_FINAL_COMMAND:
-        case COMM_AWAITING_FINAL_ACK: { // 최종 명령 패킷 전송 및 ACK 대기
-            if (device.commStatus == COMM_PENDING_FINAL_COMMAND || currentTime - device.lastPacketSendTime >= RETRY_INTERVAL_MS) {
-                // 최종 명령 패킷 전송 (RTT 및 RxProc 값 포함)
-                logPrintf(LogLevel::LOG_INFO, "COMM: 장치 %d로 FINAL_COMMAND 전송 시도 #%d (포함 RTT: %u us, RxProc: %u us)", 
-                            device.deviceID, device.sendAttempts + 1, device.currentSequenceRttUs, device.currentSequenceRxProcessingTimeUs);
-                
-                uint32_t tx_time;
-                if (sendExecutionCommand(Comm::FINAL_COMMAND, device.deviceID, device.txButtonPressSequenceMicros, 
-                                        device.delayTime, device.playTime, 
-                                        device.currentSequenceRttUs, device.currentSequenceRxProcessingTimeUs, tx_time)) {
-                    device.sendAttempts++; // sendAttempts는 전체 시퀀스에 대해 누적
-                    device.lastPacketSendTime = currentTime;
-                    device.ackTimeoutDeadline = currentTime + ACK_TIMEOUT_MS;
-                    device.lastTxTimestamp = tx_time;
-                    device.commStatus = COMM_AWAITING_FINAL_ACK;
-                } else {
-                    logPrintf(LogLevel::LOG_ERROR, "COMM: 장치 %d FINAL_COMMAND 전송 실패. 재시도 필요.", device.deviceID);
-                }
-            } else if (currentTime > device.ackTimeoutDeadline) {
-                // 최종 명령 ACK 타임아웃
-                logPrintf(LogLevel::LOG_WARN, "COMM: 장치 %d에 대한 FINAL_ACK 타임아웃 (시도 #%d)", device.deviceID, device.sendAttempts);
-                if (device.sendAttempts >= MAX_SEND_ATTEMPTS) {
-                    device.commStatus = COMM_FAILED_NO_ACK;
-                    logPrintf(LogLevel::LOG_ERROR, "COMM: 장치 %d에 대한 FINAL_ACK 모든 시도 실패. 실패로 표시.", device.deviceID);
-                } else {
-                    // 재시도를 위해 상태 유지 (manageCommunication이 다시 호출될 때 재시도 로직으로 들어감)
-                    device.commStatus = COMM_PENDING_FINAL_COMMAND; // 다시 전송 대기 상태로
-                }
+        const RunningDevice& device = runningDevices[i];
+        if (device.commStatus == COMM_ACK_RECEIVED_SUCCESS) {
+            successCount++;
+            slowestArmUs = std::max(slowestArmUs, device.armTimeUs);
+            logPrintf(LogLevel::LOG_INFO, "ARM: ID %d 무장 완료 %lu us (전송 %d회)",
+                      device.deviceID, device.armTimeUs, device.sendAttempts);
+        } else {
+            logPrintf(LogLevel::LOG_WARN, "ARM: ID %d 무장 실패 (전송 %d회)", device.deviceID, device.sendAttempts);
+        }
+    }
+    logPrintf(LogLevel::LOG_INFO, "ARM: 전체 무장 시간 %lu us (%d/%d 성공, 동시 전송 한도 %d, 중복 사본 %u개)",
+              slowestArmUs, successCount, groupDeviceCount, MAX_PACKETS_IN_FLIGHT, s_redundantCopiesSent);
+}
+
+// [NEW] BATCH_COMMAND로 묶을 수 있는 최종 명령 대기 장치인지
+static bool isBatchablePendingFinal(const RunningDevice& device) {
+    return device.commStatus == COMM_PENDING_FINAL_COMMAND && linkSupports(device.deviceID, Comm::CAP_BATCH_COMMAND);
+}
+
+// ACK 타임아웃 처리 (스케줄러 이벤트). 재시도 가능하면 전송 대기열로 되돌립니다.
+static void handleAckTimeout(uint8_t slot, int64_t dueUs) {
+    RunningDevice& device = runningDevices[slot];
+    if (!isAwaitingAck(device)) return;
+    bool isRttPhase = (device.commStatus == COMM_AWAITING_RTT_ACK);
+    const char* phaseStr = isRttPhase ? "RTT_ACK" : "FINAL_ACK";
+
+    logPrintf(LogLevel::LOG_WARN, "COMM: 장치 %d에 대한 %s 타임아웃 (시도 #%d)", device.deviceID, phaseStr, device.sendAttempts);
+    releaseInFlight(device.lastTxTimestamp);
+    linkRecordAckTimeout(device.deviceID); // [NEW] 다음 재전송의 타임아웃을 늘림
+    peerRecordMiss(device.deviceID);       // [NEW] 유니캐스트가 계속 실패하면 브로드캐스트로 대체
+    rateRecordTimeout(device.deviceID);    // [NEW] 연속 실패 시 느리고 견고한 속도로
+    if (device.sendAttempts >= MAX_SEND_ATTEMPTS) {
+        device.commStatus = COMM_FAILED_NO_ACK;
+        markFinished(device, slot, false);
+        logPrintf(LogLevel::LOG_ERROR, "COMM: 장치 %d에 대한 %s 모든 시도 실패. 실패로 표시.", device.deviceID, phaseStr);
+    } else {
+        device.commStatus = isRttPhase ? COMM_PENDING_RTT_REQUEST : COMM_PENDING_FINAL_COMMAND; // 다시 전송 대기 상태로
+        linkRecordRetry(device.deviceID); // [NEW] 링크 진단
+        enqueuePending(slot);
+    }
+}
+
+//────────────────────────────────────────────────────────────────────────────
+// [NEW] 시간이 촉박한 명령의 선제적 중복 전송
+//  - 실행 시각까지 ACK 타임아웃 후 재전송할 여유가 없는 장치의 FINAL_COMMAND(또는 일괄 명령)는
+//    ACK를 기다리지 않고 같은 프레임을 REDUNDANT_COPY_SPACING_US 간격으로 k번 더 보냄 (같은 seq이므로 수신기가 중복 제거)
+//  - k는 링크별 측정 손실률로 정함 (깨끗한 링크는 0이므로 추가 전송 없음)
+//  - 원본 패킷의 ACK를 모두 받았거나 타임아웃되면 남은 사본은 보내지 않음
+//────────────────────────────────────────────────────────────────────────────
+static_assert(MAX_DEVICES <= 32, "RedundantCopy::targetBitmap holds one bit per device ID");
+
+struct RedundantCopy {
+    uint8_t  remaining;      // 아직 보내지 않은 사본 수
+    uint8_t  sent;           // 실제로 보낸 사본 수 (0이 아니면 ACK로 RTT를 측정하지 않음)
+    uint8_t  targetId;       // 0이면 일괄 패킷 (브로드캐스트)
+    uint32_t targetBitmap;   // 손실률 집계 대상 (bit ID-1)
+    uint32_t txTimestamp;    // 원본 패킷 txMicros
+    uint8_t  len;
+    uint8_t  data[Comm::kMaxFrameSize];
+};
+static RedundantCopy s_copies[MAX_GROUP_DEVICES]; // 원본을 보낸 장치 위치별 (일괄 패킷은 첫 항목의 위치)
+
+static bool isInFlight(uint32_t txTimestamp) {
+    for (uint8_t k = 0; k < s_inFlightCount; ++k) {
+        if (s_inFlight[k].txTimestamp == txTimestamp) return true;
+    }
+    return false;
+}
+
+static bool sentRedundantCopies(uint32_t txTimestamp) {
+    for (const RedundantCopy& copy : s_copies) {
+        if (copy.sent > 0 && copy.txTimestamp == txTimestamp) return true;
+    }
+    return false;
+}
+
+// 실행 시각까지 ACK 타임아웃을 기다렸다가 다시 보낼 여유가 없으면 중복 사본 수, 아니면 0
+// 시퀀스 번호 중복 제거를 지원하는 수신기만 (구 펌웨어는 사본마다 다시 실행하므로 제외)
+static uint8_t redundantCopiesFor(const RunningDevice& device) {
+    if (!linkSupports(device.deviceID, Comm::CAP_SEQ_DEDUP)) return 0;
+    int64_t fireAtUs = device.sequenceStartUs + (int64_t)device.delayTime * 1000;
+    if (fireAtUs - esp_timer_get_time() >= (int64_t)linkAckTimeoutUs(device.deviceID)) return 0;
+    return linkRedundantCopies(device.deviceID);
+}
+
+// 방금 보낸 프레임(s_lastFrame)의 사본 예약
+static void planRedundantCopies(uint8_t slot, uint8_t copies, uint8_t targetId, uint32_t targetBitmap, uint32_t txTimestamp) {
+    RedundantCopy& copy = s_copies[slot];
+    copy.remaining = copies;
+    copy.sent = 0;
+    copy.txTimestamp = txTimestamp;
+    if (copies == 0) {
+        schedCancel(SCHED_REDUNDANT_COPY, slot);
+        return;
+    }
+    copy.targetId = targetId;
+    copy.targetBitmap = targetBitmap;
+    copy.len = s_lastFrameLen;
+    memcpy(copy.data, s_lastFrame, s_lastFrameLen);
+    schedArm(SCHED_REDUNDANT_COPY, slot, esp_timer_get_time() + REDUNDANT_COPY_SPACING_US);
+}
+
+// 중복 사본 전송 (스케줄러 이벤트). 전송 한도와 간격 제한은 적용하지 않음 (사본 사이 간격으로 제한됨)
+static void sendRedundantCopy(uint8_t slot, int64_t dueUs) {
+    RedundantCopy& copy = s_copies[slot];
+    if (copy.remaining == 0) return;
+    if (!isInFlight(copy.txTimestamp)) { // 모두 ACK했거나 타임아웃됨
+        copy.remaining = 0;
+        return;
+    }
+
+    esp_err_t result;
+    if (copy.targetId != 0) {
+        result = sendToDevice(copy.targetId, copy.data, copy.len, copy.txTimestamp);
+    } else {
+        result = txqSubmit(broadcastAddress, copy.data, copy.len, rateForBroadcast(copy.targetBitmap), copy.txTimestamp);
+        if (result == ESP_OK) {
+            for (uint8_t id = 1; id <= MAX_DEVICES; ++id) {
+                if (copy.targetBitmap & (1UL << (id - 1))) linkRecordFrameSent(id);
             }
-            return false; // 하나의 장치에 대해서만 처리 후 즉시 반환
         }
+    }
+    copy.remaining--;
+    if (result == ESP_OK) {
+        copy.sent++;
+        s_redundantCopiesSent++;
+    }
+    logPrintf(LogLevel::LOG_DEBUG, "COMM: 중복 사본 전송 (ID %d, 남은 사본 %d, 결과=%d)", copy.targetId, copy.remaining, result);
+    if (copy.remaining > 0) schedArm(SCHED_REDUNDANT_COPY, slot, dueUs + REDUNDANT_COPY_SPACING_US);
+}
+
+// [NEW] 다음 전송 가능 시각 예약 (간격 제한이 걸려 있는 동안 SCHED_SEND_READY가 예약되어 있음)
+static void holdSending(uint32_t holdUs) {
+    if (holdUs > 0) schedArm(SCHED_SEND_READY, 0, esp_timer_get_time() + holdUs);
+}
+
+// 전송 대기 중인 장치에 현재 단계의 패킷을 전송합니다.
+static bool sendPendingPacket(uint8_t slot, unsigned long currentTime) {
+    RunningDevice& device = runningDevices[slot];
+    bool isRttPhase = (device.commStatus == COMM_PENDING_RTT_REQUEST);
+    uint32_t tx_time;
+    bool sent;
+
+    // 재전송은 같은 시퀀스 번호를 유지하므로 수신기가 중복으로 인식해 즉시 ACK만 보냄
+    if (device.messageSeq == 0) device.messageSeq = nextMessageSeq();
+    uint8_t copies = 0; // [NEW] 최종 명령만 중복 전송 대상
+
+    // [NEW] 구 펌웨어로 확인된 수신기는 v3 형식 사용. 버전을 아직 모르면 RTT_REQUEST 재시도를 두 형식으로 번갈아 보냄
+    bool useLegacy = linkIsLegacy(device.deviceID) ||
+                     (isRttPhase && linkIsUnknown(device.deviceID) && (device.sendAttempts % 2) == 1);
+
+    if (useLegacy) {
+        // 구 수신기는 RTT/2 + 처리 시간만 보정하므로, 버튼 눌림 후 경과 시간은 지연/플레이 시간에서 미리 빼서 보냄
+        uint32_t elapsedMs = (micros() - device.txButtonPressSequenceMicros) / 1000UL;
+        uint32_t delayMs = (device.delayTime > elapsedMs) ? device.delayTime - elapsedMs : 0;
+        uint32_t overrunMs = (elapsedMs > device.delayTime) ? elapsedMs - device.delayTime : 0;
+        uint32_t playMs = (device.playTime > overrunMs) ? device.playTime - overrunMs : 0;
+        logPrintf(LogLevel::LOG_INFO, "COMM: 장치 %d로 v3 %s 전송 시도 #%d", device.deviceID,
+                  isRttPhase ? "RTT_REQUEST" : "FINAL_COMMAND", device.sendAttempts + 1);
+        sent = isRttPhase
+            ? sendLegacyExecutionCommand(Comm::RTT_REQUEST, device.deviceID, device.txButtonPressSequenceMicros,
+                                         device.delayTime, device.playTime, 0, 0, tx_time)
+            : sendLegacyExecutionCommand(Comm::FINAL_COMMAND, device.deviceID, device.txButtonPressSequenceMicros,
+                                         delayMs, playMs, device.currentSequenceRttUs, device.currentSequenceRxProcessingTimeUs, tx_time);
+    } else if (isRttPhase) {
+        // RTT 요청 패킷 전송 (이전 RTT, RxProc는 0으로 보냄)
+        logPrintf(LogLevel::LOG_INFO, "COMM: 장치 %d로 RTT_REQUEST 전송 시도 #%d", device.deviceID, device.sendAttempts + 1);
+        sent = sendExecutionCommand(Comm::RTT_REQUEST, device.deviceID, device.messageSeq, device.txButtonPressSequenceMicros,
+                                    device.delayTime, device.playTime, 0, 0, 0, Comm::kNoClockOffset, tx_time);
+    } else {
+        // 최종 명령 패킷 전송 (RTT 및 RxProc 값, 절대 실행 시각과 그 시점의 시계 오프셋 포함)
+        int64_t fireAtTxUs = device.sequenceStartUs + (int64_t)device.delayTime * 1000;
+        int64_t clockOffsetUs = linkSupports(device.deviceID, Comm::CAP_ABSOLUTE_TIME)
+                                    ? clockSyncOffsetAt(device.deviceID, fireAtTxUs) : Comm::kNoClockOffset;
+        copies = redundantCopiesFor(device);
+        logPrintf(LogLevel::LOG_INFO, "COMM: 장치 %d로 FINAL_COMMAND 전송 시도 #%d (포함 RTT: %u us, RxProc: %u us, 오프셋: %s)",
+                  device.deviceID, device.sendAttempts + 1, device.currentSequenceRttUs, device.currentSequenceRxProcessingTimeUs,
+                  (clockOffsetUs == Comm::kNoClockOffset) ? "없음" : "동기화됨");
+        sent = sendExecutionCommand(Comm::FINAL_COMMAND, device.deviceID, device.messageSeq, device.txButtonPressSequenceMicros,
+                                    device.delayTime, device.playTime,
+                                    device.currentSequenceRttUs, device.currentSequenceRxProcessingTimeUs,
+                                    (uint64_t)fireAtTxUs, clockOffsetUs, tx_time);
+    }
+
+    if (!sent) {
+        logPrintf(LogLevel::LOG_ERROR, "COMM: 장치 %d %s 전송 실패. 재시도 필요.", device.deviceID, isRttPhase ? "RTT_REQUEST" : "FINAL_COMMAND");
+        return false;
+    }
+
+    device.sendAttempts++; // sendAttempts는 전체 시퀀스에 대해 누적
+    device.lastPacketSendTime = currentTime;
+    device.lastTxTimestamp = tx_time;
+    device.ackSlotWaitUs = 0; // 단일 대상 패킷은 즉시 ACK
+    device.commStatus = isRttPhase ? COMM_AWAITING_RTT_ACK : COMM_AWAITING_FINAL_ACK;
+    // [MODIFIED] 링크별 적응형 타임아웃 (중복 사본을 보내는 동안만큼 연장)
+    // [MODIFIED] 송신 큐에 밀린 프레임이 나가는 시간만큼 더 연장
+    uint32_t timeoutUs = linkAckTimeoutUs(device.deviceID) + (uint32_t)copies * REDUNDANT_COPY_SPACING_US + txqBacklogUs();
+    schedArm(SCHED_ACK_TIMEOUT, slot, esp_timer_get_time() + timeoutUs);
+    acquireInFlight(tx_time, 1);
+    planRedundantCopies(slot, copies, device.deviceID, 1UL << (device.deviceID - 1), tx_time); // [NEW]
+    return true;
+}
+
+// [NEW] 대기열에서 BATCH_COMMAND로 묶을 수 있는 장치를 모아 한 패킷으로 전송. 묶을 장치가 2개 미만이면 false
+// [MODIFIED] 기한이 가장 급한 장치가 묶을 수 없는 장치면 그 장치를 먼저 보내도록 false (일괄 전송이 앞지르지 않게)
+static bool trySendBatch(unsigned long currentTime) {
+    if (!isBatchablePendingFinal(runningDevices[s_pendingQueue[0]])) return false;
+    uint8_t batchIndex[MAX_GROUP_DEVICES];
+    RunningDevice* batch[MAX_GROUP_DEVICES];
+    uint8_t batchCount = 0;
+    for (uint8_t q = 0; q < s_pendingCount; ++q) {
+        RunningDevice& device = runningDevices[s_pendingQueue[q]];
+        if (!isBatchablePendingFinal(device)) continue;
+        batchIndex[batchCount] = q;
+        batch[batchCount++] = &device;
+    }
+    if (batchCount < 2) return false;
+    // [NEW] 그룹 구성원 전부이면 그룹 주소 명령 하나로 (항목 수 제한 없음), 아니면 앞에서부터 한 패킷 분량만 묶음
+    uint8_t groupId = groupAddressFor(batch, batchCount);
+    if (groupId == 0 && batchCount > Comm::kMaxBatchEntries) batchCount = Comm::kMaxBatchEntries;
+
+    // [NEW] 묶인 장치 중 시간이 가장 촉박한 장치에 맞춰 중복 사본 수를 정함 (중복 제거를 모르는 수신기가 있으면 0)
+    uint8_t copies = 0;
+    uint32_t targetBitmap = 0;
+    for (uint8_t i = 0; i < batchCount; ++i) {
+        targetBitmap |= 1UL << (batch[i]->deviceID - 1);
+        copies = std::max(copies, redundantCopiesFor(*batch[i]));
+    }
+    for (uint8_t i = 0; i < batchCount; ++i) {
+        if (!linkSupports(batch[i]->deviceID, Comm::CAP_SEQ_DEDUP)) copies = 0;
+    }
+
+    uint32_t tx_time;
+    bool sent = (groupId != 0) ? sendGroupCommand(batch, batchCount, groupId, tx_time) : sendBatchCommand(batch, batchCount, tx_time);
+    if (!sent) {
+        holdSending(SEND_RETRY_BACKOFF_US);
+        return true;
+    }
+    uint8_t firstSlot = s_pendingQueue[batchIndex[0]];
+    int64_t nowUs = esp_timer_get_time();
+    uint32_t backlogUs = txqBacklogUs(); // [NEW]
+    for (uint8_t i = batchCount; i-- > 0;) { // 뒤에서부터 지워야 앞쪽 위치가 바뀌지 않음
+        uint8_t slot = s_pendingQueue[batchIndex[i]];
+        RunningDevice& device = runningDevices[slot];
+        device.sendAttempts++;
+        device.lastPacketSendTime = currentTime;
+        device.lastTxTimestamp = tx_time;
+        device.commStatus = COMM_AWAITING_FINAL_ACK;
+        schedArm(SCHED_ACK_TIMEOUT, slot, nowUs + linkAckTimeoutUs(device.deviceID) + device.ackSlotWaitUs // 슬롯 대기만큼 연장
+                                          + (uint32_t)copies * REDUNDANT_COPY_SPACING_US + backlogUs);
+        removePendingAt(batchIndex[i]);
+    }
+    acquireInFlight(tx_time, batchCount);
+    planRedundantCopies(firstSlot, copies, 0, targetBitmap, tx_time); // [NEW]
+    holdSending((uint32_t)SEND_PACING_MS * 1000);
+    return true;
+}
+
+// [MODIFIED] 한 장치씩 순차 처리하던 방식에서 모든 장치를 동시에 진행하는 파이프라인 방식으로 변경
+// 이 함수는 loop()에서 반복적으로 호출되어야 합니다. 모든 장치의 통신이 끝나면 true를 반환합니다.
+bool manageCommunication() {
+    if (!s_sequenceReady) startSequenceQueue();
+    processReceivedAcks(); // [NEW] 타임아웃 판단 전에 도착한 ACK부터 반영
+    schedRunDue();         // [NEW] 기한이 지난 ACK 타임아웃, 전송 간격, 로컬 타이머 이벤트를 기한 순으로 처리
+
+    if (s_finishedCount >= groupDeviceCount) {
+        if (!s_armReportLogged && groupDeviceCount > 0) {
+            logArmTimeReport();
+            s_armReportLogged = true;
+        }
+        return true;
+    }
+
+    // 전송 한도나 간격 제한에 걸리면 ACK 수신 또는 SCHED_SEND_READY 이벤트가 loop를 깨움
+    if (s_pendingCount == 0 || s_inFlightCount >= MAX_PACKETS_IN_FLIGHT) return false;
+    if (schedIsArmed(SCHED_SEND_READY, 0)) return false;
+    unsigned long currentTime = millis();
+
+    // [NEW] 최종 명령 대기 장치가 여럿이면 아직 ACK하지 않은 장치만 모아 하나의 BATCH_COMMAND로 전송
+    // [MODIFIED] BATCH_COMMAND를 지원한다고 알려온 수신기만 묶고, 나머지는 아래에서 개별 전송
+    if (ENABLE_BATCH_COMMAND && trySendBatch(currentTime)) return false;
+
+    // 동시 전송 한도와 전송 간격 안에서 전송 기한이 가장 빠른 장치부터 전송
+    while (s_pendingCount > 0 && s_inFlightCount < MAX_PACKETS_IN_FLIGHT) {
+        if (!sendPendingPacket(s_pendingQueue[0], currentTime)) {
+            holdSending(SEND_RETRY_BACKOFF_US); // [MODIFIED] 송신 큐가 가득 차면 잠시 뒤 재시도
+            break;
+        }
+        removePendingAt(0);
+        if (SEND_PACING_MS > 0) { // 간격 제한이 있으면 한 번의 호출에 하나만 전송
+            holdSending((uint32_t)SEND_PACING_MS * 1000);
+            break;
+        }
+    }
+    return false;
+}
+
+// [NEW] 유휴 상태(실행 중이 아닐 때) 링크 캐시를 따뜻하게 유지. 오래된 수신기에 하나씩 RTT_REQUEST를 보냄
+void refreshLinkCache() {
+    if (!espNowInitialized) return;
+    processReceivedAcks();
+    if (isProcessing || emergencyStopActive()) {
+        s_probe.active = false; // 실행이 시작되면 진행 중인 갱신은 버림 (늦은 ACK는 무시됨)
+        return;
+    }
+    if (channelSurveyActive() || channelHopActive()) return; // [NEW] 다른 채널을 듣거나 채널을 옮기는 중에는 보내지 않음
+    if (s_cue.active || s_groupCfg.active) return; // [NEW] ARM_CUE/GROUP_CONFIG 응답을 기다리는 중
+
+    if (s_probe.active) {
+        if ((int32_t)(micros() - s_probe.deadlineUs) <= 0) return;
+        s_probe.active = false;
+        if (s_probe.deviceID == s_focusId) {
+            linkRecordAckTimeout(s_probe.deviceID); // [NEW] 진단용 탐색은 응답이 없어도 갱신을 멈추지 않음 (손실률에만 반영)
+        } else {
+            linkRecordRefreshFailure(s_probe.deviceID);
+        }
+        peerRecordMiss(s_probe.deviceID);
+        rateRecordTimeout(s_probe.deviceID); // [NEW]
+    }
+
+    unsigned long nowMs = millis();
+    // [NEW] 진단 화면에서 보고 있는 장치는 오래되지 않았어도 DIAG_PROBE_INTERVAL_MS마다 탐색 (RTT 분포 측정)
+    bool focusDue = (s_focusId != 0) && (s_lastProbeMs == 0 || nowMs - s_lastProbeMs >= DIAG_PROBE_INTERVAL_MS);
+    if (!focusDue && s_lastProbeMs != 0 && nowMs - s_lastProbeMs < LINK_REFRESH_INTERVAL_MS) return;
+
+    for (uint8_t n = 0; n < MAX_DEVICES; ++n) {
+        uint8_t id = focusDue ? s_focusId : (uint8_t)((s_nextProbeId - 1 + n) % MAX_DEVICES + 1);
+        if (!focusDue && !linkNeedsRefresh(id)) continue;
+
+        uint32_t txMicros;
+        s_probe.deviceID = id;
+        s_probe.active = true;
+        bool sent = linkIsLegacy(id)
+            ? sendLegacyExecutionCommand(Comm::RTT_REQUEST, id, micros(), 0, 0, 0, 0, txMicros)
+            : sendExecutionCommand(Comm::RTT_REQUEST, id, nextMessageSeq(), micros(), 0, 0, 0, 0, 0, Comm::kNoClockOffset, txMicros);
+        s_lastProbeMs = nowMs;
+        if (!focusDue) s_nextProbeId = (uint8_t)(id % MAX_DEVICES + 1);
+        if (!sent) {
+            s_probe.active = false;
+            return;
+        }
+        s_probe.txMicros = txMicros;
+        s_probe.deadlineUs = micros() + linkAckTimeoutUs(id);
+        return;
+    }
+}
+
+void setLinkProbeFocus(uint8_t deviceID) {
+    s_focusId = (deviceID <= MAX_DEVICES) ? deviceID : 0;
+}
+
+//────────────────────────────────────────────────────────────────────────────
+// [NEW] ARM/GO 두 단계 실행
+//  - 유휴 중(GENERAL_MODE) 실행 정보를 지원하는 수신기에 ARM_CUE를 하나씩 보내 딜레이/플레이 시간, 보정값
+//    (링크 캐시의 RTT/2 + 처리 시간), 시계 오프셋과 드리프트를 미리 보관시킴. ACK를 받은 장치를 무장된 것으로 봄
+//  - 무장된 장치에는 ARM_REFRESH_MS마다 최신 보정값으로 다시 보냄. 설정이 바뀐 장치는 보내는 순간 무장을 풀고
+//    ACK를 받아야 다시 무장 (ACK를 잃으면 수신기가 어느 값을 보관하는지 알 수 없으므로)
+//  - PLAY 시 무장된 장치는 버튼 눌림 시각만 실린 GO_COMMAND 브로드캐스트 하나로 실행. 모두 ACK하거나
+//    GO_MAX_ATTEMPTS번 보낼 때까지 재전송하고, 끝내 ACK가 없는 장치는 개별 명령 파이프라인으로 대체
+//    (수신기는 같은 버튼 눌림의 명령을 한 번만 실행하므로 GO를 받고 ACK만 잃은 장치도 두 번 실행되지 않음)
+//  - 무장 회차(armId)는 부팅마다 새로 정하므로 이전 부팅에서 보관된 실행 정보로는 실행되지 않음
+//────────────────────────────────────────────────────────────────────────────
+static_assert(!ARM_REQUIRE_ALL || ENABLE_ARM_GO, "ARM_REQUIRE_ALL needs ENABLE_ARM_GO");
+static_assert(MAX_DEVICES <= 32, "GO_COMMAND targetBitmap holds one bit per device ID");
+
+struct ArmSlot {
+    bool          armed;        // 이 회차의 실행 정보에 대한 ACK를 받음
+    uint32_t      delayMs;      // 수신기가 보관한 값
+    uint32_t      playMs;
+    unsigned long armedAtMs;    // 마지막 ACK 시각
+    unsigned long lastCueMs;    // 마지막 전송 시각
+    uint8_t       failures;     // 연속으로 응답이 없던 수
+};
+static ArmSlot s_armSlots[MAX_DEVICES + 1];
+static uint32_t s_armId = 0;
+static unsigned long s_lastCueMs = 0;
+
+struct GoTrigger {
+    bool     active;
+    uint32_t targetBitmap;                // GO로 실행하는 장치 (bit ID-1)
+    uint32_t ackedBitmap;
+    uint32_t txMicros[GO_MAX_ATTEMPTS];   // 전송별 txMicros (같은 시각에 개별 명령도 오가므로 범위가 아니라 값으로 확인)
+    uint8_t  attempts;
+    uint32_t pressMicros;                 // 버튼 눌림 시각 (수신기의 명령 식별자)
+    int64_t  pressAtUs;
+};
+static GoTrigger s_go = {};
+
+bool armReady(uint8_t deviceID, uint32_t delayMs, uint32_t playMs) {
+    if (!ENABLE_ARM_GO || deviceID == 0 || deviceID > MAX_DEVICES) return false;
+    const ArmSlot& slot = s_armSlots[deviceID];
+    return slot.armed && slot.delayMs == delayMs && slot.playMs == playMs && millis() - slot.armedAtMs < ARM_MAX_AGE_MS;
+}
+
+static bool armNeedsCue(uint8_t id, unsigned long nowMs) {
+    if (!deviceSettings[id].isValid() || !linkSupports(id, Comm::CAP_ARM_GO)) return false;
+    const ArmSlot& slot = s_armSlots[id];
+    if (slot.failures >= ARM_MAX_FAILURES && nowMs - slot.lastCueMs < ARM_REFRESH_MS) return false;
+    if (!slot.armed || slot.delayMs != getTimerMs(id, true) || slot.playMs != getTimerMs(id, false)) return true;
+    return nowMs - slot.armedAtMs >= ARM_REFRESH_MS;
+}
+
+// 실행 정보 전송. 링크 캐시가 없으면 보정값을 정할 수 없으므로 보내지 않음 (백그라운드 갱신이 채움)
+static bool sendArmCue(uint8_t id, unsigned long nowMs) {
+    uint32_t rttUs, rxProcessingUs;
+    if (!linkCachedTiming(id, rttUs, rxProcessingUs)) return false;
+
+    ArmSlot& slot = s_armSlots[id];
+    uint32_t delayMs = getTimerMs(id, true);
+    uint32_t playMs = getTimerMs(id, false);
+    if (slot.delayMs != delayMs || slot.playMs != playMs) slot.armed = false;
+
+    int64_t nowUs = esp_timer_get_time();
+    int64_t offsetUs = linkSupports(id, Comm::CAP_ABSOLUTE_TIME) ? clockSyncOffsetAt(id, nowUs) : Comm::kNoClockOffset;
+    const ClockSyncState* sync = clockSyncState(id);
+    int32_t driftPpb = (offsetUs != Comm::kNoClockOffset && sync) ? sync->driftPpb : 0;
+
+    Comm::Frame frame;
+    uint32_t txMicros = 0;
+    size_t frameLen = Comm::buildArmCueFrame(frame, id, nextMessageSeq(), s_armId, delayMs, playMs, rttUs / 2 + rxProcessingUs,
+                                             offsetUs, (uint64_t)nowUs, driftPpb, txMicros);
+    slot.lastCueMs = nowMs;
+    s_lastCueMs = nowMs;
+    if (frameLen == 0 || sendToDevice(id, frame.data, frameLen, txMicros) != ESP_OK) return true; // 다음 간격에 다른 장치부터
+    s_cue = { true, id, txMicros, (uint32_t)(micros() + linkAckTimeoutUs(id) + txqBacklogUs()), delayMs, playMs };
+    return true;
+}
+
+static void recordArmCueAck() {
+    ArmSlot& slot = s_armSlots[s_cue.deviceID];
+    slot.armed = true;
+    slot.delayMs = s_cue.delayMs;
+    slot.playMs = s_cue.playMs;
+    slot.armedAtMs = millis();
+    slot.failures = 0;
+    s_cue.active = false;
+    logPrintf(LogLevel::LOG_DEBUG, "ARM: ID %d 무장 (딜레이 %lu ms, 플레이 %lu ms)", s_cue.deviceID, s_cue.delayMs, s_cue.playMs);
+}
+
+void manageArming() {
+    if (!ENABLE_ARM_GO || !espNowInitialized) return;
+    processReceivedAcks();
+    if (isProcessing || emergencyStopActive() || currentMode != GENERAL_MODE) {
+        s_cue.active = false; // 늦은 ACK는 무시됨 (설정이 그대로면 무장 상태도 그대로)
+        return;
+    }
+    if (channelSurveyActive() || channelHopActive() || s_probe.active || s_groupCfg.active) return;
+
+    if (s_cue.active) {
+        if ((int32_t)(micros() - s_cue.deadlineUs) <= 0) return;
+        s_cue.active = false;
+        ArmSlot& slot = s_armSlots[s_cue.deviceID];
+        if (slot.failures < 255) slot.failures++;
+        linkRecordAckTimeout(s_cue.deviceID);
+        peerRecordMiss(s_cue.deviceID);
+        rateRecordTimeout(s_cue.deviceID);
+        logPrintf(LogLevel::LOG_DEBUG, "ARM: ID %d 실행 정보 응답 없음 (연속 %u회)", s_cue.deviceID, slot.failures);
+    }
+
+    unsigned long nowMs = millis();
+    if (s_lastCueMs != 0 && nowMs - s_lastCueMs < ARM_CUE_INTERVAL_MS) return;
+    if (s_armId == 0) s_armId = esp_random() | 1;
+
+    for (uint8_t id = 1; id <= MAX_DEVICES; ++id) {
+        if (armNeedsCue(id, nowMs) && sendArmCue(id, nowMs)) return;
+    }
+}
+
+static uint8_t goSlotFor(uint8_t deviceID) {
+    RunningDevice* found = findRunningDevice(deviceID);
+    return found ? (uint8_t)(found - runningDevices) : MAX_GROUP_DEVICES;
+}
+
+static void cancelGoTrigger() {
+    s_go.active = false;
+    schedCancel(SCHED_GO_RETRY, 0);
+}
+
+// GO에 끝내 응답하지 않은 장치를 개별 명령 파이프라인으로 넘김 (시퀀스 번호는 새로, 버튼 눌림 시각은 같게)
+static void fallBackFromGo(uint32_t remaining) {
+    cancelGoTrigger();
+    logPrintf(LogLevel::LOG_WARN, "GO: %u회 전송 후 %d대 응답 없음 (비트맵 0x%08lX). 개별 명령으로 대체.",
+              s_go.attempts, __builtin_popcount(remaining), (unsigned long)remaining);
+    for (uint8_t id = 1; id <= MAX_DEVICES; ++id) {
+        if (!(remaining & (1UL << (id - 1)))) continue;
+        uint8_t slot = goSlotFor(id);
+        if (slot >= MAX_GROUP_DEVICES) continue;
+        RunningDevice& device = runningDevices[slot];
+        uint32_t rttUs, rxProcessingUs;
+        if (linkCachedTiming(id, rttUs, rxProcessingUs)) {
+            device.currentSequenceRttUs = rttUs;
+            device.currentSequenceRxProcessingTimeUs = rxProcessingUs;
+            device.commStatus = COMM_PENDING_FINAL_COMMAND;
+        } else {
+            device.commStatus = COMM_PENDING_RTT_REQUEST;
+        }
+        device.messageSeq = 0;
+        linkRecordRetry(id);
+        enqueuePending(slot);
+    }
+}
+
+// GO_COMMAND 전송 (스케줄러 이벤트). 아직 ACK하지 않은 장치만 비트맵에 넣음
+static void sendGoPacket(uint8_t slot, int64_t dueUs) {
+    if (!s_go.active) return;
+    uint32_t remaining = s_go.targetBitmap & ~s_go.ackedBitmap;
+    if (s_go.attempts >= GO_MAX_ATTEMPTS) {
+        fallBackFromGo(remaining);
+        return;
+    }
+
+    uint16_t ackSlotUs = currentAckSlotUs();
+    Comm::Frame frame;
+    uint32_t txMicros = 0;
+    size_t frameLen = Comm::buildGoFrame(frame, remaining, s_armId, s_go.pressMicros, (uint64_t)s_go.pressAtUs, ackSlotUs, txMicros);
+    esp_err_t result = (frameLen > 0) ? txqSubmit(broadcastAddress, frame.data, frameLen, rateForBroadcast(remaining), txMicros) : ESP_FAIL;
+    if (result == ESP_OK) {
+        s_go.txMicros[s_go.attempts++] = txMicros;
+        for (uint8_t id = 1; id <= MAX_DEVICES; ++id) {
+            if (remaining & (1UL << (id - 1))) linkRecordFrameSent(id);
+        }
+    } else {
+        logPrintf(LogLevel::LOG_ERROR, "GO: GO_COMMAND 전송 실패: %s", esp_err_to_name(result));
+    }
+    int64_t waitUs = (result == ESP_OK)
+        ? (int64_t)GO_RETRY_INTERVAL_MS * 1000 + (int64_t)__builtin_popcount(remaining) * ackSlotUs + txqBacklogUs()
+        : SEND_RETRY_BACKOFF_US;
+    schedArm(SCHED_GO_RETRY, 0, esp_timer_get_time() + waitUs);
+}
 
-        default:
-            // COMM_ACK_RECEIVED_SUCCESS 또는 COMM_FAILED_NO_ACK는 위에서 이미 처리되었음
-            break; 
+static void startGoTrigger(uint32_t targetBitmap) {
+    s_go = {};
+    s_go.active = true;
+    s_go.targetBitmap = targetBitmap;
+    s_go.pressMicros = runningDevices[0].txButtonPressSequenceMicros;
+    s_go.pressAtUs = runningDevices[0].sequenceStartUs;
+    logPrintf(LogLevel::LOG_INFO, "GO: 무장된 %d대에 GO_COMMAND 전송 (비트맵 0x%08lX).",
+              __builtin_popcount(targetBitmap), (unsigned long)targetBitmap);
+    sendGoPacket(0, esp_timer_get_time());
+}
+
+// GO_COMMAND에 대한 ACK이면 그 장치의 통신을 성공으로 마치고 true
+static bool handleGoAck(uint8_t deviceID, uint32_t originalTxMicros, int64_t rxTimeUs) {
+    uint8_t attempt = 0;
+    while (attempt < s_go.attempts && s_go.txMicros[attempt] != originalTxMicros) attempt++;
+    if (attempt >= s_go.attempts) return false;
+    if (deviceID == 0 || deviceID > 32) return true;
+
+    uint32_t bit = 1UL << (deviceID - 1);
+    if (!s_go.active || !(s_go.targetBitmap & bit) || (s_go.ackedBitmap & bit)) return true;
+    s_go.ackedBitmap |= bit;
+    uint8_t slot = goSlotFor(deviceID);
+    if (slot < MAX_GROUP_DEVICES && runningDevices[slot].commStatus == COMM_AWAITING_GO_ACK) {
+        RunningDevice& device = runningDevices[slot];
+        device.successfulAcks++;
+        device.sendAttempts = attempt + 1;
+        device.armTimeUs = (uint32_t)rxTimeUs - device.txButtonPressSequenceMicros;
+        device.commStatus = COMM_ACK_RECEIVED_SUCCESS;
+        logPrintf(LogLevel::LOG_INFO, "COMM: ID %d로부터 GO ACK 성공 (%u번째 전송).", deviceID, attempt + 1);
+        markFinished(device, slot, true);
     }
-    return all_comm_done; // 모든 통신이 완료되었는지 반환 (이 코드는 사실상 도달하지 않음)
+    if ((s_go.targetBitmap & ~s_go.ackedBitmap) == 0) {
+        cancelGoTrigger();
+        logPrintf(LogLevel::LOG_INFO, "GO: 모든 장치 확인 (%u회 전송).", s_go.attempts);
+    }
+    return true;
+}
+
+//────────────────────────────────────────────────────────────────────────────
+// [NEW] 그룹 주소
+//  - 송신부 그룹(inGroup이고 설정이 유효한 장치)을 이 송신기의 그룹 번호(GROUP_ID_ADDR)로 수신기에 등록.
+//    수신기는 등록을 보낸 송신기(MAC)별로 따로 저장하고 그 송신기의 그룹 명령에만 응하므로,
+//    송신기 여러 대가 같은 번호(기본값 1)를 써도 서로의 수신기를 실행하거나 해제하지 않음
+//    유휴 중 그룹 주소를 지원하는 수신기에 GROUP_CONFIG를 하나씩 보내 등록/해제하고, ACK로 확인한 상태만 기록
+//    (수신기는 NVS에 저장하므로 송신기가 재부팅하면 같은 내용으로 한 번씩 다시 확인함)
+//  - 최종 명령을 기다리는 장치가 확인된 구성원 전부이고 딜레이/플레이 시간이 같으면 BATCH_COMMAND 대신
+//    그룹 주소 FINAL_COMMAND 하나로 보냄. 장치 수와 관계없이 크기가 같고, 보정값은 구성원 평균을 씀
+//  - 그룹 명령에는 장치별 시계 오프셋과 보정값을 실을 수 없으므로, 시계가 동기화된 구성원이 하나라도 있거나
+//    구성원 보정값 차이가 GROUP_MAX_COMPENSATION_SPREAD_US보다 크면 장치별 항목을 싣는 BATCH_COMMAND로 보냄
+//    (그룹 명령은 모든 구성원이 받으므로 일부에게만 보낼 수 없음)
+//  - 등록 상태를 확인하지 못한 구성원이 있거나 그룹에서 빠진 장치의 해제가 아직 확인되지 않았으면 쓰지 않음.
+//    단, 꺼져 있는 동안 그룹에서 빠진 수신기는 다시 응답해 해제될 때까지 등록이 남아 있음
+//────────────────────────────────────────────────────────────────────────────
+enum GroupState : uint8_t { GROUP_UNKNOWN = 0, GROUP_MEMBER, GROUP_NOT_MEMBER };
+
+struct GroupSlot {
+    uint8_t       state;        // 수신기가 ACK로 확인한 등록 상태
+    uint8_t       failures;     // 연속으로 응답이 없던 수
+    unsigned long lastConfigMs; // 마지막 전송 시각
+};
+static GroupSlot s_groupSlots[MAX_DEVICES + 1];
+static unsigned long s_lastGroupConfigMs = 0;
+
+static uint8_t transmitterGroupId() {
+    static uint8_t groupId = 0;
+    if (groupId == 0) {
+        groupId = loadGroupID();
+        if (Comm::groupBit(groupId) == 0) groupId = 1; // 저장된 값이 없으면 (0xFF) 그룹 1 (번호는 송신기마다 따로 적용됨)
+    }
+    return groupId;
+}
+
+static bool groupWanted(uint8_t id) {
+    return deviceSettings[id].inGroup && deviceSettings[id].isValid();
+}
+
+static bool groupNeedsConfig(uint8_t id, unsigned long nowMs) {
+    if (!linkSupports(id, Comm::CAP_GROUP_ADDRESS)) return false;
+    const GroupSlot& slot = s_groupSlots[id];
+    if (slot.failures >= GROUP_CONFIG_MAX_FAILURES && nowMs - slot.lastConfigMs < GROUP_CONFIG_RETRY_MS) return false;
+    return slot.state != (groupWanted(id) ? GROUP_MEMBER : GROUP_NOT_MEMBER);
+}
+
+static void recordGroupConfigAck() {
+    GroupSlot& slot = s_groupSlots[s_groupCfg.deviceID];
+    slot.state = s_groupCfg.member ? GROUP_MEMBER : GROUP_NOT_MEMBER;
+    slot.failures = 0;
+    s_groupCfg.active = false;
+    logPrintf(LogLevel::LOG_DEBUG, "GROUP: ID %d 그룹 %u %s 확인", s_groupCfg.deviceID, transmitterGroupId(),
+              s_groupCfg.member ? "등록" : "해제");
+}
+
+void manageGroups() {
+    if (!ENABLE_GROUP_ADDRESS || !espNowInitialized) return;
+    processReceivedAcks();
+    if (isProcessing || emergencyStopActive()) {
+        s_groupCfg.active = false;
+        return;
+    }
+    if (channelSurveyActive() || channelHopActive() || s_probe.active || s_cue.active) return;
+
+    if (s_groupCfg.active) {
+        if ((int32_t)(micros() - s_groupCfg.deadlineUs) <= 0) return;
+        s_groupCfg.active = false;
+        GroupSlot& slot = s_groupSlots[s_groupCfg.deviceID];
+        if (slot.failures < 255) slot.failures++;
+        linkRecordAckTimeout(s_groupCfg.deviceID);
+        peerRecordMiss(s_groupCfg.deviceID);
+        rateRecordTimeout(s_groupCfg.deviceID);
+    }
+
+    unsigned long nowMs = millis();
+    if (s_lastGroupConfigMs != 0 && nowMs - s_lastGroupConfigMs < GROUP_CONFIG_INTERVAL_MS) return;
+
+    for (uint8_t id = 1; id <= MAX_DEVICES; ++id) {
+        if (!groupNeedsConfig(id, nowMs)) continue;
+        bool member = groupWanted(id);
+        Comm::Frame frame;
+        uint32_t txMicros = 0;
+        size_t frameLen = Comm::buildGroupConfigFrame(frame, id, nextMessageSeq(), transmitterGroupId(), member, txMicros);
+        s_groupSlots[id].lastConfigMs = nowMs;
+        s_lastGroupConfigMs = nowMs;
+        if (frameLen == 0 || sendToDevice(id, frame.data, frameLen, txMicros) != ESP_OK) return;
+        s_groupCfg = { true, id, txMicros, (uint32_t)(micros() + linkAckTimeoutUs(id) + txqBacklogUs()), member };
+        return;
+    }
+}
+
+// 묶으려는 장치가 확인된 그룹 구성원 전부이고 실행 정보가 모두 같으면 그룹 번호, 아니면 0
+// [MODIFIED] 평균 보정값으로 충분한 경우만: 시계가 동기화된 구성원이 있거나 보정값 차이가 크면 0
+static uint8_t groupAddressFor(RunningDevice* const devices[], uint8_t count) {
+    if (!ENABLE_GROUP_ADDRESS || count < 2) return 0;
+    uint32_t included = 0; // bit ID-1
+    uint32_t minCompensationUs = UINT32_MAX, maxCompensationUs = 0;
+    for (uint8_t i = 0; i < count; ++i) {
+        const RunningDevice& device = *devices[i];
+        if (s_groupSlots[device.deviceID].state != GROUP_MEMBER) return 0;
+        if (device.delayTime != devices[0]->delayTime || device.playTime != devices[0]->playTime) return 0;
+        // 절대 시각으로 실행할 수 있는 장치는 일괄 명령의 장치별 시계 오프셋을 받아야 함
+        int64_t fireAtTxUs = device.sequenceStartUs + (int64_t)device.delayTime * 1000;
+        if (linkSupports(device.deviceID, Comm::CAP_ABSOLUTE_TIME) &&
+            clockSyncOffsetAt(device.deviceID, fireAtTxUs) != Comm::kNoClockOffset) return 0;
+        uint32_t compensationUs = device.currentSequenceRttUs / 2 + device.currentSequenceRxProcessingTimeUs;
+        minCompensationUs = std::min(minCompensationUs, compensationUs);
+        maxCompensationUs = std::max(maxCompensationUs, compensationUs);
+        included |= 1UL << (device.deviceID - 1);
+    }
+    if (maxCompensationUs - minCompensationUs > GROUP_MAX_COMPENSATION_SPREAD_US) return 0;
+    for (uint8_t id = 1; id <= MAX_DEVICES; ++id) {
+        if (s_groupSlots[id].state == GROUP_MEMBER && !(included & (1UL << (id - 1)))) return 0;
+    }
+    return transmitterGroupId();
+}
+
+// 그룹 주소 FINAL_COMMAND 전송. 구성원은 ID 순서 슬롯에서 ACK하므로 장치별 슬롯 대기 시간을 기록
+static bool sendGroupCommand(RunningDevice* const devices[], uint8_t count, uint8_t groupId, uint32_t& out_tx_timestamp) {
+    uint32_t rttSumUs = 0, rxProcessingSumUs = 0, rateBitmap = 0;
+    for (uint8_t i = 0; i < count; ++i) {
+        rttSumUs += devices[i]->currentSequenceRttUs;
+        rxProcessingSumUs += devices[i]->currentSequenceRxProcessingTimeUs;
+        rateBitmap |= 1UL << (devices[i]->deviceID - 1);
+    }
+    const RunningDevice& first = *devices[0];
+    uint16_t ackSlotUs = currentAckSlotUs();
+    uint64_t fireAtTxUs = (uint64_t)(first.sequenceStartUs + (int64_t)first.delayTime * 1000);
+    Comm::Frame frame;
+    size_t size = Comm::buildGroupCommandFrame(frame, groupId, nextMessageSeq(), first.txButtonPressSequenceMicros, first.delayTime,
+                                               first.playTime, rttSumUs / count, rxProcessingSumUs / count, fireAtTxUs, ackSlotUs,
+                                               out_tx_timestamp);
+    if (size == 0) return false;
+    for (uint8_t i = 0; i < count; ++i) devices[i]->ackSlotWaitUs = (uint32_t)(devices[i]->deviceID - 1) * ackSlotUs;
+
+    logPrintf(LogLevel::LOG_DEBUG, "COMM: 그룹 %u FINAL_COMMAND 전송 시도 (장치 %d개, %u 바이트, 슬롯: %u us, 패킷: %u us)",
+              groupId, count, (unsigned)size, ackSlotUs, out_tx_timestamp);
+    esp_err_t result = txqSubmit(broadcastAddress, frame.data, size, rateForBroadcast(rateBitmap), out_tx_timestamp);
+    if (result != ESP_OK) {
+        logPrintf(LogLevel::LOG_ERROR, "ESP-NOW: 그룹 FINAL_COMMAND 전송 실패 (에러=%d)", result);
+        return false;
+    }
+    rememberFrame(frame.data, size);
+    for (uint8_t i = 0; i < count; ++i) linkRecordFrameSent(devices[i]->deviceID);
+    return true;
+}
+
+//────────────────────────────────────────────────────────────────────────────
+// [NEW] 비상 정지
+//  - STOP_COMMAND를 브로드캐스트로 STOP_RETRY_INTERVAL_MS마다 다시 보내며, 확인 대상 장치가 모두 ACK하거나
+//    STOP_MAX_ATTEMPTS번 보낼 때까지 반복 (수신기는 받을 때마다 출력을 끄고 비트맵 순서의 슬롯에서 ACK)
+//  - 재전송마다 txMicros가 바뀌므로 첫 전송부터 마지막 전송까지의 txMicros에 대한 ACK는 모두 정지 확인으로 봄
+//    (정지 중에는 다른 패킷을 보내지 않음)
+//────────────────────────────────────────────────────────────────────────────
+struct EmergencyStop {
+    bool     active;          // 재전송 중
+    uint32_t targetBitmap;    // 패킷 대상 (bit ID-1)
+    uint32_t confirmBitmap;   // ACK를 기다리는 장치
+    uint32_t ackedBitmap;     // ACK한 장치 (확인 대상이 아닌 장치 포함)
+    uint32_t firstTxMicros;
+    uint32_t lastTxMicros;
+    uint8_t  attempts;
+};
+static EmergencyStop s_stop = {};
+
+static void finishEmergencyStop() {
+    s_stop.active = false;
+    schedCancel(SCHED_STOP_RETRY, 0);
+    uint32_t missing = s_stop.confirmBitmap & ~s_stop.ackedBitmap;
+    if (missing == 0) {
+        logPrintf(LogLevel::LOG_INFO, "STOP: 비상 정지 확인 완료 (%u회 전송, 확인 %d대).",
+                  s_stop.attempts, __builtin_popcount(s_stop.ackedBitmap));
+    } else {
+        logPrintf(LogLevel::LOG_ERROR, "STOP: %u회 전송 후에도 %d대 응답 없음 (비트맵 0x%08lX).",
+                  s_stop.attempts, __builtin_popcount(missing), (unsigned long)missing);
+    }
+}
+
+// 비상 정지 패킷 전송 (스케줄러 이벤트). 최대 횟수를 보냈으면 마지막 전송의 ACK 슬롯이 끝난 이 시점에 종료
+static void sendStopPacket(uint8_t slot, int64_t dueUs) {
+    if (!s_stop.active) return;
+    if (s_stop.attempts >= STOP_MAX_ATTEMPTS) {
+        finishEmergencyStop();
+        return;
+    }
+
+    Comm::Frame frame;
+    uint32_t txMicros = 0;
+    size_t frameLen = Comm::buildStopFrame(frame, s_stop.targetBitmap, currentAckSlotUs(), txMicros);
+    // [NEW] 정지는 모든 수신기가 들어야 하므로 가장 견고한 속도와 최대 세기
+    esp_err_t result = (frameLen > 0) ? txqSubmit(broadcastAddress, frame.data, frameLen, rateForBroadcast(0), txMicros) : ESP_FAIL;
+    if (result == ESP_OK) {
+        if (s_stop.attempts == 0) s_stop.firstTxMicros = txMicros;
+        s_stop.lastTxMicros = txMicros;
+        s_stop.attempts++;
+    } else {
+        logPrintf(LogLevel::LOG_ERROR, "STOP: 비상 정지 패킷 전송 실패: %s", esp_err_to_name(result));
+    }
+    // 드라이버가 거부했으면 짧게 기다렸다가 다시 시도 (횟수에는 넣지 않음)
+    int64_t waitUs = (result == ESP_OK) ? (int64_t)STOP_RETRY_INTERVAL_MS * 1000 : SEND_RETRY_BACKOFF_US;
+    schedArm(SCHED_STOP_RETRY, 0, esp_timer_get_time() + waitUs);
+}
+
+// 정지 패킷에 대한 ACK이면 기록하고 true
+static bool handleStopAck(uint8_t deviceID, uint32_t originalTxMicros) {
+    if (s_stop.attempts == 0) return false;
+    if (originalTxMicros - s_stop.firstTxMicros > s_stop.lastTxMicros - s_stop.firstTxMicros) return false;
+    if (deviceID == 0 || deviceID > 32) return true;
+
+    uint32_t bit = 1UL << (deviceID - 1);
+    if (!(s_stop.ackedBitmap & bit)) {
+        s_stop.ackedBitmap |= bit;
+        logPrintf(LogLevel::LOG_INFO, "STOP: ID %d 정지 확인 (%u번째 전송 중).", deviceID, s_stop.attempts);
+    }
+    if (s_stop.active && (s_stop.confirmBitmap & ~s_stop.ackedBitmap) == 0) finishEmergencyStop();
+    return true;
+}
+
+void startEmergencyStop(uint32_t targetBitmap, uint32_t confirmBitmap) {
+    s_stop = {};
+    s_stop.active = true;
+    s_stop.targetBitmap = targetBitmap;
+    s_stop.confirmBitmap = confirmBitmap & targetBitmap;
+    s_probe.active = false;
+    s_cue.active = false; // [NEW]
+    s_groupCfg.active = false;
+    uint8_t dropped = txqDropPending(); // [NEW] 밀린 명령보다 정지 패킷이 먼저 나가도록
+    if (dropped > 0) logPrintf(LogLevel::LOG_DEBUG, "STOP: 송신 대기 프레임 %u개 버림", dropped);
+    logPrintf(LogLevel::LOG_WARN, "STOP: 비상 정지 시작 (대상 0x%08lX, 확인 대상 %d대).",
+              (unsigned long)targetBitmap, __builtin_popcount(s_stop.confirmBitmap));
+    sendStopPacket(0, esp_timer_get_time());
+}
+
+void manageEmergencyStop() {
+    if (!s_stop.active) return;
+    processReceivedAcks();
+    schedRunDue();
+}
+
+bool emergencyStopActive() {
+    return s_stop.active;
+}
+
+StopStatus emergencyStopStatus(uint8_t deviceID) {
+    if (deviceID == 0 || deviceID > 32) return STOP_NOT_TARGETED;
+    uint32_t bit = 1UL << (deviceID - 1);
+    if (s_stop.ackedBitmap & bit) return STOP_CONFIRMED;
+    if (!(s_stop.confirmBitmap & bit)) return STOP_NOT_TARGETED;
+    return s_stop.active ? STOP_AWAITING_ACK : STOP_NO_ACK;
+}
+
+//────────────────────────────────────────────────────────────────────────────
+// [NEW] 조용한 채널 선택과 조정된 채널 전환
+//  - 유휴 중 CHANNEL_SURVEY_INTERVAL_MS마다 채널별 혼잡도를 측정하고(channel_t), 현재 채널보다 충분히 조용한
+//    채널이 있으면 CHANNEL_HOP을 브로드캐스트. 전환 시각(첫 전송 + CHANNEL_HOP_LEAD_MS)까지 재전송하며 ACK를 모으고,
+//    그 시각에 송신기와 ACK한 수신기가 함께 옮김 (재전송마다 남은 시간을 실어 보내므로 수신기도 같은 시각에 옮김)
+//  - 응답한 적 있는 수신기 중 채널 전환을 지원하지 않는 장치가 있으면 옮기지 않음 (그 장치를 잃게 되므로)
+//  - 전환을 놓친 수신기는 CHANNEL_BEACON이 끊기면 채널을 돌며 비콘을 찾아 따라옴.
+//    비콘은 측정 중이 아니면 실행 중에도 CHANNEL_BEACON_INTERVAL_MS마다 보냄
+//────────────────────────────────────────────────────────────────────────────
+struct ChannelHop {
+    bool     active;
+    uint8_t  newChannel;
+    int64_t  switchAtUs;      // 전환 시각 (esp_timer)
+    uint32_t targetBitmap;    // 패킷 대상 (모든 ID)
+    uint32_t confirmBitmap;   // ACK를 기다리는 장치 (응답한 적 있는 수신기)
+    uint32_t ackedBitmap;
+    uint32_t firstTxMicros;
+    uint32_t lastTxMicros;
+    uint8_t  attempts;
+};
+static ChannelHop s_hop = {};
+static unsigned long s_lastBeaconMs = 0;
+static bool s_beaconSent = false;
+static unsigned long s_nextSurveyMs = CHANNEL_SURVEY_FIRST_DELAY_MS;
+
+static bool channelHopActive() {
+    return s_hop.active;
+}
+
+// 실행이나 비상 정지가 있었으면 다음 측정을 CHANNEL_SURVEY_FIRST_DELAY_MS 뒤로 미룸 (연속 실행 사이에 측정하지 않도록)
+static void deferChannelSurvey() {
+    unsigned long earliestMs = millis() + CHANNEL_SURVEY_FIRST_DELAY_MS;
+    if ((long)(earliestMs - s_nextSurveyMs) > 0) s_nextSurveyMs = earliestMs;
+}
+
+static void completeChannelHop() {
+    s_hop.active = false;
+    schedCancel(SCHED_CHANNEL_HOP, 0);
+    uint8_t oldChannel = channelCurrent();
+    if (!channelSwitch(s_hop.newChannel)) return;
+    s_beaconSent = false; // 새 채널에서 바로 비콘
+
+    uint32_t missing = s_hop.confirmBitmap & ~s_hop.ackedBitmap;
+    if (missing == 0) {
+        logPrintf(LogLevel::LOG_INFO, "CHANNEL: 채널 %d -> %d 전환 완료 (%u회 전송, 확인 %d대).",
+                  oldChannel, s_hop.newChannel, s_hop.attempts, __builtin_popcount(s_hop.ackedBitmap));
+    } else {
+        logPrintf(LogLevel::LOG_WARN, "CHANNEL: 채널 %d -> %d 전환. %d대 응답 없음 (비트맵 0x%08lX, 비콘 탐색으로 따라와야 함).",
+                  oldChannel, s_hop.newChannel, __builtin_popcount(missing), (unsigned long)missing);
+    }
+}
+
+// 채널 전환 패킷 전송 (스케줄러 이벤트). 전환 직전 CHANNEL_HOP_ACK_MARGIN_MS 동안과 모두 확인된 뒤에는
+// 보내지 않고 전환 시각을 기다림
+static void sendChannelHop(uint8_t slot, int64_t dueUs) {
+    if (!s_hop.active) return;
+    int64_t nowUs = esp_timer_get_time();
+    int64_t remainingUs = s_hop.switchAtUs - nowUs;
+    if (remainingUs <= 0) {
+        completeChannelHop();
+        return;
+    }
+    bool allAcked = s_hop.attempts > 0 && (s_hop.confirmBitmap & ~s_hop.ackedBitmap) == 0;
+    if (allAcked || remainingUs < (int64_t)CHANNEL_HOP_ACK_MARGIN_MS * 1000) {
+        schedArm(SCHED_CHANNEL_HOP, 0, s_hop.switchAtUs);
+        return;
+    }
+
+    Comm::Frame frame;
+    uint32_t txMicros = 0;
+    size_t frameLen = Comm::buildChannelHopFrame(frame, s_hop.targetBitmap, currentAckSlotUs(), s_hop.newChannel,
+                                                 (uint16_t)(remainingUs / 1000), txMicros);
+    esp_err_t result = (frameLen > 0) ? txqSubmit(broadcastAddress, frame.data, frameLen, rateForBroadcast(0), txMicros) : ESP_FAIL;
+    if (result == ESP_OK) {
+        if (s_hop.attempts == 0) s_hop.firstTxMicros = txMicros;
+        s_hop.lastTxMicros = txMicros;
+        s_hop.attempts++;
+    } else {
+        logPrintf(LogLevel::LOG_WARN, "CHANNEL: 채널 전환 패킷 전송 실패: %s", esp_err_to_name(result));
+    }
+    int64_t waitUs = (result == ESP_OK) ? (int64_t)CHANNEL_HOP_RETRY_INTERVAL_MS * 1000 : SEND_RETRY_BACKOFF_US;
+    schedArm(SCHED_CHANNEL_HOP, 0, std::min(nowUs + waitUs, s_hop.switchAtUs));
+}
+
+// 채널 전환 패킷에 대한 ACK이면 기록하고 true
+static bool handleChannelHopAck(uint8_t deviceID, uint32_t originalTxMicros) {
+    if (!s_hop.active || s_hop.attempts == 0) return false;
+    if (originalTxMicros - s_hop.firstTxMicros > s_hop.lastTxMicros - s_hop.firstTxMicros) return false;
+    if (deviceID == 0 || deviceID > 32) return true;
+
+    uint32_t bit = 1UL << (deviceID - 1);
+    if (!(s_hop.ackedBitmap & bit)) {
+        s_hop.ackedBitmap |= bit;
+        logPrintf(LogLevel::LOG_DEBUG, "CHANNEL: ID %d 채널 전환 확인.", deviceID);
+    }
+    return true;
+}
+
+static void startChannelHop(uint8_t newChannel) {
+    uint32_t targetBitmap = 0;
+    uint32_t confirmBitmap = 0;
+    for (uint8_t id = 1; id <= MAX_DEVICES; ++id) {
+        uint32_t bit = 1UL << (id - 1);
+        targetBitmap |= bit;
+        if (linkIsUnknown(id)) continue;
+        if (!linkSupports(id, Comm::CAP_CHANNEL_HOP)) {
+            logPrintf(LogLevel::LOG_WARN, "CHANNEL: ID %d가 채널 전환을 지원하지 않음. 채널 %d 유지.", id, channelCurrent());
+            return;
+        }
+        confirmBitmap |= bit;
+    }
+
+    s_hop = {};
+    s_hop.active = true;
+    s_hop.newChannel = newChannel;
+    s_hop.targetBitmap = targetBitmap;
+    s_hop.confirmBitmap = confirmBitmap;
+    s_hop.switchAtUs = esp_timer_get_time() + (int64_t)CHANNEL_HOP_LEAD_MS * 1000;
+    logPrintf(LogLevel::LOG_INFO, "CHANNEL: 채널 %d -> %d 전환 시작 (%d ms 뒤, 확인 대상 %d대).",
+              channelCurrent(), newChannel, CHANNEL_HOP_LEAD_MS, __builtin_popcount(confirmBitmap));
+    sendChannelHop(0, esp_timer_get_time());
+}
+
+static void sendChannelBeacon() {
+    unsigned long nowMs = millis();
+    if (s_beaconSent && nowMs - s_lastBeaconMs < CHANNEL_BEACON_INTERVAL_MS) return;
+    s_lastBeaconMs = nowMs;
+    s_beaconSent = true;
+
+    Comm::Frame frame;
+    size_t frameLen = Comm::buildChannelBeaconFrame(frame, channelCurrent());
+    // [NEW] 링크 상태를 모르는 수신기도 찾을 수 있게
+    if (frameLen > 0) txqSubmit(broadcastAddress, frame.data, frameLen, rateForBroadcast(0), 0);
+}
+
+void manageChannel() {
+    if (!espNowInitialized) return;
+    if (s_hop.active) {
+        // 실행 시작/종료 때 스케줄러를 비우면 전환 이벤트도 지워지므로 다시 예약 (sendChannelHop이 남은 시간을 보고 판단)
+        if (!schedIsArmed(SCHED_CHANNEL_HOP, 0)) schedArm(SCHED_CHANNEL_HOP, 0, esp_timer_get_time());
+        processReceivedAcks();
+        schedRunDue();
+        return;
+    }
+    if (isProcessing || emergencyStopActive()) {
+        channelSurveyAbort();
+        deferChannelSurvey();
+    } else if (channelSurveyActive()) {
+        if (!channelSurveyStep()) return;
+        s_nextSurveyMs = millis() + CHANNEL_SURVEY_INTERVAL_MS;
+        uint8_t quieter;
+        if (channelPickQuieter(quieter)) startChannelHop(quieter);
+        return;
+    }
+
+    sendChannelBeacon();
+    if (!ENABLE_CHANNEL_SURVEY || isProcessing || emergencyStopActive() || s_probe.active) return;
+    if ((long)(millis() - s_nextSurveyMs) < 0) return;
+    channelSurveyStart();
+}
+
+void settleChannel() {
+    channelSurveyAbort();
+    deferChannelSurvey();
+    if (!s_hop.active) return;
+    // 기다리지 않고 현재 채널에서 바로 시작 (실행과 비상 정지 모두). ACK한 수신기도 전환 시각까지는 현재 채널에 있고,
+    // 전환 시각에는 송신부도 함께 옮기므로 남은 재전송은 새 채널에서 이어짐 (전환 이벤트는 manageChannel이 유지).
+    // 비상 정지에서 미리 옮기면 전환 시각까지 아무 수신기도 정지를 듣지 못함
+    logPrintf(LogLevel::LOG_INFO, "CHANNEL: 채널 전환 대기 중 전송 시작. 채널 %d에서 전송하고 %ld ms 뒤 채널 %d로 전환.",
+              channelCurrent(), (long)((s_hop.switchAtUs - esp_timer_get_time()) / 1000), s_hop.newChannel);
 }
@@ -20,10 +20,67 @@ void espNowSendCb(const uint8_t* mac_addr, esp_now_send_status_t status);
 // ESP-NOW 수신 콜백 함수 (ACK 패킷을 수신하기 위해 필요)
 void OnDataRecv(const esp_now_recv_info_t *info, const uint8_t *data, int len);
 
+// [NEW] 새 실행 시퀀스 시작 시 통신 엔진 상태(전송 대기열, 스케줄러 이벤트, 무장 시간 보고) 초기화
+void beginCommSequence();
+
+// [NEW] 현재 시퀀스에서 모든 시도가 실패한 장치 수 (로컬 타이머 완료 판단용)
+uint8_t commFailedDeviceCount();
+
 // [핵심] 통신 상태 관리 함수 (송신부에서 재전송 및 타임아웃 관리)
 bool manageCommunication();
 
-// [MODIFIED] 실행 명령 전송 함수에 packetType 파라미터 추가
-bool sendExecutionCommand(Comm::PacketType type, uint8_t targetId, uint32_t txButtonPressSequenceMicros, uint32_t original_delay_ms, uint32_t play_ms, uint32_t rttUs, uint32_t rxProcessingTimeUs, uint32_t& out_tx_timestamp);
+// [NEW] 다음 메시지 시퀀스 번호 발급 (0은 미할당 표시용으로 건너뜀)
+uint32_t nextMessageSeq();
+
+// [MODIFIED] 실행 명령 전송 함수에 packetType, seq, 절대 실행 시각(fireAtTxUs)과 시계 오프셋 파라미터 추가
+bool sendExecutionCommand(Comm::PacketType type, uint8_t targetId, uint32_t seq, uint32_t txButtonPressSequenceMicros, uint32_t original_delay_ms, uint32_t play_ms, uint32_t rttUs, uint32_t rxProcessingTimeUs,
+                          uint64_t fireAtTxUs, int64_t clockOffsetUs, uint32_t& out_tx_timestamp);
+
+// [NEW] 구 펌웨어(v3) 수신기용 실행 명령 전송
+bool sendLegacyExecutionCommand(Comm::PacketType type, uint8_t targetId, uint32_t txButtonPressSequenceMicros, uint32_t original_delay_ms, uint32_t play_ms, uint32_t rttUs, uint32_t rxProcessingTimeUs, uint32_t& out_tx_timestamp);
+
+// [NEW] 여러 장치의 최종 명령을 하나의 BATCH_COMMAND 패킷으로 전송
+bool sendBatchCommand(RunningDevice* const devices[], uint8_t count, uint32_t& out_tx_timestamp);
+
+// [NEW] 수신기 출력 시작 보고로 측정한 장치별 실행 오차와 장치 간 편차를 로그로 출력 (실행 완료 시 호출)
+void logExecutionSkewReport();
+
+// [NEW] 진행 중인 실행 시퀀스를 버림 (예약된 ACK 타임아웃, 중복 사본, 로컬 타이머 취소)
+void abortCommSequence();
+
+// [NEW] 비상 정지 시작. targetBitmap(bit ID-1, Comm::kStopAllDevices면 모든 ID)에 STOP_COMMAND를 브로드캐스트하고,
+// confirmBitmap의 장치가 모두 ACK하거나 STOP_MAX_ATTEMPTS번 보낼 때까지 재전송
+void startEmergencyStop(uint32_t targetBitmap, uint32_t confirmBitmap);
+
+// [NEW] 비상 정지 재전송과 ACK 처리 (loop에서 호출, 정지 중이 아니면 바로 반환)
+void manageEmergencyStop();
+
+// [NEW] 비상 정지 패킷을 아직 재전송 중인지
+bool emergencyStopActive();
+
+// [NEW] 마지막 비상 정지의 장치별 확인 상태
+StopStatus emergencyStopStatus(uint8_t deviceID);
+
+// [NEW] 유휴 상태에서 오래된 링크 캐시를 백그라운드 RTT_REQUEST로 갱신 (loop에서 호출)
+void refreshLinkCache();
+
+// [NEW] 진단 화면에서 보고 있는 장치. 유휴 중 이 장치에 DIAG_PROBE_INTERVAL_MS마다 RTT_REQUEST를 보냄 (0이면 해제)
+void setLinkProbeFocus(uint8_t deviceID);
+
+// [NEW] 유휴 중 실행 정보를 지원하는 수신기에 ARM_CUE를 하나씩 보내 무장 (loop에서 호출)
+void manageArming();
+
+// [NEW] 이 장치가 주어진 딜레이/플레이 시간으로 무장되어 있어 GO_COMMAND로 실행할 수 있는지
+bool armReady(uint8_t deviceID, uint32_t delayMs, uint32_t playMs);
+
+// [NEW] 유휴 중 수신기에 GROUP_CONFIG를 보내 송신부 그룹 설정을 수신기의 그룹 등록과 맞춤 (loop에서 호출)
+void manageGroups();
+
+// [NEW] 채널 비콘 전송, 유휴 중 채널 혼잡도 측정, 더 조용한 채널로의 조정된 전환 (loop에서 호출)
+void manageChannel();
+
+// [NEW] 실행/비상 정지 시작 전 호출. 측정 중이면 현재 채널로 돌아옴. 전환 중이면 기다리지 않음
+// (현재 채널에서 시작하고 예정된 전환 시각에 수신기와 함께 옮김)
+void settleChannel();
 
 #endif // ESPNOW_T_H
@@ -1,5 +1,9 @@
 #include "hardware_t.h"
 #include "utils_t.h" // logPrintf 사용을 위해
+#include "link_t.h"  // [NEW] 링크 캐시 (RTT_REQUEST 단계 생략)
+#include "sched_t.h" // [NEW] 로컬 타이머 이벤트
+#include "rate_t.h"  // [NEW] 진단 화면의 전송 속도/세기
+#include "txqueue_t.h" // [NEW] 송신 큐 통계
 #include <algorithm> // std::max 사용을 위해 (이전 보정 로직 흔적이지만 유지)
 
 //────────────────────────────────────────────────────────────────────────
@@ -9,6 +13,11 @@ Adafruit_SSD1306 display(DISPLAY_WIDTH, DISPLAY_HEIGHT, &Wire, -1);
 Button button1(BUTTON1_PIN), button2(BUTTON2_PIN), button3(BUTTON3_PIN), button4(BUTTON4_PIN);
 bool viewingGroup = true;
 unsigned long completionStartTime = 0;
+static uint8_t s_localTimersDone = 0; // [NEW] 로컬 플레이 타이머까지 끝난 장치 수
+static unsigned long s_stopFinishedMs = 0; // [NEW] 비상 정지 재전송이 끝난 시각 (0이면 아직 진행 중)
+static bool s_stopComboLatched = false;    // [NEW] 비상 정지 버튼 조합을 놓을 때까지 다시 처리하지 않음
+static bool s_diagHoldLatched = false;     // [NEW] 진단 화면에 들어온 MODE 길게 누름을 놓을 때까지 다시 처리하지 않음
+static uint8_t s_diagDevice = 1;           // [NEW] 진단 화면에서 보고 있는 장치
 
 // [MODIFIED] Helper to sort devices by delay time, then by ID.
 static void sortRunningDevicesByDelay(RunningDevice arr[], uint8_t count) {
@@ -25,12 +34,55 @@ static void sortRunningDevicesByDelay(RunningDevice arr[], uint8_t count) {
 // Execution Start Logic
 //────────────────────────────────────────────────────────────────────────
 void prepareForExecution() {
+    settleChannel(); // [NEW] 채널 측정 중이면 현재 채널로 돌아와 시작 (예정된 전환은 실행과 함께 진행)
     groupDeviceCount = 0;
     isProcessing = true;
     executionComplete = false;
     currentMode = EXECUTION_MODE;
+    s_localTimersDone = 0;
+    beginCommSequence(); // [NEW] 파이프라인 통신 엔진 상태 초기화
     updateDisplay(); 
-    delay(100);
+    // [MODIFIED] delay(100) 제거. 무장된 장치의 GO_COMMAND가 버튼 직후 바로 나가도록
+}
+
+// [NEW] 최근에 측정한 RTT가 캐시에 있으면 RTT_REQUEST 단계를 건너뛰고 바로 최종 명령부터 전송
+static void applyLinkCache(RunningDevice& rd) {
+    uint32_t rttUs, rxProcessingUs;
+    if (!linkCachedTiming(rd.deviceID, rttUs, rxProcessingUs)) return;
+    rd.commStatus = COMM_PENDING_FINAL_COMMAND;
+    rd.currentSequenceRttUs = rttUs;
+    rd.currentSequenceRxProcessingTimeUs = rxProcessingUs;
+    logPrintf(LogLevel::LOG_INFO, "COMM: ID %d 링크 캐시 사용 (RTT: %lu us, RxProc: %lu us). RTT_REQUEST 생략.",
+              rd.deviceID, (unsigned long)rttUs, (unsigned long)rxProcessingUs);
+}
+
+// [NEW] 실행 정보를 미리 받아 둔 수신기는 개별 명령 대신 GO_COMMAND로 실행 (통신 엔진이 시퀀스 시작 시 한 번에 보냄)
+static void applyArmedCue(RunningDevice& rd) {
+    if (!armReady(rd.deviceID, rd.delayTime, rd.playTime)) return;
+    rd.commStatus = COMM_AWAITING_GO_ACK;
+    logPrintf(LogLevel::LOG_INFO, "COMM: ID %d 무장됨. GO_COMMAND로 실행.", rd.deviceID);
+}
+
+// [NEW] ARM_REQUIRE_ALL이면 대상 장치가 모두 무장되어 있어야 실행 (아니면 실행하지 않고 일반 모드로)
+static bool armPolicyAllows() {
+    if (!ARM_REQUIRE_ALL) return true;
+    uint8_t unarmed = 0;
+    for (uint8_t i = 0; i < groupDeviceCount; ++i) {
+        if (runningDevices[i].commStatus == COMM_AWAITING_GO_ACK) continue;
+        unarmed++;
+        logPrintf(LogLevel::LOG_WARN, "ARM: ID %d 무장되지 않음.", runningDevices[i].deviceID);
+    }
+    if (unarmed == 0) return true;
+    logPrintf(LogLevel::LOG_ERROR, "Cannot start: %d device(s) not armed (ARM_REQUIRE_ALL).", unarmed);
+    groupDeviceCount = 0;
+    isProcessing = false;
+    currentMode = GENERAL_MODE;
+    return false;
+}
+
+// [NEW] micros() 기준 버튼 누름 시각을 64비트 esp_timer 시각으로 변환 (절대 실행 시각 계산용)
+static int64_t pressTimeToTimerUs(unsigned long buttonPressTime) {
+    return esp_timer_get_time() - (int64_t)(uint32_t)(micros() - buttonPressTime);
 }
 
 void startSingleExecution(uint8_t deviceID, unsigned long buttonPressTime) {
@@ -49,22 +101,35 @@ void startSingleExecution(uint8_t deviceID, unsigned long buttonPressTime) {
     rd.delayTime = getTimerMs(deviceID, true);
     rd.playTime = getTimerMs(deviceID, false);
     rd.txButtonPressSequenceMicros = buttonPressTime;
+    rd.sequenceStartUs = pressTimeToTimerUs(buttonPressTime);
     rd.commStatus = COMM_PENDING_RTT_REQUEST; // [MODIFIED] 초기 상태 변경
     rd.sendAttempts = 0;
     rd.successfulAcks = 0;
     rd.lastPacketSendTime = 0;
     rd.lastTxTimestamp = 0;
+    rd.ackSlotWaitUs = 0;
+    rd.messageSeq = 0;
     // [REMOVED] rd.lastRttUs = g_lastKnownGlobalRttUs;
     // [REMOVED] rd.lastRxProcessingTimeUs = g_lastKnownGlobalRxProcessingTimeUs;
     rd.currentSequenceRttUs = 0; // [NEW] 현재 시퀀스 RTT 초기화
     rd.currentSequenceRxProcessingTimeUs = 0; // [NEW] 현재 시퀀스 Rx 처리 시간 초기화
+    rd.armTimeUs = 0;
+    rd.reportedPhase = 0; // [NEW] 수신기 단계 보고 초기화
+    rd.rxCompensationUs = 0;
+    rd.rxPlayMs = 0;
+    rd.rxFireReported = false;
+    rd.rxFireErrorUs = 0;
+    rd.rxFireTxUs = 0;
+    applyLinkCache(rd); // [NEW]
+    applyArmedCue(rd); // [NEW]
     rd.isDelayCompleted = false;
     rd.isCompleted = false;
     rd.delayEndTime = 0;
     rd.playEndTime = 0;
     groupDeviceCount = 1;
+    if (!armPolicyAllows()) return; // [NEW]
 
-    logPrintf(LogLevel::LOG_INFO, "COMM: Prepared single execution for ID %d. (RTT/RxProc는 현재 시퀀스에서 측정됨)", 
+    logPrintf(LogLevel::LOG_INFO, "COMM: Prepared single execution for ID %d. (캐시가 없으면 RTT/RxProc는 현재 시퀀스에서 측정됨)", 
               deviceID);
 }
 
@@ -83,22 +148,34 @@ void startGroupExecution(unsigned long buttonPressTime) {
             rd.delayTime = getTimerMs(id, true);
             rd.playTime = getTimerMs(id, false);
             rd.txButtonPressSequenceMicros = buttonPressTime;
+            rd.sequenceStartUs = pressTimeToTimerUs(buttonPressTime);
             rd.commStatus = COMM_PENDING_RTT_REQUEST; // [MODIFIED] 초기 상태 변경
             rd.sendAttempts = 0;
             rd.successfulAcks = 0;
             rd.lastPacketSendTime = 0;
             rd.lastTxTimestamp = 0;
+            rd.ackSlotWaitUs = 0;
+            rd.messageSeq = 0;
             // [REMOVED] rd.lastRttUs = g_lastKnownGlobalRttUs;
             // [REMOVED] rd.lastRxProcessingTimeUs = g_lastKnownGlobalRxProcessingTimeUs;
             rd.currentSequenceRttUs = 0; // [NEW] 현재 시퀀스 RTT 초기화
             rd.currentSequenceRxProcessingTimeUs = 0; // [NEW] 현재 시퀀스 Rx 처리 시간 초기화
+            rd.armTimeUs = 0;
+            rd.reportedPhase = 0; // [NEW] 수신기 단계 보고 초기화
+            rd.rxCompensationUs = 0;
+            rd.rxPlayMs = 0;
+            rd.rxFireReported = false;
+            rd.rxFireErrorUs = 0;
+            rd.rxFireTxUs = 0;
+            applyLinkCache(rd); // [NEW]
+            applyArmedCue(rd); // [NEW]
             rd.isDelayCompleted = false;
             rd.isCompleted = false;
             rd.delayEndTime = 0;
             rd.playEndTime = 0;
             groupDeviceCount++;
 
-            logPrintf(LogLevel::LOG_INFO, "COMM: Added device %d to group execution. (RTT/RxProc는 현재 시퀀스에서 측정됨)", 
+            logPrintf(LogLevel::LOG_INFO, "COMM: Added device %d to group execution. (캐시가 없으면 RTT/RxProc는 현재 시퀀스에서 측정됨)", 
                       id);
         }
     }
@@ -110,11 +187,88 @@ void startGroupExecution(unsigned long buttonPressTime) {
         return;
     }
     
-    sortRunningDevicesByDelay(runningDevices, groupDeviceCount); // 여전히 딜레이 시간 순으로 정렬 (RTT 요청은 동시에 보내고, 최종 명령은 딜레이가 짧은 순서로 보내면 더 효율적일 수 있으나, 현재는 RTT 요청-응답-최종 명령이 한 디바이스씩 진행되므로 순차 정렬은 의미가 없어짐)
+    if (!armPolicyAllows()) return; // [NEW]
+    sortRunningDevicesByDelay(runningDevices, groupDeviceCount); // 딜레이 시간 순으로 정렬 (표시/로그 순서용. 전송 순서는 통신 엔진이 장치별 실행 시각으로 정함)
     logPrintf(LogLevel::LOG_INFO, "COMM: Prepared group execution for %d devices.", groupDeviceCount);
 }
 
 
+//────────────────────────────────────────────────────────────────────────
+// [NEW] 송신부 로컬 타이머 (스케줄러 이벤트, 최종 ACK를 받으면 통신 엔진이 딜레이 종료를 예약)
+//────────────────────────────────────────────────────────────────────────
+static void onLocalDelayEnd(uint8_t slot, int64_t dueUs) {
+    RunningDevice& rd = runningDevices[slot];
+    rd.isDelayCompleted = true;
+    startMotorVibration(500, false);
+    logPrintf(LogLevel::LOG_DEBUG, "ID %d: 송신부 로컬 딜레이 타이머 종료. 모터 ON.", rd.deviceID);
+    // 딜레이 종료가 늦게 처리되었어도 플레이 종료는 버튼 누름 시점 기준으로 예약
+    // [MODIFIED] 수신기 출력 시작 보고로 실제 종료 시각이 이미 예약되어 있으면 그대로 둠
+    if (!schedIsArmed(SCHED_PLAY_END, slot)) {
+        schedArm(SCHED_PLAY_END, slot, rd.sequenceStartUs + (int64_t)(rd.delayTime + rd.playTime) * 1000);
+    }
+}
+
+static void onLocalPlayEnd(uint8_t slot, int64_t dueUs) {
+    RunningDevice& rd = runningDevices[slot];
+    if (rd.isCompleted) return; // [NEW] 수신기 종료 보고와 로컬 타이머가 겹쳐도 한 번만 셈
+    rd.isCompleted = true;
+    s_localTimersDone++;
+    logPrintf(LogLevel::LOG_DEBUG, "ID %d: 송신부 로컬 플레이 타이머 종료.", rd.deviceID);
+}
+
+//────────────────────────────────────────────────────────────────────────
+// [NEW] Emergency Stop
+//────────────────────────────────────────────────────────────────────────
+// 진행 중인 실행을 버리고 모든 ID에 STOP_COMMAND 전송. 실행 중인 장치, 그룹 멤버, 응답한 적 있는 수신기의 확인을 기다림
+static void triggerEmergencyStop() {
+    uint32_t confirmBitmap = 0;
+    for (uint8_t k = 0; k < groupDeviceCount; ++k) {
+        uint8_t id = runningDevices[k].deviceID;
+        if (id >= 1 && id <= MAX_DEVICES) confirmBitmap |= 1UL << (id - 1);
+    }
+    for (uint8_t id = 1; id <= MAX_DEVICES; ++id) {
+        if (deviceSettings[id].inGroup || !linkIsUnknown(id)) confirmBitmap |= 1UL << (id - 1);
+    }
+
+    logPrintf(LogLevel::LOG_WARN, "비상 정지 버튼 입력. 실행 중단 후 STOP 전송.");
+    if (isProcessing) abortCommSequence();
+    isProcessing = false;
+    executionComplete = true;
+    groupDeviceCount = 0;
+    currentMode = STOP_MODE;
+    s_stopFinishedMs = 0;
+    settleChannel(); // [NEW] 채널 측정 중이면 현재 채널로 (예정된 전환은 전환 시각에 수신기와 함께 진행)
+    startEmergencyStop(Comm::kStopAllDevices, confirmBitmap);
+    startMotorVibration(150, false);
+    updateDisplay();
+}
+
+static void leaveStopMode() {
+    logPrintf(LogLevel::LOG_INFO, "비상 정지 화면 종료. GENERAL_MODE로 복귀.");
+    currentMode = GENERAL_MODE;
+    viewingGroup = (previousSelectedDevice == 0);
+    selectedDevice = previousSelectedDevice == 0 ? 1 : previousSelectedDevice;
+    s_stopFinishedMs = 0;
+    updateDisplay();
+}
+
+// SET + PLAY를 함께 누르면 비상 정지 (실행 중이거나 정지 화면일 때만, 일반 모드에서는 각 버튼 동작이 먼저 실행되므로 제외)
+// 조합을 누르고 있는 동안은 다른 버튼 처리를 하지 않음
+static bool handleEmergencyStopCombo() {
+    if (!(button1.isDown() && button4.isDown())) {
+        s_stopComboLatched = false;
+        return false;
+    }
+    if (s_stopComboLatched) return true;
+    if (!isProcessing && currentMode != STOP_MODE) return false;
+
+    s_stopComboLatched = true;
+    button1.isPressed(); // 조합에 쓰인 눌림 이벤트 소비
+    button4.isPressed();
+    triggerEmergencyStop();
+    return true;
+}
+
 //────────────────────────────────────────────────────────────────────────
 // Main Execution and Mode Transition Logic
 //────────────────────────────────────────────────────────────────────────
@@ -122,42 +276,16 @@ void checkExecutionAndMode() {
     unsigned long now = millis();
 
     if (currentMode == EXECUTION_MODE && isProcessing) {
-        manageCommunication(); // Manages sending packets in the background
-        bool allLocalTimersDone = true;
-
-        for (uint8_t i = 0; i < groupDeviceCount; i++) {
-            RunningDevice& rd = runningDevices[i];
-            
-            // [MODIFIED] 최종 명령 ACK를 받은 후에만 타이머 시작
-            if (rd.commStatus == COMM_ACK_RECEIVED_SUCCESS && rd.delayEndTime == 0) {
-                // RTT 및 RxProc 값을 사용하여 최종 지연 시간 계산 (이 부분은 수신부에서 진행되므로, 여기서는 단순히 실행 시작으로만 표시)
-                // 송신부의 로컬 타이머는 이미 전체 지연 시간을 기준으로 동작하고 있음.
-                // 그러나 사용자 요구사항에 따라 송신부 로컬 타이머는 보정값과 관계없이 설정된 딜레이/플레이 시간을 따름.
-                // (이 부분이 실제 수신부 동작과 일치하도록 변경하려면 송신부도 수신부처럼 보정된 시간으로 타이머를 시작해야 함.
-                //  하지만 현재는 송신부는 관리, 수신부는 실제 실행이므로, 송신부는 설정된 시간을 따르고 수신부는 보정된 시간을 따르는 것이 맞음.)
-                rd.delayEndTime = now + rd.delayTime; // 송신부는 설정된 딜레이 시간 기준으로 로컬 타이머 시작
-                rd.playEndTime = rd.delayEndTime + rd.playTime;
-                logPrintf(LogLevel::LOG_INFO, "ID %d: 송신부 로컬 타이머 시작. (설정된 지연: %lu ms)", rd.deviceID, rd.delayTime);
-            }
+        manageCommunication(); // Manages sending packets in the background (로컬 타이머 이벤트도 여기서 처리됨)
+        // [MODIFIED] 매 루프 모든 장치를 훑지 않고 완료 수로 판단 (실패한 장치는 통신 엔진이 완료로 표시)
+        bool allLocalTimersDone = (uint8_t)(s_localTimersDone + commFailedDeviceCount()) >= groupDeviceCount;
 
-            if (!rd.isDelayCompleted && rd.delayEndTime > 0 && now >= rd.delayEndTime) {
-                rd.isDelayCompleted = true;
-                startMotorVibration(500, false);
-                logPrintf(LogLevel::LOG_DEBUG, "ID %d: 송신부 로컬 딜레이 타이머 종료. 모터 ON.", rd.deviceID);
-            }
-
-            if (!rd.isCompleted && rd.playEndTime > 0 && now >= rd.playEndTime) {
-                rd.isCompleted = true;
-                logPrintf(LogLevel::LOG_DEBUG, "ID %d: 송신부 로컬 플레이 타이머 종료.", rd.deviceID);
-            }
-            
-            if (!rd.isCompleted) {
-                allLocalTimersDone = false;
-            }
-        }
-        
         if (allLocalTimersDone) {
             logPrintf(LogLevel::LOG_INFO, "모든 송신부 로컬 타이머 종료. 완료 화면으로 전환.");
+            schedLogStats(); // [NEW]
+            txqLogStats();   // [NEW]
+            logExecutionSkewReport(); // [NEW] 수신기 보고 기반 장치 간 실행 편차
+            schedClear();    // [NEW] 남은 전송 간격 이벤트 정리 (실행 중이 아닐 때는 처리되지 않음)
             currentMode = COMPLETION_MODE;
             completionStartTime = now;
             
@@ -168,6 +296,21 @@ void checkExecutionAndMode() {
             startMotorVibration(successCount > 0 ? 300 : 600, successCount == 0);
         }
     }
+    else if (currentMode == STOP_MODE) {
+        // [NEW] 정지 확인이 끝나면 결과를 진동으로 알리고 잠시 보여준 뒤 일반 모드로 복귀
+        if (emergencyStopActive()) {
+            s_stopFinishedMs = 0;
+        } else if (s_stopFinishedMs == 0) {
+            s_stopFinishedMs = now;
+            bool anyMissing = false;
+            for (uint8_t id = 1; id <= MAX_DEVICES; ++id) {
+                if (emergencyStopStatus(id) == STOP_NO_ACK) anyMissing = true;
+            }
+            startMotorVibration(anyMissing ? 600 : 300, anyMissing);
+        } else if (now - s_stopFinishedMs >= STOP_RESULT_HOLD_MS) {
+            leaveStopMode();
+        }
+    }
     else if (currentMode == COMPLETION_MODE) {
         if (now - completionStartTime >= 500) { 
             logPrintf(LogLevel::LOG_INFO, "완료 화면 종료. GENERAL_MODE로 복귀.");
@@ -199,7 +342,10 @@ void displayExecutionMode() {
 
     for (uint8_t i = 0; i < groupDeviceCount; i++) {
         // [MODIFIED] COMM_FAILED_NO_ACK 상태인 장치도 표시 (실패 정보)
-        if (runningDevices[i].commStatus != COMM_ACK_RECEIVED_SUCCESS && runningDevices[i].commStatus != COMM_FAILED_NO_ACK) {
+        // [MODIFIED] 무장에 성공한 장치도 플레이가 끝날 때까지 수신기 보고 기반 상태로 표시
+        if (runningDevices[i].commStatus == COMM_ACK_RECEIVED_SUCCESS && !runningDevices[i].isCompleted) {
+            displayDevices[displayCount++] = runningDevices[i];
+        } else if (runningDevices[i].commStatus != COMM_ACK_RECEIVED_SUCCESS && runningDevices[i].commStatus != COMM_FAILED_NO_ACK) {
              // 아직 진행 중인 장치
              displayDevices[displayCount++] = runningDevices[i];
         } else if (runningDevices[i].commStatus == COMM_FAILED_NO_ACK) {
@@ -251,10 +397,20 @@ void displayExecutionMode() {
         // [MODIFIED] 통신 상태에 따라 표시 변경
         if (rd.commStatus == COMM_ACK_RECEIVED_SUCCESS) {
             // 성공적으로 통신 완료된 장치는 타이머가 종료되었는지 여부를 표시
-            if (rd.isCompleted) {
+            // [MODIFIED] 수신기 단계 보고가 있으면 실제 상태와 수신기 일정 기준 남은 시간 표시
+            unsigned long remainingDelayMs = (rd.delayEndTime > now) ? rd.delayEndTime - now : 0;
+            unsigned long remainingPlayMs = (rd.playEndTime > now) ? rd.playEndTime - now : 0;
+            if (rd.reportedPhase == Comm::PHASE_ABORTED) {
+                snprintf(lineBuffer, sizeof(lineBuffer), "ID:%02d/ABORTED", rd.deviceID);
+            } else if (rd.isCompleted || rd.reportedPhase == Comm::PHASE_PLAY_ENDED) {
                 snprintf(lineBuffer, sizeof(lineBuffer), "ID:%02d/COMPLETE", rd.deviceID);
+            } else if (rd.reportedPhase == Comm::PHASE_PLAY_STARTED) {
+                snprintf(lineBuffer, sizeof(lineBuffer), "ID:%02d/ON/P:%lus", rd.deviceID, remainingPlayMs / MS_PER_SEC);
             } else if (rd.isDelayCompleted) {
                  snprintf(lineBuffer, sizeof(lineBuffer), "ID:%02d/PLAYING", rd.deviceID);
+            } else if (rd.reportedPhase == Comm::PHASE_ARMED) {
+                snprintf(lineBuffer, sizeof(lineBuffer), "ID:%02d/ARMED/D:%lum%02lus", rd.deviceID,
+                         remainingDelayMs / MS_PER_MIN, (remainingDelayMs % MS_PER_MIN) / MS_PER_SEC);
             } else {
                  snprintf(lineBuffer, sizeof(lineBuffer), "ID:%02d/ACK_OK", rd.deviceID);
             }
@@ -292,6 +448,7 @@ void displayExecutionMode() {
                 case COMM_AWAITING_RTT_ACK: snprintf(lineBuffer + strlen(lineBuffer), sizeof(lineBuffer) - strlen(lineBuffer), "/WAIT_RTT"); break;
                 case COMM_PENDING_FINAL_COMMAND: snprintf(lineBuffer + strlen(lineBuffer), sizeof(lineBuffer) - strlen(lineBuffer), "/REQ_CMD"); break;
                 case COMM_AWAITING_FINAL_ACK: snprintf(lineBuffer + strlen(lineBuffer), sizeof(lineBuffer) - strlen(lineBuffer), "/WAIT_CMD"); break;
+                case COMM_AWAITING_GO_ACK: snprintf(lineBuffer + strlen(lineBuffer), sizeof(lineBuffer) - strlen(lineBuffer), "/WAIT_GO"); break; // [NEW]
                 default: break; // 그 외 상태는 표시 안 함
             }
         }
@@ -325,6 +482,82 @@ void displayCompletionMode() {
     display.println(primaryMsg);
 }
 
+// [NEW] 비상 정지 화면: 장치별 확인 상태 (OK: 정지 확인, ..: ACK 대기, X: 응답 없음)
+void displayStopMode() {
+    bool active = emergencyStopActive();
+    displayCenteredModeName(active ? "STOPPING" : "STOP");
+    display.setCursor(0, LINE_HEIGHT + 2);
+
+    char lineBuffer[MAX_CHARS_PER_LINE + 1] = "";
+    uint8_t perLine = 0, targeted = 0, confirmed = 0;
+    for (uint8_t id = 1; id <= MAX_DEVICES; ++id) {
+        StopStatus status = emergencyStopStatus(id);
+        if (status == STOP_NOT_TARGETED) continue;
+        targeted++;
+        if (status == STOP_CONFIRMED) confirmed++;
+        const char* mark = (status == STOP_CONFIRMED) ? "OK" : (status == STOP_NO_ACK) ? "X " : "..";
+        size_t len = strlen(lineBuffer);
+        snprintf(lineBuffer + len, sizeof(lineBuffer) - len, "%02d:%s ", id, mark);
+        if (++perLine == 3) {
+            display.println(lineBuffer);
+            lineBuffer[0] = '\0';
+            perLine = 0;
+        }
+    }
+    if (perLine > 0) display.println(lineBuffer);
+    if (targeted == 0) display.println("NO KNOWN DEVICE");
+
+    snprintf(lineBuffer, sizeof(lineBuffer), "ACK %u/%u%s", confirmed, targeted, active ? "" : "  SET:EXIT");
+    display.setCursor(0, DISPLAY_HEIGHT - LINE_HEIGHT + 2);
+    display.print(lineBuffer);
+}
+
+// [NEW] 링크 진단 화면: 수신 세기(평활/마지막), 손실률, 재전송(마지막 시퀀스/평균), 최근 RTT 분포,
+// 전송 속도와 송신 세기, 마지막 수신 후 경과 시간
+void displayDiagnosticsMode() {
+    char lineBuffer[MAX_CHARS_PER_LINE + 1];
+    snprintf(lineBuffer, sizeof(lineBuffer), "LINK ID %02d", s_diagDevice);
+    displayCenteredModeName(lineBuffer);
+    display.setCursor(0, LINE_HEIGHT + 2);
+
+    const LinkState* link = linkState(s_diagDevice);
+    if (!link || link->protocolVersion == 0) {
+        display.println("NO RESPONSE YET");
+    } else {
+        if (link->rssiKnown) snprintf(lineBuffer, sizeof(lineBuffer), "RSSI %d dBm (L %d)", link->rssiX16 / 16, link->lastRssi);
+        else                 snprintf(lineBuffer, sizeof(lineBuffer), "RSSI --");
+        display.println(lineBuffer);
+
+        unsigned avgRetriesX10 = link->sequences ? (unsigned)(link->totalRetries * 10 / link->sequences) : 0;
+        if (link->lossKnown) snprintf(lineBuffer, sizeof(lineBuffer), "LOSS %u.%u%% RTX %u/%u.%u", link->lossPermille / 10, link->lossPermille % 10,
+                                      link->lastSeqRetries, avgRetriesX10 / 10, avgRetriesX10 % 10);
+        else                 snprintf(lineBuffer, sizeof(lineBuffer), "LOSS --  RTX %u/%u.%u", link->lastSeqRetries, avgRetriesX10 / 10, avgRetriesX10 % 10);
+        display.println(lineBuffer);
+
+        LinkRttSummary rtt;
+        if (linkRttSummary(s_diagDevice, rtt)) {
+            snprintf(lineBuffer, sizeof(lineBuffer), "RTT n=%u min/med/p95", rtt.count);
+            display.println(lineBuffer);
+            snprintf(lineBuffer, sizeof(lineBuffer), "%lu.%02lu/%lu.%02lu/%lu.%02lums",
+                     (unsigned long)(rtt.minUs / 1000), (unsigned long)(rtt.minUs % 1000 / 10),
+                     (unsigned long)(rtt.medianUs / 1000), (unsigned long)(rtt.medianUs % 1000 / 10),
+                     (unsigned long)(rtt.p95Us / 1000), (unsigned long)(rtt.p95Us % 1000 / 10));
+            display.println(lineBuffer);
+        } else {
+            display.println("RTT --");
+        }
+
+        // [MODIFIED] 전송 속도와 송신 세기를 마지막 수신 후 경과 시간과 같은 줄에 표시
+        uint8_t powerQdbm = rateTxPowerQdbm(s_diagDevice);
+        unsigned long ageMs = (link->lastHeardMs != 0) ? millis() - link->lastHeardMs : 0;
+        snprintf(lineBuffer, sizeof(lineBuffer), "%-3s %u.%udBm AGE %lu.%lus", rateName(s_diagDevice),
+                 powerQdbm / 4, powerQdbm % 4 * 25 / 10, ageMs / 1000, ageMs % 1000 / 100);
+        display.println(lineBuffer);
+    }
+    display.setCursor(0, DISPLAY_HEIGHT - LINE_HEIGHT + 2);
+    display.print("SET:EXIT PLAY:RESET");
+}
+
 void displayCenteredModeName(const char* modeName) {
   String name = String(modeName);
   int nameLen = name.length();
@@ -353,6 +586,8 @@ void updateDisplay() {
     case ADJUSTING_VALUE_MODE:  displayAdjustingValueMode(); break;
     case EXECUTION_MODE:        displayExecutionMode(); break;
     case COMPLETION_MODE:       displayCompletionMode(); break;
+    case STOP_MODE:             displayStopMode(); break;
+    case DIAGNOSTICS_MODE:      displayDiagnosticsMode(); break;
   }
   display.display();
 }
@@ -392,6 +627,7 @@ void Button::update() {
 }
 bool Button::isPressed() { if(pressed){ pressed = false; return true; } return false; }
 bool Button::checkHold() { return isHolding; }
+bool Button::isDown() { return state == LOW; }
 bool Button::shouldCount() {
   if (!isHolding) return false;
   unsigned long now = millis();
@@ -445,6 +681,8 @@ bool initHardware() {
   initVibrationMotor();
   initEEPROM();
   loadSettings();
+  schedSetHandler(SCHED_DELAY_END, onLocalDelayEnd); // [NEW]
+  schedSetHandler(SCHED_PLAY_END, onLocalPlayEnd);
   selectedDevice = 1;
   viewingGroup = true;
   return displayOK;
@@ -453,6 +691,8 @@ void updateButtons() { button1.update(); button2.update(); button3.update(); but
 
 // Button handlers
 void handleButtons() {
+    if (handleEmergencyStopCombo()) return; // [NEW] 비상 정지 조합은 모든 처리보다 먼저
+
     if (currentMode == GENERAL_MODE) {
         handleGeneralModeButtons();
     } else if (currentMode == GROUP_SETTING_MODE) {
@@ -463,6 +703,10 @@ void handleButtons() {
         handleDetailedSettingModeButtons();
     } else if (currentMode == ADJUSTING_VALUE_MODE) {
         handleAdjustingValueModeButtons();
+    } else if (currentMode == STOP_MODE) {
+        handleStopModeButtons();
+    } else if (currentMode == DIAGNOSTICS_MODE) {
+        handleDiagnosticsModeButtons();
     }
 
     // PLAY 버튼 (BUTTON4) 처리 - 모든 모드에서 공통
@@ -531,9 +775,47 @@ void handleGeneralModeButtons() {
         updateDisplay();
     }
 
+    // [NEW] MODE 버튼을 길게 누르면 링크 진단 화면 (눌림으로 바뀐 그룹/단일 보기는 되돌림)
+    if (!button3.isDown()) {
+        s_diagHoldLatched = false;
+    } else if (button3.checkHold() && !s_diagHoldLatched) {
+        s_diagHoldLatched = true;
+        viewingGroup = !viewingGroup;
+        s_diagDevice = selectedDevice;
+        currentMode = DIAGNOSTICS_MODE;
+        setLinkProbeFocus(s_diagDevice);
+        linkLogReport();
+        logPrintf(LogLevel::LOG_INFO, "링크 진단 화면 진입 (ID %d).", s_diagDevice);
+        updateDisplay();
+    }
+
     // PLAY 버튼 (BUTTON4) 처리는 handleButtons()로 이동
 }
 
+// [NEW] 정지 확인이 끝난 뒤 SET으로 결과 화면 닫기. 나머지 버튼 입력은 일반 모드로 넘어가지 않도록 버림
+void handleStopModeButtons() {
+    if (button1.isPressed() && !emergencyStopActive()) leaveStopMode();
+    button2.isPressed();
+    button3.isPressed();
+}
+
+// [NEW] 링크 진단 화면: SET 나가기, UP/DOWN 장치 이동, PLAY 이 장치의 통계 초기화
+void handleDiagnosticsModeButtons() {
+    if (!button3.isDown()) s_diagHoldLatched = false;
+    if (button1.isPressed()) {
+        setLinkProbeFocus(0);
+        currentMode = GENERAL_MODE;
+        logPrintf(LogLevel::LOG_INFO, "링크 진단 화면 종료. GENERAL_MODE로 복귀.");
+    }
+    else if (button2.isPressed()) { s_diagDevice = (s_diagDevice == MAX_DEVICES) ? 1 : s_diagDevice + 1; setLinkProbeFocus(s_diagDevice); }
+    else if (button3.isPressed()) {
+        if (s_diagHoldLatched) return; // 진입에 쓴 MODE 버튼을 아직 누르고 있음
+        s_diagDevice = (s_diagDevice == 1) ? MAX_DEVICES : s_diagDevice - 1;
+        setLinkProbeFocus(s_diagDevice);
+    }
+    else if (button4.isPressed()) { linkResetStats(s_diagDevice); }
+}
+
 void handleGroupSettingModeButtons() {
     if (button1.isPressed()) { 
         currentMode = GENERAL_MODE; 
@@ -32,6 +32,7 @@ public:
     void update();
     bool isPressed();
     bool checkHold();
+    bool isDown(); // [NEW] 디바운스된 현재 눌림 상태 (눌림 이벤트를 소비하지 않음)
     bool shouldCount();
     void resetPressCount();
 };
@@ -70,6 +71,8 @@ void handleDetailedSettingModeButtons();
 void handleAdjustingValueModeButtons();
 void handleExecutionModeButtons();
 void handleCompletionModeButtons();
+void handleStopModeButtons(); // [NEW]
+void handleDiagnosticsModeButtons(); // [NEW]
 
 //────────────────────────────────────────────────────────────────────────
 // Display Functions
@@ -81,6 +84,8 @@ void displayDetailedSettingMode(uint8_t id, uint8_t dMin, uint8_t dSec, bool isD
 void displayAdjustingValueMode();
 void displayExecutionMode();
 void displayCompletionMode();
+void displayStopMode(); // [NEW] 비상 정지 장치별 확인 상태
+void displayDiagnosticsMode(); // [NEW] 링크 진단 (수신 세기, 손실률, 재전송, RTT 분포)
 void displayCenteredModeName(const char* modeName);
 
 //────────────────────────────────────────────────────────────────────────
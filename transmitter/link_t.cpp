@@ -0,0 +1,218 @@
+#include "link_t.h"
+#include "utils_t.h"
+#include <algorithm>
+
+// 장치 ID로 바로 접근 (1부터 시작, 0번은 사용하지 않음)
+static LinkState s_links[MAX_DEVICES + 1];
+
+void linkInit() {
+    memset(s_links, 0, sizeof(s_links));
+    for (LinkState& link : s_links) link.rtoUs = ACK_TIMEOUT_MS * 1000UL;
+}
+
+LinkState* linkState(uint8_t deviceID) {
+    if (deviceID == 0 || deviceID > MAX_DEVICES) return nullptr;
+    return &s_links[deviceID];
+}
+
+void linkRecordProtocol(uint8_t deviceID, uint8_t version, uint32_t capabilities) {
+    LinkState* link = linkState(deviceID);
+    if (!link) return;
+    if (link->protocolVersion != version || link->capabilities != capabilities) {
+        logPrintf(LogLevel::LOG_INFO, "LINK: ID %d 프로토콜 v%d, 기능 0x%08X", deviceID, version, capabilities);
+    }
+    link->protocolVersion = version;
+    link->capabilities = capabilities;
+}
+
+bool linkIsLegacy(uint8_t deviceID) {
+    const LinkState* link = linkState(deviceID);
+    return link && link->protocolVersion == Comm::kLegacyVersion;
+}
+
+bool linkIsUnknown(uint8_t deviceID) {
+    const LinkState* link = linkState(deviceID);
+    return !link || link->protocolVersion == 0;
+}
+
+bool linkSupports(uint8_t deviceID, uint32_t capability) {
+    const LinkState* link = linkState(deviceID);
+    return link && (link->capabilities & capability) == capability;
+}
+
+// RFC 6298: 첫 샘플은 SRTT = R, RTTVAR = R/2. 이후 RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|, SRTT = 7/8 SRTT + 1/8 R
+// ACK는 원본 패킷의 txMicros를 돌려주므로 재전송된 패킷의 ACK도 어느 전송에 대한 것인지 구분됨
+// [MODIFIED] 단, 같은 프레임을 그대로 다시 보내는 중복 사본은 구분되지 않으므로 호출하는 쪽에서 샘플을 버림 (Karn 규칙)
+void linkRecordRtt(uint8_t deviceID, uint32_t rttUs, uint32_t rxProcessingUs) {
+    LinkState* link = linkState(deviceID);
+    if (!link) return;
+    if (rttUs == 0) rttUs = 1; // srttUs == 0은 샘플 없음 표시
+    if (link->srttUs == 0) {
+        link->srttUs = rttUs;
+        link->rttVarUs = rttUs / 2;
+    } else {
+        uint32_t errUs = (rttUs > link->srttUs) ? rttUs - link->srttUs : link->srttUs - rttUs;
+        link->rttVarUs = (link->rttVarUs * 3 + errUs) / 4;
+        link->srttUs = (link->srttUs * 7 + rttUs) / 8;
+    }
+    uint32_t rtoUs = link->srttUs + std::max<uint32_t>(ACK_RTO_GRANULARITY_US, link->rttVarUs * 4);
+    link->rtoUs = std::max<uint32_t>(ACK_RTO_MIN_US, std::min<uint32_t>(ACK_RTO_MAX_US, rtoUs));
+    link->rtoBackoff = 0;
+
+    // [NEW] 링크 캐시
+    link->rxProcessingUs = (link->sampleCount == 0) ? rxProcessingUs : (link->rxProcessingUs * 7 + rxProcessingUs) / 8;
+    link->lastSampleMs = millis();
+    if (link->sampleCount < UINT8_MAX) link->sampleCount++;
+    link->refreshFailures = 0;
+    link->rttHistoryUs[link->rttHistoryNext] = rttUs; // [NEW] 진단용 기록
+    link->rttHistoryNext = (link->rttHistoryNext + 1) % LINK_RTT_HISTORY;
+    if (link->rttHistoryCount < LINK_RTT_HISTORY) link->rttHistoryCount++;
+    logPrintf(LogLevel::LOG_DEBUG, "LINK: ID %d RTT %lu us -> SRTT %lu us, RTTVAR %lu us, RTO %lu us", deviceID,
+              (unsigned long)rttUs, (unsigned long)link->srttUs, (unsigned long)link->rttVarUs, (unsigned long)link->rtoUs);
+}
+
+void linkRecordAckTimeout(uint8_t deviceID) {
+    LinkState* link = linkState(deviceID);
+    if (!link) return;
+    if (link->rtoBackoff < ACK_RTO_MAX_BACKOFF) link->rtoBackoff++;
+}
+
+uint32_t linkAckTimeoutUs(uint8_t deviceID) {
+    const LinkState* link = linkState(deviceID);
+    if (!link) return ACK_TIMEOUT_MS * 1000UL;
+    uint64_t timeoutUs = (uint64_t)link->rtoUs << link->rtoBackoff;
+    return (uint32_t)std::min<uint64_t>(timeoutUs, std::max<uint32_t>(ACK_RTO_MAX_US, link->rtoUs)); // 초기 RTO는 상한보다 클 수 있음
+}
+
+bool linkCachedTiming(uint8_t deviceID, uint32_t& rttUs, uint32_t& rxProcessingUs) {
+    const LinkState* link = linkState(deviceID);
+    if (!link || link->protocolVersion == 0 || link->refreshFailures > 0) return false;
+    if (link->sampleCount < LINK_CACHE_MIN_SAMPLES || link->rttVarUs > LINK_CACHE_MAX_RTTVAR_US) return false;
+    if (millis() - link->lastSampleMs > LINK_CACHE_MAX_AGE_MS) return false;
+    rttUs = link->srttUs;
+    rxProcessingUs = link->rxProcessingUs;
+    return true;
+}
+
+bool linkNeedsRefresh(uint8_t deviceID) {
+    const LinkState* link = linkState(deviceID);
+    if (!link || link->protocolVersion == 0 || link->sampleCount == 0) return false;
+    if (link->refreshFailures >= LINK_REFRESH_MAX_FAILURES) return false;
+    return millis() - link->lastSampleMs > LINK_REFRESH_AGE_MS;
+}
+
+void linkRecordFrameSent(uint8_t deviceID) {
+    LinkState* link = linkState(deviceID);
+    if (!link) return;
+    if (++link->windowSent < LINK_LOSS_WINDOW) return;
+
+    // 창의 마지막 프레임에 대한 ACK는 다음 창으로 넘어갈 수 있으므로 받은 수가 더 많으면 손실 0으로 봄
+    uint8_t acked = std::min(link->windowAcked, link->windowSent);
+    uint16_t samplePermille = (uint16_t)((link->windowSent - acked) * 1000U / link->windowSent);
+    link->lossPermille = link->lossKnown ? (uint16_t)((link->lossPermille * 3U + samplePermille) / 4) : samplePermille;
+    link->lossKnown = true;
+    link->windowSent = 0;
+    link->windowAcked = 0;
+    logPrintf(LogLevel::LOG_DEBUG, "LINK: ID %d 손실률 %u.%u%% (창 %u%%)", deviceID,
+              link->lossPermille / 10, link->lossPermille % 10, samplePermille / 10);
+}
+
+void linkRecordAckHeard(uint8_t deviceID) {
+    LinkState* link = linkState(deviceID);
+    if (link && link->windowAcked < UINT8_MAX) link->windowAcked++;
+}
+
+// 수신 경로에서 호출되므로 평활만 하고 바로 반환 (EWMA 계수 1/8, 1/16 dBm 고정소수점)
+void linkRecordRssi(uint8_t deviceID, int8_t rssi) {
+    LinkState* link = linkState(deviceID);
+    if (!link) return;
+    int16_t sampleX16 = (int16_t)(rssi * 16);
+    link->rssiX16 = link->rssiKnown ? (int16_t)(link->rssiX16 + (sampleX16 - link->rssiX16) / 8) : sampleX16;
+    link->lastRssi = rssi;
+    link->rssiKnown = true;
+    link->lastHeardMs = millis();
+}
+
+void linkRecordRetry(uint8_t deviceID) {
+    LinkState* link = linkState(deviceID);
+    if (link && link->seqRetries < UINT8_MAX) link->seqRetries++;
+}
+
+void linkRecordSequenceEnd(uint8_t deviceID) {
+    LinkState* link = linkState(deviceID);
+    if (!link) return;
+    link->lastSeqRetries = link->seqRetries;
+    link->totalRetries += link->seqRetries;
+    if (link->sequences < UINT16_MAX) link->sequences++;
+    link->seqRetries = 0;
+}
+
+// 최근접 순위 방식: p 분위수는 정렬된 n개 중 ceil(p*n)번째 값
+bool linkRttSummary(uint8_t deviceID, LinkRttSummary& summary) {
+    const LinkState* link = linkState(deviceID);
+    if (!link || link->rttHistoryCount == 0) return false;
+    uint32_t sorted[LINK_RTT_HISTORY];
+    uint8_t n = link->rttHistoryCount;
+    memcpy(sorted, link->rttHistoryUs, n * sizeof(uint32_t)); // 가득 차기 전에는 앞쪽 n개가 유효
+    std::sort(sorted, sorted + n);
+    summary.count = n;
+    summary.minUs = sorted[0];
+    summary.medianUs = sorted[(n * 50 + 99) / 100 - 1];
+    summary.p95Us = sorted[(n * 95 + 99) / 100 - 1];
+    return true;
+}
+
+void linkResetStats(uint8_t deviceID) {
+    LinkState* link = linkState(deviceID);
+    if (!link) return;
+    link->windowSent = 0;
+    link->windowAcked = 0;
+    link->lossPermille = 0;
+    link->lossKnown = false;
+    link->rssiX16 = 0;
+    link->lastRssi = 0;
+    link->rssiKnown = false;
+    link->seqRetries = 0;
+    link->lastSeqRetries = 0;
+    link->sequences = 0;
+    link->totalRetries = 0;
+    link->rttHistoryNext = 0;
+    link->rttHistoryCount = 0;
+    logPrintf(LogLevel::LOG_INFO, "LINK: ID %d 진단 통계 초기화", deviceID);
+}
+
+void linkLogReport() {
+    for (uint8_t id = 1; id <= MAX_DEVICES; ++id) {
+        const LinkState* link = linkState(id);
+        if (link->protocolVersion == 0) continue;
+        LinkRttSummary rtt = {};
+        linkRttSummary(id, rtt);
+        logPrintf(LogLevel::LOG_INFO, "LINK: ID %d RSSI %d dBm, 손실 %u.%u%%, 재전송 %lu/%u 시퀀스, RTT 최소 %lu / 중앙 %lu / p95 %lu us (n=%u)",
+                  id, link->rssiX16 / 16, link->lossPermille / 10, link->lossPermille % 10,
+                  (unsigned long)link->totalRetries, link->sequences,
+                  (unsigned long)rtt.minUs, (unsigned long)rtt.medianUs, (unsigned long)rtt.p95Us, rtt.count);
+    }
+}
+
+uint8_t linkRedundantCopies(uint8_t deviceID) {
+    const LinkState* link = linkState(deviceID);
+    if (!ENABLE_REDUNDANT_TX || !link) return 0;
+    uint32_t lossPpm = (link->lossKnown ? link->lossPermille : REDUNDANT_DEFAULT_LOSS_PERMILLE) * 1000UL;
+
+    // 사본이 독립적으로 손실된다고 보면 k개를 더 보낼 때 남는 손실률은 p^(k+1)
+    uint32_t residualPpm = lossPpm;
+    uint8_t copies = 0;
+    while (residualPpm > REDUNDANT_TARGET_LOSS_PPM && copies < REDUNDANT_MAX_COPIES) {
+        residualPpm = (uint32_t)((uint64_t)residualPpm * lossPpm / 1000000UL);
+        copies++;
+    }
+    return copies;
+}
+
+void linkRecordRefreshFailure(uint8_t deviceID) {
+    LinkState* link = linkState(deviceID);
+    if (!link) return;
+    if (link->refreshFailures < UINT8_MAX) link->refreshFailures++;
+    linkRecordAckTimeout(deviceID);
+    logPrintf(LogLevel::LOG_WARN, "LINK: ID %d 백그라운드 갱신 응답 없음 (%d회 연속)", deviceID, link->refreshFailures);
+}
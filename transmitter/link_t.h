@@ -0,0 +1,119 @@
+#pragma once
+#ifndef LINK_T_H
+#define LINK_T_H
+
+#include <Arduino.h>
+#include "config_t.h"
+
+//────────────────────────────────────────────────────────────────────────────
+// [NEW] 수신기별 링크 상태 (장치 ID로 관리, 실행 시퀀스가 끝나도 유지)
+//  - 프로토콜 버전과 기능 비트맵: 수신기가 ACK로 알려준 값으로 패킷 형식을 고름
+//    (TLV를 지원하지 않는 구 펌웨어에는 v3 형식으로 대체)
+//  - [NEW] 적응형 ACK 타임아웃 (Jacobson/Karels): SRTT, RTTVAR로 RTO를 계산하고
+//    연속 타임아웃마다 2배씩 늘림 (새 RTT 샘플을 받으면 백오프 해제)
+//  - [NEW] 링크 캐시: 최근 RTT/수신기 처리 시간과 측정 시각, 샘플 수를 보관해
+//    충분히 새롭고 안정적이면 실행 시 RTT_REQUEST 단계를 건너뜀. 유휴 시 백그라운드로 갱신
+//  - [NEW] 손실률: 보낸 프레임 수 대비 받은 ACK 수를 LINK_LOSS_WINDOW 프레임마다 EWMA로 반영
+//    (왕복 손실률. 시간이 촉박한 명령의 중복 전송 횟수를 정하는 데 사용)
+//  - [NEW] 진단 통계: ACK 수신 세기(EWMA), 시퀀스별 재전송 수, 최근 LINK_RTT_HISTORY개 RTT 샘플
+//    (최소/중앙값/p95는 화면을 그릴 때만 계산하므로 수신 경로에서는 값을 넣기만 함)
+//────────────────────────────────────────────────────────────────────────────
+
+struct LinkState {
+    uint8_t  protocolVersion;   // 0이면 아직 모름, Comm::kLegacyVersion이면 구 펌웨어
+    uint32_t capabilities;      // Comm::Capability 비트맵 (구 펌웨어는 0)
+    uint32_t srttUs;            // [NEW] 평활 RTT (0이면 아직 샘플 없음)
+    uint32_t rttVarUs;          // [NEW] RTT 평균 편차
+    uint32_t rtoUs;             // [NEW] 백오프 전 ACK 타임아웃
+    uint8_t  rtoBackoff;        // [NEW] 연속 타임아웃 횟수 (ACK_RTO_MAX_BACKOFF까지)
+    uint32_t rxProcessingUs;    // [NEW] 평활 수신기 처리 시간
+    uint32_t lastSampleMs;      // [NEW] 마지막 RTT 샘플 시각 (millis())
+    uint8_t  sampleCount;       // [NEW] 누적 RTT 샘플 수 (255에서 멈춤)
+    uint8_t  refreshFailures;   // [NEW] 연속으로 응답이 없던 백그라운드 갱신 수 (샘플을 받으면 0)
+    uint8_t  windowSent;        // [NEW] 현재 손실률 측정 창에서 보낸 프레임 수
+    uint8_t  windowAcked;       // [NEW] 현재 측정 창에서 받은 ACK 수
+    uint16_t lossPermille;      // [NEW] 평활 왕복 손실률 (0.1% 단위)
+    bool     lossKnown;         // [NEW] 측정 창을 한 번 이상 채웠는지
+    int16_t  rssiX16;           // [NEW] 평활 ACK 수신 세기 (1/16 dBm)
+    int8_t   lastRssi;          // [NEW] 마지막 ACK 수신 세기 (dBm)
+    bool     rssiKnown;         // [NEW]
+    uint32_t lastHeardMs;       // [NEW] 마지막으로 이 수신기의 프레임을 받은 시각 (millis())
+    uint8_t  seqRetries;        // [NEW] 진행 중인 시퀀스의 재전송 수
+    uint8_t  lastSeqRetries;    // [NEW] 마지막으로 끝난 시퀀스의 재전송 수
+    uint16_t sequences;         // [NEW] 끝난 시퀀스 수
+    uint32_t totalRetries;      // [NEW] 끝난 시퀀스들의 재전송 합계
+    uint32_t rttHistoryUs[LINK_RTT_HISTORY]; // [NEW] 최근 RTT 샘플 (원형 버퍼)
+    uint8_t  rttHistoryNext;    // [NEW] 다음 샘플 위치
+    uint8_t  rttHistoryCount;   // [NEW]
+};
+
+// [NEW] 진단 화면용 RTT 분위수 (최근 샘플 기준, 최근접 순위)
+struct LinkRttSummary {
+    uint8_t  count;
+    uint32_t minUs;
+    uint32_t medianUs;
+    uint32_t p95Us;
+};
+
+void linkInit();
+
+LinkState* linkState(uint8_t deviceID);
+
+// 수신기가 ACK로 알려준 버전/기능 기록
+void linkRecordProtocol(uint8_t deviceID, uint8_t version, uint32_t capabilities);
+
+// 구 펌웨어(v3)로 확인된 수신기인지
+bool linkIsLegacy(uint8_t deviceID);
+
+// 버전을 아직 모르는 수신기인지 (첫 RTT_REQUEST 응답 전)
+bool linkIsUnknown(uint8_t deviceID);
+
+// 수신기가 해당 기능을 지원한다고 알려왔는지
+bool linkSupports(uint8_t deviceID, uint32_t capability);
+
+// [MODIFIED] ACK로 측정한 RTT와 수신기 처리 시간 반영 (RTT는 ACK 슬롯 대기는 제외, 수신기 처리 시간은 포함한 값)
+void linkRecordRtt(uint8_t deviceID, uint32_t rttUs, uint32_t rxProcessingUs);
+
+// [NEW] ACK 타임아웃 발생 시 호출 (다음 타임아웃을 2배로)
+void linkRecordAckTimeout(uint8_t deviceID);
+
+// [NEW] 다음 전송에 사용할 ACK 타임아웃 (us, 백오프 포함)
+uint32_t linkAckTimeoutUs(uint8_t deviceID);
+
+// [NEW] 캐시된 RTT/처리 시간이 새롭고 안정적이면 true (RTT_REQUEST 단계 생략 가능)
+bool linkCachedTiming(uint8_t deviceID, uint32_t& rttUs, uint32_t& rxProcessingUs);
+
+// [NEW] 백그라운드 갱신이 필요한 수신기인지 (응답한 적이 있고, 캐시가 오래되었고, 연속 실패 한도 미만)
+bool linkNeedsRefresh(uint8_t deviceID);
+
+// [NEW] 백그라운드 RTT_REQUEST에 응답이 없었음
+void linkRecordRefreshFailure(uint8_t deviceID);
+
+// [NEW] 이 수신기가 받아야 할 프레임을 한 번 전송함 (중복 사본, 일괄 패킷 포함)
+void linkRecordFrameSent(uint8_t deviceID);
+
+// [NEW] 이 수신기의 ACK를 받음 (중복 사본에 대한 ACK 포함)
+void linkRecordAckHeard(uint8_t deviceID);
+
+// [NEW] 이 수신기에서 받은 프레임의 수신 세기 기록 (ACK, 실행 단계 보고)
+void linkRecordRssi(uint8_t deviceID, int8_t rssi);
+
+// [NEW] ACK 타임아웃 후 같은 단계를 다시 보냄
+void linkRecordRetry(uint8_t deviceID);
+
+// [NEW] 실행 시퀀스의 통신이 끝남 (성공/실패 모두). 이번 시퀀스의 재전송 수를 마감
+void linkRecordSequenceEnd(uint8_t deviceID);
+
+// [NEW] 최근 RTT 샘플의 최소/중앙값/p95. 샘플이 없으면 false
+bool linkRttSummary(uint8_t deviceID, LinkRttSummary& summary);
+
+// [NEW] 진단 통계(세기, 재전송, RTT 기록, 손실률)만 초기화 (버전/기능과 RTO는 유지)
+void linkResetStats(uint8_t deviceID);
+
+// [NEW] 응답한 적 있는 모든 수신기의 진단 통계를 로그로 출력
+void linkLogReport();
+
+// [NEW] 시간이 촉박한 패킷에 덧붙일 중복 사본 수. 남는 손실률이 REDUNDANT_TARGET_LOSS_PPM 이하가 되는 최소값
+uint8_t linkRedundantCopies(uint8_t deviceID);
+
+#endif // LINK_T_H
@@ -0,0 +1,117 @@
+#include "peer_t.h"
+#include "utils_t.h"
+#include "rate_t.h"
+
+static constexpr uint8_t kMacValidMarker = 0xA5;
+
+struct PeerEntry {
+    uint8_t       mac[6];
+    bool          known;        // MAC을 학습함
+    bool          registered;   // esp_now 피어 테이블에 등록됨
+    uint8_t       misses;       // 연속으로 ACK를 받지 못한 유니캐스트 수
+    bool          awaitingAck;  // 마지막 전송이 유니캐스트였고 아직 ACK를 받지 못함
+    unsigned long lastUsedMs;   // LRU 교체 기준 (millis())
+};
+
+// 장치 ID로 바로 접근 (1부터 시작, 0번은 사용하지 않음)
+static PeerEntry s_peers[MAX_DEVICES + 1];
+static uint8_t s_registeredCount = 0;
+
+static uint16_t macAddr(uint8_t deviceID) {
+    return PEER_MAC_TABLE_ADDR + (uint16_t)(deviceID - 1) * 7;
+}
+
+static void saveMac(uint8_t deviceID) {
+    uint16_t addr = macAddr(deviceID);
+    for (uint8_t i = 0; i < 6; ++i) EEPROM.write(addr + i, s_peers[deviceID].mac[i]);
+    EEPROM.write(addr + 6, kMacValidMarker);
+    EEPROM.commit();
+}
+
+static void unregisterPeer(uint8_t deviceID) {
+    PeerEntry& peer = s_peers[deviceID];
+    if (!peer.registered) return;
+    esp_now_del_peer(peer.mac);
+    peer.registered = false;
+    rateInvalidatePeer(deviceID); // [NEW] 다시 등록하면 속도 설정도 다시 적용
+    s_registeredCount--;
+}
+
+// 피어 테이블이 가득 찼으면 가장 오래 쓰지 않은 피어를 삭제
+static bool registerPeer(uint8_t deviceID) {
+    PeerEntry& peer = s_peers[deviceID];
+    if (peer.registered) return true;
+
+    if (s_registeredCount >= PEER_UNICAST_LIMIT) {
+        uint8_t lruId = 0;
+        for (uint8_t id = 1; id <= MAX_DEVICES; ++id) {
+            if (s_peers[id].registered && (lruId == 0 || (long)(s_peers[id].lastUsedMs - s_peers[lruId].lastUsedMs) < 0)) lruId = id;
+        }
+        if (lruId == 0) return false;
+        logPrintf(LogLevel::LOG_DEBUG, "PEER: ID %d 피어 삭제 (LRU)", lruId);
+        unregisterPeer(lruId);
+    }
+
+    esp_now_peer_info_t info = {};
+    memcpy(info.peer_addr, peer.mac, 6);
+    info.channel = 0; // [MODIFIED] 현재 채널 (채널 전환 후에도 그대로 사용)
+    info.encrypt = false;
+    esp_err_t result = esp_now_add_peer(&info);
+    if (result != ESP_OK && result != ESP_ERR_ESPNOW_EXIST) {
+        logPrintf(LogLevel::LOG_WARN, "PEER: ID %d 피어 추가 실패 (에러=%d). 브로드캐스트 사용.", deviceID, result);
+        return false;
+    }
+    peer.registered = true;
+    s_registeredCount++;
+    return true;
+}
+
+void peerInit() {
+    memset(s_peers, 0, sizeof(s_peers));
+    s_registeredCount = 0;
+
+    uint8_t loaded = 0;
+    for (uint8_t id = 1; id <= MAX_DEVICES; ++id) {
+        uint16_t addr = macAddr(id);
+        if (EEPROM.read(addr + 6) != kMacValidMarker) continue;
+        for (uint8_t i = 0; i < 6; ++i) s_peers[id].mac[i] = EEPROM.read(addr + i);
+        s_peers[id].known = true;
+        loaded++;
+    }
+    logPrintf(LogLevel::LOG_INFO, "PEER: 저장된 수신기 MAC %d개 로드", loaded);
+}
+
+void peerLearn(uint8_t deviceID, const uint8_t* mac) {
+    if (deviceID == 0 || deviceID > MAX_DEVICES || !mac) return;
+    PeerEntry& peer = s_peers[deviceID];
+    peer.misses = 0;
+    peer.awaitingAck = false;
+    if (peer.known && memcmp(peer.mac, mac, 6) == 0) return;
+
+    unregisterPeer(deviceID);
+    memcpy(peer.mac, mac, 6);
+    peer.known = true;
+    saveMac(deviceID);
+    logPrintf(LogLevel::LOG_INFO, "PEER: ID %d MAC 학습 %02X:%02X:%02X:%02X:%02X:%02X", deviceID,
+              mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
+const uint8_t* peerDestination(uint8_t deviceID) {
+    if (!ENABLE_UNICAST_PEERS || deviceID == 0 || deviceID > MAX_DEVICES) return broadcastAddress;
+    PeerEntry& peer = s_peers[deviceID];
+    if (!peer.known || peer.misses >= PEER_UNICAST_MAX_MISSES) return broadcastAddress;
+    if (!registerPeer(deviceID)) return broadcastAddress;
+    peer.lastUsedMs = millis();
+    peer.awaitingAck = true;
+    return peer.mac;
+}
+
+void peerRecordMiss(uint8_t deviceID) {
+    if (deviceID == 0 || deviceID > MAX_DEVICES) return;
+    PeerEntry& peer = s_peers[deviceID];
+    if (!peer.awaitingAck) return; // 브로드캐스트(일괄 명령 등)로 보낸 패킷의 타임아웃은 세지 않음
+    peer.awaitingAck = false;
+    if (++peer.misses == PEER_UNICAST_MAX_MISSES) {
+        logPrintf(LogLevel::LOG_WARN, "PEER: ID %d 유니캐스트 응답 없음. ACK를 받을 때까지 브로드캐스트 사용.", deviceID);
+    }
+}
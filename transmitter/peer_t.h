@@ -0,0 +1,31 @@
+#pragma once
+#ifndef PEER_T_H
+#define PEER_T_H
+
+#include <Arduino.h>
+#include <esp_now.h>
+#include "config_t.h"
+
+//────────────────────────────────────────────────────────────────────────────
+// [NEW] 수신기 MAC 테이블과 유니캐스트 피어 관리
+//  - ACK를 보낸 MAC을 장치 ID별로 학습하고 EEPROM에 저장 (재부팅 후에도 유지)
+//  - MAC을 아는 수신기에는 유니캐스트로 보내 링크 계층 ACK와 하드웨어 재전송을 사용하고,
+//    다른 수신기가 남의 패킷을 깨어나 검사하지 않게 함
+//  - esp_now 피어 테이블은 드라이버 한도(브로드캐스트 포함 20개)가 있으므로
+//    PEER_UNICAST_LIMIT개까지만 등록하고, 넘치면 가장 오래 쓰지 않은 피어를 삭제 (LRU)
+//  - MAC을 모르거나 유니캐스트가 연속으로 응답을 받지 못하면 브로드캐스트로 대체
+//────────────────────────────────────────────────────────────────────────────
+
+// EEPROM에서 MAC 테이블 로드 (esp_now_init 후 호출)
+void peerInit();
+
+// ACK를 보낸 MAC 학습. 바뀌었으면 EEPROM에 저장하고 이전 피어 삭제
+void peerLearn(uint8_t deviceID, const uint8_t* mac);
+
+// 장치에 보낼 목적지 MAC (유니캐스트 피어 등록까지 처리, 불가능하면 broadcastAddress)
+const uint8_t* peerDestination(uint8_t deviceID);
+
+// ACK 타임아웃 발생. 마지막 전송이 유니캐스트였으면 실패로 셈 (연속 PEER_UNICAST_MAX_MISSES회면 브로드캐스트로 대체)
+void peerRecordMiss(uint8_t deviceID);
+
+#endif // PEER_T_H
@@ -0,0 +1,140 @@
+#include "rate_t.h"
+#include "utils_t.h"
+#include "espnow_comm_shared.h"
+#include <esp_wifi.h>
+#include <algorithm>
+
+static_assert(TX_POWER_MIN_QDBM >= 8 && TX_POWER_MAX_QDBM <= 84 && TX_POWER_MIN_QDBM <= TX_POWER_MAX_QDBM,
+              "TX power must be within the driver range [8, 84] (0.25 dBm)");
+static_assert(MAX_DEVICES <= 32, "rateForBroadcast() takes one bit per device ID");
+
+static constexpr uint8_t kNoStep = 0xFF;
+static constexpr uint8_t kTopStep = Comm::kRateLadderSize - 1;
+
+struct RateState {
+    uint8_t step;          // 현재 속도 단계 (Comm::kRateLadder 인덱스)
+    uint8_t appliedStep;   // 피어에 적용하도록 요청한 단계 (kNoStep이면 아직 적용 안 됨)
+    uint8_t lastSentStep;  // 마지막 프레임을 보낸 단계 (브로드캐스트는 현재 단계보다 느릴 수 있음)
+    uint8_t successes;     // 현재 단계에서 연속으로 받은 ACK
+    uint8_t failures;      // 연속 타임아웃
+    uint8_t upThreshold;   // 다음 단계를 시도할 연속 ACK 수
+    bool    probing;       // 단계를 올린 뒤 아직 ACK를 받지 못함
+    uint8_t powerQdbm;     // 이 링크에 쓰는 송신 세기
+};
+
+// 장치 ID로 바로 접근 (1부터 시작, 0번은 사용하지 않음)
+static RateState s_rates[MAX_DEVICES + 1];
+
+static RateState* rateState(uint8_t deviceID) {
+    if (deviceID == 0 || deviceID > MAX_DEVICES) return nullptr;
+    return &s_rates[deviceID];
+}
+
+static void changeStep(uint8_t deviceID, RateState& rate, uint8_t step, const char* reason) {
+    logPrintf(LogLevel::LOG_INFO, "RATE: ID %d %s -> %s (%s)", deviceID, Comm::kRateLadder[rate.step].name, Comm::kRateLadder[step].name, reason);
+    rate.step = step;
+    rate.successes = 0;
+    rate.failures = 0;
+}
+
+void rateInit() {
+    for (RateState& rate : s_rates) {
+        rate = {};
+        rate.appliedStep = kNoStep;
+        rate.upThreshold = RATE_UP_SUCCESSES;
+        rate.powerQdbm = TX_POWER_MAX_QDBM;
+    }
+    if (esp_wifi_config_espnow_rate(WIFI_IF_STA, Comm::kRateLadder[0].rate) != ESP_OK) {
+        logPrintf(LogLevel::LOG_WARN, "RATE: 기본 ESP-NOW 속도 설정 실패");
+    }
+    logPrintf(LogLevel::LOG_INFO, "RATE: 링크별 속도 조정 %s (기본 %s, 최대 세기 %d.%02d dBm)", ENABLE_RATE_CONTROL ? "사용" : "사용 안 함",
+              Comm::kRateLadder[0].name, TX_POWER_MAX_QDBM / 4, TX_POWER_MAX_QDBM % 4 * 25);
+}
+
+void rateRecordAck(uint8_t deviceID, int8_t rssi) {
+    RateState* rate = rateState(deviceID);
+    if (!ENABLE_RATE_CONTROL || !rate) return;
+    int16_t effectiveRssi = rssi - (TX_POWER_MAX_QDBM - rate->powerQdbm) / 4; // 최대 세기로 보냈을 때보다 약하게 도착함
+    rate->failures = 0;
+    if (rate->probing) {
+        rate->probing = false;
+        rate->upThreshold = RATE_UP_SUCCESSES;
+    }
+
+    // 세기가 현재 단계 기준보다 약해지면 타임아웃을 기다리지 않고 내림 (세기를 낮춘 링크는 먼저 최대로)
+    if (effectiveRssi < Comm::kRateLadder[rate->step].minRssi + RATE_RSSI_MARGIN_DB) {
+        if (rate->powerQdbm < TX_POWER_MAX_QDBM) rate->powerQdbm = TX_POWER_MAX_QDBM;
+        else if (rate->step > 0) changeStep(deviceID, *rate, rate->step - 1, "세기 약함");
+        return;
+    }
+    if (rate->lastSentStep != rate->step) return; // 더 느린 브로드캐스트에 대한 ACK는 현재 단계의 성공이 아님
+    if (++rate->successes < rate->upThreshold) return;
+    rate->successes = 0;
+
+    if (rate->step < kTopStep) {
+        if (effectiveRssi >= Comm::kRateLadder[rate->step + 1].minRssi + RATE_RSSI_MARGIN_DB) {
+            changeStep(deviceID, *rate, rate->step + 1, "시도");
+            rate->probing = true;
+        }
+        return;
+    }
+    // 가장 빠른 단계에서 여유가 충분하면 송신 세기를 낮춤 (주변 Wi-Fi와의 충돌 감소)
+    if (effectiveRssi >= Comm::kRateLadder[kTopStep].minRssi + RATE_RSSI_MARGIN_DB + TX_POWER_HEADROOM_DB && rate->powerQdbm > TX_POWER_MIN_QDBM) {
+        rate->powerQdbm = (uint8_t)std::max<int>(TX_POWER_MIN_QDBM, rate->powerQdbm - TX_POWER_STEP_QDBM);
+        logPrintf(LogLevel::LOG_DEBUG, "RATE: ID %d 송신 세기 %d.%02d dBm", deviceID, rate->powerQdbm / 4, rate->powerQdbm % 4 * 25);
+    }
+}
+
+void rateRecordTimeout(uint8_t deviceID) {
+    RateState* rate = rateState(deviceID);
+    if (!ENABLE_RATE_CONTROL || !rate) return;
+    rate->successes = 0;
+    rate->powerQdbm = TX_POWER_MAX_QDBM;
+    if (rate->probing) {
+        rate->probing = false;
+        rate->upThreshold = (uint8_t)std::min<int>(RATE_UP_SUCCESSES_MAX, rate->upThreshold * 2);
+        changeStep(deviceID, *rate, rate->step - 1, "시도 실패");
+        return;
+    }
+    if (++rate->failures < RATE_DOWN_FAILURES || rate->step == 0) return;
+    rate->upThreshold = RATE_UP_SUCCESSES;
+    changeStep(deviceID, *rate, rate->step - 1, "연속 타임아웃");
+}
+
+TxRate rateForUnicast(uint8_t deviceID) {
+    RateState* rate = rateState(deviceID);
+    if (!rate) return rateForBroadcast(0);
+    TxRate tx = { rate->step, rate->powerQdbm, rate->appliedStep != rate->step };
+    rate->appliedStep = rate->step;
+    rate->lastSentStep = rate->step;
+    return tx;
+}
+
+TxRate rateForBroadcast(uint32_t targetBitmap) {
+    uint8_t step = targetBitmap ? kTopStep : 0;
+    uint8_t power = targetBitmap ? TX_POWER_MIN_QDBM : TX_POWER_MAX_QDBM;
+    for (uint8_t id = 1; id <= MAX_DEVICES; ++id) {
+        if (!(targetBitmap & (1UL << (id - 1)))) continue;
+        step = std::min(step, s_rates[id].step);
+        power = std::max(power, s_rates[id].powerQdbm);
+    }
+    for (uint8_t id = 1; id <= MAX_DEVICES; ++id) {
+        if (targetBitmap & (1UL << (id - 1))) s_rates[id].lastSentStep = step;
+    }
+    return TxRate{ step, power, false };
+}
+
+void rateInvalidatePeer(uint8_t deviceID) {
+    RateState* rate = rateState(deviceID);
+    if (rate) rate->appliedStep = kNoStep;
+}
+
+const char* rateName(uint8_t deviceID) {
+    const RateState* rate = rateState(deviceID);
+    return Comm::kRateLadder[rate ? rate->step : 0].name;
+}
+
+uint8_t rateTxPowerQdbm(uint8_t deviceID) {
+    const RateState* rate = rateState(deviceID);
+    return rate ? rate->powerQdbm : TX_POWER_MAX_QDBM;
+}
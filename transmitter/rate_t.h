@@ -0,0 +1,51 @@
+#pragma once
+#ifndef RATE_T_H
+#define RATE_T_H
+
+#include <Arduino.h>
+#include "config_t.h"
+
+//────────────────────────────────────────────────────────────────────────────
+// [NEW] 링크별 ESP-NOW 전송 속도와 송신 세기 조정
+//  - 속도: Comm::kRateLadder 단계를 ACK 결과로 오르내림 (AARF 방식)
+//    연속 ACK가 기준 횟수만큼 쌓이고 다음 단계의 수신 감도 + RATE_RSSI_MARGIN_DB보다 세면 한 단계 올리고,
+//    올린 직후 첫 프레임이 타임아웃되면 바로 내리며 다음 시도 기준을 두 배로 늘림.
+//    연속 타임아웃 RATE_DOWN_FAILURES회, 또는 세기가 현재 단계 기준보다 약해지면 한 단계 내림
+//  - 세기 기준은 수신기 ACK의 RSSI에서 낮춘 송신 세기만큼 뺀 값 (수신기는 항상 같은 세기로 ACK하므로)
+//  - 송신 세기: 가장 빠른 단계에서도 TX_POWER_HEADROOM_DB 이상 여유가 있는 링크만 낮추고, 타임아웃 한 번이면 최대로
+//  - 유니캐스트는 피어별 속도 설정을 쓰고, 브로드캐스트(일괄 명령 등)는 대상 중 가장 느린 단계로 보냄.
+//    송신 세기는 드라이버 전체 설정이므로 보내기 직전에 그 프레임의 대상에 맞춤
+//  - [MODIFIED] 여기서는 프레임별 속도/세기만 정하고, 드라이버 설정은 송신 큐(txqueue_t)가 실제로 보낼 때 적용
+//────────────────────────────────────────────────────────────────────────────
+
+// [NEW] 프레임 하나에 쓸 속도 단계와 송신 세기
+struct TxRate {
+    uint8_t step;        // Comm::kRateLadder 인덱스
+    uint8_t powerQdbm;   // 0.25 dBm 단위
+    bool    applyPeer;   // 유니캐스트 피어에 속도 설정을 (다시) 적용해야 함
+};
+
+// 기본 속도 설정 (esp_now_init 후 호출)
+void rateInit();
+
+// 이 수신기의 ACK를 받음 (비상 정지/채널 전환 확인 제외)
+void rateRecordAck(uint8_t deviceID, int8_t rssi);
+
+// 이 수신기로 보낸 프레임의 ACK 타임아웃
+void rateRecordTimeout(uint8_t deviceID);
+
+// [MODIFIED] 이 링크로 보내는 유니캐스트의 속도와 송신 세기
+TxRate rateForUnicast(uint8_t deviceID);
+
+// [MODIFIED] targetBitmap(bit ID-1, 패킷 비트맵과 같음)에 보내는 브로드캐스트: 대상 중 가장 느린 단계와 가장 센 송신 세기
+// (0이면 모든 수신기 대상: 가장 견고한 단계, 최대 세기)
+TxRate rateForBroadcast(uint32_t targetBitmap);
+
+// 피어가 esp_now 피어 테이블에서 삭제됨 (다시 등록하면 속도 설정을 다시 적용해야 함)
+void rateInvalidatePeer(uint8_t deviceID);
+
+// 진단 화면용: 현재 속도 단계 이름과 송신 세기 (0.25 dBm 단위)
+const char* rateName(uint8_t deviceID);
+uint8_t rateTxPowerQdbm(uint8_t deviceID);
+
+#endif // RATE_T_H
@@ -0,0 +1,156 @@
+#include "sched_t.h"
+#include "utils_t.h"
+#include <algorithm>
+
+static constexpr uint16_t kCapacity = (uint16_t)SCHED_EVENT_KINDS * MAX_GROUP_DEVICES;
+
+struct HeapEntry {
+    int64_t dueUs;
+    uint8_t kind;
+    uint8_t slot;
+};
+
+static HeapEntry s_heap[kCapacity];
+static uint16_t s_size = 0;
+static uint16_t s_pos[SCHED_EVENT_KINDS][MAX_GROUP_DEVICES]; // 힙 위치 + 1 (0이면 예약 안 됨)
+static SchedHandler s_handlers[SCHED_EVENT_KINDS];
+static SchedStats s_stats;
+static TaskHandle_t s_loopTask = nullptr;
+
+static void place(uint16_t index, const HeapEntry& entry) {
+    s_heap[index] = entry;
+    s_pos[entry.kind][entry.slot] = index + 1;
+}
+
+static void siftUp(uint16_t index) {
+    HeapEntry entry = s_heap[index];
+    while (index > 0) {
+        uint16_t parent = (index - 1) / 2;
+        if (s_heap[parent].dueUs <= entry.dueUs) break;
+        place(index, s_heap[parent]);
+        index = parent;
+    }
+    place(index, entry);
+}
+
+static void siftDown(uint16_t index) {
+    HeapEntry entry = s_heap[index];
+    while (true) {
+        uint16_t child = index * 2 + 1;
+        if (child >= s_size) break;
+        if (child + 1 < s_size && s_heap[child + 1].dueUs < s_heap[child].dueUs) child++;
+        if (entry.dueUs <= s_heap[child].dueUs) break;
+        place(index, s_heap[child]);
+        index = child;
+    }
+    place(index, entry);
+}
+
+static void removeAt(uint16_t index) {
+    const HeapEntry& removed = s_heap[index];
+    s_pos[removed.kind][removed.slot] = 0;
+    s_size--;
+    if (index == s_size) return;
+    place(index, s_heap[s_size]);
+    if (index > 0 && s_heap[index].dueUs < s_heap[(index - 1) / 2].dueUs) siftUp(index); else siftDown(index);
+}
+
+void schedInit() {
+    s_loopTask = xTaskGetCurrentTaskHandle();
+    memset(s_handlers, 0, sizeof(s_handlers));
+    schedReset();
+}
+
+void schedSetHandler(SchedEvent kind, SchedHandler handler) {
+    if (kind < SCHED_EVENT_KINDS) s_handlers[kind] = handler;
+}
+
+void schedReset() {
+    schedClear();
+    memset(&s_stats, 0, sizeof(s_stats));
+}
+
+void schedClear() {
+    s_size = 0;
+    memset(s_pos, 0, sizeof(s_pos));
+    s_stats.depth = 0;
+}
+
+void schedArm(SchedEvent kind, uint8_t slot, int64_t dueUs) {
+    if (kind >= SCHED_EVENT_KINDS || slot >= MAX_GROUP_DEVICES) return;
+    int64_t nowUs = esp_timer_get_time();
+    if (dueUs < nowUs) dueUs = nowUs; // 이미 지난 기한은 처리 지연 통계에 넣지 않음
+
+    uint16_t pos = s_pos[kind][slot];
+    if (pos != 0) {
+        uint16_t index = pos - 1;
+        int64_t oldDueUs = s_heap[index].dueUs;
+        s_heap[index].dueUs = dueUs;
+        if (dueUs < oldDueUs) siftUp(index); else siftDown(index);
+        return;
+    }
+    place(s_size, { dueUs, kind, slot });
+    siftUp(s_size++);
+    s_stats.depth = s_size;
+    if (s_size > s_stats.peakDepth) s_stats.peakDepth = s_size;
+}
+
+void schedCancel(SchedEvent kind, uint8_t slot) {
+    if (kind >= SCHED_EVENT_KINDS || slot >= MAX_GROUP_DEVICES) return;
+    uint16_t pos = s_pos[kind][slot];
+    if (pos == 0) return;
+    removeAt(pos - 1);
+    s_stats.depth = s_size;
+}
+
+bool schedIsArmed(SchedEvent kind, uint8_t slot) {
+    return kind < SCHED_EVENT_KINDS && slot < MAX_GROUP_DEVICES && s_pos[kind][slot] != 0;
+}
+
+uint16_t schedRunDue() {
+    uint16_t count = 0;
+    while (s_size > 0) {
+        int64_t nowUs = esp_timer_get_time();
+        HeapEntry top = s_heap[0];
+        if (top.dueUs > nowUs) break;
+        removeAt(0);
+        s_stats.depth = s_size;
+
+        uint32_t latenessUs = (uint32_t)std::min<int64_t>(nowUs - top.dueUs, UINT32_MAX);
+        s_stats.fired++;
+        s_stats.totalLatenessUs += latenessUs;
+        if (latenessUs > s_stats.maxLatenessUs) s_stats.maxLatenessUs = latenessUs;
+        if (latenessUs > SCHED_LATE_THRESHOLD_US) s_stats.lateCount++;
+
+        // 처리 함수가 같은 이벤트를 다시 예약할 수 있으므로 꺼낸 뒤 호출
+        if (s_handlers[top.kind]) s_handlers[top.kind](top.slot, top.dueUs);
+        count++;
+    }
+    return count;
+}
+
+void schedIdleWait(uint32_t maxSleepMs) {
+    uint32_t sleepMs = maxSleepMs;
+    if (s_size > 0) {
+        int64_t untilUs = s_heap[0].dueUs - esp_timer_get_time();
+        if (untilUs < 1000) return; // 1 ms 미만은 틱 단위로 잠들 수 없으므로 바로 다음 루프
+        sleepMs = (uint32_t)std::min<int64_t>(untilUs / 1000, maxSleepMs);
+    }
+    TickType_t ticks = pdMS_TO_TICKS(sleepMs);
+    if (ticks > 0) ulTaskNotifyTake(pdTRUE, ticks);
+}
+
+void schedWake() {
+    if (s_loopTask) xTaskNotifyGive(s_loopTask);
+}
+
+const SchedStats& schedStats() {
+    return s_stats;
+}
+
+void schedLogStats() {
+    uint32_t avgUs = s_stats.fired ? (uint32_t)(s_stats.totalLatenessUs / s_stats.fired) : 0;
+    logPrintf(LogLevel::LOG_INFO, "SCHED: 이벤트 %lu개 처리, 최대 대기열 %u, 처리 지연 평균 %lu us / 최대 %lu us, %lu us 초과 %lu개",
+              (unsigned long)s_stats.fired, s_stats.peakDepth, (unsigned long)avgUs, (unsigned long)s_stats.maxLatenessUs,
+              (unsigned long)SCHED_LATE_THRESHOLD_US, (unsigned long)s_stats.lateCount);
+}
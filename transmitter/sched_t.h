@@ -0,0 +1,72 @@
+#pragma once
+#ifndef SCHED_T_H
+#define SCHED_T_H
+
+#include <Arduino.h>
+#include "config_t.h"
+
+//────────────────────────────────────────────────────────────────────────────
+// [NEW] 기한 순 타이머 스케줄러 (색인된 최소 힙)
+//  - 이벤트는 (종류, 슬롯) 쌍으로 하나씩만 존재하며 다시 예약하면 기한만 옮김 (O(log n))
+//  - loop()는 가장 빠른 기한 또는 ACK 수신 알림까지 잠들고, 깨어나면 기한이 지난 이벤트를 순서대로 처리
+//  - 슬롯은 runningDevices 위치 (장치와 무관한 이벤트는 0)
+//  - 처리 지연(기한 대비 늦게 처리된 시간)과 대기열 깊이 통계를 시퀀스마다 집계
+//────────────────────────────────────────────────────────────────────────────
+
+enum SchedEvent : uint8_t {
+    SCHED_ACK_TIMEOUT = 0,  // 장치별 ACK 대기 기한
+    SCHED_DELAY_END,        // 장치별 송신부 로컬 딜레이 종료
+    SCHED_PLAY_END,         // 장치별 송신부 로컬 플레이 종료
+    SCHED_SEND_READY,       // 전송 간격 제한이 풀리는 시각 (슬롯 0, 처리 함수 없이 loop만 깨움)
+    SCHED_REDUNDANT_COPY,   // [NEW] 시간이 촉박한 패킷의 다음 중복 사본 전송
+    SCHED_STOP_RETRY,       // [NEW] 비상 정지 패킷 재전송 (슬롯 0)
+    SCHED_CHANNEL_HOP,      // [NEW] 채널 전환 패킷 재전송과 전환 시각 (슬롯 0)
+    SCHED_GO_RETRY,         // [NEW] GO_COMMAND 재전송 (슬롯 0)
+    SCHED_EVENT_KINDS
+};
+
+struct SchedStats {
+    uint16_t depth;             // 현재 예약된 이벤트 수
+    uint16_t peakDepth;         // 시퀀스 중 최대 예약 수
+    uint32_t fired;             // 처리한 이벤트 수
+    uint32_t lateCount;         // SCHED_LATE_THRESHOLD_US보다 늦게 처리된 이벤트 수
+    uint32_t maxLatenessUs;
+    uint64_t totalLatenessUs;
+};
+
+typedef void (*SchedHandler)(uint8_t slot, int64_t dueUs);
+
+// 스케줄러 초기화. 호출한 태스크(loop)를 schedWake()로 깨울 대상으로 등록 (setup에서 호출)
+void schedInit();
+
+// 이벤트 종류별 처리 함수 등록
+void schedSetHandler(SchedEvent kind, SchedHandler handler);
+
+// 모든 이벤트와 통계 초기화 (새 실행 시퀀스 시작 시)
+void schedReset();
+
+// 예약된 이벤트만 모두 취소 (통계는 유지)
+void schedClear();
+
+// 이벤트 예약 또는 기한 변경 (이미 지난 기한은 지금으로 취급)
+void schedArm(SchedEvent kind, uint8_t slot, int64_t dueUs);
+
+void schedCancel(SchedEvent kind, uint8_t slot);
+
+bool schedIsArmed(SchedEvent kind, uint8_t slot);
+
+// 기한이 지난 이벤트를 기한 순으로 꺼내 처리 함수 호출. 처리한 개수 반환
+uint16_t schedRunDue();
+
+// 다음 이벤트 기한까지 (최대 maxSleepMs) 잠듦. schedWake()가 호출되면 바로 깨어남
+void schedIdleWait(uint32_t maxSleepMs);
+
+// loop 태스크 깨우기 (ESP-NOW 콜백 등 다른 태스크에서 호출 가능)
+void schedWake();
+
+const SchedStats& schedStats();
+
+// 통계 로그 출력
+void schedLogStats();
+
+#endif // SCHED_T_H
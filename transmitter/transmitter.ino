@@ -2,6 +2,8 @@
 #include "utils_t.h"
 #include "hardware_t.h"
 #include "espnow_t.h"
+#include "capture_t.h"
+#include "sched_t.h"
 
 //========================================================================
 // SETUP
@@ -11,6 +13,8 @@ void setup() {
     initLog();
     logPrintf(LogLevel::LOG_INFO, "시스템 부팅 중...");
     
+    schedInit(); // [NEW] loop 태스크를 스케줄러 대기 대상으로 등록 (모듈별 이벤트 처리 함수 등록 전에)
+
     // 하드웨어 초기화 시도
     if (!initHardware()) {
         logPrintf(LogLevel::LOG_ERROR, "하드웨어 초기화 실패!");
@@ -43,9 +47,15 @@ void loop() {
 
     // 2. 사용자 입력 및 모드 로직 처리
     handleButtons(); // 버튼 이벤트 처리
+    captureHandleSerial(); // [NEW] 시리얼 캡처 덤프 명령
 
     // 3. 실행 상태 변경 및 타이머 확인
     checkExecutionAndMode(); // 실행 모드 및 타이머 관리
+    manageEmergencyStop();   // [NEW] 비상 정지 재전송 및 확인 ACK 처리
+    refreshLinkCache();      // [NEW] 유휴 시 링크 캐시 백그라운드 갱신
+    manageArming();          // [NEW] 유휴 시 수신기에 실행 정보 미리 전송
+    manageGroups();          // [NEW] 유휴 시 수신기 그룹 등록
+    manageChannel();         // [NEW] 채널 비콘, 유휴 시 채널 혼잡도 측정과 조정된 채널 전환
 
     // 4. 변경 사항이 있으면 디스플레이 업데이트
     // 효율성을 위해 각 함수 내에서 처리되지만, 필요한 경우 주기적인 업데이트를 강제할 수 있습니다.
@@ -54,4 +64,7 @@ void loop() {
         updateDisplay();
         lastDisplayUpdateTime = loopStartTime;
     }
+
+    // 5. [NEW] 다음 예약 이벤트(ACK 타임아웃, 전송 간격, 로컬 타이머)까지 대기. ACK가 도착하면 바로 깨어남
+    schedIdleWait(SCHED_MAX_IDLE_SLEEP_MS);
 }
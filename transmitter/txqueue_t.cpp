@@ -0,0 +1,250 @@
+#include "txqueue_t.h"
+#include "utils_t.h"
+#include "capture_t.h"
+#include "sched_t.h"
+#include "espnow_comm_shared.h"
+#include <esp_wifi.h>
+#include <algorithm>
+
+static_assert(TX_DRIVER_DEPTH >= 1, "TX_DRIVER_DEPTH must be at least 1");
+
+static constexpr uint8_t kNoStep = 0xFF;
+
+struct TxSlot {
+    uint8_t  dest[6];
+    uint8_t  len;
+    TxRate   rate;
+    uint32_t txMicros;
+    uint32_t id;          // 제출 순번 (txqSubmit이 자기 프레임의 결과를 알아보는 데 사용)
+    int64_t  queuedUs;
+    uint8_t  data[Comm::kMaxFrameSize];
+};
+
+// 드라이버에 넘겼고 송신 콜백을 기다리는 프레임 (드라이버는 넘긴 순서대로 콜백을 부름)
+struct DriverEntry {
+    uint32_t txMicros;
+    uint32_t airtimeUs;   // 방송 시간 (유니캐스트는 링크 계층 ACK 교환 포함)
+    int64_t  queuedUs;
+};
+
+// 송신 완료 기록 (ACK 처리 때 txMicros로 찾음)
+struct DoneEntry {
+    uint32_t txMicros;
+    int64_t  airStartUs;
+};
+
+static TxSlot      s_slots[TX_QUEUE_SLOTS];
+static uint8_t     s_head = 0, s_count = 0;
+static uint32_t    s_nextId = 1;
+static DriverEntry s_driver[TX_DRIVER_DEPTH];
+static uint8_t     s_driverHead = 0, s_driverCount = 0;
+static DoneEntry   s_done[TX_DONE_HISTORY];
+static uint8_t     s_doneNext = 0;
+static int64_t     s_retryAtUs = 0;          // 메모리 부족 후 완료 콜백 없이 다시 시도할 시각 (0이면 없음)
+static uint8_t     s_broadcastStep = kNoStep;
+static uint8_t     s_appliedPowerQdbm = 0;
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// 통계 (콜백에서도 갱신하므로 s_mux 안에서만 씀)
+static uint8_t  s_peakDepth = 0;
+static uint32_t s_noMemCount = 0;
+static uint32_t s_droppedCount = 0;
+static uint32_t s_maxQueueDelayUs = 0;
+static uint32_t s_noMemReported = 0;
+static uint32_t s_droppedReported = 0;
+
+static bool isBroadcast(const uint8_t* mac) {
+    return memcmp(mac, broadcastAddress, 6) == 0;
+}
+
+// 드라이버 호출 (loop에서만, 임계 구역 밖). 속도/세기 적용 후 전송하고, 유니캐스트가 거부되면 브로드캐스트로
+static esp_err_t driverSend(TxSlot& slot, bool& sentBroadcast) {
+    sentBroadcast = isBroadcast(slot.dest);
+    if (sentBroadcast) {
+        if (slot.rate.step != s_broadcastStep && Comm::applyPeerRate(broadcastAddress, slot.rate.step)) s_broadcastStep = slot.rate.step;
+    } else if (slot.rate.applyPeer) {
+        Comm::applyPeerRate(slot.dest, slot.rate.step);
+        slot.rate.applyPeer = false; // 메모리 부족으로 다시 보낼 때는 적용하지 않음
+    }
+    if (slot.rate.powerQdbm != s_appliedPowerQdbm && esp_wifi_set_max_tx_power((int8_t)slot.rate.powerQdbm) == ESP_OK) {
+        s_appliedPowerQdbm = slot.rate.powerQdbm;
+    }
+
+    // 큐와 메모리 부족 재시도에서 기다린 시간을 수신부 보정에 넣기 위해 넘기는 순간의 경과 시간으로 다시 씀
+    Comm::restampElapsedSincePress(slot.data, slot.len, micros());
+
+    esp_err_t result = esp_now_send(slot.dest, slot.data, slot.len);
+    captureTx(slot.dest, slot.data, slot.len, result);
+    if (result != ESP_OK && result != ESP_ERR_ESPNOW_NO_MEM && !sentBroadcast) {
+        sentBroadcast = true;
+        if (slot.rate.step != s_broadcastStep && Comm::applyPeerRate(broadcastAddress, slot.rate.step)) s_broadcastStep = slot.rate.step;
+        result = esp_now_send(broadcastAddress, slot.data, slot.len);
+        captureTx(broadcastAddress, slot.data, slot.len, result);
+    }
+    return result;
+}
+
+// 드라이버에 여유가 있는 동안 큐 앞의 프레임을 넘김 (loop에서만). watchId 프레임이 드라이버에서 거부되어 버려졌으면 그 에러를 반환
+// 큐 앞 위치와 개수는 loop만 바꾸고, 송신 콜백은 드라이버 기록만 꺼내므로 임계 구역은 드라이버 기록과 통계에만 필요
+static esp_err_t pump(uint32_t watchId) {
+    esp_err_t watchResult = ESP_OK;
+    for (;;) {
+        portENTER_CRITICAL(&s_mux);
+        if (s_count == 0 || s_driverCount >= TX_DRIVER_DEPTH) {
+            portEXIT_CRITICAL(&s_mux);
+            return watchResult;
+        }
+        TxSlot& slot = s_slots[s_head];
+        // 콜백이 esp_now_send가 반환되기 전에 올 수 있으므로 드라이버 기록을 먼저 넣음
+        uint8_t driverIdx = (uint8_t)((s_driverHead + s_driverCount) % TX_DRIVER_DEPTH);
+        s_driver[driverIdx].txMicros = slot.txMicros;
+        s_driver[driverIdx].queuedUs = slot.queuedUs;
+        s_driver[driverIdx].airtimeUs = Comm::frameAirtimeUs(slot.rate.step, slot.len) +
+                                        (isBroadcast(slot.dest) ? 0 : Comm::linkAckExchangeUs(slot.rate.step));
+        s_driverCount++;
+        portEXIT_CRITICAL(&s_mux);
+
+        bool sentBroadcast = false;
+        esp_err_t result = driverSend(slot, sentBroadcast); // 유니캐스트 거부 후 브로드캐스트로 보낸 경우 방송 시간이 약간 큼
+
+        portENTER_CRITICAL(&s_mux);
+        if (result != ESP_OK) s_driverCount--; // 콜백이 오지 않으므로 방금 넣은 기록을 뺌 (가장 최근 기록)
+        if (result == ESP_ERR_ESPNOW_NO_MEM) {
+            // 프레임은 큐 앞에 둠. 드라이버에 남은 프레임이 있으면 그 완료 콜백이 loop를 깨워 다시 시도함
+            s_noMemCount++;
+            if (s_driverCount == 0) s_retryAtUs = esp_timer_get_time() + SEND_RETRY_BACKOFF_US;
+            portEXIT_CRITICAL(&s_mux);
+            return watchResult;
+        }
+        if (result != ESP_OK) {
+            s_droppedCount++;
+            if (slot.id == watchId) watchResult = result;
+        }
+        s_head = (uint8_t)((s_head + 1) % TX_QUEUE_SLOTS);
+        s_count--;
+        portEXIT_CRITICAL(&s_mux);
+    }
+}
+
+void txqInit() {
+    portENTER_CRITICAL(&s_mux);
+    s_head = s_count = 0;
+    s_driverHead = s_driverCount = 0;
+    s_retryAtUs = 0;
+    memset(s_done, 0, sizeof(s_done));
+    portEXIT_CRITICAL(&s_mux);
+    s_broadcastStep = Comm::applyPeerRate(broadcastAddress, 0) ? 0 : kNoStep;
+    s_appliedPowerQdbm = (esp_wifi_set_max_tx_power((int8_t)TX_POWER_MAX_QDBM) == ESP_OK) ? TX_POWER_MAX_QDBM : 0;
+}
+
+esp_err_t txqSubmit(const uint8_t* dest, const uint8_t* data, size_t len, const TxRate& rate, uint32_t txMicros) {
+    if (len == 0 || len > Comm::kMaxFrameSize) return ESP_ERR_ESPNOW_ARG;
+    portENTER_CRITICAL(&s_mux);
+    if (s_count >= TX_QUEUE_SLOTS) {
+        portEXIT_CRITICAL(&s_mux);
+        return ESP_ERR_ESPNOW_NO_MEM;
+    }
+    TxSlot& slot = s_slots[(s_head + s_count) % TX_QUEUE_SLOTS];
+    memcpy(slot.dest, dest, 6);
+    memcpy(slot.data, data, len);
+    slot.len = (uint8_t)len;
+    slot.rate = rate;
+    slot.txMicros = txMicros;
+    slot.id = s_nextId++;
+    slot.queuedUs = esp_timer_get_time();
+    uint32_t id = slot.id;
+    s_count++;
+    s_peakDepth = std::max(s_peakDepth, s_count);
+    portEXIT_CRITICAL(&s_mux);
+    return pump(id);
+}
+
+// 완료 기록과 드라이버 자리 반환만 하고, 다음 프레임은 깨어난 loop의 txqPump()가 넘김
+void txqOnSendDone(esp_now_send_status_t status) {
+    int64_t nowUs = esp_timer_get_time();
+    portENTER_CRITICAL(&s_mux);
+    if (s_driverCount > 0) {
+        const DriverEntry& entry = s_driver[s_driverHead];
+        s_driverHead = (uint8_t)((s_driverHead + 1) % TX_DRIVER_DEPTH);
+        s_driverCount--;
+        // 실패한 유니캐스트는 재전송 끝에 포기한 것이므로 전송 시작 시각을 알 수 없음 (ACK도 오지 않음)
+        if (status == ESP_NOW_SEND_SUCCESS) {
+            DoneEntry& done = s_done[s_doneNext];
+            s_doneNext = (uint8_t)((s_doneNext + 1) % TX_DONE_HISTORY);
+            done.txMicros = entry.txMicros;
+            done.airStartUs = nowUs - entry.airtimeUs;
+            uint32_t queueDelayUs = (uint32_t)std::max<int64_t>(0, done.airStartUs - entry.queuedUs);
+            s_maxQueueDelayUs = std::max(s_maxQueueDelayUs, queueDelayUs);
+        }
+    }
+    s_retryAtUs = 0;
+    bool pending = s_count > 0;
+    portEXIT_CRITICAL(&s_mux);
+    if (pending) schedWake();
+}
+
+uint8_t txqDropPending() {
+    portENTER_CRITICAL(&s_mux);
+    uint8_t dropped = s_count;
+    s_count = 0;
+    s_retryAtUs = 0;
+    portEXIT_CRITICAL(&s_mux);
+    return dropped;
+}
+
+void txqPump() {
+    portENTER_CRITICAL(&s_mux);
+    // 메모리 부족 뒤 완료 콜백이 없으면 SEND_RETRY_BACKOFF_US까지는 다시 넘기지 않음
+    bool backingOff = (s_retryAtUs != 0 && esp_timer_get_time() < s_retryAtUs);
+    if (!backingOff) s_retryAtUs = 0;
+    uint32_t noMem = s_noMemCount, dropped = s_droppedCount;
+    portEXIT_CRITICAL(&s_mux);
+    if (!backingOff) pump(0);
+
+    if (noMem != s_noMemReported) {
+        logPrintf(LogLevel::LOG_DEBUG, "TXQ: 드라이버 메모리 부족 %lu회 (큐에서 대기 후 재전송)", (unsigned long)(noMem - s_noMemReported));
+        s_noMemReported = noMem;
+    }
+    if (dropped != s_droppedReported) {
+        logPrintf(LogLevel::LOG_WARN, "TXQ: 드라이버가 거부한 프레임 %lu개 버림", (unsigned long)(dropped - s_droppedReported));
+        s_droppedReported = dropped;
+    }
+}
+
+bool txqSentAt(uint32_t txMicros, int64_t& airStartUs) {
+    bool found = false;
+    portENTER_CRITICAL(&s_mux);
+    for (uint8_t n = 1; n <= TX_DONE_HISTORY; ++n) { // 최근 기록부터 (같은 프레임의 중복 사본은 마지막 것)
+        const DoneEntry& done = s_done[(s_doneNext + TX_DONE_HISTORY - n) % TX_DONE_HISTORY];
+        if (done.airStartUs != 0 && done.txMicros == txMicros) {
+            airStartUs = done.airStartUs;
+            found = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_mux);
+    return found;
+}
+
+uint32_t txqBacklogUs() {
+    uint32_t backlogUs = 0;
+    portENTER_CRITICAL(&s_mux);
+    for (uint8_t i = 0; i < s_driverCount; ++i) backlogUs += s_driver[(s_driverHead + i) % TX_DRIVER_DEPTH].airtimeUs;
+    for (uint8_t i = 0; i < s_count; ++i) {
+        const TxSlot& slot = s_slots[(s_head + i) % TX_QUEUE_SLOTS];
+        backlogUs += Comm::frameAirtimeUs(slot.rate.step, slot.len);
+    }
+    portEXIT_CRITICAL(&s_mux);
+    return backlogUs;
+}
+
+void txqLogStats() {
+    portENTER_CRITICAL(&s_mux);
+    uint8_t peak = s_peakDepth;
+    uint32_t maxDelayUs = s_maxQueueDelayUs, noMem = s_noMemCount, dropped = s_droppedCount;
+    s_peakDepth = s_count;
+    s_maxQueueDelayUs = 0;
+    portEXIT_CRITICAL(&s_mux);
+    logPrintf(LogLevel::LOG_INFO, "TXQ: 최대 큐 깊이 %u/%u, 최대 대기 %lu us, 드라이버 메모리 부족 누적 %lu회, 거부 누적 %lu개",
+              peak, TX_QUEUE_SLOTS, (unsigned long)maxDelayUs, (unsigned long)noMem, (unsigned long)dropped);
+}
@@ -0,0 +1,51 @@
+#pragma once
+#ifndef TXQUEUE_T_H
+#define TXQUEUE_T_H
+
+#include <Arduino.h>
+#include <esp_now.h>
+#include "config_t.h"
+#include "rate_t.h"
+
+//────────────────────────────────────────────────────────────────────────────
+// [NEW] 송신 완료 기반 송신 큐
+//  - loop는 만든 프레임을 큐에 넣고, 드라이버에는 TX_DRIVER_DEPTH개까지만 넘김.
+//    송신 콜백(Wi-Fi 태스크)은 완료를 기록하고 드라이버 자리를 비운 뒤 loop를 깨우기만 하며,
+//    다음 프레임은 loop의 txqPump()가 넘김 (드라이버 호출과 속도/세기 설정은 모두 loop에서)
+//  - 드라이버가 ESP_ERR_ESPNOW_NO_MEM을 돌려주면 프레임을 큐 앞에 그대로 두고, 드라이버에 남은 프레임의
+//    완료 콜백이 깨운 loop(남은 프레임이 없으면 SEND_RETRY_BACKOFF_US 뒤 txqPump())에서 다시 넘김 (스스로 버리는 프레임 없음)
+//  - 속도와 송신 세기는 드라이버에 넘기기 직전에 그 프레임의 값으로 설정
+//  - 명령 프레임(개별/일괄/GO)의 버튼 눌림 후 경과 시간은 드라이버에 넘기는 순간 다시 기록하고 검사값을 다시 붙임.
+//    수신부의 경과 시간 보정에 큐 대기가 빠지지 않도록 (txMicros는 ACK 대조 키이므로 그대로)
+//  - 송신 완료 시각에서 방송 시간(유니캐스트는 링크 계층 ACK 교환 포함)을 빼 실제 전송 시작 시각을 기록.
+//    RTT와 시계 동기화의 T1로 쓰면 큐와 드라이버에서 기다린 시간이 빠짐
+//  - 드라이버 기록과 송신 완료 기록은 loop와 Wi-Fi 태스크가 함께 쓰므로 portMUX로 보호 (드라이버 호출은 임계 구역 밖에서)
+//────────────────────────────────────────────────────────────────────────────
+
+// 큐 초기화. 브로드캐스트 피어 속도와 최대 송신 세기 설정 (esp_now_init과 브로드캐스트 피어 등록 후 호출)
+void txqInit();
+
+// 프레임을 큐에 넣고, 드라이버에 여유가 있으면 바로 넘김. txMicros는 프레임에 넣은 송신 시각 (송신 완료 기록의 키)
+// dest가 유니캐스트인데 드라이버가 거부하면 브로드캐스트로 한 번 더 보냄. 큐가 가득 차면 ESP_ERR_ESPNOW_NO_MEM
+esp_err_t txqSubmit(const uint8_t* dest, const uint8_t* data, size_t len, const TxRate& rate, uint32_t txMicros);
+
+// 송신 콜백에서 호출 (Wi-Fi 태스크). 완료만 기록하고, 보낼 프레임이 남아 있으면 loop를 깨움
+void txqOnSendDone(esp_now_send_status_t status);
+
+// 아직 드라이버에 넘기지 않은 프레임을 모두 버림 (비상 정지가 밀린 명령 뒤에서 기다리지 않도록). 버린 개수 반환
+uint8_t txqDropPending();
+
+// 드라이버에 자리가 생긴 만큼 큐 앞 프레임을 넘기고 (메모리 부족 뒤 대기 중이면 SEND_RETRY_BACKOFF_US 뒤에),
+// 콜백에서 센 통계를 로그로 보고 (loop에서 호출)
+void txqPump();
+
+// txMicros 프레임이 실제로 전송되기 시작한 시각 (esp_timer 기준). 송신 완료 기록이 없으면 false
+bool txqSentAt(uint32_t txMicros, int64_t& airStartUs);
+
+// 큐와 드라이버에 남은 프레임을 모두 보내는 데 걸릴 시간 추정 (ACK 타임아웃 연장용, us)
+uint32_t txqBacklogUs();
+
+// 시퀀스 통계 로그 (최대 큐 깊이, 드라이버 거부, 큐 대기 시간)
+void txqLogStats();
+
+#endif // TXQUEUE_T_H